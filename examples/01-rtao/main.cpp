@@ -25,6 +25,8 @@ SOFTWARE.
 #include "gfx_scene.h"
 #include "gfx_imgui.h"
 
+#include "raytracing_scene.h"
+
 #include "glm/gtc/matrix_transform.hpp"
 #include "samplerBlueNoiseErrorDistribution_128x128_OptimizedFor_2d2d2d2d_1spp.cpp"
 
@@ -114,17 +116,8 @@ int32_t main()
         albedo_buffers.insert(material_ref, albedo_buffer);
     }
 
-    GfxAccelerationStructure rt_scene = gfxCreateAccelerationStructure(gfx);
-
-    for(uint32_t i = 0; i < instance_count; ++i)
-    {
-        GfxConstRef<GfxInstance> instance_ref = gfxSceneGetInstanceHandle(scene, i);
-        GfxRaytracingPrimitive   rt_mesh      = gfxCreateRaytracingPrimitive(gfx, rt_scene);
-
-        gfxRaytracingPrimitiveBuild(gfx, rt_mesh, index_buffers[instance_ref->mesh], vertex_buffers[instance_ref->mesh]);
-    }
-
-    gfxAccelerationStructureUpdate(gfx, rt_scene);
+    // Build our acceleration structure, sharing one BLAS between all the instances of a mesh
+    RaytracingScene rt_scene = CreateRaytracingScene(gfx, scene);
 
     // Create our raytracing render targets
     GfxTexture color_buffer = gfxCreateTexture2D(gfx, DXGI_FORMAT_R16G16B16A16_FLOAT);
@@ -157,7 +150,7 @@ int32_t main()
     gfxProgramSetParameter(gfx, rtao_program, "RankingBuffer", ranking_buffer);
     gfxProgramSetParameter(gfx, rtao_program, "ScramblingBuffer", scrambling_buffer);
 
-    gfxProgramSetParameter(gfx, rtao_program, "Scene", rt_scene);
+    gfxProgramSetParameter(gfx, rtao_program, "Scene", rt_scene.acceleration_structure);
 
     // Enable anisotropic texture filtering
     GfxSamplerState texture_sampler = gfxCreateSamplerState(gfx, D3D12_FILTER_ANISOTROPIC, D3D12_TEXTURE_ADDRESS_MODE_WRAP, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
@@ -173,6 +166,9 @@ int32_t main()
     {
         gfxWindowPumpEvents(window);
 
+        // Keep the acceleration structure in sync with the scene
+        UpdateRaytracingScene(gfx, scene, rt_scene);
+
         // Show the GUI options
         if(ImGui::Begin("gfx - rtao", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings))
         {
@@ -269,7 +265,7 @@ int32_t main()
     gfxDestroyProgram(gfx, rtao_program);
 
     gfxDestroySamplerState(gfx, texture_sampler);
-    gfxDestroyAccelerationStructure(gfx, rt_scene);
+    ReleaseRaytracingScene(gfx, rt_scene);
 
     for(uint32_t i = 0; i < index_buffers.size(); ++i)
         gfxDestroyBuffer(gfx, index_buffers.data()[i]);
@@ -51,7 +51,7 @@ int main()
     // Process the environment for image-based lighting (i.e., IBL)
     GfxConstRef<GfxImage> environment_image = gfxSceneFindObjectByAssetFile<GfxImage>(scene, environment_map_path);
 
-    GfxTexture environment_map = (environment_image ? gpu_scene.textures[(uint32_t)environment_image] : GfxTexture());
+    GfxTexture environment_map = GetImageTexture(gpu_scene, (uint64_t)environment_image);
 
     IBL const ibl = ConvolveIBL(gfx, environment_map);
 
@@ -113,6 +113,14 @@ int main()
     // Run the application loop
     FlyCamera fly_camera = CreateFlyCamera(gfx, glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 
+    GpuDrawList draw_list = {};
+
+    CullingBounds culling_bounds;
+    OcclusionBuffer occlusion_buffer;
+    std::vector<uint32_t> visible_instances;
+
+    occlusion_buffer.resize(256, 128);
+
     while(!gfxWindowIsCloseRequested(window))
     {
         gfxWindowPumpEvents(window);
@@ -121,6 +129,8 @@ int main()
         UpdateGpuScene(gfx, scene, gpu_scene);
         UpdateFlyCamera(gfx, window, fly_camera);
 
+        BindGpuScene(gfx, pbr_program, gpu_scene);
+
         gfxProgramSetParameter(gfx, pbr_program, "g_Eye", fly_camera.eye);
         gfxProgramSetParameter(gfx, sky_program, "g_Eye", fly_camera.eye);
 
@@ -141,31 +151,27 @@ int main()
         gfxCommandClearTexture(gfx, velocity_buffer);
         gfxCommandClearTexture(gfx, depth_buffer);
 
-        // Draw all the meshes in the scene
-        uint32_t const instance_count = gfxSceneGetInstanceCount(scene);
+        // Cull and draw all the meshes in the scene
+        CullingView const culling_view = CreateCullingView(fly_camera.view_proj, fly_camera.eye);
+
+        UpdateCullingBounds(scene, culling_bounds);
+        CullInstances(culling_bounds, &culling_view, 1, &visible_instances);
+
+        RasterizeOccluders(scene, culling_bounds, visible_instances, fly_camera.view_proj, occlusion_buffer);
+        CullOccludedInstances(occlusion_buffer, culling_bounds, visible_instances);
+
+        BuildGpuDrawList(gfx, scene, gpu_scene, fly_camera.eye, draw_list, &visible_instances);
+
+        gfxProgramSetParameter(gfx, pbr_program, "g_ViewProjection", fly_camera.view_proj);
+        gfxProgramSetParameter(gfx, pbr_program, "g_PreviousViewProjection", fly_camera.prev_view_proj);
 
         gfxCommandBindColorTarget(gfx, 0, color_buffer);
         gfxCommandBindColorTarget(gfx, 1, velocity_buffer);
         gfxCommandBindDepthStencilTarget(gfx, depth_buffer);
-        gfxCommandBindKernel(gfx, pbr_kernel);
         gfxCommandBindIndexBuffer(gfx, gpu_scene.index_buffer);
         gfxCommandBindVertexBuffer(gfx, gpu_scene.vertex_buffer);
 
-        for(uint32_t i = 0; i < instance_count; ++i)
-        {
-            GfxConstRef<GfxInstance> const instance_ref = gfxSceneGetInstanceHandle(scene, i);
-
-            uint32_t const instance_id = (uint32_t)instance_ref;
-            uint32_t const mesh_id     = (uint32_t)instance_ref->mesh;
-
-            Mesh const mesh = gpu_scene.meshes[mesh_id];
-
-            gfxProgramSetParameter(gfx, pbr_program, "g_InstanceId", instance_id);
-            gfxProgramSetParameter(gfx, pbr_program, "g_ViewProjection", fly_camera.view_proj);
-            gfxProgramSetParameter(gfx, pbr_program, "g_PreviousViewProjection", fly_camera.prev_view_proj);
-
-            gfxCommandDrawIndexed(gfx, mesh.count, 1, mesh.first_index, mesh.base_vertex);
-        }
+        DrawGpuDrawList(gfx, pbr_program, &pbr_kernel, 0, draw_list);
 
         // Draw our skybox
         gfxCommandBindColorTarget(gfx, 0, color_buffer);
@@ -212,6 +218,7 @@ int main()
     gfxImGuiTerminate();
     gfxDestroyScene(scene);
     ReleaseGpuScene(gfx, gpu_scene);
+    ReleaseGpuDrawList(gfx, draw_list);
 
     gfxDestroyContext(gfx);
     gfxDestroyWindow(window);
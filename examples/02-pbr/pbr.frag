@@ -24,7 +24,6 @@ SOFTWARE.
 #include "../common/gpu_scene.hlsli"
 
 float3 g_Eye;
-uint   g_InstanceId;
 
 Texture2D   g_BrdfBuffer;
 TextureCube g_IrradianceBuffer;
@@ -40,6 +39,8 @@ struct Params
     float3 world    : POSITION0;
     float4 current  : POSITION1;
     float4 previous : POSITION2;
+
+    nointerpolation uint instance_id : INSTANCE_ID;
 };
 
 struct Result
@@ -67,7 +68,7 @@ float2 CalculateVelocity(in Params params)
 Result main(in Params params)
 {
     // Load our material
-    Instance instance = g_InstanceBuffer[g_InstanceId];
+    Instance instance = g_InstanceBuffer[params.instance_id];
     Material material = g_MaterialBuffer[instance.material_id];
 
     // Load and sample our texture maps
@@ -79,17 +80,17 @@ Result main(in Params params)
 
     if(albedo_map != uint(-1))
     {
-        material.albedo.xyz *= g_Textures[albedo_map].Sample(g_TextureSampler, params.uv).xyz;
+        material.albedo.xyz *= SampleSceneTexture(albedo_map, params.uv).xyz;
     }
 
     if(roughness_map != uint(-1))
     {
-        material.metallicity_roughness.z *= g_Textures[roughness_map].Sample(g_TextureSampler, params.uv).x;
+        material.metallicity_roughness.z *= SampleSceneTexture(roughness_map, params.uv).x;
     }
 
     if(metallicity_map != uint(-1))
     {
-        material.metallicity_roughness.x *= g_Textures[metallicity_map].Sample(g_TextureSampler, params.uv).x;
+        material.metallicity_roughness.x *= SampleSceneTexture(metallicity_map, params.uv).x;
     }
 
     if(normal_map != uint(-1))
@@ -109,14 +110,14 @@ Result main(in Params params)
 
         float    invmax  = rsqrt(max(dot(tangent, tangent), dot(bitangent, bitangent)));
         float3x3 tbn     = transpose(float3x3(tangent * invmax, bitangent * invmax, normal));
-        float3   disturb = 2.0f * g_Textures[normal_map].Sample(g_TextureSampler, params.uv).xyz - 1.0f;
+        float3   disturb = 2.0f * SampleSceneTexture(normal_map, params.uv).xyz - 1.0f;
 
         params.normal = mul(tbn, disturb);
     }
 
     if(ao_map != uint(-1))
     {
-        material.ao_normal_emissivity.x = g_Textures[ao_map].Sample(g_TextureSampler, params.uv).x;
+        material.ao_normal_emissivity.x = SampleSceneTexture(ao_map, params.uv).x;
     }
     else
     {
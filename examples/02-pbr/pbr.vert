@@ -23,10 +23,12 @@ SOFTWARE.
 ****************************************************************************/
 #include "../common/gpu_scene.hlsli"
 
-uint     g_InstanceId;
+uint     g_DrawOffset;
 float4x4 g_ViewProjection;
 float4x4 g_PreviousViewProjection;
 
+StructuredBuffer<uint> g_DrawInstanceBuffer;
+
 struct Params
 {
     float4 position : SV_Position;
@@ -35,16 +37,30 @@ struct Params
     float3 world    : POSITION0;
     float4 current  : POSITION1;
     float4 previous : POSITION2;
+
+    nointerpolation uint instance_id : INSTANCE_ID;
 };
 
-Params main(in Vertex vertex)
+Params main(in Vertex vertex, in uint vertex_id : SV_VertexID, in uint draw_id : gfx_DrawID)
 {
-    float4x4 transform          = g_TransformBuffer[g_InstanceId];
-    float4x4 previous_transform = g_PreviousTransformBuffer[g_InstanceId];
+    uint     instance_id        = g_DrawInstanceBuffer[g_DrawOffset + draw_id];
+    float4x4 transform          = g_TransformBuffer[instance_id];
+    float4x4 previous_transform = g_PreviousTransformBuffer[instance_id];
     float4   position           = mul(transform, vertex.position);
     float4   previous_position  = mul(previous_transform, vertex.position);
     float3   normal             = TransformDirection(transform, vertex.normal.xyz);
 
+    // Skinned vertices land in world space directly (no motion vectors from the joint animation yet)
+    float4 skinned_position = vertex.position;
+    float3 skinned_normal   = vertex.normal.xyz;
+
+    if(SkinVertex(g_InstanceBuffer[instance_id], vertex_id, skinned_position, skinned_normal))
+    {
+        position          = skinned_position;
+        previous_position = skinned_position;
+        normal            = skinned_normal;
+    }
+
     Params params;
     params.position = mul(g_ViewProjection, position);
     params.normal   = normal;
@@ -53,5 +69,7 @@ Params main(in Vertex vertex)
     params.current  = params.position;
     params.previous = mul(g_PreviousViewProjection, previous_position);
 
+    params.instance_id = instance_id;
+
     return params;
 }
@@ -0,0 +1,165 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "blas_sharing_map.h"
+
+void BlasSharingMap::update(uint64_t const *instance_handles, uint64_t const *mesh_handles, uint32_t instance_count, Changes &changes)
+{
+    changes.added_meshes.clear();
+    changes.removed_meshes.clear();
+    changes.added_instances.clear();
+    changes.removed_instances.clear();
+
+    ++update_index_;
+
+    // Flag the instances that are unchanged
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        uint32_t const slot = (uint32_t)instance_handles[i];
+
+        if(slot < instance_handles_.size() && instance_handles_[slot] == instance_handles[i] && instance_meshes_[slot] == mesh_handles[i])
+        {
+            instance_updates_[slot] = update_index_;
+        }
+    }
+
+    // Release the ones that are gone, or were replaced
+    for(uint32_t slot = 0; slot < (uint32_t)instance_handles_.size(); ++slot)
+    {
+        if(instance_handles_[slot] == 0 || instance_updates_[slot] == update_index_)
+        {
+            continue;   // free slot, or still alive
+        }
+
+        changes.removed_instances.push_back(instance_handles_[slot]);
+
+        releaseMesh(instance_meshes_[slot], changes);
+
+        instance_handles_[slot] = 0;
+        instance_meshes_[slot]  = 0;
+
+        --instance_count_;
+    }
+
+    // And track the new ones
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        uint32_t const slot = (uint32_t)instance_handles[i];
+
+        if(slot >= instance_handles_.size())
+        {
+            instance_handles_.resize(slot + 1);
+            instance_meshes_.resize(slot + 1);
+            instance_updates_.resize(slot + 1);
+        }
+
+        if(instance_handles_[slot] != 0)
+        {
+            continue;   // already tracked
+        }
+
+        instance_handles_[slot] = instance_handles[i];
+        instance_meshes_[slot]  = mesh_handles[i];
+        instance_updates_[slot] = update_index_;
+
+        changes.added_instances.push_back(instance_handles[i]);
+
+        if(mesh_handles[i] != 0 && mesh_reference_counts_[mesh_handles[i]]++ == 0)
+        {
+            changes.added_meshes.push_back(mesh_handles[i]);
+        }
+
+        ++instance_count_;
+    }
+
+    // Meshes that were released then re-acquired keep their BLAS
+    std::vector<uint64_t>::iterator it = changes.removed_meshes.begin();
+
+    while(it != changes.removed_meshes.end())
+    {
+        std::unordered_map<uint64_t, uint32_t>::iterator const mesh = mesh_reference_counts_.find(*it);
+
+        if(mesh->second == 0)
+        {
+            mesh_reference_counts_.erase(mesh);
+
+            ++it;
+        }
+        else
+        {
+            for(std::vector<uint64_t>::iterator added_mesh = changes.added_meshes.begin(); added_mesh != changes.added_meshes.end(); ++added_mesh)
+            {
+                if(*added_mesh == *it)
+                {
+                    changes.added_meshes.erase(added_mesh);
+
+                    break;
+                }
+            }
+
+            it = changes.removed_meshes.erase(it);
+        }
+    }
+}
+
+void BlasSharingMap::clear()
+{
+    instance_handles_.clear();
+    instance_meshes_.clear();
+    instance_updates_.clear();
+    mesh_reference_counts_.clear();
+
+    instance_count_ = 0;
+}
+
+uint64_t BlasSharingMap::getInstanceMesh(uint64_t instance_handle) const
+{
+    uint32_t const slot = (uint32_t)instance_handle;
+
+    if(slot >= instance_handles_.size() || instance_handles_[slot] != instance_handle)
+    {
+        return 0;   // not tracked
+    }
+
+    return instance_meshes_[slot];
+}
+
+uint32_t BlasSharingMap::getMeshReferenceCount(uint64_t mesh_handle) const
+{
+    std::unordered_map<uint64_t, uint32_t>::const_iterator const mesh = mesh_reference_counts_.find(mesh_handle);
+
+    return (mesh != mesh_reference_counts_.end() ? mesh->second : 0);
+}
+
+void BlasSharingMap::releaseMesh(uint64_t mesh_handle, Changes &changes)
+{
+    if(mesh_handle == 0)
+    {
+        return; // instance has no mesh
+    }
+
+    if(--mesh_reference_counts_[mesh_handle] == 0)
+    {
+        changes.removed_meshes.push_back(mesh_handle);
+    }
+}
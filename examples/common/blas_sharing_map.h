@@ -0,0 +1,64 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Tracks which mesh each instance is drawn from so that a single BLAS can be shared between all the
+// instances of a mesh; a BLAS is requested when its first instance appears and released with its last.
+// Only deals in object handles (no gfx dependencies) so it can be built and exercised on any platform.
+class BlasSharingMap
+{
+public:
+    struct Changes
+    {
+        std::vector<uint64_t> added_meshes;         // meshes that need their BLAS built
+        std::vector<uint64_t> removed_meshes;       // meshes whose BLAS is no longer referenced
+        std::vector<uint64_t> added_instances;      // new instances, or instances that changed mesh
+        std::vector<uint64_t> removed_instances;    // processed before any of the additions
+    };
+
+    // Takes the (instance, mesh) pairs currently in the scene and returns what changed since the last call;
+    // the lower 32 bits of an instance handle are used as its slot, the upper bits disambiguate reuse.
+    void update(uint64_t const *instance_handles, uint64_t const *mesh_handles, uint32_t instance_count, Changes &changes);
+    void clear();
+
+    uint64_t getInstanceMesh(uint64_t instance_handle) const;  // returns 0 if the instance isn't tracked
+    uint32_t getMeshReferenceCount(uint64_t mesh_handle) const;
+
+    inline uint32_t getInstanceCount() const { return instance_count_; }
+    inline uint32_t getMeshCount() const { return (uint32_t)mesh_reference_counts_.size(); }
+
+private:
+    void releaseMesh(uint64_t mesh_handle, Changes &changes);
+
+    std::vector<uint64_t> instance_handles_;    // tracked instance in each slot, or 0 if free
+    std::vector<uint64_t> instance_meshes_;
+    std::vector<uint32_t> instance_updates_;    // last update that saw each instance
+    std::unordered_map<uint64_t, uint32_t> mesh_reference_counts_;
+    uint32_t instance_count_ = 0;
+    uint32_t update_index_ = 0;
+};
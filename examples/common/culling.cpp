@@ -0,0 +1,215 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "culling.h"
+#include "gfx_core.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+
+uint32_t const kMinBlocksPerThread = 4096; // below this, threading costs more than it saves
+
+// Written as fixed-width loops over a block without branches so that compilers turn them into
+// straight SIMD code (SSE/AVX2 on x64, NEON on ARM) without us needing intrinsics.
+uint32_t CullBlock(float const *center_x, float const *center_y, float const *center_z, float const *radius, CullingView const &view)
+{
+    uint32_t const kBlockSize = CullingBounds::kBlockSize;
+
+    float visible[kBlockSize];
+
+    for(uint32_t i = 0; i < kBlockSize; ++i)
+    {
+        float const dx = center_x[i] - view.eye.x;
+        float const dy = center_y[i] - view.eye.y;
+        float const dz = center_z[i] - view.eye.z;
+
+        float const max_distance = view.max_distance + radius[i];
+
+        visible[i] = (dx * dx + dy * dy + dz * dz <= max_distance * max_distance && radius[i] >= 0.0f ? 1.0f : 0.0f);
+    }
+
+    for(uint32_t p = 0; p < 6; ++p)
+    {
+        glm::vec4 const plane = view.planes[p];
+
+        for(uint32_t i = 0; i < kBlockSize; ++i)
+        {
+            float const distance = plane.x * center_x[i] + plane.y * center_y[i] + plane.z * center_z[i] + plane.w;
+
+            visible[i] = (distance >= -radius[i] ? visible[i] : 0.0f);
+        }
+    }
+
+    uint32_t mask = 0;
+
+    for(uint32_t i = 0; i < kBlockSize; ++i)
+    {
+        mask |= (visible[i] != 0.0f ? 1u << i : 0u);
+    }
+
+    return mask;
+}
+
+} //! unnamed namespace
+
+void CullingBounds::resize(uint32_t count)
+{
+    uint32_t const padded_count = ((count + kBlockSize - 1) / kBlockSize) * kBlockSize;
+
+    center_x_.resize(padded_count);
+    center_y_.resize(padded_count);
+    center_z_.resize(padded_count);
+    radius_.resize(padded_count);
+
+    // Padding never passes the tests
+    for(uint32_t i = count; i < padded_count; ++i)
+    {
+        center_x_[i] = center_y_[i] = center_z_[i] = 0.0f;
+
+        radius_[i] = -FLT_MAX;
+    }
+
+    count_ = count;
+}
+
+void CullingBounds::setSphere(uint32_t index, glm::vec3 const &center, float radius)
+{
+    center_x_[index] = center.x;
+    center_y_[index] = center.y;
+    center_z_[index] = center.z;
+    radius_[index]   = radius;
+}
+
+void CullingBounds::setBox(uint32_t index, glm::vec3 const &bounds_min, glm::vec3 const &bounds_max, glm::mat4 const &transform)
+{
+    glm::vec3 const center = glm::vec3(transform * glm::vec4(0.5f * (bounds_min + bounds_max), 1.0f));
+    glm::vec3 const extent = 0.5f * (bounds_max - bounds_min);
+
+    // Scale the box' bounding sphere by the largest axis of the transform
+    float const scale = glm::sqrt(glm::max(glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+                                                    glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+                                                    glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+
+    setSphere(index, center, scale * glm::length(extent));
+}
+
+CullingView CreateCullingView(glm::mat4 const &view_proj, glm::vec3 const &eye, float max_distance)
+{
+    CullingView view = {};
+
+    glm::mat4 const m = glm::transpose(view_proj);  // rows of the view-projection matrix
+
+    view.planes[0] = m[3] + m[0];   // left
+    view.planes[1] = m[3] - m[0];   // right
+    view.planes[2] = m[3] + m[1];   // bottom
+    view.planes[3] = m[3] - m[1];   // top
+    view.planes[4] = m[2];          // near (D3D clip space depth is [0, 1])
+    view.planes[5] = m[3] - m[2];   // far
+
+    for(glm::vec4 &plane : view.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    view.eye          = eye;
+    view.max_distance = max_distance;
+
+    return view;
+}
+
+void CullInstances(CullingBounds const &bounds, CullingView const *views, uint32_t view_count, std::vector<uint32_t> *visible_indices, uint32_t thread_count)
+{
+    uint32_t const block_count = bounds.getBlockCount();
+
+    if(thread_count == 0)
+    {
+        thread_count = gfxGetJobSystem().get_thread_count();
+    }
+
+    thread_count = std::max(std::min(thread_count, block_count / kMinBlocksPerThread), 1u);
+
+    // Each job compacts its range of blocks into its own lists, which get concatenated in order
+    std::vector<std::vector<uint32_t>> thread_visible_indices(thread_count * view_count);
+
+    auto const worker = [&](uint32_t thread_index)
+    {
+        uint32_t const begin = (uint32_t)(((uint64_t)block_count * (thread_index + 0)) / thread_count);
+        uint32_t const end   = (uint32_t)(((uint64_t)block_count * (thread_index + 1)) / thread_count);
+
+        std::vector<uint32_t> *thread_indices = (thread_count > 1 ? &thread_visible_indices[thread_index * view_count] : visible_indices);
+
+        for(uint32_t v = 0; v < view_count; ++v)
+        {
+            thread_indices[v].clear();
+            thread_indices[v].reserve((end - begin) * CullingBounds::kBlockSize);
+        }
+
+        for(uint32_t block = begin; block < end; ++block)
+        {
+            uint32_t const first = block * CullingBounds::kBlockSize;
+
+            // Test the block against all the views while it's still in cache
+            for(uint32_t v = 0; v < view_count; ++v)
+            {
+                uint32_t const mask = CullBlock(bounds.getCentersX() + first, bounds.getCentersY() + first, bounds.getCentersZ() + first, bounds.getRadii() + first, views[v]);
+
+                if(mask == 0)
+                {
+                    continue;   // fully culled
+                }
+
+                for(uint32_t i = 0; i < CullingBounds::kBlockSize; ++i)
+                {
+                    if((mask & (1u << i)) != 0)
+                    {
+                        thread_indices[v].push_back(first + i);
+                    }
+                }
+            }
+        }
+    };
+
+    if(thread_count == 1)
+    {
+        worker(0);
+
+        return; // wrote straight into the output lists
+    }
+
+    gfxGetJobSystem().parallel_for(thread_count, 1, worker);
+
+    for(uint32_t v = 0; v < view_count; ++v)
+    {
+        visible_indices[v].clear();
+
+        for(uint32_t i = 0; i < thread_count; ++i)
+        {
+            std::vector<uint32_t> const &thread_indices = thread_visible_indices[i * view_count + v];
+
+            visible_indices[v].insert(visible_indices[v].end(), thread_indices.begin(), thread_indices.end());
+        }
+    }
+}
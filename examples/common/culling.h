@@ -0,0 +1,70 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// World-space bounding spheres stored as structure-of-arrays; the arrays are padded to a multiple of
+// the block size with spheres that never pass the culling tests.
+class CullingBounds
+{
+public:
+    static uint32_t const kBlockSize = 8;   // instances tested per iteration; one AVX2 register of floats
+
+    void resize(uint32_t count);
+    void setSphere(uint32_t index, glm::vec3 const &center, float radius);
+    void setBox(uint32_t index, glm::vec3 const &bounds_min, glm::vec3 const &bounds_max, glm::mat4 const &transform);
+
+    inline uint32_t getCount() const { return count_; }
+    inline uint32_t getBlockCount() const { return (count_ + kBlockSize - 1) / kBlockSize; }
+
+    inline float const *getCentersX() const { return center_x_.data(); }
+    inline float const *getCentersY() const { return center_y_.data(); }
+    inline float const *getCentersZ() const { return center_z_.data(); }
+    inline float const *getRadii() const { return radius_.data(); }
+
+private:
+    std::vector<float> center_x_;
+    std::vector<float> center_y_;
+    std::vector<float> center_z_;
+    std::vector<float> radius_;
+    uint32_t count_ = 0;
+};
+
+struct CullingView
+{
+    glm::vec4 planes[6];    // normalized, pointing inwards
+    glm::vec3 eye;
+    float     max_distance; // instances further away are culled
+};
+
+CullingView CreateCullingView(glm::mat4 const &view_proj, glm::vec3 const &eye, float max_distance = 3.402823466e+38f);
+
+// Tests all the bounds against each of the views (e.g., main camera plus shadow cascades) in a single
+// pass over the data, split into `thread_count` jobs (0 uses all the job system's threads), and writes
+// out the indices of the visible instances in increasing order, one list per view.
+void CullInstances(CullingBounds const &bounds, CullingView const *views, uint32_t view_count, std::vector<uint32_t> *visible_indices, uint32_t thread_count = 0);
@@ -0,0 +1,236 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "draw_list.h"
+#include "gfx_core.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+uint32_t const kMinDrawsPerThread = 16384;  // below this, threading costs more than it saves
+
+uint32_t const kPassShift     = 60;
+uint32_t const kKernelShift   = 52;
+uint32_t const kMaterialShift = 36;
+uint32_t const kMeshShift     = 16;
+
+uint32_t GetChunkOffset(uint32_t count, uint32_t chunk, uint32_t chunk_count)
+{
+    return (uint32_t)(((uint64_t)count * chunk) / chunk_count);
+}
+
+} //! unnamed namespace
+
+void DrawListBuilder::clear()
+{
+    draw_items_.clear();
+    arguments_.clear();
+    instance_ids_.clear();
+    batches_.clear();
+}
+
+void DrawListBuilder::reserve(uint32_t draw_count)
+{
+    draw_items_.reserve(draw_count);
+}
+
+void DrawListBuilder::addDraw(DrawItem const &draw_item)
+{
+    draw_items_.push_back(draw_item);
+}
+
+void DrawListBuilder::build(uint32_t thread_count)
+{
+    uint32_t const draw_count = (uint32_t)draw_items_.size();
+
+    if(thread_count == 0)
+    {
+        thread_count = gfxGetJobSystem().get_thread_count();
+    }
+
+    thread_count = std::max(std::min(thread_count, draw_count / kMinDrawsPerThread), 1u);
+
+    keys_.resize(draw_count);
+    scratch_keys_.resize(draw_count);
+    indices_.resize(draw_count);
+    scratch_indices_.resize(draw_count);
+    histograms_.resize(256 * thread_count);
+    arguments_.resize(draw_count);
+    instance_ids_.resize(draw_count);
+    batches_.clear();
+
+    // Each phase splits the draws into one chunk per thread and runs these as jobs
+    gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t chunk)
+    {
+        uint32_t const end = GetChunkOffset(draw_count, chunk + 1, thread_count);
+
+        for(uint32_t i = GetChunkOffset(draw_count, chunk, thread_count); i < end; ++i)
+        {
+            keys_[i]    = CalculateSortKey(draw_items_[i]);
+            indices_[i] = i;
+        }
+    });
+
+    sortKeys(thread_count);
+
+    // Split the sorted draws into batches of matching pass and kernel
+    for(uint32_t i = 0; i < draw_count; ++i)
+    {
+        if(i > 0 && (keys_[i] >> kKernelShift) == (keys_[i - 1] >> kKernelShift))
+        {
+            ++batches_.back().draw_count;
+
+            continue;
+        }
+
+        DrawItem const &draw_item = draw_items_[indices_[i]];
+
+        DrawBatch batch  = {};
+        batch.pass       = draw_item.pass;
+        batch.kernel     = draw_item.kernel;
+        batch.first_draw = i;
+        batch.draw_count = 1;
+
+        batches_.push_back(batch);
+    }
+
+    // And write out the indirect arguments
+    gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t chunk)
+    {
+        uint32_t const begin = GetChunkOffset(draw_count, chunk + 0, thread_count);
+        uint32_t const end   = GetChunkOffset(draw_count, chunk + 1, thread_count);
+
+        if(begin == end)
+        {
+            return; // no draws to process
+        }
+
+        std::vector<DrawBatch>::const_iterator batch = std::upper_bound(batches_.begin(), batches_.end(), begin,
+            [](uint32_t draw, DrawBatch const &batch) { return draw < batch.first_draw; }) - 1;
+
+        for(uint32_t i = begin; i < end; ++i)
+        {
+            if(i >= batch->first_draw + batch->draw_count)
+            {
+                ++batch;
+            }
+
+            DrawItem const &draw_item = draw_items_[indices_[i]];
+
+            DrawIndexedArguments &arguments = arguments_[i];
+
+            arguments.index_count_per_instance = draw_item.index_count;
+            arguments.instance_count           = 1;
+            arguments.start_index_location     = draw_item.first_index;
+            arguments.base_vertex_location     = draw_item.base_vertex;
+            arguments.start_instance_location  = i - batch->first_draw;
+
+            instance_ids_[i] = draw_item.instance_id;
+        }
+    });
+}
+
+uint64_t DrawListBuilder::CalculateSortKey(DrawItem const &draw_item)
+{
+    uint32_t depth_bits = 0;
+
+    if(draw_item.depth > 0.0f)
+    {
+        memcpy(&depth_bits, &draw_item.depth, sizeof(depth_bits));   // positive floats sort like integers
+    }
+
+    return ((uint64_t)(draw_item.pass     & 0xFu)     << kPassShift)
+         | ((uint64_t)(draw_item.kernel   & 0xFFu)    << kKernelShift)
+         | ((uint64_t)(draw_item.material & 0xFFFFu)  << kMaterialShift)
+         | ((uint64_t)(draw_item.mesh     & 0xFFFFFu) << kMeshShift)
+         | ((uint64_t)(depth_bits >> 16));
+}
+
+void DrawListBuilder::sortKeys(uint32_t thread_count)
+{
+    uint32_t const draw_count = (uint32_t)keys_.size();
+
+    // Radix sort the keys 8 bits at a time, skipping the digits that all keys share
+    for(uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t chunk)
+        {
+            uint32_t *histogram = &histograms_[256 * chunk];
+
+            std::fill(histogram, histogram + 256, 0u);
+
+            uint32_t const end = GetChunkOffset(draw_count, chunk + 1, thread_count);
+
+            for(uint32_t i = GetChunkOffset(draw_count, chunk, thread_count); i < end; ++i)
+            {
+                ++histogram[(keys_[i] >> shift) & 0xFFu];
+            }
+        });
+
+        uint32_t offset = 0;
+
+        bool skip_pass = false;
+
+        for(uint32_t digit = 0; digit < 256; ++digit)
+        {
+            uint32_t const digit_offset = offset;
+
+            for(uint32_t chunk = 0; chunk < thread_count; ++chunk)
+            {
+                uint32_t const count = histograms_[256 * chunk + digit];
+
+                histograms_[256 * chunk + digit] = offset;
+
+                offset += count;
+            }
+
+            skip_pass |= (offset - digit_offset == draw_count);
+        }
+
+        if(skip_pass)
+        {
+            continue;   // keys are already ordered on this digit
+        }
+
+        gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t chunk)
+        {
+            uint32_t *histogram = &histograms_[256 * chunk];
+
+            uint32_t const end = GetChunkOffset(draw_count, chunk + 1, thread_count);
+
+            for(uint32_t i = GetChunkOffset(draw_count, chunk, thread_count); i < end; ++i)
+            {
+                uint32_t const dst = histogram[(keys_[i] >> shift) & 0xFFu]++;
+
+                scratch_keys_[dst]    = keys_[i];
+                scratch_indices_[dst] = indices_[i];
+            }
+        });
+
+        keys_.swap(scratch_keys_);
+        indices_.swap(scratch_indices_);
+    }
+}
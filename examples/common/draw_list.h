@@ -0,0 +1,95 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Same layout as D3D12_DRAW_INDEXED_ARGUMENTS, so the arguments can be uploaded as-is and consumed
+// by gfxCommandMultiDrawIndexedIndirect().
+struct DrawIndexedArguments
+{
+    uint32_t index_count_per_instance;
+    uint32_t instance_count;
+    uint32_t start_index_location;
+    int32_t  base_vertex_location;
+    uint32_t start_instance_location;
+};
+
+struct DrawItem
+{
+    uint32_t pass;          // 4 bits
+    uint32_t kernel;        // 8 bits
+    uint32_t material;      // 16 bits
+    uint32_t mesh;          // 20 bits
+    float    depth;         // >= 0; draws of equal state are sorted front-to-back
+    uint32_t instance_id;
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t  base_vertex;
+};
+
+struct DrawBatch
+{
+    uint32_t pass;
+    uint32_t kernel;
+    uint32_t first_draw;    // into the arguments and instance ids arrays
+    uint32_t draw_count;
+};
+
+// Sorts draws by (pass, kernel, material, mesh, depth) and compacts the runs of draws sharing a pass
+// and kernel into batches of indirect arguments, one gfxCommandMultiDrawIndexedIndirect() call each.
+// Draw `i` of a batch gets `start_instance_location = i`, so `gfx_DrawID` in the vertex shader can be
+// offset by the batch's `first_draw` to look up the instance being drawn.
+// Only depends on gfx_core.h (for the job system) so it can be built and exercised on any platform.
+class DrawListBuilder
+{
+public:
+    void clear();
+    void reserve(uint32_t draw_count);
+
+    void addDraw(DrawItem const &draw_item);
+    void build(uint32_t thread_count = 0);  // splits the work into `thread_count' jobs per phase; 0 uses all the job system's threads
+
+    inline uint32_t getDrawCount() const { return (uint32_t)draw_items_.size(); }
+
+    inline std::vector<DrawIndexedArguments> const &getArguments() const { return arguments_; }
+    inline std::vector<uint32_t> const &getInstanceIds() const { return instance_ids_; }
+    inline std::vector<DrawBatch> const &getBatches() const { return batches_; }
+
+    static uint64_t CalculateSortKey(DrawItem const &draw_item);
+
+private:
+    void sortKeys(uint32_t thread_count);   // radix sorts `keys_' and `indices_' in place
+
+    std::vector<DrawItem> draw_items_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint64_t> scratch_keys_;
+    std::vector<uint32_t> indices_;         // draw item of each sorted key
+    std::vector<uint32_t> scratch_indices_;
+    std::vector<uint32_t> histograms_;
+    std::vector<DrawIndexedArguments> arguments_;
+    std::vector<uint32_t> instance_ids_;
+    std::vector<DrawBatch> batches_;
+};
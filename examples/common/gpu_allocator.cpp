@@ -0,0 +1,151 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gpu_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+RangeAllocator::RangeAllocator(uint32_t capacity)
+    : capacity_(0)
+    , free_count_(0)
+{
+    reset(capacity);
+}
+
+bool RangeAllocator::allocate(uint32_t count, uint32_t &offset)
+{
+    if(count == 0)
+    {
+        offset = 0;
+
+        return true;    // nothing to allocate
+    }
+
+    for(size_t i = 0; i < free_ranges_.size(); ++i)
+    {
+        Range &range = free_ranges_[i];
+
+        if(range.count < count)
+        {
+            continue;   // not large enough
+        }
+
+        offset = range.offset;
+
+        range.offset += count;
+        range.count  -= count;
+
+        if(range.count == 0)
+        {
+            free_ranges_.erase(free_ranges_.begin() + i);
+        }
+
+        free_count_ -= count;
+
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t count)
+{
+    if(count == 0)
+    {
+        return; // nothing to free
+    }
+
+    assert(offset + count <= capacity_);
+
+    // Find the first free range located after the one being released
+    std::vector<Range>::iterator next = std::lower_bound(free_ranges_.begin(), free_ranges_.end(), offset,
+        [](Range const &range, uint32_t offset) { return range.offset < offset; });
+
+    assert(next == free_ranges_.end() || offset + count <= next->offset);
+
+    bool const merge_prev = (next != free_ranges_.begin() && (next - 1)->offset + (next - 1)->count == offset);
+    bool const merge_next = (next != free_ranges_.end() && offset + count == next->offset);
+
+    if(merge_prev && merge_next)
+    {
+        (next - 1)->count += count + next->count;
+
+        free_ranges_.erase(next);
+    }
+    else if(merge_prev)
+    {
+        (next - 1)->count += count;
+    }
+    else if(merge_next)
+    {
+        next->offset  = offset;
+        next->count  += count;
+    }
+    else
+    {
+        Range range = {};
+        range.offset = offset;
+        range.count  = count;
+
+        free_ranges_.insert(next, range);
+    }
+
+    free_count_ += count;
+}
+
+void RangeAllocator::grow(uint32_t capacity)
+{
+    if(capacity <= capacity_)
+    {
+        return; // nothing to grow
+    }
+
+    uint32_t const offset = capacity_;
+
+    capacity_ = capacity;
+
+    free(offset, capacity - offset);
+}
+
+void RangeAllocator::reset(uint32_t capacity)
+{
+    free_ranges_.clear();
+
+    capacity_   = 0;
+    free_count_ = 0;
+
+    grow(capacity);
+}
+
+uint32_t RangeAllocator::getLargestFreeRange() const
+{
+    uint32_t largest_free_range = 0;
+
+    for(Range const &range : free_ranges_)
+    {
+        largest_free_range = std::max(largest_free_range, range.count);
+    }
+
+    return largest_free_range;
+}
@@ -0,0 +1,58 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Hands out [offset, offset + count) ranges from a linear address space (e.g., the vertex or index
+// pool of a GPU scene); freed ranges are coalesced with their neighbors and reused first-fit.
+// Has no dependencies on gfx so it can be built and exercised on any platform.
+class RangeAllocator
+{
+public:
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    bool allocate(uint32_t count, uint32_t &offset);    // returns false if there's no free range large enough
+    void free(uint32_t offset, uint32_t count);
+
+    void grow(uint32_t capacity);   // the new space is appended at the end of the address space
+    void reset(uint32_t capacity);  // frees all the ranges
+
+    inline uint32_t getCapacity() const { return capacity_; }
+    inline uint32_t getFreeCount() const { return free_count_; }
+    inline uint32_t getFreeRangeCount() const { return (uint32_t)free_ranges_.size(); }
+    uint32_t getLargestFreeRange() const;
+
+private:
+    struct Range
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    std::vector<Range> free_ranges_;    // sorted by offset, never adjacent
+    uint32_t capacity_;
+    uint32_t free_count_;
+};
@@ -23,6 +23,9 @@ SOFTWARE.
 ****************************************************************************/
 #include "gpu_scene.h"
 
+#include <chrono>
+#include <cstring>
+
 namespace
 {
 
@@ -37,6 +40,7 @@ struct Instance
 {
     uint32_t mesh_id;
     uint32_t material_id;
+    uint32_t skin_id;
 };
 
 struct Vertex
@@ -46,19 +50,148 @@ struct Vertex
     glm::vec2 uv;
 };
 
-} //! unnamed namespace
+struct TransformPacket
+{
+    uint32_t  instance_id;
+    glm::vec4 rows[3];  // affine transform, last row is implicitly (0, 0, 0, 1)
+};
 
-GpuScene UploadSceneToGpuMemory(GfxContext gfx, GfxScene scene)
+uint32_t const kTransformPacket_WritePrevious = 0x80000000u;   // newly added instance; initializes the previous transform also
+
+uint32_t const kInvalidJoint = 0xFFFFFFFFu;    // mesh or instance without skinning
+
+uint32_t const kMaxAtlasImageSize = 128;    // larger images keep a texture of their own
+uint32_t const kMaxAtlasSize      = 2048;
+float    const kMaxAtlasWaste     = 0.9f;   // a standalone texture takes at least 64KiB, so even mostly-border cells pay off
+
+char const *transform_program_cs =
+    "struct TransformPacket { uint instance_id; float4 rows[3]; };"
+    "StructuredBuffer<TransformPacket> g_TransformPacketBuffer;"
+    "RWStructuredBuffer<float4x4> g_TransformBuffer;"
+    "RWStructuredBuffer<float4x4> g_PreviousTransformBuffer;"
+    "uint g_TransformPacketCount;"
+    "[numthreads(128, 1, 1)]"
+    "void main(in uint did : SV_DispatchThreadID)"
+    "{"
+    "    if(did >= g_TransformPacketCount) return;"
+    "    TransformPacket packet = g_TransformPacketBuffer[did];"
+    "    uint instance_id = (packet.instance_id & 0x7FFFFFFFu);"
+    "    float4x4 transform = float4x4(packet.rows[0], packet.rows[1], packet.rows[2], float4(0.0f, 0.0f, 0.0f, 1.0f));"
+    "    g_TransformBuffer[instance_id] = transform;"
+    "    if((packet.instance_id & 0x80000000u) != 0) g_PreviousTransformBuffer[instance_id] = transform;"
+    "}";
+
+double GetElapsedMilliseconds(std::chrono::high_resolution_clock::time_point const &start)
 {
-    GpuScene gpu_scene = {};
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+uint32_t CalculatePoolCapacity(uint32_t capacity, uint32_t required_capacity)
+{
+    if(required_capacity <= capacity)
+    {
+        return capacity;    // large enough
+    }
+
+    return std::max(required_capacity, 2 * capacity);
+}
+
+template<typename TYPE>
+void ResizeBuffer(GfxContext gfx, GfxBuffer &buffer, uint32_t element_count, GfxCpuAccess cpu_access = kGfxCpuAccess_None)
+{
+    if(element_count == 0 || (buffer && buffer.getCount() == element_count))
+    {
+        return; // already the right size
+    }
+
+    GfxBuffer resized_buffer = gfxCreateBuffer<TYPE>(gfx, element_count, nullptr, cpu_access);
+
+    if(buffer)
+    {
+        // Preserve the existing content (not needed for upload buffers, which get rewritten)
+        if(cpu_access == kGfxCpuAccess_None)
+        {
+            uint64_t const copy_size = std::min(buffer.getSize(), resized_buffer.getSize());
+
+            gfxCommandCopyBuffer(gfx, resized_buffer, 0, buffer, 0, copy_size);
+        }
+
+        gfxDestroyBuffer(gfx, buffer);
+    }
+
+    buffer = resized_buffer;
+}
+
+template<typename TYPE>
+void UploadBufferElements(GfxContext gfx, GfxBuffer buffer, std::vector<uint32_t> const &slots, std::vector<TYPE> const &elements)
+{
+    if(slots.empty())
+    {
+        return; // nothing to upload
+    }
+
+    GfxBuffer upload_buffer = gfxCreateBuffer<TYPE>(gfx, (uint32_t)elements.size(), elements.data(), kGfxCpuAccess_Write);
 
-    // Load our materials
+    for(size_t i = 0; i < slots.size();)
+    {
+        // Coalesce runs of consecutive slots into a single copy
+        size_t j = i + 1;
+
+        while(j < slots.size() && slots[j] == slots[j - 1] + 1)
+        {
+            ++j;
+        }
+
+        gfxCommandCopyBuffer(gfx, buffer, slots[i] * sizeof(TYPE), upload_buffer, i * sizeof(TYPE), (j - i) * sizeof(TYPE));
+
+        i = j;
+    }
+
+    gfxDestroyBuffer(gfx, upload_buffer);
+}
+
+template<typename TYPE>
+bool IsObjectResident(std::vector<uint64_t> const &object_handles, GfxConstRef<TYPE> const &object_ref)
+{
+    uint32_t const object_id = (uint32_t)object_ref;
+
+    return object_id < object_handles.size() && object_handles[object_id] == (uint64_t)object_ref;
+}
+
+void MarkObjectResident(std::vector<uint64_t> &object_handles, uint32_t object_id, uint64_t object_handle)
+{
+    if(object_id >= object_handles.size())
+    {
+        object_handles.resize(object_id + 1);
+    }
+
+    object_handles[object_id] = object_handle;
+}
+
+void StreamMaterials(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    std::vector<uint32_t> material_slots;
     std::vector<Material> materials;
 
+    // Release the materials that are no longer in the scene
+    for(uint64_t &material_handle : gpu_scene.material_handles)
+    {
+        if(material_handle != 0 && gfxSceneGetMaterial(scene, material_handle) == nullptr)
+        {
+            material_handle = 0;
+        }
+    }
+
+    // And upload the new ones
     for(uint32_t i = 0; i < gfxSceneGetMaterialCount(scene); ++i)
     {
         GfxConstRef<GfxMaterial> material_ref = gfxSceneGetMaterialHandle(scene, i);
 
+        if(IsObjectResident(gpu_scene.material_handles, material_ref))
+        {
+            continue;   // already uploaded
+        }
+
         Material material = {};
         material.albedo                = glm::vec4(glm::vec3(material_ref->albedo),     glm::uintBitsToFloat((uint32_t)material_ref->albedo_map));
         material.metallicity_roughness = glm::vec4(          material_ref->metallicity, glm::uintBitsToFloat((uint32_t)material_ref->metallicity_map),
@@ -69,31 +202,98 @@ GpuScene UploadSceneToGpuMemory(GfxContext gfx, GfxScene scene)
 
         uint32_t const material_id = (uint32_t)material_ref;
 
-        if(material_id >= materials.size())
+        MarkObjectResident(gpu_scene.material_handles, material_id, (uint64_t)material_ref);
+
+        material_slots.push_back(material_id);
+        materials.push_back(material);
+    }
+
+    if(materials.empty())
+    {
+        return; // no new materials
+    }
+
+    uint32_t const material_capacity = CalculatePoolCapacity(gpu_scene.material_buffer.getCount(), (uint32_t)gpu_scene.material_handles.size());
+
+    ResizeBuffer<Material>(gfx, gpu_scene.material_buffer, material_capacity);
+
+    UploadBufferElements(gfx, gpu_scene.material_buffer, material_slots, materials);
+}
+
+void StreamMeshes(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    std::vector<uint32_t> mesh_slots;
+    std::vector<Mesh> meshes;
+
+    // Release the meshes that are no longer in the scene
+    for(uint32_t mesh_id = 0; mesh_id < (uint32_t)gpu_scene.mesh_handles.size(); ++mesh_id)
+    {
+        uint64_t &mesh_handle = gpu_scene.mesh_handles[mesh_id];
+
+        if(mesh_handle == 0 || gfxSceneGetMesh(scene, mesh_handle) != nullptr)
         {
-            materials.resize(material_id + 1);
+            continue;   // still alive
         }
 
-        materials[material_id] = material;
-    }
+        Mesh &mesh = gpu_scene.meshes[mesh_id];
 
-    gpu_scene.material_buffer = gfxCreateBuffer<Material>(gfx, (uint32_t)materials.size(), materials.data());
+        gpu_scene.index_allocator.free(mesh.first_index, mesh.count);
+        gpu_scene.vertex_allocator.free(mesh.base_vertex, mesh.vertex_count);
 
-    // Load our meshes
-    uint32_t first_index = 0;
-    uint32_t base_vertex = 0;
+        if(mesh.base_joint != kInvalidJoint)
+        {
+            gpu_scene.joint_allocator.free(mesh.base_joint, mesh.vertex_count);
+        }
+
+        mesh        = {};
+        mesh_handle = 0;
+    }
 
+    // Allocate space for the new ones, growing the pools as needed
     for(uint32_t i = 0; i < gfxSceneGetMeshCount(scene); ++i)
     {
         GfxConstRef<GfxMesh> mesh_ref = gfxSceneGetMeshHandle(scene, i);
 
+        if(IsObjectResident(gpu_scene.mesh_handles, mesh_ref))
+        {
+            continue;   // already uploaded
+        }
+
         Mesh mesh = {};
-        mesh.count       = (uint32_t)mesh_ref->indices.size();
-        mesh.first_index = first_index;
-        mesh.base_vertex = base_vertex;
+        mesh.count        = (uint32_t)mesh_ref->indices.size();
+        mesh.vertex_count = (uint32_t)mesh_ref->vertices.size();
+        mesh.base_joint   = kInvalidJoint;
+
+        if(!gpu_scene.index_allocator.allocate(mesh.count, mesh.first_index))
+        {
+            uint32_t const index_capacity = gpu_scene.index_allocator.getCapacity();
+
+            gpu_scene.index_allocator.grow(CalculatePoolCapacity(index_capacity, index_capacity + mesh.count));
+            gpu_scene.index_allocator.allocate(mesh.count, mesh.first_index);
+        }
+
+        if(!gpu_scene.vertex_allocator.allocate(mesh.vertex_count, mesh.base_vertex))
+        {
+            uint32_t const vertex_capacity = gpu_scene.vertex_allocator.getCapacity();
+
+            gpu_scene.vertex_allocator.grow(CalculatePoolCapacity(vertex_capacity, vertex_capacity + mesh.vertex_count));
+            gpu_scene.vertex_allocator.allocate(mesh.vertex_count, mesh.base_vertex);
+        }
+
+        // Skinned meshes also get a joint stream, laid out like their vertices
+        if(!mesh_ref->joints.empty() && mesh_ref->joints.size() == mesh_ref->vertices.size() &&
+           !gpu_scene.joint_allocator.allocate(mesh.vertex_count, mesh.base_joint))
+        {
+            uint32_t const joint_capacity = gpu_scene.joint_allocator.getCapacity();
+
+            gpu_scene.joint_allocator.grow(CalculatePoolCapacity(joint_capacity, joint_capacity + mesh.vertex_count));
+            gpu_scene.joint_allocator.allocate(mesh.vertex_count, mesh.base_joint);
+        }
 
         uint32_t const mesh_id = (uint32_t)mesh_ref;
 
+        MarkObjectResident(gpu_scene.mesh_handles, mesh_id, (uint64_t)mesh_ref);
+
         if(mesh_id >= gpu_scene.meshes.size())
         {
             gpu_scene.meshes.resize(mesh_id + 1);
@@ -101,162 +301,1099 @@ GpuScene UploadSceneToGpuMemory(GfxContext gfx, GfxScene scene)
 
         gpu_scene.meshes[mesh_id] = mesh;
 
-        first_index += (uint32_t)mesh_ref->indices.size();
-        base_vertex += (uint32_t)mesh_ref->vertices.size();
+        mesh_slots.push_back(mesh_id);
+        meshes.push_back(mesh);
+    }
+
+    if(meshes.empty())
+    {
+        return; // no new meshes
     }
 
-    gpu_scene.mesh_buffer = gfxCreateBuffer<Mesh>(gfx, (uint32_t)gpu_scene.meshes.size(), gpu_scene.meshes.data());
+    uint32_t const mesh_capacity = CalculatePoolCapacity(gpu_scene.mesh_buffer.getCount(), (uint32_t)gpu_scene.meshes.size());
 
-    // Load our vertices
-    std::vector<uint32_t> indices;
-    std::vector<Vertex> vertices;
+    ResizeBuffer<Mesh>(gfx, gpu_scene.mesh_buffer, mesh_capacity);
+    ResizeBuffer<uint32_t>(gfx, gpu_scene.index_buffer, gpu_scene.index_allocator.getCapacity());
+    ResizeBuffer<Vertex>(gfx, gpu_scene.vertex_buffer, gpu_scene.vertex_allocator.getCapacity());
+    ResizeBuffer<GfxJoint>(gfx, gpu_scene.joint_buffer, gpu_scene.joint_allocator.getCapacity());
 
-    for(uint32_t i = 0; i < gfxSceneGetMeshCount(scene); ++i)
+    UploadBufferElements(gfx, gpu_scene.mesh_buffer, mesh_slots, meshes);
+
+    // Lay out the new vertices and indices contiguously in the staging buffers
+    auto const pack_start = std::chrono::high_resolution_clock::now();
+
+    std::vector<GfxMesh const *> mesh_objects(mesh_slots.size());
+    std::vector<uint32_t> staging_index_offsets(mesh_slots.size());
+    std::vector<uint32_t> staging_vertex_offsets(mesh_slots.size());
+    std::vector<uint32_t> staging_joint_offsets(mesh_slots.size());
+
+    uint32_t index_count  = 0;
+    uint32_t vertex_count = 0;
+    uint32_t joint_count  = 0;
+
+    for(size_t i = 0; i < mesh_slots.size(); ++i)
     {
-        GfxConstRef<GfxMesh> mesh_ref = gfxSceneGetMeshHandle(scene, i);
+        mesh_objects[i] = gfxSceneGetMesh(scene, gpu_scene.mesh_handles[mesh_slots[i]]);
+
+        staging_index_offsets[i]  = index_count;
+        staging_vertex_offsets[i] = vertex_count;
+        staging_joint_offsets[i]  = joint_count;
 
-        std::vector<uint32_t> const &index_buffer = mesh_ref->indices;
+        index_count  += meshes[i].count;
+        vertex_count += meshes[i].vertex_count;
 
-        for(uint32_t index : index_buffer)
+        if(meshes[i].base_joint != kInvalidJoint)
         {
-            indices.push_back(index);
+            joint_count += meshes[i].vertex_count;
         }
+    }
+
+    GfxBuffer upload_index_buffer  = gfxCreateBuffer<uint32_t>(gfx, std::max(index_count, 1u), nullptr, kGfxCpuAccess_Write);
+    GfxBuffer upload_vertex_buffer = gfxCreateBuffer<Vertex>(gfx, std::max(vertex_count, 1u), nullptr, kGfxCpuAccess_Write);
+    GfxBuffer upload_joint_buffer  = gfxCreateBuffer<GfxJoint>(gfx, std::max(joint_count, 1u), nullptr, kGfxCpuAccess_Write);
+
+    uint32_t *upload_indices  = gfxBufferGetData<uint32_t>(gfx, upload_index_buffer);
+    Vertex   *upload_vertices = gfxBufferGetData<Vertex>(gfx, upload_vertex_buffer);
+    GfxJoint *upload_joints   = gfxBufferGetData<GfxJoint>(gfx, upload_joint_buffer);
+
+    // Pack the meshes straight into mapped memory from the job system's threads
+    gfxGetJobSystem().parallel_for((uint32_t)mesh_slots.size(), 1, [&](uint32_t i)
+    {
+        GfxMesh const &mesh_object = *mesh_objects[i];
+
+        std::copy(mesh_object.indices.begin(), mesh_object.indices.end(), upload_indices + staging_index_offsets[i]);
+
+        Vertex *vertices = upload_vertices + staging_vertex_offsets[i];
+
+        for(GfxVertex const &vertex : mesh_object.vertices)
+        {
+            vertices->position = glm::vec4(vertex.position, 1.0f);
+            vertices->normal   = glm::vec4(vertex.normal,   0.0f);
+            vertices->uv       = glm::vec2(vertex.uv);
 
-        std::vector<GfxVertex> const &vertex_buffer = mesh_ref->vertices;
+            ++vertices;
+        }
 
-        for(GfxVertex vertex : vertex_buffer)
+        if(meshes[i].base_joint != kInvalidJoint)
         {
-            Vertex gpu_vertex = {};
+            std::copy(mesh_object.joints.begin(), mesh_object.joints.end(), upload_joints + staging_joint_offsets[i]);
+        }
+    });
+
+    gpu_scene.upload_timings.mesh_packing_ms += GetElapsedMilliseconds(pack_start);
 
-            gpu_vertex.position = glm::vec4(vertex.position, 1.0f);
-            gpu_vertex.normal   = glm::vec4(vertex.normal,   0.0f);
-            gpu_vertex.uv       = glm::vec2(vertex.uv);
+    // And copy each mesh into its pool ranges
+    for(size_t i = 0; i < mesh_slots.size(); ++i)
+    {
+        Mesh const &mesh = meshes[i];
+
+        gfxCommandCopyBuffer(gfx, gpu_scene.index_buffer, mesh.first_index * sizeof(uint32_t), upload_index_buffer, staging_index_offsets[i] * sizeof(uint32_t), mesh.count * sizeof(uint32_t));
+        gfxCommandCopyBuffer(gfx, gpu_scene.vertex_buffer, mesh.base_vertex * sizeof(Vertex), upload_vertex_buffer, staging_vertex_offsets[i] * sizeof(Vertex), mesh.vertex_count * sizeof(Vertex));
 
-            vertices.push_back(gpu_vertex);
+        if(mesh.base_joint != kInvalidJoint)
+        {
+            gfxCommandCopyBuffer(gfx, gpu_scene.joint_buffer, mesh.base_joint * sizeof(GfxJoint), upload_joint_buffer, staging_joint_offsets[i] * sizeof(GfxJoint), mesh.vertex_count * sizeof(GfxJoint));
         }
     }
 
-    gpu_scene.index_buffer  = gfxCreateBuffer<uint32_t>(gfx, (uint32_t)indices.size(), indices.data());
-    gpu_scene.vertex_buffer = gfxCreateBuffer<Vertex>(gfx, (uint32_t)vertices.size(), vertices.data());
+    gfxDestroyBuffer(gfx, upload_index_buffer);
+    gfxDestroyBuffer(gfx, upload_vertex_buffer);
+    gfxDestroyBuffer(gfx, upload_joint_buffer);
+}
+
+void StreamInstances(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    std::vector<uint32_t> instance_slots;
+    std::vector<Instance> instances;
 
-    // Load our instances
-    std::vector<Instance>  instances;
-    std::vector<glm::mat4> transforms;
+    // Release the instances that are no longer in the scene
+    for(uint64_t &instance_handle : gpu_scene.instance_handles)
+    {
+        if(instance_handle != 0 && gfxSceneGetInstance(scene, instance_handle) == nullptr)
+        {
+            instance_handle = 0;
+        }
+    }
 
+    // And upload the new ones
     for(uint32_t i = 0; i < gfxSceneGetInstanceCount(scene); ++i)
     {
         GfxConstRef<GfxInstance> const instance_ref = gfxSceneGetInstanceHandle(scene, i);
 
+        if(IsObjectResident(gpu_scene.instance_handles, instance_ref))
+        {
+            continue;   // already uploaded
+        }
+
         Instance instance    = {};
         instance.mesh_id     = (uint32_t)instance_ref->mesh;
         instance.material_id = (uint32_t)instance_ref->material;
+        instance.skin_id     = (instance_ref->skin ? (uint32_t)instance_ref->skin : kInvalidJoint);
 
         uint32_t const instance_id = (uint32_t)instance_ref;
 
-        if(instance_id >= instances.size())
+        MarkObjectResident(gpu_scene.instance_handles, instance_id, (uint64_t)instance_ref);
+
+        if(instance_id >= gpu_scene.transforms.size())
         {
-            instances.resize(instance_id + 1);
-            transforms.resize(instance_id + 1);
+            gpu_scene.transforms.resize(instance_id + 1);
         }
 
-        instances[instance_id]  = instance;
-        transforms[instance_id] = instance_ref->transform;
+        gpu_scene.transforms[instance_id] = instance_ref->transform;
+
+        gpu_scene.new_instances.push_back(instance_id);
+
+        instance_slots.push_back(instance_id);
+        instances.push_back(instance);
     }
 
-    gpu_scene.instance_buffer           = gfxCreateBuffer<Instance>(gfx, (uint32_t)instances.size(), instances.data());
-    gpu_scene.transform_buffer          = gfxCreateBuffer<glm::mat4>(gfx, (uint32_t)transforms.size(), transforms.data());
-    gpu_scene.previous_transform_buffer = gfxCreateBuffer<glm::mat4>(gfx, (uint32_t)transforms.size(), transforms.data());
+    if(instances.empty())
+    {
+        return; // no new instances
+    }
+
+    uint32_t const instance_capacity = CalculatePoolCapacity(gpu_scene.instance_buffer.getCount(), (uint32_t)gpu_scene.instance_handles.size());
+
+    ResizeBuffer<Instance>(gfx, gpu_scene.instance_buffer, instance_capacity);
+    ResizeBuffer<glm::mat4>(gfx, gpu_scene.transform_buffer, instance_capacity);
+    ResizeBuffer<glm::mat4>(gfx, gpu_scene.previous_transform_buffer, instance_capacity);
 
     for(GfxBuffer &upload_transform_buffer : gpu_scene.upload_transform_buffers)
     {
-        upload_transform_buffer = gfxCreateBuffer<glm::mat4>(gfx, (uint32_t)transforms.size(), nullptr, kGfxCpuAccess_Write);
+        ResizeBuffer<TransformPacket>(gfx, upload_transform_buffer, 2 * instance_capacity, kGfxCpuAccess_Write); // an instance may be both moved and re-added
     }
 
-    for(uint32_t i = 0; i < gfxSceneGetImageCount(scene); ++i)
+    UploadBufferElements(gfx, gpu_scene.instance_buffer, instance_slots, instances);
+}
+
+bool IsAtlasCompatible(GfxImage const &image)
+{
+    bool const is_rgba8 = (image.format == DXGI_FORMAT_R8G8B8A8_UNORM || image.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+
+    return is_rgba8 && (image.flags & kGfxImageFlag_HasMipLevels) == 0 &&
+           image.width <= kMaxAtlasImageSize && image.height <= kMaxAtlasImageSize &&
+           image.data.size() == (size_t)image.width * image.height * 4;
+}
+
+uint64_t CalculateTextureMemory(uint32_t width, uint32_t height, uint32_t bytes_per_pixel)
+{
+    uint64_t size = 0;
+
+    for(uint32_t mip_level = 0; mip_level < gfxCalculateMipCount(width, height); ++mip_level)
     {
-        GfxConstRef<GfxImage> const image_ref = gfxSceneGetImageHandle(scene, i);
+        size += (uint64_t)std::max(width >> mip_level, 1u) * std::max(height >> mip_level, 1u) * bytes_per_pixel;
+    }
+
+    return GFX_ALIGN(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+}
 
-        GfxTexture texture = gfxCreateTexture2D(gfx, image_ref->width, image_ref->height, image_ref->format, gfxCalculateMipCount(image_ref->width, image_ref->height));
+uint32_t AllocateTextureSlot(GpuScene &gpu_scene)
+{
+    uint32_t texture_id = 0;
 
-        uint32_t const texture_size = image_ref->width * image_ref->height * image_ref->channel_count * image_ref->bytes_per_channel;
+    if(!gpu_scene.texture_allocator.allocate(1, texture_id))
+    {
+        uint32_t const texture_capacity = gpu_scene.texture_allocator.getCapacity();
 
-        GfxBuffer upload_texture_buffer = gfxCreateBuffer(gfx, texture_size, image_ref->data.data(), kGfxCpuAccess_Write);
+        gpu_scene.texture_allocator.grow(CalculatePoolCapacity(texture_capacity, texture_capacity + 1));
+        gpu_scene.texture_allocator.allocate(1, texture_id);
+    }
 
-        gfxCommandCopyBufferToTexture(gfx, texture, upload_texture_buffer);
-        gfxDestroyBuffer(gfx, upload_texture_buffer);
-        gfxCommandGenerateMips(gfx, texture);
+    if(texture_id >= gpu_scene.textures.size())
+    {
+        gpu_scene.textures.resize(gpu_scene.texture_allocator.getCapacity());
+        gpu_scene.texture_image_counts.resize(gpu_scene.texture_allocator.getCapacity());
+    }
 
-        uint32_t const image_id = (uint32_t)image_ref;
+    return texture_id;
+}
 
-        if(image_id >= gpu_scene.textures.size())
+void StreamTextures(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    // Release the images that are no longer in the scene, and their texture once no other image uses it
+    for(uint32_t image_id = 0; image_id < (uint32_t)gpu_scene.image_handles.size(); ++image_id)
+    {
+        uint64_t &image_handle = gpu_scene.image_handles[image_id];
+
+        if(image_handle == 0 || gfxSceneGetImage(scene, image_handle) != nullptr)
+        {
+            continue;   // still alive
+        }
+
+        uint32_t const texture_id = gpu_scene.texture_regions[image_id].texture_id;
+
+        if(--gpu_scene.texture_image_counts[texture_id] == 0)
         {
-            gpu_scene.textures.resize(image_id + 1);
+            gfxDestroyTexture(gfx, gpu_scene.textures[texture_id]);
+
+            gpu_scene.textures[texture_id] = GfxTexture();
+
+            gpu_scene.texture_allocator.free(texture_id, 1);
         }
 
-        gpu_scene.textures[image_id] = texture;
+        image_handle = 0;
     }
 
-    gpu_scene.texture_sampler = gfxCreateSamplerState(gfx, D3D12_FILTER_ANISOTROPIC, D3D12_TEXTURE_ADDRESS_MODE_WRAP, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+    // Gather the new images, setting aside the small ones to be packed into atlases
+    struct AtlasGroup
+    {
+        DXGI_FORMAT           format;
+        std::vector<uint32_t> image_slots;
+        std::vector<uint64_t> staging_offsets;  // one per atlas
+        TextureAtlasPacker    packer;
+        uint32_t              atlas_count;
+    };
 
-    return gpu_scene;
-}
+    std::vector<uint32_t> image_slots;
+    std::vector<uint64_t> staging_offsets;
+    std::vector<AtlasGroup> atlas_groups;
 
-void ReleaseGpuScene(GfxContext gfx, GpuScene const &gpu_scene)
-{
-    gfxDestroyBuffer(gfx, gpu_scene.mesh_buffer);
-    gfxDestroyBuffer(gfx, gpu_scene.index_buffer);
-    gfxDestroyBuffer(gfx, gpu_scene.vertex_buffer);
-    gfxDestroyBuffer(gfx, gpu_scene.instance_buffer);
-    gfxDestroyBuffer(gfx, gpu_scene.material_buffer);
-    gfxDestroyBuffer(gfx, gpu_scene.transform_buffer);
-    gfxDestroyBuffer(gfx, gpu_scene.previous_transform_buffer);
+    uint64_t staging_size = 0;
 
-    for(GfxBuffer upload_transform_buffer : gpu_scene.upload_transform_buffers)
+    for(uint32_t i = 0; i < gfxSceneGetImageCount(scene); ++i)
     {
-        gfxDestroyBuffer(gfx, upload_transform_buffer);
+        GfxConstRef<GfxImage> const image_ref = gfxSceneGetImageHandle(scene, i);
+
+        if(IsObjectResident(gpu_scene.image_handles, image_ref))
+        {
+            continue;   // already uploaded
+        }
+
+        uint32_t const image_id = (uint32_t)image_ref;
+
+        MarkObjectResident(gpu_scene.image_handles, image_id, (uint64_t)image_ref);
+
+        if(IsAtlasCompatible(*image_ref))
+        {
+            size_t group_index = 0;
+
+            while(group_index < atlas_groups.size() && atlas_groups[group_index].format != image_ref->format)
+            {
+                ++group_index;
+            }
+
+            if(group_index == atlas_groups.size())
+            {
+                atlas_groups.emplace_back().format = image_ref->format;
+            }
+
+            atlas_groups[group_index].image_slots.push_back(image_id);
+
+            continue;
+        }
+
+        image_slots.push_back(image_id);
+        staging_offsets.push_back(staging_size);
+
+        staging_size += GFX_ALIGN((uint64_t)image_ref->data.size(), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
     }
 
-    for(GfxTexture texture : gpu_scene.textures)
+    if(image_slots.empty() && atlas_groups.empty())
     {
-        gfxDestroyTexture(gfx, texture);
+        return; // no new images
     }
 
-    gfxDestroySamplerState(gfx, gpu_scene.texture_sampler);
-}
+    // Pack the small images; the ones left out, or whose atlases would take more memory than they
+    // would on their own, get a texture of their own instead
+    auto const pack_start = std::chrono::high_resolution_clock::now();
 
-void UpdateGpuScene(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
-{
-    GfxBuffer upload_transform_buffer = gpu_scene.upload_transform_buffers[gfxGetBackBufferIndex(gfx)];
+    std::vector<std::pair<uint32_t, uint32_t>> atlas_copies;    // (group, image) pairs
 
-    glm::mat4 *transforms = gfxBufferGetData<glm::mat4>(gfx, upload_transform_buffer);
+    for(uint32_t group_index = 0; group_index < (uint32_t)atlas_groups.size(); ++group_index)
+    {
+        AtlasGroup &group = atlas_groups[group_index];
 
-    uint32_t const instance_count = gfxSceneGetInstanceCount(scene);
+        std::vector<AtlasImage> atlas_images;
 
-    for(uint32_t i = 0; i < instance_count; ++i)
-    {
-        GfxConstRef<GfxInstance> const instance_ref = gfxSceneGetInstanceHandle(scene, i);
+        for(uint32_t image_id : group.image_slots)
+        {
+            GfxImage const *image = gfxSceneGetImage(scene, gpu_scene.image_handles[image_id]);
 
-        uint32_t const instance_id = (uint32_t)instance_ref;
+            atlas_images.push_back({ image->width, image->height });
+        }
+
+        group.atlas_count = group.packer.pack(atlas_images.data(), (uint32_t)atlas_images.size(), kMaxAtlasSize,
+                                              TextureAtlasPacker::kDefaultBorder, kMaxAtlasWaste);
+
+        uint64_t atlas_bytes = 0;
+        uint64_t standalone_bytes = 0;
+
+        for(uint32_t j = 0; j < group.atlas_count; ++j)
+        {
+            atlas_bytes += CalculateTextureMemory(group.packer.getAtlasWidth(), group.packer.getAtlasHeight(j), 4);
+        }
+
+        for(uint32_t j = 0; j < (uint32_t)group.image_slots.size(); ++j)
+        {
+            if(group.packer.getPlacements()[j].atlas != TextureAtlasPacker::kInvalidAtlas)
+            {
+                standalone_bytes += CalculateTextureMemory(atlas_images[j].width, atlas_images[j].height, 4);
+            }
+        }
 
-        transforms[instance_id] = instance_ref->transform;
+        bool const is_worth_packing = (atlas_bytes < standalone_bytes);
+
+        if(!is_worth_packing)
+        {
+            group.atlas_count = 0;
+        }
+
+        uint32_t packed_image_count = 0;
+
+        for(uint32_t j = 0; j < (uint32_t)group.image_slots.size(); ++j)
+        {
+            if(is_worth_packing && group.packer.getPlacements()[j].atlas != TextureAtlasPacker::kInvalidAtlas)
+            {
+                atlas_copies.emplace_back(group_index, j);
+
+                ++packed_image_count;
+
+                continue;
+            }
+
+            uint32_t const image_id = group.image_slots[j];
+
+            image_slots.push_back(image_id);
+            staging_offsets.push_back(staging_size);
+
+            staging_size += GFX_ALIGN((uint64_t)atlas_images[j].width * atlas_images[j].height * 4, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        }
+
+        for(uint32_t j = 0; j < group.atlas_count; ++j)
+        {
+            group.staging_offsets.push_back(staging_size);
+
+            staging_size += GFX_ALIGN((uint64_t)group.packer.getAtlasWidth() * group.packer.getAtlasHeight(j) * 4, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        }
+
+        if(group.atlas_count > 0)
+        {
+            gpu_scene.texture_stats.packed_image_count += packed_image_count;
+            gpu_scene.texture_stats.atlas_count += group.atlas_count;
+            gpu_scene.texture_stats.saved_bytes += standalone_bytes - atlas_bytes;
+        }
     }
 
-    gfxCommandCopyBuffer(gfx, gpu_scene.previous_transform_buffer, gpu_scene.transform_buffer);
+    // Copy all the texels into a single staging buffer
+    GfxBuffer upload_texture_buffer = gfxCreateBuffer(gfx, staging_size, nullptr, kGfxCpuAccess_Write);
 
-    gfxCommandCopyBuffer(gfx, gpu_scene.transform_buffer, upload_transform_buffer);
-}
+    uint8_t *upload_texels = (uint8_t *)gfxBufferGetData(gfx, upload_texture_buffer);
 
-void BindGpuScene(GfxContext gfx, GfxProgram program, GpuScene const &gpu_scene)
-{
-    gfxProgramSetParameter(gfx, program, "g_MeshBuffer", gpu_scene.mesh_buffer);
-    gfxProgramSetParameter(gfx, program, "g_IndexBuffer", gpu_scene.index_buffer);
-    gfxProgramSetParameter(gfx, program, "g_VertexBuffer", gpu_scene.vertex_buffer);
-    gfxProgramSetParameter(gfx, program, "g_InstanceBuffer", gpu_scene.instance_buffer);
-    gfxProgramSetParameter(gfx, program, "g_MaterialBuffer", gpu_scene.material_buffer);
-    gfxProgramSetParameter(gfx, program, "g_TransformBuffer", gpu_scene.transform_buffer);
-    gfxProgramSetParameter(gfx, program, "g_PreviousTransformBuffer", gpu_scene.previous_transform_buffer);
+    gfxGetJobSystem().parallel_for((uint32_t)(image_slots.size() + atlas_copies.size()), 1, [&](uint32_t i)
+    {
+        if(i < (uint32_t)image_slots.size())
+        {
+            GfxImage const *image = gfxSceneGetImage(scene, gpu_scene.image_handles[image_slots[i]]);
 
-    gfxProgramSetParameter(gfx, program, "g_Textures", gpu_scene.textures.data(), (uint32_t)gpu_scene.textures.size());
+            std::copy(image->data.begin(), image->data.end(), upload_texels + staging_offsets[i]);
+
+            return;
+        }
+
+        AtlasGroup const &group = atlas_groups[atlas_copies[i - image_slots.size()].first];
+
+        uint32_t const j = atlas_copies[i - image_slots.size()].second;
+
+        GfxImage const *image = gfxSceneGetImage(scene, gpu_scene.image_handles[group.image_slots[j]]);
+
+        group.packer.copyImage(j, image->data.data(), 4, upload_texels + group.staging_offsets[group.packer.getPlacements()[j].atlas]);
+    });
+
+    gpu_scene.upload_timings.texture_packing_ms += GetElapsedMilliseconds(pack_start);
+
+    // And create the textures from it
+    std::vector<uint32_t> region_slots;
+    std::vector<TextureRegion> regions;
+
+    for(size_t i = 0; i < image_slots.size(); ++i)
+    {
+        uint32_t const image_id = image_slots[i];
+
+        GfxImage const *image = gfxSceneGetImage(scene, gpu_scene.image_handles[image_id]);
+
+        bool const has_mip_levels = ((image->flags & kGfxImageFlag_HasMipLevels) != 0);
+
+        GfxTexture texture = gfxCreateTexture2D(gfx, image->width, image->height, image->format, gfxCalculateMipCount(image->width, image->height));
+
+        if(!image->data.empty())
+        {
+            GfxBuffer texture_data = gfxCreateBufferRange(gfx, upload_texture_buffer, staging_offsets[i], image->data.size());
+
+            gfxCommandCopyBufferToTexture(gfx, texture, texture_data);
+            gfxDestroyBuffer(gfx, texture_data);
+        }
+
+        if(!has_mip_levels)
+        {
+            gfxCommandGenerateMips(gfx, texture);   // the image only carries its top level
+        }
+
+        uint32_t const texture_id = AllocateTextureSlot(gpu_scene);
+
+        gpu_scene.textures[texture_id] = texture;
+        gpu_scene.texture_image_counts[texture_id] = 1;
+
+        TextureRegion region = {};
+        region.scale_offset = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+        region.texture_size = glm::vec2((float)image->width, (float)image->height);
+        region.max_lod      = -1.0f;    // sampled directly
+        region.texture_id   = texture_id;
+
+        region_slots.push_back(image_id);
+        regions.push_back(region);
+    }
+
+    for(AtlasGroup const &group : atlas_groups)
+    {
+        uint32_t const atlas_width = group.packer.getAtlasWidth();
+
+        std::vector<uint32_t> atlas_texture_ids(group.atlas_count);
+        std::vector<uint32_t> atlas_heights(group.atlas_count);
+
+        for(uint32_t j = 0; j < group.atlas_count; ++j)
+        {
+            atlas_heights[j] = group.packer.getAtlasHeight(j);
+
+            GfxTexture texture = gfxCreateTexture2D(gfx, atlas_width, atlas_heights[j], group.format, gfxCalculateMipCount(atlas_width, atlas_heights[j]));
+
+            GfxBuffer texture_data = gfxCreateBufferRange(gfx, upload_texture_buffer, group.staging_offsets[j], (uint64_t)atlas_width * atlas_heights[j] * 4);
+
+            gfxCommandCopyBufferToTexture(gfx, texture, texture_data);
+            gfxCommandGenerateMips(gfx, texture);
+            gfxDestroyBuffer(gfx, texture_data);
+
+            atlas_texture_ids[j] = AllocateTextureSlot(gpu_scene);
+
+            gpu_scene.textures[atlas_texture_ids[j]] = texture;
+            gpu_scene.texture_image_counts[atlas_texture_ids[j]] = 0;
+        }
+
+        for(uint32_t j = 0; j < (uint32_t)group.image_slots.size() && group.atlas_count > 0; ++j)
+        {
+            uint32_t const image_id = group.image_slots[j];
+
+            GfxImage const *image = gfxSceneGetImage(scene, gpu_scene.image_handles[image_id]);
+
+            AtlasPlacement const &placement = group.packer.getPlacements()[j];
+
+            if(placement.atlas == TextureAtlasPacker::kInvalidAtlas)
+            {
+                continue;   // has a texture of its own
+            }
+
+            uint32_t const texture_id = atlas_texture_ids[placement.atlas];
+
+            ++gpu_scene.texture_image_counts[texture_id];
+
+            float const rcp_atlas_width = 1.0f / (float)atlas_width;
+            float const rcp_atlas_height = 1.0f / (float)atlas_heights[placement.atlas];
+
+            TextureRegion region = {};
+            region.scale_offset = glm::vec4((float)image->width * rcp_atlas_width, (float)image->height * rcp_atlas_height,
+                                            (float)placement.x * rcp_atlas_width, (float)placement.y * rcp_atlas_height);
+            region.texture_size = glm::vec2((float)image->width, (float)image->height);
+            region.max_lod      = (float)placement.max_lod;
+            region.texture_id   = texture_id;
+
+            region_slots.push_back(image_id);
+            regions.push_back(region);
+        }
+    }
+
+    gfxDestroyBuffer(gfx, upload_texture_buffer);
+
+    // Publish where each image now lives
+    if(gpu_scene.texture_regions.size() < gpu_scene.image_handles.size())
+    {
+        gpu_scene.texture_regions.resize(gpu_scene.image_handles.size());
+    }
+
+    for(size_t i = 0; i < region_slots.size(); ++i)
+    {
+        gpu_scene.texture_regions[region_slots[i]] = regions[i];
+    }
+
+    uint32_t const region_capacity = CalculatePoolCapacity(gpu_scene.texture_region_buffer.getCount(), (uint32_t)gpu_scene.image_handles.size());
+
+    ResizeBuffer<TextureRegion>(gfx, gpu_scene.texture_region_buffer, region_capacity);
+
+    UploadBufferElements(gfx, gpu_scene.texture_region_buffer, region_slots, regions);
+}
+
+void UpdateTransforms(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    std::vector<uint32_t> &packet_instances = gpu_scene.transform_packet_instances;
+
+    packet_instances = gpu_scene.dirty_instances;
+
+    gpu_scene.dirty_instances.clear();
+
+    // Pick up the instances that the scene recorded as modified since the last update, so that
+    // a static scene costs nothing here
+    auto const transform_start = std::chrono::high_resolution_clock::now();
+
+    uint64_t const *modified_instances = gfxSceneGetModifiedInstances(scene);
+
+    uint32_t const modified_instance_count = gfxSceneGetModifiedInstanceCount(scene);
+
+    for(uint32_t i = 0; i < modified_instance_count; ++i)
+    {
+        GfxInstance const *instance = gfxSceneGetInstance(scene, modified_instances[i]);
+
+        uint32_t const instance_id = (uint32_t)modified_instances[i];
+
+        if(instance == nullptr || instance_id >= gpu_scene.transforms.size())
+        {
+            continue;   // destroyed, or not streamed in yet
+        }
+
+        if(instance->transform == gpu_scene.transforms[instance_id])
+        {
+            continue;   // instance didn't move
+        }
+
+        gpu_scene.transforms[instance_id] = instance->transform;
+
+        gpu_scene.dirty_instances.push_back(instance_id);
+    }
+
+    gfxSceneClearModifiedInstances(scene);
+
+    packet_instances.insert(packet_instances.end(), gpu_scene.dirty_instances.begin(), gpu_scene.dirty_instances.end());
+
+    std::sort(packet_instances.begin(), packet_instances.end());
+
+    packet_instances.erase(std::unique(packet_instances.begin(), packet_instances.end()), packet_instances.end());
+
+    // New instances go into both the current and previous transform buffers
+    for(uint32_t instance_id : gpu_scene.new_instances)
+    {
+        packet_instances.push_back(instance_id | kTransformPacket_WritePrevious);
+    }
+
+    gpu_scene.new_instances.clear();
+
+    gpu_scene.upload_timings.transform_ms += GetElapsedMilliseconds(transform_start);
+
+    if(packet_instances.empty())
+    {
+        return; // nothing to upload
+    }
+
+    // Pack the (index, 3x4 transform) pairs for the modified instances
+    GfxBuffer upload_transform_buffer = gpu_scene.upload_transform_buffers[gfxGetBackBufferIndex(gfx)];
+
+    TransformPacket *packets = gfxBufferGetData<TransformPacket>(gfx, upload_transform_buffer);
+
+    uint32_t const packet_count = std::min((uint32_t)packet_instances.size(), upload_transform_buffer.getCount());
+
+    auto const packing_start = std::chrono::high_resolution_clock::now();
+
+    for(uint32_t i = 0; i < packet_count; ++i)
+    {
+        uint32_t const instance_id = (packet_instances[i] & ~kTransformPacket_WritePrevious);
+
+        glm::mat4 const transform = glm::transpose(gpu_scene.transforms[instance_id]);
+
+        packets[i].instance_id = packet_instances[i];
+        packets[i].rows[0]     = transform[0];
+        packets[i].rows[1]     = transform[1];
+        packets[i].rows[2]     = transform[2];
+    }
+
+    gpu_scene.upload_timings.transform_packing_ms += GetElapsedMilliseconds(packing_start);
+
+    // And scatter them into the transform buffers
+    gfxProgramSetParameter(gfx, gpu_scene.transform_program, "g_TransformPacketBuffer", upload_transform_buffer);
+    gfxProgramSetParameter(gfx, gpu_scene.transform_program, "g_TransformBuffer", gpu_scene.transform_buffer);
+    gfxProgramSetParameter(gfx, gpu_scene.transform_program, "g_PreviousTransformBuffer", gpu_scene.previous_transform_buffer);
+    gfxProgramSetParameter(gfx, gpu_scene.transform_program, "g_TransformPacketCount", packet_count);
+
+    uint32_t const *num_threads = gfxKernelGetNumThreads(gfx, gpu_scene.transform_kernel);
+    uint32_t const num_groups   = (packet_count + num_threads[0] - 1) / num_threads[0];
+
+    gfxCommandBindKernel(gfx, gpu_scene.transform_kernel);
+    gfxCommandDispatch(gfx, num_groups, 1, 1);
+}
+
+void UpdateSkins(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    JointPalette &joint_palette = gpu_scene.joint_palette;
+
+    // Release the skins that are no longer in the scene
+    std::vector<uint64_t> const &skin_handles = joint_palette.getSkinHandles();
+
+    for(uint32_t skin_id = 0; skin_id < (uint32_t)skin_handles.size(); ++skin_id)
+    {
+        if(skin_handles[skin_id] != 0 && gfxSceneGetSkin(scene, skin_handles[skin_id]) == nullptr)
+        {
+            joint_palette.releaseSkin(skin_id);
+        }
+    }
+
+    // Find the skins that were added or animated since the last update
+    std::vector<uint32_t> skin_slots;
+    std::vector<uint32_t> skin_offsets;
+
+    for(uint32_t i = 0; i < gfxSceneGetSkinCount(scene); ++i)
+    {
+        GfxConstRef<GfxSkin> const skin_ref = gfxSceneGetSkinHandle(scene, i);
+
+        uint32_t const skin_id = (uint32_t)skin_ref;
+
+        if(joint_palette.updateSkin(skin_id, (uint64_t)skin_ref, skin_ref->joint_matrices.data(), (uint32_t)skin_ref->joint_matrices.size()))
+        {
+            skin_slots.push_back(skin_id);
+            skin_offsets.push_back(joint_palette.getSkinRange(skin_id).offset);
+        }
+    }
+
+    std::vector<uint32_t> const &dirty_skins = joint_palette.getDirtySkins();
+
+    if(dirty_skins.empty())
+    {
+        return; // nothing to upload
+    }
+
+    uint32_t const joint_capacity = joint_palette.getCapacity();
+
+    ResizeBuffer<JointRows>(gfx, gpu_scene.joint_palette_buffer, joint_capacity);
+
+    for(GfxBuffer &upload_joint_palette_buffer : gpu_scene.upload_joint_palette_buffers)
+    {
+        ResizeBuffer<JointRows>(gfx, upload_joint_palette_buffer, joint_capacity, kGfxCpuAccess_Write);
+    }
+
+    if(!skin_slots.empty())
+    {
+        uint32_t const skin_capacity = CalculatePoolCapacity(gpu_scene.skin_buffer.getCount(), (uint32_t)skin_handles.size());
+
+        ResizeBuffer<uint32_t>(gfx, gpu_scene.skin_buffer, skin_capacity);
+
+        UploadBufferElements(gfx, gpu_scene.skin_buffer, skin_slots, skin_offsets);
+    }
+
+    // Stage the modified ranges back to back and copy each into its place in the palette
+    GfxBuffer upload_joint_palette_buffer = gpu_scene.upload_joint_palette_buffers[gfxGetBackBufferIndex(gfx)];
+
+    JointRows *upload_rows = gfxBufferGetData<JointRows>(gfx, upload_joint_palette_buffer);
+
+    uint32_t staging_offset = 0;
+
+    for(uint32_t skin_id : dirty_skins)
+    {
+        SkinRange const &skin_range = joint_palette.getSkinRange(skin_id);
+
+        if(skin_range.count == 0)
+        {
+            continue;   // released since
+        }
+
+        std::copy(joint_palette.getRows() + skin_range.offset, joint_palette.getRows() + skin_range.offset + skin_range.count, upload_rows + staging_offset);
+
+        gfxCommandCopyBuffer(gfx, gpu_scene.joint_palette_buffer, skin_range.offset * sizeof(JointRows), upload_joint_palette_buffer,
+                             staging_offset * sizeof(JointRows), skin_range.count * sizeof(JointRows));
+
+        staging_offset += skin_range.count;
+    }
+
+    joint_palette.clearDirtySkins();
+}
+
+} //! unnamed namespace
+
+GpuScene UploadSceneToGpuMemory(GfxContext gfx, GfxScene scene)
+{
+    GpuScene gpu_scene = {};
+
+    GfxProgramDesc transform_program_desc = {};
+    transform_program_desc.cs = transform_program_cs;
+
+    gpu_scene.transform_program = gfxCreateProgram(gfx, transform_program_desc, "TransformProgram");
+    gpu_scene.transform_kernel  = gfxCreateComputeKernel(gfx, gpu_scene.transform_program);
+
+    gpu_scene.texture_sampler = gfxCreateSamplerState(gfx, D3D12_FILTER_ANISOTROPIC, D3D12_TEXTURE_ADDRESS_MODE_WRAP, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
+
+    // Stream in the scene content
+    UpdateGpuScene(gfx, scene, gpu_scene);
+
+    GpuSceneTimings const &timings = gpu_scene.upload_timings;
+
+    GFX_PRINTLN("Uploaded scene to GPU memory: textures %.2fms (packing %.2fms), meshes %.2fms (packing %.2fms), instances %.2fms",
+        timings.texture_ms, timings.texture_packing_ms, timings.mesh_ms, timings.mesh_packing_ms, timings.instance_ms);
+
+    GpuSceneTextureStats const &texture_stats = gpu_scene.texture_stats;
+
+    if(texture_stats.packed_image_count > 0)
+    {
+        GFX_PRINTLN("Packed %u small images into %u atlases: %u fewer descriptors, %.2fMiB of texture memory saved",
+            texture_stats.packed_image_count, texture_stats.atlas_count, texture_stats.packed_image_count - texture_stats.atlas_count,
+            (double)texture_stats.saved_bytes / (1024.0 * 1024.0));
+    }
+
+    return gpu_scene;
+}
+
+void ReleaseGpuScene(GfxContext gfx, GpuScene const &gpu_scene)
+{
+    gfxDestroyBuffer(gfx, gpu_scene.mesh_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.index_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.vertex_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.instance_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.material_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.transform_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.previous_transform_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.texture_region_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.joint_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.skin_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.joint_palette_buffer);
+
+    for(GfxBuffer upload_transform_buffer : gpu_scene.upload_transform_buffers)
+    {
+        gfxDestroyBuffer(gfx, upload_transform_buffer);
+    }
+
+    for(GfxBuffer upload_joint_palette_buffer : gpu_scene.upload_joint_palette_buffers)
+    {
+        gfxDestroyBuffer(gfx, upload_joint_palette_buffer);
+    }
+
+    gfxDestroyKernel(gfx, gpu_scene.transform_kernel);
+    gfxDestroyProgram(gfx, gpu_scene.transform_program);
+
+    for(GfxTexture texture : gpu_scene.textures)
+    {
+        gfxDestroyTexture(gfx, texture);
+    }
+
+    gfxDestroySamplerState(gfx, gpu_scene.texture_sampler);
+}
+
+void DefragmentGpuScene(GfxContext gfx, GpuScene &gpu_scene)
+{
+    uint32_t const index_capacity  = gpu_scene.index_allocator.getCapacity();
+    uint32_t const vertex_capacity = gpu_scene.vertex_allocator.getCapacity();
+    uint32_t const joint_capacity  = gpu_scene.joint_allocator.getCapacity();
+
+    if(gpu_scene.index_allocator.getLargestFreeRange() == gpu_scene.index_allocator.getFreeCount() &&
+       gpu_scene.vertex_allocator.getLargestFreeRange() == gpu_scene.vertex_allocator.getFreeCount() &&
+       gpu_scene.joint_allocator.getLargestFreeRange() == gpu_scene.joint_allocator.getFreeCount())
+    {
+        return; // no fragmentation
+    }
+
+    gpu_scene.index_allocator.reset(index_capacity);
+    gpu_scene.vertex_allocator.reset(vertex_capacity);
+    gpu_scene.joint_allocator.reset(joint_capacity);
+
+    // Pack the resident meshes at the start of new pools
+    GfxBuffer index_buffer  = gfxCreateBuffer<uint32_t>(gfx, index_capacity);
+    GfxBuffer vertex_buffer = gfxCreateBuffer<Vertex>(gfx, vertex_capacity);
+    GfxBuffer joint_buffer  = (joint_capacity > 0 ? gfxCreateBuffer<GfxJoint>(gfx, joint_capacity) : GfxBuffer());
+
+    std::vector<uint32_t> mesh_slots;
+
+    for(uint32_t mesh_id = 0; mesh_id < (uint32_t)gpu_scene.mesh_handles.size(); ++mesh_id)
+    {
+        if(gpu_scene.mesh_handles[mesh_id] == 0)
+        {
+            continue;   // free slot
+        }
+
+        Mesh &mesh = gpu_scene.meshes[mesh_id];
+
+        uint32_t first_index = 0;
+        uint32_t base_vertex = 0;
+
+        gpu_scene.index_allocator.allocate(mesh.count, first_index);
+        gpu_scene.vertex_allocator.allocate(mesh.vertex_count, base_vertex);
+
+        gfxCommandCopyBuffer(gfx, index_buffer, first_index * sizeof(uint32_t), gpu_scene.index_buffer, mesh.first_index * sizeof(uint32_t), mesh.count * sizeof(uint32_t));
+        gfxCommandCopyBuffer(gfx, vertex_buffer, base_vertex * sizeof(Vertex), gpu_scene.vertex_buffer, mesh.base_vertex * sizeof(Vertex), mesh.vertex_count * sizeof(Vertex));
+
+        mesh.first_index = first_index;
+        mesh.base_vertex = base_vertex;
+
+        if(mesh.base_joint != kInvalidJoint)
+        {
+            uint32_t base_joint = 0;
+
+            gpu_scene.joint_allocator.allocate(mesh.vertex_count, base_joint);
+
+            gfxCommandCopyBuffer(gfx, joint_buffer, base_joint * sizeof(GfxJoint), gpu_scene.joint_buffer, mesh.base_joint * sizeof(GfxJoint), mesh.vertex_count * sizeof(GfxJoint));
+
+            mesh.base_joint = base_joint;
+        }
+
+        mesh_slots.push_back(mesh_id);
+    }
+
+    gfxDestroyBuffer(gfx, gpu_scene.index_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.vertex_buffer);
+    gfxDestroyBuffer(gfx, gpu_scene.joint_buffer);
+
+    gpu_scene.index_buffer  = index_buffer;
+    gpu_scene.vertex_buffer = vertex_buffer;
+    gpu_scene.joint_buffer  = joint_buffer;
+
+    // And update the mesh ranges
+    std::vector<Mesh> meshes;
+
+    for(uint32_t mesh_id : mesh_slots)
+    {
+        meshes.push_back(gpu_scene.meshes[mesh_id]);
+    }
+
+    UploadBufferElements(gfx, gpu_scene.mesh_buffer, mesh_slots, meshes);
+}
+
+GfxTexture GetImageTexture(GpuScene const &gpu_scene, uint64_t image_handle)
+{
+    uint32_t const image_id = (uint32_t)image_handle;
+
+    if(image_handle == 0 || image_id >= gpu_scene.image_handles.size() || gpu_scene.image_handles[image_id] != image_handle)
+    {
+        return GfxTexture();    // not resident
+    }
+
+    return gpu_scene.textures[gpu_scene.texture_regions[image_id].texture_id];
+}
+
+void UpdateGpuScene(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene)
+{
+    // The current transforms become the previous ones; the buffer we now write into is still missing
+    // the instances that moved on the last update, so these get uploaded again alongside the new ones
+    std::swap(gpu_scene.transform_buffer, gpu_scene.previous_transform_buffer);
+
+    // Stream in the objects that were added to the scene and release the removed ones
+    auto const texture_start = std::chrono::high_resolution_clock::now();
+
+    StreamTextures(gfx, scene, gpu_scene);
+
+    auto const mesh_start = std::chrono::high_resolution_clock::now();
+
+    StreamMaterials(gfx, scene, gpu_scene);
+    StreamMeshes(gfx, scene, gpu_scene);
+
+    auto const instance_start = std::chrono::high_resolution_clock::now();
+
+    StreamInstances(gfx, scene, gpu_scene);
+
+    gpu_scene.upload_timings.texture_ms  += std::chrono::duration<double, std::milli>(mesh_start - texture_start).count();
+    gpu_scene.upload_timings.mesh_ms     += std::chrono::duration<double, std::milli>(instance_start - mesh_start).count();
+    gpu_scene.upload_timings.instance_ms += GetElapsedMilliseconds(instance_start);
+
+    // And upload the modified transforms and joint matrices
+    UpdateTransforms(gfx, scene, gpu_scene);
+    UpdateSkins(gfx, scene, gpu_scene);
+}
+
+void BindGpuScene(GfxContext gfx, GfxProgram program, GpuScene const &gpu_scene)
+{
+    gfxProgramSetParameter(gfx, program, "g_MeshBuffer", gpu_scene.mesh_buffer);
+    gfxProgramSetParameter(gfx, program, "g_IndexBuffer", gpu_scene.index_buffer);
+    gfxProgramSetParameter(gfx, program, "g_VertexBuffer", gpu_scene.vertex_buffer);
+    gfxProgramSetParameter(gfx, program, "g_InstanceBuffer", gpu_scene.instance_buffer);
+    gfxProgramSetParameter(gfx, program, "g_MaterialBuffer", gpu_scene.material_buffer);
+    gfxProgramSetParameter(gfx, program, "g_TransformBuffer", gpu_scene.transform_buffer);
+    gfxProgramSetParameter(gfx, program, "g_PreviousTransformBuffer", gpu_scene.previous_transform_buffer);
+
+    gfxProgramSetParameter(gfx, program, "g_TextureRegionBuffer", gpu_scene.texture_region_buffer);
+
+    gfxProgramSetParameter(gfx, program, "g_JointBuffer", gpu_scene.joint_buffer);
+    gfxProgramSetParameter(gfx, program, "g_SkinBuffer", gpu_scene.skin_buffer);
+    gfxProgramSetParameter(gfx, program, "g_JointPaletteBuffer", gpu_scene.joint_palette_buffer);
+
+    gfxProgramSetParameter(gfx, program, "g_Textures", gpu_scene.textures.data(), (uint32_t)gpu_scene.textures.size());
 
     gfxProgramSetParameter(gfx, program, "g_TextureSampler", gpu_scene.texture_sampler);
 }
+
+void UpdateCullingBounds(GfxScene scene, CullingBounds &bounds)
+{
+    uint32_t const instance_count = gfxSceneGetInstanceCount(scene);
+
+    GfxInstance const *instances = gfxSceneGetInstances(scene);
+
+    bounds.resize(instance_count);
+
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        GfxInstance const &instance = instances[i];
+
+        if(!instance.mesh)
+        {
+            bounds.setSphere(i, glm::vec3(0.0f), -1.0f);    // never visible
+
+            continue;
+        }
+
+        bounds.setBox(i, instance.mesh->bounds_min, instance.mesh->bounds_max, instance.transform);
+    }
+}
+
+void UpdateLightBounds(GfxScene scene, CullingBounds &bounds)
+{
+    uint32_t const light_count = gfxSceneGetLightCount(scene);
+
+    GfxLight const *lights = gfxSceneGetLights(scene);
+
+    bounds.resize(light_count);
+
+    for(uint32_t i = 0; i < light_count; ++i)
+    {
+        GfxLight const &light = lights[i];
+
+        if(light.type == kGfxLightType_Directional || !(light.range < FLT_MAX))
+        {
+            bounds.setSphere(i, glm::vec3(0.0f), -1.0f);    // lights every cluster
+
+            continue;
+        }
+
+        if(light.type == kGfxLightType_Spot && light.outer_cone_angle < 0.25f * 3.1415926535897932384626433832795f)
+        {
+            // Narrow cones are better bounded by the sphere going through the apex and the cap's rim
+            float const radius = light.range / (2.0f * cosf(light.outer_cone_angle));
+
+            bounds.setSphere(i, light.position + radius * glm::normalize(light.direction), radius);
+
+            continue;
+        }
+
+        bounds.setSphere(i, light.position, light.range);
+    }
+}
+
+void RasterizeOccluders(GfxScene scene, CullingBounds const &bounds, std::vector<uint32_t> const &visible_instances, glm::mat4 const &view_proj,
+                        OcclusionBuffer &occlusion_buffer, float min_screen_coverage)
+{
+    occlusion_buffer.begin(view_proj);
+
+    GfxInstance const *instances = gfxSceneGetInstances(scene);
+
+    for(uint32_t i : visible_instances)
+    {
+        if(i >= bounds.getCount() || !instances[i].mesh)
+        {
+            continue;
+        }
+
+        GfxInstance const &instance = instances[i];
+
+        GfxMesh const &mesh = *instance.mesh;
+
+        // Deformed meshes don't match their bind pose, so can't safely occlude anything
+        if(mesh.vertices.empty() || mesh.indices.empty() || !mesh.joints.empty() || !mesh.morph_targets.empty())
+        {
+            continue;
+        }
+
+        glm::vec3 const center(bounds.getCentersX()[i], bounds.getCentersY()[i], bounds.getCentersZ()[i]);
+
+        if(occlusion_buffer.calculateScreenCoverage(center, bounds.getRadii()[i]) < min_screen_coverage)
+        {
+            continue;   // too small to hide much
+        }
+
+        occlusion_buffer.addOccluder(&mesh.vertices[0].position.x, (uint32_t)sizeof(GfxVertex), mesh.indices.data(), (uint32_t)mesh.indices.size(), instance.transform);
+    }
+
+    occlusion_buffer.rasterize();
+}
+
+void BuildGpuDrawList(GfxContext gfx, GfxScene scene, GpuScene const &gpu_scene, glm::vec3 const &eye, GpuDrawList &draw_list, std::vector<uint32_t> const *visible_instances)
+{
+    DrawListBuilder &builder = draw_list.builder;
+
+    uint32_t const instance_count = (visible_instances != nullptr ? (uint32_t)visible_instances->size() : gfxSceneGetInstanceCount(scene));
+
+    builder.clear();
+    builder.reserve(instance_count);
+
+    // Gather the draws for our instances
+    GfxInstance const *instances = gfxSceneGetInstances(scene);
+
+    for(uint32_t j = 0; j < instance_count; ++j)
+    {
+        uint32_t const i = (visible_instances != nullptr ? (*visible_instances)[j] : j);
+
+        GfxInstance const &instance = instances[i];
+
+        uint32_t const mesh_id = (uint32_t)instance.mesh;
+
+        if(mesh_id >= gpu_scene.meshes.size())
+        {
+            continue;   // no mesh to draw
+        }
+
+        Mesh const &mesh = gpu_scene.meshes[mesh_id];
+
+        DrawItem draw_item    = {};
+        draw_item.material    = (uint32_t)instance.material;
+        draw_item.mesh        = mesh_id;
+        draw_item.depth       = glm::distance(eye, glm::vec3(instance.transform[3]));
+        draw_item.instance_id = (uint32_t)gfxSceneGetInstanceHandle(scene, i);
+        draw_item.index_count = mesh.count;
+        draw_item.first_index = mesh.first_index;
+        draw_item.base_vertex = (int32_t)mesh.base_vertex;
+
+        builder.addDraw(draw_item);
+    }
+
+    // Sort and batch them
+    builder.build();
+
+    uint32_t const draw_count = builder.getDrawCount();
+
+    if(draw_count == 0)
+    {
+        return; // nothing to draw
+    }
+
+    // And upload the indirect arguments
+    uint32_t const backbuffer_index = gfxGetBackBufferIndex(gfx);
+    uint32_t const draw_capacity    = CalculatePoolCapacity(draw_list.args_buffer.getCount(), draw_count);
+
+    ResizeBuffer<DrawIndexedArguments>(gfx, draw_list.args_buffer, draw_capacity);
+    ResizeBuffer<DrawIndexedArguments>(gfx, draw_list.upload_args_buffers[backbuffer_index], draw_capacity, kGfxCpuAccess_Write);
+    ResizeBuffer<uint32_t>(gfx, draw_list.instance_buffers[backbuffer_index], draw_capacity, kGfxCpuAccess_Write);
+
+    memcpy(gfxBufferGetData(gfx, draw_list.upload_args_buffers[backbuffer_index]), builder.getArguments().data(), draw_count * sizeof(DrawIndexedArguments));
+    memcpy(gfxBufferGetData(gfx, draw_list.instance_buffers[backbuffer_index]), builder.getInstanceIds().data(), draw_count * sizeof(uint32_t));
+
+    gfxCommandCopyBuffer(gfx, draw_list.args_buffer, 0, draw_list.upload_args_buffers[backbuffer_index], 0, draw_count * sizeof(DrawIndexedArguments));
+}
+
+void DrawGpuDrawList(GfxContext gfx, GfxProgram program, GfxKernel const *kernels, uint32_t pass, GpuDrawList const &draw_list)
+{
+    gfxProgramSetParameter(gfx, program, "g_DrawInstanceBuffer", draw_list.instance_buffers[gfxGetBackBufferIndex(gfx)]);
+
+    for(DrawBatch const &batch : draw_list.builder.getBatches())
+    {
+        if(batch.pass != pass)
+        {
+            continue;   // not part of this pass
+        }
+
+        GfxBuffer args_buffer = gfxCreateBufferRange<DrawIndexedArguments>(gfx, draw_list.args_buffer, batch.first_draw, batch.draw_count);
+
+        gfxProgramSetParameter(gfx, program, "g_DrawOffset", batch.first_draw);
+
+        gfxCommandBindKernel(gfx, kernels[batch.kernel]);
+        gfxCommandMultiDrawIndexedIndirect(gfx, args_buffer, batch.draw_count);
+
+        gfxDestroyBuffer(gfx, args_buffer);
+    }
+}
+
+void ReleaseGpuDrawList(GfxContext gfx, GpuDrawList const &draw_list)
+{
+    gfxDestroyBuffer(gfx, draw_list.args_buffer);
+
+    for(uint32_t i = 0; i < kGfxConstant_BackBufferCount; ++i)
+    {
+        gfxDestroyBuffer(gfx, draw_list.upload_args_buffers[i]);
+        gfxDestroyBuffer(gfx, draw_list.instance_buffers[i]);
+    }
+}
@@ -24,13 +24,47 @@ SOFTWARE.
 #pragma once
 
 #include "gfx_scene.h"
+#include "culling.h"
+#include "draw_list.h"
+#include "gpu_allocator.h"
+#include "joint_palette.h"
+#include "light_clusters.h"
+#include "occlusion.h"
+#include "texture_atlas.h"
 
 struct Mesh
 {
     uint32_t count;
     uint32_t first_index;
     uint32_t base_vertex;
-    uint32_t padding;
+    uint32_t vertex_count;
+    uint32_t base_joint;    // into the per-vertex joint stream, or 0xFFFFFFFF if the mesh isn't skinned
+};
+
+struct TextureRegion
+{
+    glm::vec4 scale_offset; // atlas uv = frac(uv) * scale + offset
+    glm::vec2 texture_size; // of the image, in texels
+    float     max_lod;      // negative for images that have a texture of their own
+    uint32_t  texture_id;
+};
+
+struct GpuSceneTextureStats
+{
+    uint32_t packed_image_count;    // small images that share an atlas rather than having a texture of their own
+    uint32_t atlas_count;
+    uint64_t saved_bytes;           // estimated from the 64KiB placement alignment of each texture; images only get packed when it saves memory
+};
+
+struct GpuSceneTimings
+{
+    double texture_ms;          // accumulated CPU time spent streaming each kind of object
+    double texture_packing_ms;
+    double mesh_ms;
+    double mesh_packing_ms;
+    double instance_ms;
+    double transform_ms;        // gathering the instances that the scene recorded as modified
+    double transform_packing_ms;
 };
 
 struct GpuScene
@@ -46,13 +80,71 @@ struct GpuScene
     GfxBuffer previous_transform_buffer;
     GfxBuffer upload_transform_buffers[kGfxConstant_BackBufferCount];
 
-    std::vector<GfxTexture> textures;
+    RangeAllocator index_allocator;
+    RangeAllocator vertex_allocator;
+    RangeAllocator joint_allocator;
+
+    GfxBuffer joint_buffer;             // per-vertex joint indices and weights of the skinned meshes
+    GfxBuffer skin_buffer;              // palette offset of each skin
+    GfxBuffer joint_palette_buffer;     // 3x4 joint matrices of all the skins
+    GfxBuffer upload_joint_palette_buffers[kGfxConstant_BackBufferCount];
+
+    JointPalette joint_palette;
+
+    std::vector<uint64_t> mesh_handles;     // scene object resident in each slot, or 0 if free
+    std::vector<uint64_t> material_handles;
+    std::vector<uint64_t> instance_handles;
+    std::vector<uint64_t> image_handles;
+
+    std::vector<glm::mat4> transforms;      // last known transform of each instance
+    std::vector<uint32_t> dirty_instances;  // instances that moved on the last update
+    std::vector<uint32_t> new_instances;    // instances that were streamed in on this update
+    std::vector<uint32_t> transform_packet_instances;
+
+    GfxProgram transform_program;
+    GfxKernel transform_kernel;
+
+    GfxBuffer texture_region_buffer;
+    RangeAllocator texture_allocator;
+
+    std::vector<GfxTexture> textures;               // images are looked up through their region, as several may share an atlas
+    std::vector<TextureRegion> texture_regions;     // indexed by image id
+    std::vector<uint32_t> texture_image_counts;     // number of images using each texture
+
+    GpuSceneTextureStats texture_stats;
+
+    GpuSceneTimings upload_timings;
 
     GfxSamplerState texture_sampler;
 };
 
+struct GpuDrawList
+{
+    DrawListBuilder builder;
+
+    GfxBuffer args_buffer;
+    GfxBuffer upload_args_buffers[kGfxConstant_BackBufferCount];
+    GfxBuffer instance_buffers[kGfxConstant_BackBufferCount];   // instance id of each draw, indexed by `g_DrawOffset + gfx_DrawID`
+};
+
 GpuScene UploadSceneToGpuMemory(GfxContext gfx, GfxScene scene);
 void ReleaseGpuScene(GfxContext gfx, GpuScene const &gpu_scene);
+void DefragmentGpuScene(GfxContext gfx, GpuScene &gpu_scene);  // compacts the vertex and index pools
 
-void UpdateGpuScene(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene);
+GfxTexture GetImageTexture(GpuScene const &gpu_scene, uint64_t image_handle);   // may be an atlas shared with other images
+
+// Note: only the instances listed by gfxSceneGetModifiedInstances() get their transform uploaded, and
+// UpdateGpuScene() clears that list; animations record the instances they move, but a transform that
+// is written through the instance's `GfxRef' needs a call to gfxSceneMarkInstanceModified().
+void UpdateGpuScene(GfxContext gfx, GfxScene scene, GpuScene &gpu_scene);  // streams added/removed objects, the modified skins, and swaps the transform buffers, so BindGpuScene() must be called afterwards
 void BindGpuScene(GfxContext gfx, GfxProgram program, GpuScene const &gpu_scene);
+
+void UpdateCullingBounds(GfxScene scene, CullingBounds &bounds);  // one bounding sphere per instance, in scene order
+void UpdateLightBounds(GfxScene scene, CullingBounds &bounds);    // one bounding sphere per point/spot light, in scene order; directional and unbounded lights get a negative radius
+void RasterizeOccluders(GfxScene scene, CullingBounds const &bounds, std::vector<uint32_t> const &visible_instances, glm::mat4 const &view_proj,
+                        OcclusionBuffer &occlusion_buffer, float min_screen_coverage = 0.01f);   // the visible instances covering enough of the screen become occluders
+
+void BuildGpuDrawList(GfxContext gfx, GfxScene scene, GpuScene const &gpu_scene, glm::vec3 const &eye, GpuDrawList &draw_list,
+                      std::vector<uint32_t> const *visible_instances = nullptr); // sorts the (visible) scene instances into multi-draw batches
+void DrawGpuDrawList(GfxContext gfx, GfxProgram program, GfxKernel const *kernels, uint32_t pass, GpuDrawList const &draw_list); // binds `kernels[batch.kernel]` for each batch of the pass
+void ReleaseGpuDrawList(GfxContext gfx, GpuDrawList const &draw_list);
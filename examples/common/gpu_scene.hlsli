@@ -36,13 +36,29 @@ struct Mesh
     uint count;
     uint first_index;
     uint base_vertex;
-    uint padding;
+    uint vertex_count;
+    uint base_joint;    // or 0xFFFFFFFF if the mesh isn't skinned
 };
 
 struct Instance
 {
     uint mesh_id;
     uint material_id;
+    uint skin_id;       // or 0xFFFFFFFF if the instance isn't skinned
+};
+
+struct Joint
+{
+    uint4  joints;
+    float4 weights;
+};
+
+struct TextureRegion
+{
+    float4 scale_offset;    // atlas uv = frac(uv) * scale + offset
+    float2 texture_size;    // of the image, in texels
+    float  max_lod;         // negative for images that have a texture of their own
+    uint   texture_id;
 };
 
 struct Vertex
@@ -59,11 +75,71 @@ StructuredBuffer<Instance> g_InstanceBuffer;
 StructuredBuffer<Material> g_MaterialBuffer;
 StructuredBuffer<float4x4> g_TransformBuffer;
 StructuredBuffer<float4x4> g_PreviousTransformBuffer;
+StructuredBuffer<TextureRegion> g_TextureRegionBuffer;
+StructuredBuffer<Joint>    g_JointBuffer;
+StructuredBuffer<uint>     g_SkinBuffer;
+StructuredBuffer<float4>   g_JointPaletteBuffer;   // 3 rows per joint
 
 Texture2D g_Textures[] : register(space99); // different space to avoid issues with bindless allocating all available texture registers...
 
 SamplerState g_TextureSampler;
 
+float4 SampleSceneTexture(in uint image_id, in float2 uv)
+{
+    TextureRegion region = g_TextureRegionBuffer[image_id];
+
+    if(region.max_lod < 0.0f)
+    {
+        return g_Textures[region.texture_id].Sample(g_TextureSampler, uv);
+    }
+
+    // Atlased images emulate the wrapping and pick the mip level from the unwrapped coordinates so
+    // that there's no seam, staying below the levels where neighboring cells would bleed in
+    float2 dx  = ddx(uv) * region.texture_size;
+    float2 dy  = ddy(uv) * region.texture_size;
+    float  lod = 0.5f * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8f));
+
+    float2 atlas_uv = frac(uv) * region.scale_offset.xy + region.scale_offset.zw;
+
+    return g_Textures[region.texture_id].SampleLevel(g_TextureSampler, atlas_uv, clamp(lod, 0.0f, region.max_lod));
+}
+
+float3x4 LoadJointMatrix(in uint joint_index)
+{
+    return float3x4(g_JointPaletteBuffer[3 * joint_index + 0],
+                     g_JointPaletteBuffer[3 * joint_index + 1],
+                     g_JointPaletteBuffer[3 * joint_index + 2]);
+}
+
+// Returns false if the instance isn't skinned; otherwise, the position and normal are moved into world space
+// (the joint matrices already account for the node transforms) and the instance transform must not be applied
+bool SkinVertex(in Instance instance, in uint vertex_index, inout float4 position, inout float3 normal)
+{
+    Mesh mesh = g_MeshBuffer[instance.mesh_id];
+
+    if(instance.skin_id == 0xFFFFFFFFu || mesh.base_joint == 0xFFFFFFFFu)
+    {
+        return false;
+    }
+
+    Joint    joint       = g_JointBuffer[mesh.base_joint + vertex_index];
+    uint     base_joint  = g_SkinBuffer[instance.skin_id];
+    float3x4 skin_matrix = (float3x4)0;
+
+    for(uint i = 0; i < 4; ++i)
+    {
+        if(joint.joints[i] != 0xFFFFFFFFu)
+        {
+            skin_matrix += joint.weights[i] * LoadJointMatrix(base_joint + joint.joints[i]);
+        }
+    }
+
+    position = float4(mul(skin_matrix, position), 1.0f);
+    normal   = normalize(mul((float3x3)skin_matrix, normal));
+
+    return true;
+}
+
 // https://github.com/graphitemaster/normals_revisited
 float3 TransformDirection(in float4x4 transform, in float3 direction)
 {
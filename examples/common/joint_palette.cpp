@@ -0,0 +1,142 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "joint_palette.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+JointRows ToJointRows(glm::mat4 const &joint_matrix)
+{
+    JointRows joint_rows = {};
+
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        joint_rows.rows[i] = glm::vec4(joint_matrix[0][i], joint_matrix[1][i], joint_matrix[2][i], joint_matrix[3][i]);
+    }
+
+    return joint_rows;
+}
+
+} //! unnamed namespace
+
+bool JointPalette::updateSkin(uint32_t skin_id, uint64_t skin_handle, glm::mat4 const *joint_matrices, uint32_t joint_count)
+{
+    if(skin_id >= skin_handles_.size())
+    {
+        skin_handles_.resize(skin_id + 1);
+        skin_ranges_.resize(skin_id + 1);
+        dirty_flags_.resize(skin_id + 1);
+    }
+
+    SkinRange &skin_range = skin_ranges_[skin_id];
+
+    bool const is_allocated = (skin_handles_[skin_id] != skin_handle || skin_range.count != joint_count);
+
+    if(is_allocated)
+    {
+        releaseSkin(skin_id);
+
+        if(joint_count > 0 && !allocator_.allocate(joint_count, skin_range.offset))
+        {
+            uint32_t const capacity = allocator_.getCapacity();
+
+            allocator_.grow(std::max(capacity + joint_count, 2 * capacity));
+            allocator_.allocate(joint_count, skin_range.offset);
+
+            rows_.resize(allocator_.getCapacity());
+        }
+
+        skin_handles_[skin_id] = skin_handle;
+        skin_range.count       = joint_count;
+    }
+
+    // Only keep the skin if one of its matrices changed
+    bool is_dirty = is_allocated;
+
+    for(uint32_t i = 0; i < joint_count; ++i)
+    {
+        JointRows const joint_rows = ToJointRows(joint_matrices[i]);
+
+        JointRows &palette_rows = rows_[skin_range.offset + i];
+
+        if(!is_dirty && memcmp(&joint_rows, &palette_rows, sizeof(JointRows)) == 0)
+        {
+            continue;   // unchanged
+        }
+
+        palette_rows = joint_rows;
+        is_dirty     = true;
+    }
+
+    if(is_dirty)
+    {
+        markDirty(skin_id);
+    }
+
+    return is_allocated;
+}
+
+void JointPalette::releaseSkin(uint32_t skin_id)
+{
+    if(skin_id >= skin_handles_.size() || skin_handles_[skin_id] == 0)
+    {
+        return; // not resident
+    }
+
+    SkinRange &skin_range = skin_ranges_[skin_id];
+
+    if(skin_range.count > 0)
+    {
+        allocator_.free(skin_range.offset, skin_range.count);
+    }
+
+    skin_range = {};
+
+    skin_handles_[skin_id] = 0;
+}
+
+void JointPalette::clearDirtySkins()
+{
+    for(uint32_t skin_id : dirty_skins_)
+    {
+        dirty_flags_[skin_id] = false;
+    }
+
+    dirty_skins_.clear();
+}
+
+void JointPalette::markDirty(uint32_t skin_id)
+{
+    if(dirty_flags_[skin_id])
+    {
+        return; // already marked
+    }
+
+    dirty_flags_[skin_id] = true;
+
+    dirty_skins_.push_back(skin_id);
+}
@@ -0,0 +1,68 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "gpu_allocator.h"
+
+#include "glm/glm.hpp"
+
+struct JointRows
+{
+    glm::vec4 rows[3];  // affine joint matrix, last row is implicitly (0, 0, 0, 1)
+};
+
+struct SkinRange
+{
+    uint32_t offset;    // into the palette, in joints
+    uint32_t count;
+};
+
+// Packs the joint matrices of all the skins into a single palette, with each skin owning a range that
+// is allocated from a pool; only the skins whose matrices changed since the last call to clearDirtySkins()
+// get reported so they can be streamed as compact 3x4 rows.
+// Has no dependencies on gfx so it can be built and exercised on any platform.
+class JointPalette
+{
+public:
+    // Returns true if the skin got a new range (i.e., it is new or its joint count changed).
+    bool updateSkin(uint32_t skin_id, uint64_t skin_handle, glm::mat4 const *joint_matrices, uint32_t joint_count);
+    void releaseSkin(uint32_t skin_id);
+    void clearDirtySkins();
+
+    inline uint32_t getCapacity() const { return allocator_.getCapacity(); }    // in joints
+    inline JointRows const *getRows() const { return rows_.data(); }
+    inline std::vector<uint64_t> const &getSkinHandles() const { return skin_handles_; }    // handle resident in each slot, or 0 if free
+    inline SkinRange const &getSkinRange(uint32_t skin_id) const { return skin_ranges_[skin_id]; }
+    inline std::vector<uint32_t> const &getDirtySkins() const { return dirty_skins_; }
+
+private:
+    void markDirty(uint32_t skin_id);
+
+    RangeAllocator allocator_;
+    std::vector<JointRows> rows_;           // CPU copy of the palette, used to detect the changes
+    std::vector<uint64_t> skin_handles_;
+    std::vector<SkinRange> skin_ranges_;
+    std::vector<uint32_t> dirty_skins_;     // in the order they were marked
+    std::vector<bool> dirty_flags_;
+};
@@ -0,0 +1,279 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "light_clusters.h"
+#include "gfx_core.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+uint32_t const kMinLightsPerThread = 256;   // below this, threading costs more than it saves
+uint32_t const kInvalidSlices = 0xFFFFFFFFu;
+
+uint32_t ToTile(float ndc, uint32_t count)
+{
+    float const tile = std::floor((ndc * 0.5f + 0.5f) * (float)count);
+
+    return (uint32_t)std::min(std::max(tile, 0.0f), (float)(count - 1));
+}
+
+} //! unnamed namespace
+
+void LightClusters::resize(uint32_t count_x, uint32_t count_y, uint32_t count_z)
+{
+    count_x_ = std::min(std::max(count_x, 1u), 0xFFFFu);
+    count_y_ = std::min(std::max(count_y, 1u), 0xFFFFu);
+    count_z_ = std::min(std::max(count_z, 1u), 0xFFFFu);
+
+    clusters_.resize(getClusterCount());
+
+    std::fill(clusters_.begin(), clusters_.end(), LightCluster {});
+
+    light_indices_.clear();
+}
+
+void LightClusters::build(CullingBounds const &light_bounds, glm::mat4 const &view, glm::mat4 const &proj, float near_z, float far_z, uint32_t thread_count)
+{
+    if(clusters_.empty())
+    {
+        resize(16, 9, 24);  // default to 16x9 tiles and 24 depth slices
+    }
+
+    near_z_ = std::max(near_z, 1e-4f);
+    far_z_ = std::max(far_z, 1.001f * near_z_);
+    proj_x_ = proj[0][0];
+    proj_y_ = proj[1][1];
+    slice_scale_ = (float)count_z_ / std::log(far_z_ / near_z_);
+
+    light_count_ = light_bounds.getCount();
+
+    view_x_.resize(light_count_);
+    view_y_.resize(light_count_);
+    view_depth_.resize(light_count_);
+    radius_.resize(light_count_);
+    light_slices_.resize(light_count_);
+
+    // Move the lights into view space; a straight loop over the structure-of-arrays so that compilers vectorize it
+    float const *center_x = light_bounds.getCentersX();
+    float const *center_y = light_bounds.getCentersY();
+    float const *center_z = light_bounds.getCentersZ();
+
+    for(uint32_t i = 0; i < light_count_; ++i)
+    {
+        view_x_[i] = view[0][0] * center_x[i] + view[1][0] * center_y[i] + view[2][0] * center_z[i] + view[3][0];
+        view_y_[i] = view[0][1] * center_x[i] + view[1][1] * center_y[i] + view[2][1] * center_z[i] + view[3][1];
+        view_depth_[i] = -(view[0][2] * center_x[i] + view[1][2] * center_y[i] + view[2][2] * center_z[i] + view[3][2]);
+        radius_[i] = light_bounds.getRadii()[i];
+    }
+
+    for(uint32_t i = 0; i < light_count_; ++i)
+    {
+        float const radius = radius_[i];
+        float const depth = view_depth_[i];
+
+        if(radius < 0.0f || depth + radius < near_z_ || depth - radius > far_z_)
+        {
+            light_slices_[i] = kInvalidSlices;
+
+            continue;
+        }
+
+        light_slices_[i] = (getSlice(depth - radius) << 16) | getSlice(std::min(depth + radius, far_z_));
+    }
+
+    if(thread_count == 0)
+    {
+        thread_count = gfxGetJobSystem().get_thread_count();
+    }
+
+    thread_count = std::max(std::min(std::min(thread_count, count_z_), light_count_ / kMinLightsPerThread), 1u);
+
+    if(thread_entries_.size() < thread_count)
+    {
+        thread_entries_.resize(thread_count);
+    }
+
+    thread_index_counts_.resize(thread_count);
+
+    // Each job owns a range of depth slices, hence a contiguous range of clusters; we first count the
+    // lights per cluster, then write out the indices once every job knows where its range starts
+    gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t thread_index)
+    {
+        binSlices(thread_index, thread_count);
+    });
+
+    uint32_t light_index_count = 0;
+
+    for(uint32_t i = 0; i < thread_count; ++i)
+    {
+        uint32_t const index_count = thread_index_counts_[i];
+
+        thread_index_counts_[i] = light_index_count;
+
+        light_index_count += index_count;
+    }
+
+    light_indices_.resize(light_index_count);
+
+    gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t thread_index)
+    {
+        writeSlices(thread_index, thread_count);
+    });
+}
+
+uint32_t LightClusters::getSlice(float view_depth) const
+{
+    if(view_depth <= near_z_)
+    {
+        return 0;
+    }
+
+    return std::min((uint32_t)(std::log(view_depth / near_z_) * slice_scale_), count_z_ - 1);
+}
+
+void LightClusters::binSlices(uint32_t thread_index, uint32_t thread_count)
+{
+    uint32_t const begin = (count_z_ * (thread_index + 0)) / thread_count;
+    uint32_t const end   = (count_z_ * (thread_index + 1)) / thread_count;
+
+    std::vector<Entry> &entries = thread_entries_[thread_index];
+
+    entries.clear();
+
+    uint32_t const first_cluster = getClusterIndex(0, 0, begin);
+    uint32_t const last_cluster  = getClusterIndex(0, 0, end);
+
+    for(uint32_t i = first_cluster; i < last_cluster; ++i)
+    {
+        clusters_[i].count = 0;
+    }
+
+    for(uint32_t i = 0; i < light_count_; ++i)
+    {
+        uint32_t const slices = light_slices_[i];
+
+        if(slices == kInvalidSlices)
+        {
+            continue;
+        }
+
+        uint32_t const first_slice = std::max(slices >> 16, begin);
+        uint32_t const last_slice  = std::min((slices & 0xFFFFu) + 1, end);
+
+        float const x = view_x_[i];
+        float const y = view_y_[i];
+        float const depth = view_depth_[i];
+        float const radius = radius_[i];
+
+        for(uint32_t slice = first_slice; slice < last_slice; ++slice)
+        {
+            float const slice_near = near_z_ * std::exp((float)(slice + 0) / slice_scale_);
+            float const slice_far  = near_z_ * std::exp((float)(slice + 1) / slice_scale_);
+
+            // Bound the part of the sphere inside the slice with a view-space box, whose projection is
+            // found from its corners since x/depth is monotonic along each axis
+            float const distance = (depth < slice_near ? slice_near - depth : depth > slice_far ? depth - slice_far : 0.0f);
+            float const extent = std::sqrt(std::max(radius * radius - distance * distance, 0.0f));
+
+            float const box_near = std::max(slice_near, depth - radius);
+            float const box_far  = std::min(slice_far, depth + radius);
+
+            float const min_x = x - extent, max_x = x + extent;
+            float const min_y = y - extent, max_y = y + extent;
+
+            float const ndc_min_x = proj_x_ * (min_x >= 0.0f ? min_x / box_far : min_x / box_near);
+            float const ndc_max_x = proj_x_ * (max_x >= 0.0f ? max_x / box_near : max_x / box_far);
+            float const ndc_min_y = proj_y_ * (min_y >= 0.0f ? min_y / box_far : min_y / box_near);
+            float const ndc_max_y = proj_y_ * (max_y >= 0.0f ? max_y / box_near : max_y / box_far);
+
+            if(ndc_max_x < -1.0f || ndc_min_x > 1.0f || ndc_max_y < -1.0f || ndc_min_y > 1.0f)
+            {
+                continue;   // off-screen
+            }
+
+            Entry entry = {};
+
+            entry.light = i;
+            entry.slice = (uint16_t)slice;
+            entry.min_x = (uint16_t)ToTile(ndc_min_x, count_x_);
+            entry.max_x = (uint16_t)ToTile(ndc_max_x, count_x_);
+            entry.min_y = (uint16_t)ToTile(-ndc_max_y, count_y_);   // tiles go top to bottom
+            entry.max_y = (uint16_t)ToTile(-ndc_min_y, count_y_);
+
+            entries.push_back(entry);
+
+            for(uint32_t tile_y = entry.min_y; tile_y <= entry.max_y; ++tile_y)
+            {
+                for(uint32_t tile_x = entry.min_x; tile_x <= entry.max_x; ++tile_x)
+                {
+                    ++clusters_[getClusterIndex(tile_x, tile_y, slice)].count;
+                }
+            }
+        }
+    }
+
+    uint32_t offset = 0;
+
+    for(uint32_t i = first_cluster; i < last_cluster; ++i)
+    {
+        clusters_[i].offset = offset;
+
+        offset += clusters_[i].count;
+    }
+
+    thread_index_counts_[thread_index] = offset;
+}
+
+void LightClusters::writeSlices(uint32_t thread_index, uint32_t thread_count)
+{
+    uint32_t const begin = (count_z_ * (thread_index + 0)) / thread_count;
+    uint32_t const end   = (count_z_ * (thread_index + 1)) / thread_count;
+
+    uint32_t const first_cluster = getClusterIndex(0, 0, begin);
+    uint32_t const last_cluster  = getClusterIndex(0, 0, end);
+
+    uint32_t const base_offset = thread_index_counts_[thread_index];
+
+    for(uint32_t i = first_cluster; i < last_cluster; ++i)
+    {
+        clusters_[i].offset += base_offset;
+        clusters_[i].count = 0; // re-counted as the indices get written
+    }
+
+    // Entries were recorded in light order, so each cluster's list ends up sorted
+    for(Entry const &entry : thread_entries_[thread_index])
+    {
+        for(uint32_t tile_y = entry.min_y; tile_y <= entry.max_y; ++tile_y)
+        {
+            for(uint32_t tile_x = entry.min_x; tile_x <= entry.max_x; ++tile_x)
+            {
+                LightCluster &cluster = clusters_[getClusterIndex(tile_x, tile_y, entry.slice)];
+
+                light_indices_[cluster.offset + cluster.count++] = entry.light;
+            }
+        }
+    }
+}
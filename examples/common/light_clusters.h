@@ -0,0 +1,89 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "culling.h"
+
+struct LightCluster
+{
+    uint32_t offset;    // into the light index list
+    uint32_t count;
+};
+
+// Bins light bounding spheres into a froxel grid: screen-space tiles along x/y (cluster (0, 0) being
+// the top-left corner) and exponentially distributed slices along the view depth. The resulting
+// cluster and light index arrays can be uploaded as-is and looked up during shading.
+// Its only gfx dependency is the job system from gfx_core.h, so it can be exercised on any platform.
+class LightClusters
+{
+public:
+    void resize(uint32_t count_x, uint32_t count_y, uint32_t count_z);
+
+    // Lights with a negative radius are skipped (e.g., directional lights, which affect all clusters).
+    // Expects a symmetric perspective projection; lights beyond `far_z` are not assigned to any cluster.
+    void build(CullingBounds const &light_bounds, glm::mat4 const &view, glm::mat4 const &proj, float near_z, float far_z, uint32_t thread_count = 0);  // `thread_count' jobs over the depth slices; 0 uses all the job system's threads
+
+    uint32_t getSlice(float view_depth) const;  // same mapping as the shading code should use
+
+    inline uint32_t getCountX() const { return count_x_; }
+    inline uint32_t getCountY() const { return count_y_; }
+    inline uint32_t getCountZ() const { return count_z_; }
+    inline uint32_t getClusterCount() const { return count_x_ * count_y_ * count_z_; }
+    inline uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * count_y_ + y) * count_x_ + x; }
+
+    inline LightCluster const *getClusters() const { return clusters_.data(); }
+    inline uint32_t const *getLightIndices() const { return light_indices_.data(); }
+    inline uint32_t getLightIndexCount() const { return (uint32_t)light_indices_.size(); }
+
+private:
+    struct Entry
+    {
+        uint32_t light;
+        uint16_t slice;
+        uint16_t min_x, max_x;
+        uint16_t min_y, max_y;
+    };
+
+    void binSlices(uint32_t thread_index, uint32_t thread_count);
+    void writeSlices(uint32_t thread_index, uint32_t thread_count);
+
+    std::vector<LightCluster> clusters_;
+    std::vector<uint32_t> light_indices_;
+    std::vector<float> view_x_;
+    std::vector<float> view_y_;
+    std::vector<float> view_depth_;
+    std::vector<float> radius_;
+    std::vector<uint32_t> light_slices_;    // first and last slice of each light packed as (first << 16 | last)
+    std::vector<std::vector<Entry>> thread_entries_;
+    std::vector<uint32_t> thread_index_counts_;
+    uint32_t light_count_ = 0;
+    uint32_t count_x_ = 0;
+    uint32_t count_y_ = 0;
+    uint32_t count_z_ = 0;
+    float near_z_ = 0.1f;
+    float far_z_ = 1.0f;
+    float proj_x_ = 1.0f;
+    float proj_y_ = 1.0f;
+    float slice_scale_ = 1.0f;  // count_z / log(far / near)
+};
@@ -0,0 +1,498 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "occlusion.h"
+#include "gfx_core.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+uint32_t const kMinTrianglesPerThread = 1024;   // below this, threading costs more than it saves
+float const kMinClipW = 1e-4f;
+
+// Rasterizes a screen-space triangle with positive signed area into a tile, keeping the nearest depth.
+// The span loop is branch-free so that compilers can vectorize it across the tile row.
+void RasterizeTriangle(float const *x, float const *y, float const *z, int32_t tile_x, int32_t tile_y, float *tile_depth)
+{
+    int32_t const min_x = std::max((int32_t)std::floor(std::min(std::min(x[0], x[1]), x[2])), tile_x);
+    int32_t const min_y = std::max((int32_t)std::floor(std::min(std::min(y[0], y[1]), y[2])), tile_y);
+    int32_t const max_x = std::min((int32_t)std::ceil(std::max(std::max(x[0], x[1]), x[2])), tile_x + (int32_t)OcclusionBuffer::kTileWidth);
+    int32_t const max_y = std::min((int32_t)std::ceil(std::max(std::max(y[0], y[1]), y[2])), tile_y + (int32_t)OcclusionBuffer::kTileHeight);
+
+    if(min_x >= max_x || min_y >= max_y)
+    {
+        return; // does not touch this tile
+    }
+
+    // Edge functions for edges (1, 2), (2, 0) and (0, 1), i.e., the barycentrics of vertices 0, 1 and 2
+    float const a0 = y[1] - y[2], b0 = x[2] - x[1];
+    float const a1 = y[2] - y[0], b1 = x[0] - x[2];
+    float const a2 = y[0] - y[1], b2 = x[1] - x[0];
+
+    float const area = b2 * (y[2] - y[0]) + a2 * (x[2] - x[0]);
+    float const rcp_area = 1.0f / area;
+
+    // Interpolating the depth directly in screen space is correct since z/w is affine there
+    float const dzdx = (a0 * z[0] + a1 * z[1] + a2 * z[2]) * rcp_area;
+
+    for(int32_t py = min_y; py < max_y; ++py)
+    {
+        float const sx = (float)min_x + 0.5f;
+        float const sy = (float)py + 0.5f;
+
+        float w0 = a0 * (sx - x[1]) + b0 * (sy - y[1]);
+        float w1 = a1 * (sx - x[2]) + b1 * (sy - y[2]);
+        float w2 = a2 * (sx - x[0]) + b2 * (sy - y[0]);
+
+        float depth = (w0 * z[0] + w1 * z[1] + w2 * z[2]) * rcp_area;
+
+        float *row = tile_depth + (py - tile_y) * OcclusionBuffer::kTileWidth - tile_x;
+
+        for(int32_t px = min_x; px < max_x; ++px)
+        {
+            bool const inside = (w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f);
+
+            row[px] = (inside ? std::min(row[px], depth) : row[px]);
+
+            w0 += a0;
+            w1 += a1;
+            w2 += a2;
+
+            depth += dzdx;
+        }
+    }
+}
+
+} //! unnamed namespace
+
+void OcclusionBuffer::resize(uint32_t width, uint32_t height)
+{
+    tile_count_x_ = (std::max(width, 1u) + kTileWidth - 1) / kTileWidth;
+    tile_count_y_ = (std::max(height, 1u) + kTileHeight - 1) / kTileHeight;
+
+    width_ = tile_count_x_ * kTileWidth;
+    height_ = tile_count_y_ * kTileHeight;
+
+    depth_.resize((size_t)width_ * height_);
+    tile_min_depths_.resize((size_t)tile_count_x_ * tile_count_y_);
+    tile_max_depths_.resize((size_t)tile_count_x_ * tile_count_y_);
+
+    begin(view_proj_);
+}
+
+void OcclusionBuffer::begin(glm::mat4 const &view_proj)
+{
+    view_proj_ = view_proj;
+
+    std::fill(depth_.begin(), depth_.end(), 1.0f);
+    std::fill(tile_min_depths_.begin(), tile_min_depths_.end(), 1.0f);
+    std::fill(tile_max_depths_.begin(), tile_max_depths_.end(), 1.0f);
+
+    occluders_.clear();
+}
+
+void OcclusionBuffer::addOccluder(float const *positions, uint32_t position_stride, uint32_t const *indices, uint32_t index_count, glm::mat4 const &transform)
+{
+    if(positions == nullptr || indices == nullptr || index_count < 3)
+    {
+        return; // nothing to rasterize
+    }
+
+    Occluder occluder = {};
+
+    occluder.positions = positions;
+    occluder.position_stride = position_stride;
+    occluder.indices = indices;
+    occluder.index_count = index_count - (index_count % 3);
+    occluder.transform = transform;
+
+    occluders_.push_back(occluder);
+}
+
+void OcclusionBuffer::rasterize(uint32_t thread_count)
+{
+    uint32_t const tile_count = tile_count_x_ * tile_count_y_;
+
+    if(tile_count == 0 || occluders_.empty())
+    {
+        return; // nothing to rasterize
+    }
+
+    occluder_first_triangles_.resize(occluders_.size() + 1);
+    occluder_first_triangles_[0] = 0;
+
+    for(size_t i = 0; i < occluders_.size(); ++i)
+    {
+        occluder_first_triangles_[i + 1] = occluder_first_triangles_[i] + occluders_[i].index_count / 3;
+    }
+
+    uint32_t const triangle_count = occluder_first_triangles_.back();
+
+    if(thread_count == 0)
+    {
+        thread_count = gfxGetJobSystem().get_thread_count();
+    }
+
+    thread_count = std::max(std::min(thread_count, triangle_count / kMinTrianglesPerThread), 1u);
+
+    if(thread_triangles_.size() < thread_count)
+    {
+        thread_triangles_.resize(thread_count);
+    }
+
+    thread_bins_.resize((size_t)thread_count * tile_count);
+
+    // Each job transforms and bins its own range of triangles, so no synchronization is needed...
+    gfxGetJobSystem().parallel_for(thread_count, 1, [&](uint32_t thread_index)
+    {
+        binTriangles(thread_index, thread_count);
+    });
+
+    // ...then each tile is owned by a single job that walks the bins in order
+    gfxGetJobSystem().parallel_for(tile_count, 1, [&](uint32_t tile_index)
+    {
+        rasterizeTile(tile_index, thread_count);
+    });
+}
+
+void OcclusionBuffer::binTriangles(uint32_t thread_index, uint32_t thread_count)
+{
+    uint32_t const triangle_count = occluder_first_triangles_.back();
+    uint32_t const tile_count = tile_count_x_ * tile_count_y_;
+
+    uint32_t const begin = (uint32_t)(((uint64_t)triangle_count * (thread_index + 0)) / thread_count);
+    uint32_t const end   = (uint32_t)(((uint64_t)triangle_count * (thread_index + 1)) / thread_count);
+
+    std::vector<Triangle> &triangles = thread_triangles_[thread_index];
+    std::vector<uint32_t> *bins = &thread_bins_[(size_t)thread_index * tile_count];
+
+    triangles.clear();
+
+    for(uint32_t i = 0; i < tile_count; ++i)
+    {
+        bins[i].clear();
+    }
+
+    size_t occluder_index = std::upper_bound(occluder_first_triangles_.begin(), occluder_first_triangles_.end(), begin) - occluder_first_triangles_.begin() - 1;
+
+    float const width = (float)width_;
+    float const height = (float)height_;
+
+    for(uint32_t triangle_index = begin; triangle_index < end; ++occluder_index)
+    {
+        Occluder const &occluder = occluders_[occluder_index];
+
+        glm::mat4 const transform = view_proj_ * occluder.transform;
+
+        uint32_t const occluder_end = std::min(occluder_first_triangles_[occluder_index + 1], end);
+
+        for(; triangle_index < occluder_end; ++triangle_index)
+        {
+            uint32_t const *indices = &occluder.indices[3 * (triangle_index - occluder_first_triangles_[occluder_index])];
+
+            Triangle triangle = {};
+            bool clipped = false;
+
+            for(uint32_t v = 0; v < 3; ++v)
+            {
+                float const *position = (float const *)((char const *)occluder.positions + (size_t)indices[v] * occluder.position_stride);
+
+                glm::vec4 const clip = transform * glm::vec4(position[0], position[1], position[2], 1.0f);
+
+                // Triangles crossing the near plane are dropped rather than clipped; losing an occluder is always safe
+                clipped |= (clip.w < kMinClipW || clip.z < 0.0f);
+
+                float const rcp_w = 1.0f / clip.w;
+
+                triangle.x[v] = ( clip.x * rcp_w * 0.5f + 0.5f) * width;
+                triangle.y[v] = (-clip.y * rcp_w * 0.5f + 0.5f) * height;
+                triangle.z[v] = clip.z * rcp_w;
+            }
+
+            if(clipped)
+            {
+                continue;
+            }
+
+            // Occluders are rasterized double-sided, so just fix up the winding
+            float const area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+
+            if(area == 0.0f || !std::isfinite(area))
+            {
+                continue;   // degenerate
+            }
+
+            if(area < 0.0f)
+            {
+                std::swap(triangle.x[1], triangle.x[2]);
+                std::swap(triangle.y[1], triangle.y[2]);
+                std::swap(triangle.z[1], triangle.z[2]);
+            }
+
+            float const min_x = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float const min_y = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+            float const max_x = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+            float const max_y = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+
+            if(max_x <= 0.0f || max_y <= 0.0f || min_x >= width || min_y >= height)
+            {
+                continue;   // off-screen
+            }
+
+            uint32_t const min_tile_x = (uint32_t)std::max(min_x, 0.0f) / kTileWidth;
+            uint32_t const min_tile_y = (uint32_t)std::max(min_y, 0.0f) / kTileHeight;
+            uint32_t const max_tile_x = std::min((uint32_t)max_x / kTileWidth, tile_count_x_ - 1);
+            uint32_t const max_tile_y = std::min((uint32_t)max_y / kTileHeight, tile_count_y_ - 1);
+
+            uint32_t const index = (uint32_t)triangles.size();
+
+            triangles.push_back(triangle);
+
+            for(uint32_t tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y)
+            {
+                for(uint32_t tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x)
+                {
+                    bins[tile_y * tile_count_x_ + tile_x].push_back(index);
+                }
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::rasterizeTile(uint32_t tile_index, uint32_t thread_count)
+{
+    uint32_t const tile_count = tile_count_x_ * tile_count_y_;
+
+    int32_t const tile_x = (int32_t)((tile_index % tile_count_x_) * kTileWidth);
+    int32_t const tile_y = (int32_t)((tile_index / tile_count_x_) * kTileHeight);
+
+    float *tile_depth = &depth_[(size_t)tile_index * kTileWidth * kTileHeight];
+
+    for(uint32_t i = 0; i < thread_count; ++i)
+    {
+        std::vector<Triangle> const &triangles = thread_triangles_[i];
+        std::vector<uint32_t> const &bin = thread_bins_[(size_t)i * tile_count + tile_index];
+
+        for(uint32_t triangle_index : bin)
+        {
+            Triangle const &triangle = triangles[triangle_index];
+
+            RasterizeTriangle(triangle.x, triangle.y, triangle.z, tile_x, tile_y, tile_depth);
+        }
+    }
+
+    float min_depth = 1.0f;
+    float max_depth = 0.0f;
+
+    for(uint32_t i = 0; i < kTileWidth * kTileHeight; ++i)
+    {
+        min_depth = std::min(min_depth, tile_depth[i]);
+        max_depth = std::max(max_depth, tile_depth[i]);
+    }
+
+    tile_min_depths_[tile_index] = min_depth;
+    tile_max_depths_[tile_index] = max_depth;
+}
+
+OcclusionBuffer::ProjectResult OcclusionBuffer::projectBox(glm::vec3 const &bounds_min, glm::vec3 const &bounds_max, glm::mat4 const &transform, ScreenRect &rect) const
+{
+    glm::mat4 const mvp = view_proj_ * transform;
+
+    float min_x =  1.0f, min_y =  1.0f, min_z = 1.0f;
+    float max_x = -1.0f, max_y = -1.0f;
+
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        glm::vec4 const corner((i & 1) != 0 ? bounds_max.x : bounds_min.x,
+                               (i & 2) != 0 ? bounds_max.y : bounds_min.y,
+                               (i & 4) != 0 ? bounds_max.z : bounds_min.z, 1.0f);
+
+        glm::vec4 const clip = mvp * corner;
+
+        if(clip.w < kMinClipW || clip.z < 0.0f)
+        {
+            return kProjectResult_Visible;  // crosses the near plane
+        }
+
+        float const rcp_w = 1.0f / clip.w;
+
+        min_x = std::min(min_x, clip.x * rcp_w);
+        min_y = std::min(min_y, clip.y * rcp_w);
+        min_z = std::min(min_z, clip.z * rcp_w);
+        max_x = std::max(max_x, clip.x * rcp_w);
+        max_y = std::max(max_y, clip.y * rcp_w);
+    }
+
+    if(min_x >= 1.0f || min_y >= 1.0f || max_x <= -1.0f || max_y <= -1.0f || min_z > 1.0f)
+    {
+        return kProjectResult_Offscreen;
+    }
+
+    float const width = (float)width_;
+    float const height = (float)height_;
+
+    // Round outwards so that every pixel the bounds touch gets tested
+    rect.min_x = (int32_t)std::floor(( std::max(min_x, -1.0f) * 0.5f + 0.5f) * width);
+    rect.min_y = (int32_t)std::floor((-std::min(max_y,  1.0f) * 0.5f + 0.5f) * height);
+    rect.max_x = (int32_t)std::ceil (( std::min(max_x,  1.0f) * 0.5f + 0.5f) * width);
+    rect.max_y = (int32_t)std::ceil ((-std::max(min_y, -1.0f) * 0.5f + 0.5f) * height);
+
+    rect.min_x = std::max(rect.min_x, 0);
+    rect.min_y = std::max(rect.min_y, 0);
+    rect.max_x = std::min(std::max(rect.max_x, rect.min_x + 1), (int32_t)width_);
+    rect.max_y = std::min(std::max(rect.max_y, rect.min_y + 1), (int32_t)height_);
+    rect.min_z = min_z;
+
+    return kProjectResult_Rect;
+}
+
+bool OcclusionBuffer::isRectVisible(ScreenRect const &rect) const
+{
+    int32_t const min_tile_x = rect.min_x / (int32_t)kTileWidth;
+    int32_t const min_tile_y = rect.min_y / (int32_t)kTileHeight;
+    int32_t const max_tile_x = (rect.max_x - 1) / (int32_t)kTileWidth;
+    int32_t const max_tile_y = (rect.max_y - 1) / (int32_t)kTileHeight;
+
+    for(int32_t tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y)
+    {
+        for(int32_t tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x)
+        {
+            uint32_t const tile_index = (uint32_t)(tile_y * (int32_t)tile_count_x_ + tile_x);
+
+            if(rect.min_z > tile_max_depths_[tile_index])
+            {
+                continue;   // behind everything in this tile
+            }
+
+            if(rect.min_z <= tile_min_depths_[tile_index])
+            {
+                return true;    // in front of everything in this tile
+            }
+
+            // Straddles the tile's depth range, so fall back to testing the covered pixels
+            int32_t const x0 = std::max(rect.min_x, tile_x * (int32_t)kTileWidth) - tile_x * (int32_t)kTileWidth;
+            int32_t const y0 = std::max(rect.min_y, tile_y * (int32_t)kTileHeight) - tile_y * (int32_t)kTileHeight;
+            int32_t const x1 = std::min(rect.max_x, (tile_x + 1) * (int32_t)kTileWidth) - tile_x * (int32_t)kTileWidth;
+            int32_t const y1 = std::min(rect.max_y, (tile_y + 1) * (int32_t)kTileHeight) - tile_y * (int32_t)kTileHeight;
+
+            float const *tile_depth = &depth_[(size_t)tile_index * kTileWidth * kTileHeight];
+
+            for(int32_t y = y0; y < y1; ++y)
+            {
+                float const *row = tile_depth + y * kTileWidth;
+
+                for(int32_t x = x0; x < x1; ++x)
+                {
+                    if(rect.min_z <= row[x])
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+bool OcclusionBuffer::isVisible(glm::vec3 const &bounds_min, glm::vec3 const &bounds_max, glm::mat4 const &transform) const
+{
+    if(depth_.empty())
+    {
+        return true;    // no occlusion information
+    }
+
+    ScreenRect rect;
+
+    switch(projectBox(bounds_min, bounds_max, transform, rect))
+    {
+    case kProjectResult_Visible:
+        return true;
+    case kProjectResult_Offscreen:
+        return false;
+    default:
+        return isRectVisible(rect);
+    }
+}
+
+bool OcclusionBuffer::isVisible(glm::vec3 const &center, float radius) const
+{
+    return isVisible(center - glm::vec3(radius), center + glm::vec3(radius), glm::mat4(1.0f));
+}
+
+float OcclusionBuffer::calculateScreenCoverage(glm::vec3 const &center, float radius) const
+{
+    if(depth_.empty())
+    {
+        return 0.0f;
+    }
+
+    ScreenRect rect;
+
+    switch(projectBox(center - glm::vec3(radius), center + glm::vec3(radius), glm::mat4(1.0f), rect))
+    {
+    case kProjectResult_Visible:
+        return 1.0f;
+    case kProjectResult_Offscreen:
+        return 0.0f;
+    default:
+        return (float)((rect.max_x - rect.min_x) * (rect.max_y - rect.min_y)) / (float)(width_ * height_);
+    }
+}
+
+float OcclusionBuffer::getDepth(uint32_t x, uint32_t y) const
+{
+    if(x >= width_ || y >= height_)
+    {
+        return 1.0f;
+    }
+
+    uint32_t const tile_index = (y / kTileHeight) * tile_count_x_ + (x / kTileWidth);
+
+    return depth_[(size_t)tile_index * kTileWidth * kTileHeight + (y % kTileHeight) * kTileWidth + (x % kTileWidth)];
+}
+
+void CullOccludedInstances(OcclusionBuffer const &occlusion_buffer, CullingBounds const &bounds, std::vector<uint32_t> &visible_indices)
+{
+    float const *center_x = bounds.getCentersX();
+    float const *center_y = bounds.getCentersY();
+    float const *center_z = bounds.getCentersZ();
+    float const *radius = bounds.getRadii();
+
+    size_t visible_count = 0;
+
+    for(size_t i = 0; i < visible_indices.size(); ++i)
+    {
+        uint32_t const index = visible_indices[i];
+
+        if(index >= bounds.getCount() || occlusion_buffer.isVisible(glm::vec3(center_x[index], center_y[index], center_z[index]), radius[index]))
+        {
+            visible_indices[visible_count++] = index;
+        }
+    }
+
+    visible_indices.resize(visible_count);
+}
@@ -0,0 +1,109 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "culling.h"
+
+// Low-resolution depth buffer that occluder meshes get rasterized into on the CPU, so that instances
+// hidden behind them can be rejected before submission. The buffer is split into tiles, each stored
+// contiguously and tracking its min/max depth so that most tests resolve without touching the pixels.
+// Uses nothing from gfx beyond the job system in gfx_core.h, so it builds and runs on any platform.
+class OcclusionBuffer
+{
+public:
+    static uint32_t const kTileWidth  = 32;
+    static uint32_t const kTileHeight = 16;
+
+    void resize(uint32_t width, uint32_t height);   // rounded up to whole tiles
+    void begin(glm::mat4 const &view_proj);         // clears the depth and the queued occluders
+
+    // The geometry must remain valid until rasterize() returns.
+    void addOccluder(float const *positions, uint32_t position_stride, uint32_t const *indices, uint32_t index_count, glm::mat4 const &transform);
+    void rasterize(uint32_t thread_count = 0);      // bins the occluder triangles in `thread_count' jobs and rasterizes them tile by tile; 0 uses all the job system's threads
+
+    // Conservative tests; returning true means the object may be visible.
+    bool isVisible(glm::vec3 const &bounds_min, glm::vec3 const &bounds_max, glm::mat4 const &transform) const;
+    bool isVisible(glm::vec3 const &center, float radius) const;
+
+    float calculateScreenCoverage(glm::vec3 const &center, float radius) const; // fraction of the buffer covered by the sphere's bounds
+
+    inline uint32_t getWidth() const { return width_; }
+    inline uint32_t getHeight() const { return height_; }
+    float getDepth(uint32_t x, uint32_t y) const;
+
+private:
+    struct Occluder
+    {
+        float const    *positions;
+        uint32_t        position_stride;
+        uint32_t const *indices;
+        uint32_t        index_count;
+        glm::mat4       transform;
+    };
+
+    struct Triangle
+    {
+        float x[3];
+        float y[3];
+        float z[3];
+    };
+
+    struct ScreenRect
+    {
+        int32_t min_x;
+        int32_t min_y;
+        int32_t max_x;  // exclusive
+        int32_t max_y;  // exclusive
+        float   min_z;
+    };
+
+    enum ProjectResult
+    {
+        kProjectResult_Visible = 0, // crosses the near plane
+        kProjectResult_Offscreen,
+        kProjectResult_Rect
+    };
+
+    ProjectResult projectBox(glm::vec3 const &bounds_min, glm::vec3 const &bounds_max, glm::mat4 const &transform, ScreenRect &rect) const;
+    bool isRectVisible(ScreenRect const &rect) const;
+
+    void binTriangles(uint32_t thread_index, uint32_t thread_count);
+    void rasterizeTile(uint32_t tile_index, uint32_t thread_count);
+
+    std::vector<float> depth_;
+    std::vector<float> tile_min_depths_;
+    std::vector<float> tile_max_depths_;
+    std::vector<Occluder> occluders_;
+    std::vector<uint32_t> occluder_first_triangles_;
+    std::vector<std::vector<Triangle>> thread_triangles_;
+    std::vector<std::vector<uint32_t>> thread_bins_;    // triangles overlapping each tile, per binning job
+    glm::mat4 view_proj_ = glm::mat4(1.0f);
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t tile_count_x_ = 0;
+    uint32_t tile_count_y_ = 0;
+};
+
+// Removes the occluded instances from `visible_indices`, preserving the order.
+void CullOccludedInstances(OcclusionBuffer const &occlusion_buffer, CullingBounds const &bounds, std::vector<uint32_t> &visible_indices);
@@ -0,0 +1,191 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "raytracing_scene.h"
+
+namespace
+{
+
+RaytracingMesh CreateRaytracingMesh(GfxContext gfx, GfxAccelerationStructure acceleration_structure, GfxMesh const &mesh)
+{
+    RaytracingMesh raytracing_mesh = {};
+
+    std::vector<glm::vec3> positions(mesh.vertices.size());
+
+    for(size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        positions[i] = mesh.vertices[i].position;
+    }
+
+    raytracing_mesh.index_buffer  = gfxCreateBuffer<uint32_t>(gfx, (uint32_t)mesh.indices.size(), mesh.indices.data());
+    raytracing_mesh.vertex_buffer = gfxCreateBuffer<glm::vec3>(gfx, (uint32_t)positions.size(), positions.data());
+
+    raytracing_mesh.blas = gfxCreateRaytracingPrimitive(gfx, acceleration_structure);
+
+    gfxRaytracingPrimitiveBuild(gfx, raytracing_mesh.blas, raytracing_mesh.index_buffer, raytracing_mesh.vertex_buffer);
+    gfxRaytracingPrimitiveSetInstanceMask(gfx, raytracing_mesh.blas, 0);
+
+    return raytracing_mesh;
+}
+
+void ReleaseRaytracingMesh(GfxContext gfx, RaytracingMesh const &raytracing_mesh)
+{
+    gfxDestroyRaytracingPrimitive(gfx, raytracing_mesh.blas);
+    gfxDestroyBuffer(gfx, raytracing_mesh.index_buffer);
+    gfxDestroyBuffer(gfx, raytracing_mesh.vertex_buffer);
+}
+
+} //! unnamed namespace
+
+RaytracingScene CreateRaytracingScene(GfxContext gfx, GfxScene scene)
+{
+    RaytracingScene raytracing_scene = {};
+
+    raytracing_scene.acceleration_structure = gfxCreateAccelerationStructure(gfx);
+
+    UpdateRaytracingScene(gfx, scene, raytracing_scene);
+
+    return raytracing_scene;
+}
+
+void ReleaseRaytracingScene(GfxContext gfx, RaytracingScene const &raytracing_scene)
+{
+    for(GfxRaytracingPrimitive const &instance : raytracing_scene.instances)
+    {
+        gfxDestroyRaytracingPrimitive(gfx, instance);
+    }
+
+    for(auto const &mesh : raytracing_scene.meshes)
+    {
+        ReleaseRaytracingMesh(gfx, mesh.second);
+    }
+
+    gfxDestroyAccelerationStructure(gfx, raytracing_scene.acceleration_structure);
+}
+
+void UpdateRaytracingScene(GfxContext gfx, GfxScene scene, RaytracingScene &raytracing_scene)
+{
+    GfxInstance const *instances = gfxSceneGetInstances(scene);
+
+    uint32_t const instance_count = gfxSceneGetInstanceCount(scene);
+
+    // Find out which instances and meshes were added or removed
+    raytracing_scene.instance_handles.resize(instance_count);
+    raytracing_scene.mesh_handles.resize(instance_count);
+
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        raytracing_scene.instance_handles[i] = (uint64_t)gfxSceneGetInstanceHandle(scene, i);
+        raytracing_scene.mesh_handles[i]     = (uint64_t)instances[i].mesh;
+    }
+
+    BlasSharingMap::Changes &changes = raytracing_scene.changes;
+
+    raytracing_scene.blas_sharing_map.update(raytracing_scene.instance_handles.data(), raytracing_scene.mesh_handles.data(), instance_count, changes);
+
+    // Release the instances first, so that no instance outlives its BLAS
+    for(uint64_t instance_handle : changes.removed_instances)
+    {
+        GfxRaytracingPrimitive &instance = raytracing_scene.instances[(uint32_t)instance_handle];
+
+        gfxDestroyRaytracingPrimitive(gfx, instance);
+
+        instance = {};
+    }
+
+    for(uint64_t mesh_handle : changes.removed_meshes)
+    {
+        ReleaseRaytracingMesh(gfx, raytracing_scene.meshes[mesh_handle]);
+
+        raytracing_scene.meshes.erase(mesh_handle);
+    }
+
+    // Build a single BLAS per new mesh
+    for(uint64_t mesh_handle : changes.added_meshes)
+    {
+        GfxMesh const *mesh = gfxSceneGetMesh(scene, mesh_handle);
+
+        if(mesh != nullptr)
+        {
+            raytracing_scene.meshes[mesh_handle] = CreateRaytracingMesh(gfx, raytracing_scene.acceleration_structure, *mesh);
+        }
+    }
+
+    // And instantiate it for each of the new instances
+    for(uint64_t instance_handle : changes.added_instances)
+    {
+        uint32_t const instance_id = (uint32_t)instance_handle;
+
+        if(instance_id >= raytracing_scene.instances.size())
+        {
+            raytracing_scene.instances.resize(instance_id + 1);
+            raytracing_scene.transforms.resize(instance_id + 1);
+        }
+
+        glm::mat4 const &transform = gfxSceneGetInstance(scene, instance_handle)->transform;
+
+        raytracing_scene.transforms[instance_id] = transform;
+
+        auto const mesh = raytracing_scene.meshes.find(raytracing_scene.blas_sharing_map.getInstanceMesh(instance_handle));
+
+        if(mesh == raytracing_scene.meshes.end())
+        {
+            continue;   // instance has no valid mesh
+        }
+
+        GfxRaytracingPrimitive instance = gfxCreateRaytracingPrimitive(gfx, mesh->second.blas);
+
+        glm::mat4 const row_major_transform = glm::transpose(transform);
+
+        gfxRaytracingPrimitiveSetInstanceID(gfx, instance, instance_id);
+        gfxRaytracingPrimitiveSetTransform(gfx, instance, &row_major_transform[0][0]);
+
+        raytracing_scene.instances[instance_id] = instance;
+    }
+
+    // Move the instances whose transform has changed
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        uint32_t const instance_id = (uint32_t)raytracing_scene.instance_handles[i];
+
+        glm::mat4 const &transform = instances[i].transform;
+
+        if(transform == raytracing_scene.transforms[instance_id])
+        {
+            continue;   // instance didn't move
+        }
+
+        raytracing_scene.transforms[instance_id] = transform;
+
+        if(!raytracing_scene.instances[instance_id])
+        {
+            continue;   // instance has no valid mesh
+        }
+
+        glm::mat4 const row_major_transform = glm::transpose(transform);
+
+        gfxRaytracingPrimitiveSetTransform(gfx, raytracing_scene.instances[instance_id], &row_major_transform[0][0]);
+    }
+
+    gfxAccelerationStructureUpdate(gfx, raytracing_scene.acceleration_structure);   // early outs if nothing changed
+}
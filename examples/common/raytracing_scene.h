@@ -0,0 +1,55 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "gfx_scene.h"
+#include "blas_sharing_map.h"
+
+struct RaytracingMesh
+{
+    GfxBuffer index_buffer;
+    GfxBuffer vertex_buffer;
+    GfxRaytracingPrimitive blas;    // masked out; only ever traced through its instances
+};
+
+struct RaytracingScene
+{
+    GfxAccelerationStructure acceleration_structure;
+
+    BlasSharingMap blas_sharing_map;
+    BlasSharingMap::Changes changes;
+
+    std::unordered_map<uint64_t, RaytracingMesh> meshes;   // one BLAS per unique mesh
+
+    std::vector<GfxRaytracingPrimitive> instances;  // one instanced primitive per instance id
+    std::vector<glm::mat4> transforms;
+
+    std::vector<uint64_t> instance_handles;
+    std::vector<uint64_t> mesh_handles;
+};
+
+RaytracingScene CreateRaytracingScene(GfxContext gfx, GfxScene scene);
+void ReleaseRaytracingScene(GfxContext gfx, RaytracingScene const &raytracing_scene);
+
+void UpdateRaytracingScene(GfxContext gfx, GfxScene scene, RaytracingScene &raytracing_scene);  // syncs the added/removed/moved instances, then updates the acceleration structure
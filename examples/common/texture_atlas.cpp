@@ -0,0 +1,256 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+uint32_t NextPowerOfTwo(uint32_t value)
+{
+    uint32_t power = 1;
+
+    while(power < value)
+    {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+uint32_t CountTrailingZeros(uint32_t value)
+{
+    uint32_t count = 0;
+
+    while(count < 31 && (value & (1u << count)) == 0)
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+uint32_t FloorLog2(uint32_t value)
+{
+    uint32_t log2 = 0;
+
+    while((value >> log2) > 1)
+    {
+        ++log2;
+    }
+
+    return log2;
+}
+
+uint32_t AlignUp(uint32_t value, uint32_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} //! unnamed namespace
+
+uint32_t TextureAtlasPacker::pack(AtlasImage const *images, uint32_t image_count, uint32_t max_atlas_size, uint32_t border, float max_waste)
+{
+    images_.assign(images, images + image_count);
+    placements_.resize(image_count);
+    order_.clear();
+
+    border_ = border;
+    max_atlas_size = std::min(NextPowerOfTwo(std::max(max_atlas_size, 1u)), 1u << 15);
+
+    uint32_t const max_lod = (border != 0 ? FloorLog2(border) : 0);
+
+    // Size each cell, narrowing the border of the images it would otherwise dwarf
+    uint64_t total_area = 0;
+    uint32_t widest_cell = 1;
+
+    for(uint32_t i = 0; i < image_count; ++i)
+    {
+        AtlasImage const &image = images[i];
+        AtlasPlacement &placement = placements_[i];
+
+        placement = AtlasPlacement { kInvalidAtlas, 0, 0, 0 };
+
+        if(image.width == 0 || image.height == 0)
+        {
+            continue;   // nothing to pack
+        }
+
+        uint64_t const image_area = (uint64_t)image.width * image.height;
+
+        placement.max_lod = std::min(std::min(CountTrailingZeros(image.width), CountTrailingZeros(image.height)), max_lod);
+
+        for(;;)
+        {
+            uint32_t const image_border = getImageBorder(i);
+            uint64_t const cell_area = (uint64_t)(image.width + 2 * image_border) * (image.height + 2 * image_border);
+
+            if((double)(cell_area - image_area) <= (double)max_waste * (double)cell_area || placement.max_lod == 0)
+            {
+                break;
+            }
+
+            --placement.max_lod;
+        }
+
+        uint32_t const image_border = getImageBorder(i);
+        uint32_t const cell_width = image.width + 2 * image_border;
+        uint32_t const cell_height = image.height + 2 * image_border;
+        uint64_t const cell_area = (uint64_t)cell_width * cell_height;
+
+        if((double)(cell_area - image_area) > (double)max_waste * (double)cell_area || cell_width > max_atlas_size || cell_height > max_atlas_size)
+        {
+            continue;   // cheaper left on its own, or doesn't fit
+        }
+
+        total_area += cell_area;
+        widest_cell = std::max(widest_cell, cell_width);
+
+        order_.push_back(i);
+    }
+
+    // Tallest cells first so that each shelf gets filled with cells of similar heights
+    std::stable_sort(order_.begin(), order_.end(), [&](uint32_t lhs, uint32_t rhs)
+    {
+        uint32_t const lhs_border = 2 * getImageBorder(lhs), rhs_border = 2 * getImageBorder(rhs);
+
+        if(images[lhs].height + lhs_border != images[rhs].height + rhs_border)
+        {
+            return images[lhs].height + lhs_border > images[rhs].height + rhs_border;
+        }
+
+        return images[lhs].width + lhs_border > images[rhs].width + rhs_border;
+    });
+
+    // Start from the smallest width that could hold everything, and widen until it all fits in a single atlas
+    uint32_t atlas_width = std::max(widest_cell, (uint32_t)std::ceil(std::sqrt((double)total_area)));
+
+    atlas_width = std::min(NextPowerOfTwo(atlas_width), max_atlas_size);
+
+    uint32_t atlas_count = packShelves(atlas_width);
+
+    while(atlas_count > 1 && atlas_width < max_atlas_size)
+    {
+        atlas_count = packShelves(atlas_width <<= 1);
+    }
+
+    return atlas_count;
+}
+
+uint32_t TextureAtlasPacker::packShelves(uint32_t atlas_width)
+{
+    atlas_width_ = atlas_width;
+    atlas_heights_.clear();
+
+    // Shelves start on a boundary that suits every image's mip alignment
+    uint32_t const shelf_alignment = (border_ != 0 ? 1u << FloorLog2(border_) : 1);
+
+    uint32_t shelf_x = atlas_width, shelf_y = 0, shelf_height = 0;
+
+    for(uint32_t i : order_)
+    {
+        AtlasImage const &image = images_[i];
+        AtlasPlacement &placement = placements_[i];
+
+        uint32_t const image_border = getImageBorder(i);
+        uint32_t const cell_width = image.width + 2 * image_border;
+        uint32_t const cell_height = image.height + 2 * image_border;
+
+        uint32_t cell_x = AlignUp(shelf_x, 1u << placement.max_lod);
+
+        if(cell_x + cell_width > atlas_width)
+        {
+            cell_x = 0; // start a new shelf
+
+            shelf_y = AlignUp(shelf_y + shelf_height, shelf_alignment);
+            shelf_height = cell_height;
+
+            if(atlas_heights_.empty() || shelf_y + cell_height > atlas_width)
+            {
+                shelf_y = 0;    // and a new atlas
+
+                atlas_heights_.push_back(0);
+            }
+        }
+
+        placement.atlas = (uint32_t)atlas_heights_.size() - 1;
+        placement.x = cell_x + image_border;
+        placement.y = shelf_y + image_border;
+
+        shelf_x = cell_x + cell_width;
+
+        atlas_heights_.back() = std::max(atlas_heights_.back(), shelf_y + cell_height);
+    }
+
+    for(uint32_t &atlas_height : atlas_heights_)
+    {
+        atlas_height = NextPowerOfTwo(atlas_height);
+    }
+
+    return (uint32_t)atlas_heights_.size();
+}
+
+void TextureAtlasPacker::copyImage(uint32_t image_index, void const *image_texels, uint32_t bytes_per_pixel, void *atlas_texels) const
+{
+    if(image_index >= (uint32_t)placements_.size() || placements_[image_index].atlas == kInvalidAtlas)
+    {
+        return; // not packed
+    }
+
+    AtlasImage const &image = images_[image_index];
+    AtlasPlacement const &placement = placements_[image_index];
+
+    uint8_t const *src = (uint8_t const *)image_texels;
+    uint8_t *dst = (uint8_t *)atlas_texels;
+
+    size_t const src_pitch = (size_t)image.width * bytes_per_pixel;
+    size_t const dst_pitch = (size_t)atlas_width_ * bytes_per_pixel;
+
+    int32_t const border = (int32_t)getImageBorder(image_index);
+    int32_t const width = (int32_t)image.width;
+    int32_t const height = (int32_t)image.height;
+
+    for(int32_t y = -border; y < height + border; ++y)
+    {
+        uint32_t const src_y = (uint32_t)(((y % height) + height) % height);
+
+        uint8_t const *src_row = src + src_y * src_pitch;
+        uint8_t *dst_row = dst + (placement.y + y) * dst_pitch + placement.x * bytes_per_pixel;
+
+        // Interior in one go, then the wrapped texels on either side
+        memcpy(dst_row, src_row, src_pitch);
+
+        for(int32_t x = 1; x <= border; ++x)
+        {
+            uint32_t const left_x  = (uint32_t)((((-x) % width) + width) % width);
+            uint32_t const right_x = (uint32_t)((x - 1) % width);
+
+            memcpy(dst_row - x * (int32_t)bytes_per_pixel, src_row + left_x * bytes_per_pixel, bytes_per_pixel);
+            memcpy(dst_row + (width + x - 1) * (int32_t)bytes_per_pixel, src_row + right_x * bytes_per_pixel, bytes_per_pixel);
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct AtlasImage
+{
+    uint32_t width;
+    uint32_t height;
+};
+
+struct AtlasPlacement
+{
+    uint32_t atlas;     // or kInvalidAtlas if the image wasn't packed
+    uint32_t x;         // top-left texel of the image, inside its border
+    uint32_t y;
+    uint32_t max_lod;   // highest mip level that can be sampled without bleeding into the neighboring cells
+};
+
+// Packs small images into atlases using shelves of rectangles. Each image is surrounded by a border of
+// 2^max_lod wrapped texels and placed at a multiple of 2^max_lod, so that its mips only ever average
+// texels of the same cell, and bilinear filtering with wrap addressing can be emulated in the shader
+// up to `max_lod`. The border gets narrowed (lowering `max_lod`) when it would make up more than
+// `max_waste` of the cell, and images that remain over budget are left out of the atlases.
+// Has no dependencies on gfx so it can be built and exercised on any platform.
+class TextureAtlasPacker
+{
+public:
+    static uint32_t const kInvalidAtlas = 0xFFFFFFFFu;
+    static uint32_t const kDefaultBorder = 4;
+    static constexpr float kDefaultMaxWaste = 0.5f;
+
+    // Returns the number of atlases; they all share the same power-of-two width, which is the smallest
+    // (up to `max_atlas_size`) that holds everything, while their heights are trimmed to the power of
+    // two that covers their content.
+    uint32_t pack(AtlasImage const *images, uint32_t image_count, uint32_t max_atlas_size, uint32_t border = kDefaultBorder, float max_waste = kDefaultMaxWaste);
+
+    inline uint32_t getAtlasWidth() const { return atlas_width_; }
+    inline uint32_t getAtlasHeight(uint32_t atlas) const { return atlas_heights_[atlas]; }
+    inline uint32_t getBorder() const { return border_; }
+    inline AtlasPlacement const *getPlacements() const { return placements_.data(); }
+
+    // Border of wrapped texels that surrounds a packed image.
+    inline uint32_t getImageBorder(uint32_t image_index) const { return (border_ != 0 ? 1u << placements_[image_index].max_lod : 0); }
+
+    // Writes the image and its wrapped border into the atlas texels; images occupy disjoint cells so
+    // that different images can be copied concurrently.
+    void copyImage(uint32_t image_index, void const *image_texels, uint32_t bytes_per_pixel, void *atlas_texels) const;
+
+private:
+    uint32_t packShelves(uint32_t atlas_width);
+
+    std::vector<AtlasPlacement> placements_;
+    std::vector<AtlasImage> images_;
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> atlas_heights_;
+    uint32_t atlas_width_ = 0;
+    uint32_t border_ = 0;
+};
@@ -104,7 +104,21 @@ class GfxInternal
     ID3D12Fence **fences_ = nullptr;
     uint64_t *fence_values_ = nullptr;
 
+    GfxQueue queue_ = kGfxQueue_Graphics;
+    ID3D12CommandQueue *compute_queue_ = nullptr;
+    ID3D12GraphicsCommandList *idle_command_list_ = nullptr;    // command list of the queue that isn't being recorded into
+    ID3D12GraphicsCommandList4 *idle_dxr_command_list_ = nullptr;
+    ID3D12GraphicsCommandList6 *idle_mesh_command_list_ = nullptr;
+    ID3D12CommandAllocator **compute_command_allocators_ = nullptr;
+    ID3D12Fence *queue_fences_[kGfxQueue_Count] = {};
+    uint64_t queue_fence_values_[kGfxQueue_Count] = {};
+    std::vector<uint64_t> compute_queue_buffers_;   // buffers used on the compute queue; released by the graphics queue upon gfxSignal()
+    std::vector<uint64_t> compute_queue_textures_;
+    bool compute_queue_hazard_ = false;             // a resource owned by the graphics queue was used on the compute queue
+
     bool debug_shaders_ = false;
+    uint32_t reserved_descriptor_count_ = D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_1;
+    uint32_t descriptor_repopulation_count_ = 0;    // kernels and SBTs that re-populated their descriptors into a new heap
     IDxcUtils *dxc_utils_ = nullptr;
     IDxcCompiler3 *dxc_compiler_ = nullptr;
     IDxcIncludeHandler *dxc_include_handler_ = nullptr;
@@ -221,7 +235,7 @@ class GfxInternal
         GfxProgram mip_program_ = {};
         GfxKernel mip_kernel_ = {};
     };
-    std::map<uint32_t, MipKernels> mip_kernels_;
+    GfxHashMap<uint32_t, MipKernels> mip_kernels_;
 
     struct ScanKernels
     {
@@ -231,7 +245,7 @@ class GfxInternal
         GfxKernel scan_kernel_ = {};
         GfxKernel args_kernel_ = {};
     };
-    std::map<uint32_t, ScanKernels> scan_kernels_;
+    GfxHashMap<uint32_t, ScanKernels> scan_kernels_;
 
     struct SortKernels
     {
@@ -241,7 +255,7 @@ class GfxInternal
         GfxKernel args_kernel_ = {};
     };
     GfxBuffer sort_scratch_buffer_;
-    std::map<uint32_t, SortKernels> sort_kernels_;
+    GfxHashMap<uint32_t, SortKernels> sort_kernels_;
 
     struct String
     {
@@ -292,6 +306,9 @@ class GfxInternal
     };
     std::deque<Garbage> garbage_collection_;
 
+    GfxMemoryTracker<GfxMemoryBudgetCallback> memory_tracker_;
+    GfxContext context_ = {};
+
     struct DescriptorHeap
     {
         inline D3D12_CPU_DESCRIPTOR_HANDLE getCPUHandle(uint32_t descriptor_slot) const
@@ -374,8 +391,7 @@ class GfxInternal
         Data draw_state_;
         uint32_t reference_count_;
     };
-    static GfxArray<DrawState> draw_states_;
-    static GfxHandles draw_state_handles_;
+    static GfxSlotMap<DrawState> draw_states_;
 
     struct Object
     {
@@ -397,9 +413,9 @@ class GfxInternal
         D3D12MA::Allocation *allocation_ = nullptr;
         D3D12_RESOURCE_STATES *resource_state_ = nullptr;
         D3D12_RESOURCE_STATES initial_resource_state_ = D3D12_RESOURCE_STATE_COMMON;
+        bool compute_queue_ = false;    // whether the buffer was used on the compute queue
     };
-    GfxArray<Buffer> buffers_;
-    GfxHandles buffer_handles_;
+    GfxSlotMap<Buffer> buffers_;
 
     struct Texture : public Object
     {
@@ -418,17 +434,16 @@ class GfxInternal
         std::vector<uint32_t> rtv_descriptor_slots_[D3D12_REQ_MIP_LEVELS];
         D3D12_RESOURCE_STATES resource_state_ = D3D12_RESOURCE_STATE_COMMON;
         D3D12_RESOURCE_STATES initial_resource_state_ = D3D12_RESOURCE_STATE_COMMON;
+        bool compute_queue_ = false;    // whether the texture was used on the compute queue
     };
-    GfxArray<Texture> textures_;
-    GfxHandles texture_handles_;
+    GfxSlotMap<Texture> textures_;
 
     struct SamplerState
     {
         D3D12_SAMPLER_DESC sampler_desc_ = {};
         uint32_t descriptor_slot_ = 0xFFFFFFFFu;
     };
-    GfxArray<SamplerState> sampler_states_;
-    GfxHandles sampler_state_handles_;
+    GfxSlotMap<SamplerState> sampler_states_;
 
     struct AccelerationStructure
     {
@@ -438,8 +453,7 @@ class GfxInternal
         uint64_t bvh_data_size_ = 0;
         std::vector<GfxRaytracingPrimitive> raytracing_primitives_;
     };
-    GfxArray<AccelerationStructure> acceleration_structures_;
-    GfxHandles acceleration_structure_handles_;
+    GfxSlotMap<AccelerationStructure> acceleration_structures_;
 
     struct RaytracingPrimitive
     {
@@ -472,8 +486,7 @@ class GfxInternal
         }
         instance_;
     };
-    GfxArray<RaytracingPrimitive> raytracing_primitives_;
-    GfxHandles raytracing_primitive_handles_;
+    GfxSlotMap<RaytracingPrimitive> raytracing_primitives_;
 
     struct Program
     {
@@ -655,8 +668,7 @@ class GfxInternal
         Parameters parameters_;
         std::vector<String> include_paths_;
     };
-    GfxArray<Program> programs_;
-    GfxHandles program_handles_;
+    GfxSlotMap<Program> programs_;
 
     struct Kernel
     {
@@ -741,9 +753,9 @@ class GfxInternal
         GfxProgram program_ = {};
         Type type_ = kType_Count;
         DrawState::Data draw_state_;
-        std::vector<String> defines_;
-        std::vector<String> exports_;
-        std::vector<String> subobjects_;
+        GfxSmallVector<String, 4> defines_;
+        GfxSmallVector<String, 4> exports_;
+        GfxSmallVector<String, 2> subobjects_;
         std::map<std::wstring, LocalRootSignatureAssociation> local_root_signature_associations_;
         uint64_t descriptor_heap_id_ = 0;
         uint32_t *num_threads_ = nullptr;
@@ -770,8 +782,7 @@ class GfxInternal
         uint32_t parameter_count_ = 0;
         uint32_t vertex_stride_ = 0;
     };
-    GfxArray<Kernel> kernels_;
-    GfxHandles kernel_handles_;
+    GfxSlotMap<Kernel> kernels_;
 
     enum ShaderType
     {
@@ -794,18 +805,53 @@ class GfxInternal
         float duration_ = 0.0f;
         bool was_begun_ = false;
     };
-    GfxArray<TimestampQuery> timestamp_queries_;
-    GfxHandles timestamp_query_handles_;
+    GfxSlotMap<TimestampQuery> timestamp_queries_;
 
     struct TimestampQueryHeap
     {
         GfxBuffer query_buffer_ = {};
         ID3D12QueryHeap *query_heap_ = nullptr;
-        std::map<uint64_t, std::pair<uint32_t, GfxTimestampQuery>> timestamp_queries_;
+        GfxHashMap<uint64_t, std::pair<uint32_t, GfxTimestampQuery>> timestamp_queries_;
     };
     uint64_t timestamp_query_ticks_per_second_ = 0;
     TimestampQueryHeap *timestamp_query_heaps_ = nullptr;
 
+    struct Bundle
+    {
+        enum CommandType
+        {
+            kCommandType_BindKernel = 0,
+            kCommandType_BindIndexBuffer,
+            kCommandType_BindVertexBuffer,
+            kCommandType_SetViewport,
+            kCommandType_SetScissorRect,
+            kCommandType_Draw,
+            kCommandType_DrawIndexed,
+
+            kCommandType_Count
+        };
+
+        struct Command
+        {
+            CommandType type_;
+            union
+            {
+                uint32_t args_[5];  // draw arguments, or index into the bundle's kernels/buffers
+                float viewport_[4];
+                int32_t scissor_rect_[4];
+            };
+        };
+
+        std::vector<Command> commands_;
+        std::vector<GfxKernel> kernels_;
+        std::vector<GfxBuffer> buffers_;
+        bool is_recorded_ = false;
+    };
+    GfxSlotMap<Bundle> bundles_;
+    GfxBundle recording_bundle_ = {};
+    GfxKernel recording_kernel_ = {};
+    bool recording_index_buffer_ = false;
+
     struct Sbt
     {
         struct ShaderRecord
@@ -813,7 +859,7 @@ class GfxInternal
             uint32_t id_ = 0;
             uint32_t commited_id_ = 0xFFFFFFFFu;
             std::wstring shader_identifier_;
-            std::vector<Kernel::Parameter> bound_parameters_;
+            GfxSmallVector<Kernel::Parameter, 4> bound_parameters_;
             std::unique_ptr<Program::Parameters> parameters_;
         };
 
@@ -862,8 +908,7 @@ class GfxInternal
         D3D12_GPU_VIRTUAL_ADDRESS_RANGE_AND_STRIDE callable_shader_table_;
         GfxKernel kernel_ = {};
     };
-    GfxArray<Sbt> sbts_;
-    GfxHandles sbt_handles_;
+    GfxSlotMap<Sbt> sbts_;
 
     struct WindowsSecurityAttributes
     {
@@ -910,9 +955,9 @@ class GfxInternal
     };
 
 public:
-    GfxInternal(GfxContext &gfx) : buffer_handles_("buffer"), texture_handles_("texture"), sampler_state_handles_("sampler state")
-                                 , acceleration_structure_handles_("acceleration structure"), raytracing_primitive_handles_("raytracing primitive")
-                                 , program_handles_("program"), kernel_handles_("kernel"), timestamp_query_handles_("timestamp query"), sbt_handles_("shader binding table")
+    GfxInternal(GfxContext &gfx) : buffers_("buffer"), textures_("texture"), sampler_states_("sampler state")
+                                 , acceleration_structures_("acceleration structure"), raytracing_primitives_("raytracing primitive")
+                                 , programs_("program"), kernels_("kernel"), timestamp_queries_("timestamp query"), bundles_("bundle"), sbts_("shader binding table")
                                  { gfx.handle = reinterpret_cast<uint64_t>(this); }
     ~GfxInternal() { terminate(); }
 
@@ -1110,6 +1155,7 @@ public:
             adapters[i] = nullptr;
         }
         debug_shaders_ = ((flags & kGfxCreateContextFlag_EnableShaderDebugging) != 0);
+        reserved_descriptor_count_ = ((flags & kGfxCreateContextFlag_DisableDescriptorHeapReservation) != 0 ? 0 : reserved_descriptor_count_);
         device_->QueryInterface(IID_PPV_ARGS(&dxr_device_));
         device_->QueryInterface(IID_PPV_ARGS(&mesh_device_));
         SetDebugName(device_, "gfx_Device");
@@ -1334,6 +1380,7 @@ public:
         adapter_->GetDesc1(&adapter_desc);
         context.vendor_id = adapter_desc.VendorId;
         GFX_SNPRINTF(context.name, sizeof(context.name), "%ws", adapter_desc.Description);
+        context_ = context;     // for passing to the memory budget callbacks
         GFX_PRINTLN("Created %s `%ws'", isInterop() ? "interop context" : "Direct3D12 device", adapter_desc.Description);
         if(dxr_device_ == nullptr)
             GFX_PRINTLN("Warning: DXR-1.1 is not supported on the selected device; no raytracing will be available");
@@ -1362,12 +1409,12 @@ public:
         gfxFree(constant_buffer_pool_);
         gfxFree(constant_buffer_pool_cursors_);
 
-        for(std::map<uint32_t, MipKernels>::const_iterator it = mip_kernels_.begin(); it != mip_kernels_.end(); ++it)
+        for(GfxHashMap<uint32_t, MipKernels>::const_iterator it = mip_kernels_.begin(); it != mip_kernels_.end(); ++it)
         {
             destroyProgram((*it).second.mip_program_);
             destroyKernel((*it).second.mip_kernel_);
         }
-        for(std::map<uint32_t, ScanKernels>::const_iterator it = scan_kernels_.begin(); it != scan_kernels_.end(); ++it)
+        for(GfxHashMap<uint32_t, ScanKernels>::const_iterator it = scan_kernels_.begin(); it != scan_kernels_.end(); ++it)
         {
             destroyProgram((*it).second.scan_program_);
             destroyKernel((*it).second.reduce_kernel_);
@@ -1375,7 +1422,7 @@ public:
             destroyKernel((*it).second.scan_kernel_);
             destroyKernel((*it).second.args_kernel_);
         }
-        for(std::map<uint32_t, SortKernels>::const_iterator it = sort_kernels_.begin(); it != sort_kernels_.end(); ++it)
+        for(GfxHashMap<uint32_t, SortKernels>::const_iterator it = sort_kernels_.begin(); it != sort_kernels_.end(); ++it)
         {
             destroyProgram((*it).second.sort_program_);
             destroyKernel((*it).second.histogram_kernel_);
@@ -1450,6 +1497,23 @@ public:
         gfxFree(fence_values_);
         gfxFree(fences_);
 
+        if(compute_queue_ != nullptr)
+            compute_queue_->Release();
+        if(idle_command_list_ != nullptr)
+            idle_command_list_->Release();
+        if(idle_dxr_command_list_ != nullptr)
+            idle_dxr_command_list_->Release();
+        if(idle_mesh_command_list_ != nullptr)
+            idle_mesh_command_list_->Release();
+        if(compute_command_allocators_ != nullptr)
+            for(uint32_t i = 0; i < max_frames_in_flight_; ++i)
+                if(compute_command_allocators_[i] != nullptr)
+                    compute_command_allocators_[i]->Release();
+        gfxFree(compute_command_allocators_);
+        for(uint32_t i = 0; i < ARRAYSIZE(queue_fences_); ++i)
+            if(queue_fences_[i] != nullptr)
+                queue_fences_[i]->Release();
+
         if(dxc_utils_ != nullptr)
             dxc_utils_->Release();
         if(dxc_compiler_ != nullptr)
@@ -1464,7 +1528,10 @@ public:
             if(back_buffer_allocations_ != nullptr)
                 for(uint32_t i = 0; i < max_frames_in_flight_; ++i)
                     if(back_buffer_allocations_[i] != nullptr)
+                    {
+                        untrackAllocation(back_buffer_allocations_[i]);
                         back_buffer_allocations_[i]->Release();
+                    }
             gfxFree(back_buffer_allocations_);
         }
         if(back_buffers_ != nullptr)
@@ -1535,7 +1602,7 @@ public:
         resource_desc.MipLevels        = 1;
         resource_desc.SampleDesc.Count = 1;
         resource_desc.Layout           = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        buffer.handle = buffer_handles_.allocate_handle();
+        buffer.handle = buffers_.allocate_handle();
         D3D12MA::ALLOCATION_DESC allocation_desc = {};
         Buffer &gfx_buffer = buffers_.insert(buffer);
         switch(cpu_access)
@@ -1596,7 +1663,7 @@ public:
     GfxBuffer createBufferRange(GfxBuffer const &buffer, uint64_t byte_offset, uint64_t size)
     {
         GfxBuffer buffer_range = {};
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot create a buffer range from an invalid buffer object");
             return buffer_range;
@@ -1615,7 +1682,7 @@ public:
         }
         Buffer const gfx_buffer = buffers_[buffer];
         if(size == 0) size = (buffer.size - byte_offset);
-        buffer_range.handle = buffer_handles_.allocate_handle();
+        buffer_range.handle = buffers_.allocate_handle();
         Buffer &gfx_buffer_range = buffers_.insert(buffer_range, gfx_buffer);
         if(gfx_buffer_range.data_ != nullptr) gfx_buffer_range.data_ = (char *)gfx_buffer_range.data_ + byte_offset;
         GFX_ASSERT(gfx_buffer_range.resource_ != nullptr && gfx_buffer_range.reference_count_ != nullptr);
@@ -1632,17 +1699,17 @@ public:
     {
         if(!buffer)
             return kGfxResult_NoError;
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid buffer object");
         collect(buffers_[buffer]);  // release resources
         buffers_.erase(buffer); // destroy buffer
-        buffer_handles_.free_handle(buffer.handle);
+        buffers_.free_handle(buffer.handle);
         return kGfxResult_NoError;
     }
 
     void *getBufferData(GfxBuffer const &buffer)
     {
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
             return nullptr; // invalid buffer object
         Buffer const &gfx_buffer = buffers_[buffer];
         return gfx_buffer.data_;
@@ -1679,7 +1746,7 @@ public:
         resource_desc.MipLevels        = (uint16_t)mip_levels;
         resource_desc.Format           = format;
         resource_desc.SampleDesc.Count = 1;
-        texture.handle = texture_handles_.allocate_handle();
+        texture.handle = textures_.allocate_handle();
         Texture &gfx_texture = textures_.insert(texture);
         D3D12MA::ALLOCATION_DESC allocation_desc = {};
         allocation_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
@@ -1733,7 +1800,7 @@ public:
         resource_desc.MipLevels        = (uint16_t)mip_levels;
         resource_desc.Format           = format;
         resource_desc.SampleDesc.Count = 1;
-        texture.handle = texture_handles_.allocate_handle();
+        texture.handle = textures_.allocate_handle();
         Texture &gfx_texture = textures_.insert(texture);
         D3D12MA::ALLOCATION_DESC allocation_desc = {};
         allocation_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
@@ -1783,7 +1850,7 @@ public:
         resource_desc.MipLevels        = (uint16_t)mip_levels;
         resource_desc.Format           = format;
         resource_desc.SampleDesc.Count = 1;
-        texture.handle = texture_handles_.allocate_handle();
+        texture.handle = textures_.allocate_handle();
         Texture &gfx_texture = textures_.insert(texture);
         D3D12MA::ALLOCATION_DESC allocation_desc = {};
         allocation_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
@@ -1826,7 +1893,7 @@ public:
         resource_desc.MipLevels        = (uint16_t)mip_levels;
         resource_desc.Format           = format;
         resource_desc.SampleDesc.Count = 1;
-        texture.handle = texture_handles_.allocate_handle();
+        texture.handle = textures_.allocate_handle();
         Texture &gfx_texture = textures_.insert(texture);
         D3D12MA::ALLOCATION_DESC allocation_desc = {};
         allocation_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
@@ -1853,11 +1920,11 @@ public:
     {
         if(!texture)
             return kGfxResult_NoError;
-        if(!texture_handles_.has_handle(texture.handle))
+        if(!textures_.has_handle(texture.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid texture object");
         collect(textures_[texture]);    // release resources
         textures_.erase(texture);   // destroy texture object
-        texture_handles_.free_handle(texture.handle);
+        textures_.free_handle(texture.handle);
         return kGfxResult_NoError;
     }
 
@@ -1884,7 +1951,7 @@ public:
                                        float mip_lod_bias, float min_lod, float max_lod)
     {
         GfxSamplerState sampler_state = {};
-        sampler_state.handle = sampler_state_handles_.allocate_handle();
+        sampler_state.handle = sampler_states_.allocate_handle();
         SamplerState &gfx_sampler_state = sampler_states_.insert(sampler_state);
         gfx_sampler_state.descriptor_slot_ = allocateSamplerDescriptor();
         if(gfx_sampler_state.descriptor_slot_ == 0xFFFFFFFFu)
@@ -1919,11 +1986,11 @@ public:
     {
         if(!sampler_state)
             return kGfxResult_NoError;
-        if(!sampler_state_handles_.has_handle(sampler_state.handle))
+        if(!sampler_states_.has_handle(sampler_state.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid sampler state object");
         collect(sampler_states_[sampler_state]);    // release resources
         sampler_states_.erase(sampler_state);   // destroy sampler state
-        sampler_state_handles_.free_handle(sampler_state.handle);
+        sampler_states_.free_handle(sampler_state.handle);
         return kGfxResult_NoError;
     }
 
@@ -1935,7 +2002,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Raytracing isn't supported on the selected device; cannot create acceleration structure");
             return acceleration_structure;  // invalid operation
         }
-        acceleration_structure.handle = acceleration_structure_handles_.allocate_handle();
+        acceleration_structure.handle = acceleration_structures_.allocate_handle();
         acceleration_structures_.insert(acceleration_structure);
         return acceleration_structure;
     }
@@ -1944,11 +2011,11 @@ public:
     {
         if(!acceleration_structure)
             return kGfxResult_NoError;
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid acceleration structure object");
         collect(acceleration_structures_[acceleration_structure]);  // release resources
         acceleration_structures_.erase(acceleration_structure); // destroy acceleration structure
-        acceleration_structure_handles_.free_handle(acceleration_structure.handle);
+        acceleration_structures_.free_handle(acceleration_structure.handle);
         return kGfxResult_NoError;
     }
 
@@ -1959,7 +2026,7 @@ public:
             return kGfxResult_InvalidOperation; // avoid spamming console output
         if(isInterop(acceleration_structure))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot update an interop acceleration structure object");
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot update an invalid acceleration structure object");
         AccelerationStructure &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
         if(!gfx_acceleration_structure.needs_update_ && !gfx_acceleration_structure.needs_rebuild_)
@@ -1974,12 +2041,12 @@ public:
         for(size_t i = 0; i < gfx_acceleration_structure.raytracing_primitives_.size(); ++i)
         {
             GfxRaytracingPrimitive const &raytracing_primitive = gfx_acceleration_structure.raytracing_primitives_[i];
-            if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+            if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
                 continue;   // invalid raytracing primitive object
             active_raytracing_primitives_.push_back(raytracing_primitive);
             RaytracingPrimitive const &gfx_raytracing_primitive = raytracing_primitives_[raytracing_primitive];
             GfxBuffer const &buffer = getRaytracingPrimitiveBuffer(gfx_raytracing_primitive);
-            if(!buffer_handles_.has_handle(buffer.handle))
+            if(!buffers_.has_handle(buffer.handle))
                 continue;   // no valid BVH memory, probably wasn't built
             D3D12_RAYTRACING_INSTANCE_DESC instance_desc = {};
             Buffer const &gfx_buffer = buffers_[buffer];
@@ -2023,13 +2090,13 @@ public:
                 return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to create acceleration structure buffer");
         }
         gfx_acceleration_structure.bvh_data_size_ = (uint64_t)tlas_info.ResultDataMaxSizeInBytes;
-        GFX_ASSERT(buffer_handles_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle));
-        GFX_ASSERT(buffer_handles_.has_handle(raytracing_scratch_buffer_.handle));
+        GFX_ASSERT(buffers_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle));
+        GFX_ASSERT(buffers_.has_handle(raytracing_scratch_buffer_.handle));
         Buffer &gfx_buffer = buffers_[gfx_acceleration_structure.bvh_buffer_];
         Buffer &gfx_scratch_buffer = buffers_[raytracing_scratch_buffer_];
         SetObjectName(gfx_buffer, acceleration_structure.name);
         transitionResource(gfx_scratch_buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        submitPipelineBarriers();   // ensure scratch is not in use
+        GFX_TRY(flushPipelineBarriers());   // ensure scratch is not in use
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC build_desc = {};
         build_desc.DestAccelerationStructureData = gfx_buffer.resource_->GetGPUVirtualAddress() + gfx_buffer.data_offset_;
         build_desc.Inputs = tlas_inputs;
@@ -2044,7 +2111,7 @@ public:
     uint64_t getAccelerationStructureDataSize(GfxAccelerationStructure const &acceleration_structure)
     {
         if(dxr_device_ == nullptr) return 0;    // avoid spamming console output
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot get the data size of an invalid acceleration structure object");
             return 0;
@@ -2056,7 +2123,7 @@ public:
     uint32_t getAccelerationStructureRaytracingPrimitiveCount(GfxAccelerationStructure const &acceleration_structure)
     {
         if(dxr_device_ == nullptr) return 0;    // avoid spamming console output
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot get the raytracing primitives of an invalid acceleration structure object");
             return 0;
@@ -2068,7 +2135,7 @@ public:
     GfxRaytracingPrimitive const *getAccelerationStructureRaytracingPrimitives(GfxAccelerationStructure const &acceleration_structure)
     {
         if(dxr_device_ == nullptr) return nullptr;  // avoid spamming console output
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot get the raytracing primitives of an invalid acceleration structure object");
             return nullptr;
@@ -2087,12 +2154,12 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create a raytracing primitive using an interop acceleration structure object");
             return raytracing_primitive;
         }
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot create a raytracing primitive using an invalid acceleration structure object");
             return raytracing_primitive;
         }
-        raytracing_primitive.handle = raytracing_primitive_handles_.allocate_handle();
+        raytracing_primitive.handle = raytracing_primitives_.allocate_handle();
         RaytracingPrimitive &gfx_raytracing_primitive = raytracing_primitives_.insert(raytracing_primitive);
         AccelerationStructure &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
         gfx_raytracing_primitive.index_ = (uint32_t)gfx_acceleration_structure.raytracing_primitives_.size();
@@ -2113,7 +2180,7 @@ public:
             return cloned_raytracing_primitive; // avoid spamming console output
         for(;;)
         {
-            if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+            if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             {
                 GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot create a raytracing primitive using an invalid raytracing primitive object");
                 return cloned_raytracing_primitive;
@@ -2134,12 +2201,12 @@ public:
         RaytracingPrimitive const &parent_raytracing_primitive = raytracing_primitives_[raytracing_primitive];
         GfxAccelerationStructure const &acceleration_structure = getRaytracingPrimitiveAccelerationStructure(parent_raytracing_primitive);
         GFX_ASSERT(!isInterop(acceleration_structure)); // should never happen
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot create a raytracing primitive using an invalid acceleration structure object");
             return cloned_raytracing_primitive;
         }
-        cloned_raytracing_primitive.handle = raytracing_primitive_handles_.allocate_handle();
+        cloned_raytracing_primitive.handle = raytracing_primitives_.allocate_handle();
         AccelerationStructure &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
         RaytracingPrimitive &gfx_raytracing_primitive = raytracing_primitives_.insert(cloned_raytracing_primitive);
         gfx_raytracing_primitive.index_ = (uint32_t)gfx_acceleration_structure.raytracing_primitives_.size();
@@ -2157,15 +2224,15 @@ public:
     {
         if(!raytracing_primitive)
             return kGfxResult_NoError;
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid raytracing primitive object");
         RaytracingPrimitive const &gfx_raytracing_primitive = raytracing_primitives_[raytracing_primitive];
         GfxAccelerationStructure const &acceleration_structure = getRaytracingPrimitiveAccelerationStructure(gfx_raytracing_primitive);
-        if(acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(acceleration_structures_.has_handle(acceleration_structure.handle))
             acceleration_structures_[acceleration_structure].needs_rebuild_ = true;
         collect(gfx_raytracing_primitive);  // release resources
         raytracing_primitives_.erase(raytracing_primitive); // destroy raytracing primitive
-        raytracing_primitive_handles_.free_handle(raytracing_primitive.handle);
+        raytracing_primitives_.free_handle(raytracing_primitive.handle);
         return kGfxResult_NoError;
     }
 
@@ -2173,9 +2240,9 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set geometry on an invalid raytracing primitive object");
-        if(!buffer_handles_.has_handle(vertex_buffer.handle))
+        if(!buffers_.has_handle(vertex_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot build a raytracing primitive using an invalid vertex buffer object");
         vertex_stride = (vertex_stride != 0 ? vertex_stride : vertex_buffer.stride);
         if(vertex_stride == 0)
@@ -2195,11 +2262,11 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set geometry on an invalid raytracing primitive object");
-        if(!buffer_handles_.has_handle(index_buffer.handle))
+        if(!buffers_.has_handle(index_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot build a raytracing primitive using an invalid index buffer object");
-        if(!buffer_handles_.has_handle(vertex_buffer.handle))
+        if(!buffers_.has_handle(vertex_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot build a raytracing primitive using an invalid vertex buffer object");
         uint32_t const index_stride = (index_buffer.stride == 2 ? 2 : 4);
         if(index_buffer.size / index_stride > 0xFFFFFFFFull)
@@ -2224,7 +2291,7 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set transform on an invalid raytracing primitive object");
         if(row_major_4x4_transform == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot pass `nullptr' as the transform of a raytracing primitive object");
@@ -2238,7 +2305,7 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set instanceID on an invalid raytracing primitive object");
         if(instance_id >= (1u << 24))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set an instanceID that is greater than %u", (1u << 24) - 1);
@@ -2252,7 +2319,7 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set instance mask on an invalid raytracing primitive object");
         RaytracingPrimitive &gfx_raytracing_primitive = raytracing_primitives_[raytracing_primitive];
         GFX_TRY(updateRaytracingPrimitive(raytracing_primitive, gfx_raytracing_primitive));
@@ -2264,7 +2331,7 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set instance contribution to hit group index on an invalid raytracing primitive object");
         RaytracingPrimitive &gfx_raytracing_primitive = raytracing_primitives_[raytracing_primitive];
         GFX_TRY(updateRaytracingPrimitive(raytracing_primitive, gfx_raytracing_primitive));
@@ -2275,7 +2342,7 @@ public:
     uint64_t getRaytracingPrimitiveDataSize(GfxRaytracingPrimitive const &raytracing_primitive)
     {
         if(dxr_device_ == nullptr) return 0;    // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot get the data size of an invalid raytracing primitive object");
             return 0;
@@ -2295,7 +2362,7 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot update an invalid raytracing primitive object");
         RaytracingPrimitive &gfx_raytracing_primitive = raytracing_primitives_[raytracing_primitive];
         if(gfx_raytracing_primitive.type_ != RaytracingPrimitive::kType_Triangles)
@@ -2307,11 +2374,11 @@ public:
     {
         if(dxr_device_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.handle))
+        if(!raytracing_primitives_.has_handle(raytracing_primitive.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set geometry on an invalid raytracing primitive object");
-        if(!buffer_handles_.has_handle(index_buffer.handle))
+        if(!buffers_.has_handle(index_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot update a raytracing primitive using an invalid index buffer object");
-        if(!buffer_handles_.has_handle(vertex_buffer.handle))
+        if(!buffers_.has_handle(vertex_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot update a raytracing primitive using an invalid vertex buffer object");
         uint32_t const index_stride = (index_buffer.stride == 2 ? 2 : 4);
         if(index_buffer.size / index_stride > 0xFFFFFFFFull)
@@ -2343,7 +2410,7 @@ public:
         char const *path_separator = (last_char == '/' || last_char == '\\' ? "" : "/");
         GFX_SNPRINTF(program.name, sizeof(program.name), "%s%s%s", file_path, path_separator, file_name);
         shader_model = (shader_model != nullptr ? shader_model : dxr_device_ != nullptr ? "6_5" : "6_0");
-        program.handle = program_handles_.allocate_handle();
+        program.handle = programs_.allocate_handle();
         Program &gfx_program = programs_.insert(program);
         gfx_program.shader_model_ = shader_model;
         gfx_program.file_name_ = file_name;
@@ -2355,7 +2422,7 @@ public:
     GfxProgram createProgram(GfxProgramDesc const &program_desc, char const *name, char const *shader_model, char const **include_paths, uint32_t include_path_count)
     {
         GfxProgram program = {};
-        program.handle = program_handles_.allocate_handle();
+        program.handle = programs_.allocate_handle();
         if(name != nullptr)
             GFX_SNPRINTF(program.name, sizeof(program.name), "%s", name);
         else
@@ -2379,17 +2446,17 @@ public:
     {
         if(!program.handle)
             return kGfxResult_NoError;
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid program object");
         collect(programs_[program]);    // release resources
         programs_.erase(program);   // destroy program
-        program_handles_.free_handle(program.handle);
+        programs_.free_handle(program.handle);
         return kGfxResult_NoError;
     }
 
     GfxResult setProgramBuffer(GfxProgram const &program, char const *parameter_name, GfxBuffer const &buffer)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2400,7 +2467,7 @@ public:
 
     GfxResult setProgramBuffers(GfxProgram const &program, char const *parameter_name, GfxBuffer const *buffers, uint32_t buffer_count)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2413,7 +2480,7 @@ public:
 
     GfxResult setProgramTexture(GfxProgram const &program, char const *parameter_name, GfxTexture const &texture, uint32_t mip_level)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2424,7 +2491,7 @@ public:
 
     GfxResult setProgramTextures(GfxProgram const &program, char const *parameter_name, GfxTexture const *textures, uint32_t const *mip_levels, uint32_t texture_count)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2437,7 +2504,7 @@ public:
 
     GfxResult setProgramSamplerState(GfxProgram const &program, char const *parameter_name, GfxSamplerState const &sampler_state)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2448,7 +2515,7 @@ public:
 
     GfxResult setProgramAccelerationStructure(GfxProgram const &program, char const *parameter_name, GfxAccelerationStructure const &acceleration_structure)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2459,7 +2526,7 @@ public:
 
     GfxResult setProgramConstants(GfxProgram const &program, char const *parameter_name, void const *data, uint32_t data_size)
     {
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid program object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2478,7 +2545,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Mesh shaders aren't supported on the selected device; cannot create mesh kernel");
             return mesh_kernel; // invalid operation
         }
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create a mesh kernel using an invalid program object");
             return mesh_kernel;
@@ -2495,7 +2562,7 @@ public:
         Program const &gfx_program = programs_[program];
         entry_point = (entry_point ? entry_point : "main");
         GFX_SNPRINTF(mesh_kernel.name, sizeof(mesh_kernel.name), "%s", entry_point);
-        mesh_kernel.handle = kernel_handles_.allocate_handle();
+        mesh_kernel.handle = kernels_.allocate_handle();
         Kernel &gfx_kernel = kernels_.insert(mesh_kernel);
         gfx_kernel.program_ = program;
         gfx_kernel.entry_point_ = entry_point;
@@ -2517,7 +2584,7 @@ public:
     GfxKernel createComputeKernel(GfxProgram const &program, char const *entry_point, char const **defines, uint32_t define_count)
     {
         GfxKernel compute_kernel = {};
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create a compute kernel using an invalid program object");
             return compute_kernel;
@@ -2526,7 +2593,7 @@ public:
         Program const &gfx_program = programs_[program];
         entry_point = (entry_point ? entry_point : "main");
         GFX_SNPRINTF(compute_kernel.name, sizeof(compute_kernel.name), "%s", entry_point);
-        compute_kernel.handle = kernel_handles_.allocate_handle();
+        compute_kernel.handle = kernels_.allocate_handle();
         Kernel &gfx_kernel = kernels_.insert(compute_kernel);
         gfx_kernel.program_ = program;
         gfx_kernel.entry_point_ = entry_point;
@@ -2549,7 +2616,7 @@ public:
     {
         GfxResult result;
         GfxKernel graphics_kernel = {};
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create a graphics kernel using an invalid program object");
             return graphics_kernel;
@@ -2566,7 +2633,7 @@ public:
         graphics_kernel.type = GfxKernel::kType_Graphics;
         entry_point = (entry_point ? entry_point : "main");
         GFX_SNPRINTF(graphics_kernel.name, sizeof(graphics_kernel.name), "%s", entry_point);
-        graphics_kernel.handle = kernel_handles_.allocate_handle();
+        graphics_kernel.handle = kernels_.allocate_handle();
         Kernel &gfx_kernel = kernels_.insert(graphics_kernel);
         gfx_kernel.program_ = program;
         gfx_kernel.entry_point_ = entry_point;
@@ -2603,7 +2670,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Raytracing isn't supported on the selected device; cannot create raytracing kernel");
             return raytracing_kernel;   // invalid operation
         }
-        if(!program_handles_.has_handle(program.handle))
+        if(!programs_.has_handle(program.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create a compute kernel using an invalid program object");
             return raytracing_kernel;
@@ -2611,7 +2678,7 @@ public:
         raytracing_kernel.type = GfxKernel::kType_Raytracing;
         Program const &gfx_program = programs_[program];
         GFX_SNPRINTF(raytracing_kernel.name, sizeof(raytracing_kernel.name), "%s", "");
-        raytracing_kernel.handle = kernel_handles_.allocate_handle();
+        raytracing_kernel.handle = kernels_.allocate_handle();
         Kernel &gfx_kernel = kernels_.insert(raytracing_kernel);
         gfx_kernel.program_ = program;
         gfx_kernel.entry_point_ = "";
@@ -2645,11 +2712,11 @@ public:
     {
         if(!kernel)
             return kGfxResult_NoError;
-        if(!kernel_handles_.has_handle(kernel.handle))
+        if(!kernels_.has_handle(kernel.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid kernel object");
         collect(kernels_[kernel]);  // release resources
         kernels_.erase(kernel); // destroy kernel
-        kernel_handles_.free_handle(kernel.handle);
+        kernels_.free_handle(kernel.handle);
         return kGfxResult_NoError;
     }
 
@@ -2657,7 +2724,7 @@ public:
 
     uint32_t const *getKernelNumThreads(GfxKernel const &kernel)
     {
-        if(!kernel_handles_.has_handle(kernel.handle))
+        if(!kernels_.has_handle(kernel.handle))
             return kNumThreads_Invalid; // invalid kernel object
         Kernel const &gfx_kernel = kernels_[kernel];
         GFX_ASSERT(gfx_kernel.num_threads_ != nullptr);
@@ -2679,7 +2746,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Raytracing isn't supported on the selected device; cannot create SBT");
             return sbt; // invalid operation
         }
-        sbt.handle = sbt_handles_.allocate_handle();
+        sbt.handle = sbts_.allocate_handle();
         Sbt &gfx_sbt = sbts_.insert(sbt);
         for(uint32_t i = 0; i < kernel_count; ++i)
         {
@@ -2734,18 +2801,18 @@ public:
     {
         if(!sbt)
             return kGfxResult_NoError;
-        if(!sbt_handles_.has_handle(sbt.handle))
+        if(!sbts_.has_handle(sbt.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid sbt object");
         Sbt const &gfx_sbt = sbts_[sbt];
         collect(gfx_sbt);  // release resources
         sbts_.erase(sbt); // destroy sbt
-        sbt_handles_.free_handle(sbt.handle);
+        sbts_.free_handle(sbt.handle);
         return kGfxResult_NoError;
     }
 
     GfxResult sbtSetShaderGroup(GfxSbt const &sbt, GfxShaderGroupType shader_group_type, uint32_t index, char const *group_name)
     {
-        if(!sbt_handles_.has_handle(sbt.handle))
+        if(!sbts_.has_handle(sbt.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid sbt object");
         if(!group_name || !*group_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a shader group with an invalid name");
@@ -2758,7 +2825,7 @@ public:
 
     GfxResult sbtSetConstants(GfxSbt const &sbt, GfxShaderGroupType shader_group_type, uint32_t index, char const *parameter_name, void const *data, uint32_t data_size)
     {
-        if(!sbt_handles_.has_handle(sbt.handle))
+        if(!sbts_.has_handle(sbt.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid sbt object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2774,7 +2841,7 @@ public:
 
     GfxResult sbtSetTexture(GfxSbt const &sbt, GfxShaderGroupType shader_group_type, uint32_t index, char const *parameter_name, GfxTexture texture, uint32_t mip_level)
     {
-        if(!sbt_handles_.has_handle(sbt.handle))
+        if(!sbts_.has_handle(sbt.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot set a parameter onto an invalid sbt object");
         if(!parameter_name || !*parameter_name)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set a program parameter with an invalid name");
@@ -2802,11 +2869,12 @@ public:
 
     GfxResult encodeCopyBuffer(GfxBuffer const &dst, GfxBuffer const &src)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!buffer_handles_.has_handle(dst.handle))
+        if(!buffers_.has_handle(dst.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy into an invalid buffer object");
-        if(!buffer_handles_.has_handle(src.handle))
+        if(!buffers_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid buffer object");
         if(dst.size != src.size)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy between buffer objects of different size");
@@ -2814,14 +2882,17 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy to a buffer object with write CPU access");
         if(src.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from a buffer object with read CPU access");
+#endif //! GFX_ENABLE_VALIDATION
         if(dst.size == 0) return kGfxResult_NoError;    // nothing to copy
         Buffer &gfx_dst = buffers_[dst], &gfx_src = buffers_[src];
         SetObjectName(gfx_dst, dst.name); SetObjectName(gfx_src, src.name);
+#if GFX_ENABLE_VALIDATION
         if(gfx_dst.resource_ == gfx_src.resource_)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy between two buffer objects that are pointing at the same resource; use an intermediate buffer");
+#endif //! GFX_ENABLE_VALIDATION
         if(dst.cpu_access == kGfxCpuAccess_None) transitionResource(gfx_dst, D3D12_RESOURCE_STATE_COPY_DEST);
         if(src.cpu_access == kGfxCpuAccess_None) transitionResource(gfx_src, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->CopyBufferRegion(gfx_dst.resource_, gfx_dst.data_offset_,
                                         gfx_src.resource_, gfx_src.data_offset_,
                                         dst.size);
@@ -2830,11 +2901,12 @@ public:
 
     GfxResult encodeCopyBuffer(GfxBuffer const &dst, uint64_t dst_offset, GfxBuffer const &src, uint64_t src_offset, uint64_t size)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!buffer_handles_.has_handle(dst.handle))
+        if(!buffers_.has_handle(dst.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy into an invalid buffer object");
-        if(!buffer_handles_.has_handle(src.handle))
+        if(!buffers_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid buffer object");
         if(dst_offset + size > dst.size || src_offset + size > src.size)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy between regions that are not fully contained within their respective buffer objects");
@@ -2842,14 +2914,17 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy to a buffer object with write CPU access");
         if(src.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from a buffer object with read CPU access");
+#endif //! GFX_ENABLE_VALIDATION
         if(size == 0) return kGfxResult_NoError;    // nothing to copy
         Buffer &gfx_dst = buffers_[dst], &gfx_src = buffers_[src];
         SetObjectName(gfx_dst, dst.name); SetObjectName(gfx_src, src.name);
+#if GFX_ENABLE_VALIDATION
         if(gfx_dst.resource_ == gfx_src.resource_)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy between two buffer objects that are pointing at the same resource; use an intermediate buffer");
+#endif //! GFX_ENABLE_VALIDATION
         if(dst.cpu_access == kGfxCpuAccess_None) transitionResource(gfx_dst, D3D12_RESOURCE_STATE_COPY_DEST);
         if(src.cpu_access == kGfxCpuAccess_None) transitionResource(gfx_src, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->CopyBufferRegion(gfx_dst.resource_, gfx_dst.data_offset_ + dst_offset,
                                         gfx_src.resource_, gfx_src.data_offset_ + src_offset,
                                         size);
@@ -2859,10 +2934,12 @@ public:
     GfxResult encodeClearBuffer(GfxBuffer buffer, uint32_t clear_value)
     {
         GfxResult result = kGfxResult_NoError;
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot clear an invalid buffer object");
+#endif //! GFX_ENABLE_VALIDATION
         if(buffer.size == 0) return kGfxResult_NoError; // nothing to clear
         uint64_t const data_size = GFX_ALIGN(buffer.size, 4);
         uint64_t const num_uints = data_size / sizeof(uint32_t);
@@ -2902,7 +2979,7 @@ public:
                 uint32_t const num_groups = (uint32_t)((num_uints + group_size - 1) / group_size);
                 GFX_TRY(encodeBindKernel(clear_buffer_kernel_));
                 result = encodeDispatch(num_groups, 1, 1);
-                if(kernel_handles_.has_handle(bound_kernel.handle))
+                if(kernels_.has_handle(bound_kernel.handle))
                     encodeBindKernel(bound_kernel);
                 else
                     bound_kernel_ = bound_kernel;
@@ -2920,6 +2997,8 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot clear backbuffer when using an interop context");
         if(swap_chain_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot clear backbuffer when using a headless context");
+        if(queue_ != kGfxQueue_Graphics)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot clear backbuffer when recording for the compute queue");
         float const clear_color[] = { 0.0f, 0.0f, 0.0f, 1.0f };
         D3D12_RECT
         rect        = {};
@@ -2946,9 +3025,9 @@ public:
     {
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!texture_handles_.has_handle(dst.handle))
+        if(!textures_.has_handle(dst.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy to an invalid texture object");
-        if(!texture_handles_.has_handle(src.handle))
+        if(!textures_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid texture object");
         if(dst.type != src.type)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy between texture objects of different types");
@@ -2958,7 +3037,7 @@ public:
             return kGfxResult_NoError;  // nothing to be copied
         transitionResource(dst_texture, D3D12_RESOURCE_STATE_COPY_DEST);
         transitionResource(src_texture, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         if(dst.mip_levels == src.mip_levels)
             command_list_->CopyResource(dst_texture.resource_, src_texture.resource_);
         else
@@ -2981,14 +3060,18 @@ public:
 
     GfxResult encodeClearImage(GfxTexture const &texture, uint32_t mip_level, uint32_t slice)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!texture_handles_.has_handle(texture.handle))
+        if(!textures_.has_handle(texture.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot clear an invalid texture object");
         if(mip_level >= texture.mip_levels)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot clear non-existing mip level %u", mip_level);
         if(slice >= (texture.is3D() ? GFX_MAX(texture.depth >> mip_level, 1u) : texture.depth))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot clear non-existing slice %u", slice);
+#endif //! GFX_ENABLE_VALIDATION
+        if(queue_ != kGfxQueue_Graphics)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot clear a texture object when recording for the compute queue");
         Texture &gfx_texture = textures_[texture];
         SetObjectName(gfx_texture, texture.name);
         if(IsDepthStencilFormat(texture.format))
@@ -3003,7 +3086,7 @@ public:
             rect.right  = (LONG)resource_desc.Width;
             rect.bottom = (LONG)resource_desc.Height;
             transitionResource(gfx_texture, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-            submitPipelineBarriers();   // transition our resources if needed
+            GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
             command_list_->ClearDepthStencilView(dsv_descriptors_.getCPUHandle(gfx_texture.dsv_descriptor_slots_[mip_level][slice]), clear_flags, gfx_texture.clear_value_[0], (UINT8)gfx_texture.clear_value_[1], 1, &rect);
         }
         else
@@ -3016,7 +3099,7 @@ public:
             rect.right  = (LONG)resource_desc.Width;
             rect.bottom = (LONG)resource_desc.Height;
             transitionResource(gfx_texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
-            submitPipelineBarriers();   // transition our resources if needed
+            GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
             command_list_->ClearRenderTargetView(rtv_descriptors_.getCPUHandle(gfx_texture.rtv_descriptor_slots_[mip_level][slice]), gfx_texture.clear_value_, 1, &rect);
         }
         return kGfxResult_NoError;
@@ -3027,19 +3110,23 @@ public:
         GfxResult result;
         if(isInterop())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy to backbuffer when using an interop context");
-        if(!texture_handles_.has_handle(texture.handle))
+#if GFX_ENABLE_VALIDATION
+        if(!textures_.has_handle(texture.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid texture object");
         if(!texture.is2D())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from a non-2D texture object");
+#endif //! GFX_ENABLE_VALIDATION
         Texture &gfx_texture = textures_[texture]; SetObjectName(gfx_texture, texture.name);
+#if GFX_ENABLE_VALIDATION
         D3D12_RESOURCE_DESC const resource_desc = gfx_texture.resource_->GetDesc();
         if(window_width_ != (uint32_t)resource_desc.Width || window_height_ != (uint32_t)resource_desc.Height)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy between texture objects that do not have the same dimensions");
+#endif //! GFX_ENABLE_VALIDATION
         GfxKernel const bound_kernel = bound_kernel_;
         GFX_TRY(encodeBindKernel(copy_to_backbuffer_kernel_));
         setProgramTexture(copy_to_backbuffer_program_, "InputBuffer", texture, 0);
         result = encodeDraw(3, 1, 0, 0);    // copy to backbuffer
-        if(kernel_handles_.has_handle(bound_kernel.handle))
+        if(kernels_.has_handle(bound_kernel.handle))
             encodeBindKernel(bound_kernel);
         else
             bound_kernel_ = bound_kernel;
@@ -3050,16 +3137,20 @@ public:
 
     GfxResult encodeCopyBufferToTexture(GfxTexture const &dst, GfxBuffer const &src)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!texture_handles_.has_handle(dst.handle))
+        if(!textures_.has_handle(dst.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy to an invalid texture object");
-        if(!buffer_handles_.has_handle(src.handle))
+        if(!buffers_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid buffer object");
+#endif //! GFX_ENABLE_VALIDATION
         if(!dst.is2D()) // TODO: implement for the other texture types (gboisse)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from buffer to a non-2D texture object");
+#if GFX_ENABLE_VALIDATION
         if(src.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from a buffer object with read CPU access");
+#endif //! GFX_ENABLE_VALIDATION
         Texture &gfx_texture = textures_[dst]; SetObjectName(gfx_texture, dst.name);
         uint32_t num_rows[D3D12_REQ_MIP_LEVELS] = {};
         uint64_t row_sizes[D3D12_REQ_MIP_LEVELS] = {};
@@ -3082,12 +3173,13 @@ public:
                 break;  // further mips aren't available
             uint64_t const buffer_row_pitch = row_sizes[mip_level];
             uint64_t const buffer_size = (uint64_t)num_rows[mip_level] * buffer_row_pitch;
+            uint64_t const src_offset = gfx_buffer.data_offset_ + buffer_offset;    // account for buffer ranges
             if(buffer_offset + buffer_size > src.size)
                 return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy to mip level %u from buffer object with insufficient storage", mip_level);
             Buffer *texture_upload_buffer = nullptr;
             uint64_t const texture_row_pitch = subresource_footprints[mip_level].Footprint.RowPitch;
             if(!unrestricted_pitch && (buffer_row_pitch != texture_row_pitch || // we must respect the 256-byte pitch alignment
-               GFX_ALIGN(buffer_offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) != buffer_offset))
+               GFX_ALIGN(src_offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) != src_offset))
             {
                 uint64_t texture_upload_buffer_size = num_rows[mip_level] * static_cast<uint64_t>(subresource_footprints[mip_level].Footprint.RowPitch);
                 if(texture_upload_buffer_.size < texture_upload_buffer_size)
@@ -3103,9 +3195,9 @@ public:
                 texture_upload_buffer = &buffers_[texture_upload_buffer_];
                 SetObjectName(*texture_upload_buffer, texture_upload_buffer_.name);
                 transitionResource(*texture_upload_buffer, D3D12_RESOURCE_STATE_COPY_DEST);
-                submitPipelineBarriers();   // transition our resources if needed
+                GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
                 for(uint32_t i = 0; i < num_rows[mip_level]; ++i)
-                    command_list_->CopyBufferRegion(texture_upload_buffer->resource_, i * texture_row_pitch, gfx_buffer.resource_, i * buffer_row_pitch + buffer_offset, buffer_row_pitch);
+                    command_list_->CopyBufferRegion(texture_upload_buffer->resource_, i * texture_row_pitch, gfx_buffer.resource_, i * buffer_row_pitch + src_offset, buffer_row_pitch);
                 transitionResource(*texture_upload_buffer, D3D12_RESOURCE_STATE_COPY_SOURCE);
                 submitPipelineBarriers();
             }
@@ -3120,7 +3212,7 @@ public:
                 src_location.PlacedFootprint.Footprint = subresource_footprints[mip_level].Footprint;
                 if(texture_upload_buffer == nullptr)
                     src_location.PlacedFootprint.Footprint.RowPitch = (UINT)buffer_row_pitch;
-                src_location.PlacedFootprint.Offset = (texture_upload_buffer == nullptr ? buffer_offset : 0);
+                src_location.PlacedFootprint.Offset = (texture_upload_buffer == nullptr ? src_offset : 0);
                 command_list_->CopyTextureRegion(&dst_location, 0, 0, 0, &src_location, nullptr);
             }
             buffer_offset += buffer_size;   // advance the buffer offset
@@ -3130,16 +3222,18 @@ public:
 
     GfxResult encodeCopyBufferToCubeFace(GfxTexture const &dst, GfxBuffer const &src, uint32_t face)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!texture_handles_.has_handle(dst.handle))
+        if(!textures_.has_handle(dst.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy to an invalid texture object");
-        if(!buffer_handles_.has_handle(src.handle))
+        if(!buffers_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid buffer object");
         if(dst.type != GfxTexture::kType_Cube)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from buffer to a non-cube texture object");
         if(src.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from a buffer object with read CPU access");
+#endif //! GFX_ENABLE_VALIDATION
         Texture &gfx_texture = textures_[dst];
         SetObjectName(gfx_texture, dst.name);
         uint32_t num_rows[D3D12_REQ_MIP_LEVELS] = {};
@@ -3175,16 +3269,20 @@ public:
 
     GfxResult encodeCopyTextureToBuffer(GfxBuffer const &dst, GfxTexture const &src)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!texture_handles_.has_handle(src.handle))
+        if(!textures_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy from an invalid texture object");
-        if(!buffer_handles_.has_handle(dst.handle))
+        if(!buffers_.has_handle(dst.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot copy to an invalid buffer object");
+#endif //! GFX_ENABLE_VALIDATION
         if(!src.is2D()) // TODO: implement for the other texture types (gboisse)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy a non-2D texture object");
+#if GFX_ENABLE_VALIDATION
         if(dst.cpu_access == kGfxCpuAccess_Write)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy to a buffer object with write CPU access");
+#endif //! GFX_ENABLE_VALIDATION
         Texture &gfx_texture = textures_[src]; SetObjectName(gfx_texture, src.name);
         Buffer &gfx_buffer = buffers_[dst]; SetObjectName(gfx_buffer, dst.name);
         uint32_t num_rows[D3D12_REQ_MIP_LEVELS] = {};
@@ -3198,7 +3296,7 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot copy from texture object of unsupported format");
         if(dst.cpu_access == kGfxCpuAccess_None) transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_COPY_DEST);
         transitionResource(gfx_texture, D3D12_RESOURCE_STATE_COPY_SOURCE);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         for(uint32_t mip_level = 0; mip_level < src.mip_levels; ++mip_level)
         {
             if(buffer_offset >= dst.size)
@@ -3228,10 +3326,12 @@ public:
     GfxResult encodeGenerateMips(GfxTexture const &texture)
     {
         GfxResult result = kGfxResult_NoError;
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!texture_handles_.has_handle(texture.handle))
+        if(!textures_.has_handle(texture.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot generate mips of an invalid texture object");
+#endif //! GFX_ENABLE_VALIDATION
         if(!texture.is2D() && !texture.is2DArray() && !texture.isCube())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot generate mips of a 3D texture object");
         if(texture.mip_levels <= 1) return kGfxResult_NoError;  // nothing to generate
@@ -3252,7 +3352,7 @@ public:
             result = encodeDispatch(num_groups_x, num_groups_y, num_groups_z);
             if(result != kGfxResult_NoError) break;
         }
-        if(kernel_handles_.has_handle(bound_kernel.handle))
+        if(kernels_.has_handle(bound_kernel.handle))
             encodeBindKernel(bound_kernel);
         else
             bound_kernel_ = bound_kernel;
@@ -3263,6 +3363,7 @@ public:
 
     GfxResult encodeBindColorTarget(uint32_t target_index, GfxTexture target_texture, uint32_t mip_level, uint32_t slice)
     {
+#if GFX_ENABLE_VALIDATION
         if(target_index >= kGfxConstant_MaxRenderTarget)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot bind more than %u render targets", (uint32_t)kGfxConstant_MaxRenderTarget);
         if(!target_texture)
@@ -3271,6 +3372,7 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to mip level that does not exist in texture object");
         if(slice >= (target_texture.is3D() ? GFX_MAX(target_texture.depth >> mip_level, 1u) : target_texture.depth))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to slice that does not exist in texture object");
+#endif //! GFX_ENABLE_VALIDATION
         bound_color_targets_[target_index].texture_  = target_texture;
         bound_color_targets_[target_index].mip_level_ = mip_level;
         bound_color_targets_[target_index].slice_     = slice;
@@ -3279,12 +3381,14 @@ public:
 
     GfxResult encodeBindDepthStencilTarget(GfxTexture target_texture, uint32_t mip_level, uint32_t slice)
     {
+#if GFX_ENABLE_VALIDATION
         if(!target_texture)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to an invalid texture object");
         if(mip_level >= target_texture.mip_levels)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to mip level that does not exist in texture object");
         if(slice >= (target_texture.is3D() ? GFX_MAX(target_texture.depth >> mip_level, 1u) : target_texture.depth))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to slice that does not exist in texture object");
+#endif //! GFX_ENABLE_VALIDATION
         bound_depth_stencil_target_.texture_   = target_texture;
         bound_depth_stencil_target_.mip_level_ = mip_level;
         bound_depth_stencil_target_.slice_     = slice;
@@ -3293,30 +3397,36 @@ public:
 
     GfxResult encodeBindKernel(GfxKernel const &kernel)
     {
-        if(command_list_ == nullptr)
-            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
         if((kernel.isMesh() && mesh_command_list_ == nullptr))
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!kernel_handles_.has_handle(kernel.handle))
+        Kernel const *const gfx_kernel = kernels_.get(kernel.handle);
+#if GFX_ENABLE_VALIDATION
+        if(command_list_ == nullptr)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot bind invalid kernel object");
+#endif //! GFX_ENABLE_VALIDATION
+        if(recording_bundle_)
+            return recordBindKernel(kernel);
         if(bound_kernel_.handle == kernel.handle) return kGfxResult_NoError;    // already bound
-        Kernel const &gfx_kernel = kernels_[kernel];
-        if(gfx_kernel.isRaytracing())
+        if(queue_ != kGfxQueue_Graphics && !gfx_kernel->isCompute() && !gfx_kernel->isRaytracing())
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot bind a graphics kernel object when recording for the compute queue");
+        if(gfx_kernel->isRaytracing())
         {
-            if(gfx_kernel.state_object_ != nullptr)
-                dxr_command_list_->SetPipelineState1(gfx_kernel.state_object_);
+            if(gfx_kernel->state_object_ != nullptr)
+                dxr_command_list_->SetPipelineState1(gfx_kernel->state_object_);
         }
         else
         {
-            if(gfx_kernel.pipeline_state_ != nullptr)
-                command_list_->SetPipelineState(gfx_kernel.pipeline_state_);
+            if(gfx_kernel->pipeline_state_ != nullptr)
+                command_list_->SetPipelineState(gfx_kernel->pipeline_state_);
         }
-        if(gfx_kernel.root_signature_ != nullptr)
+        if(gfx_kernel->root_signature_ != nullptr)
         {
-            if(gfx_kernel.isCompute() || gfx_kernel.isRaytracing())
-                command_list_->SetComputeRootSignature(gfx_kernel.root_signature_);
+            if(gfx_kernel->isCompute() || gfx_kernel->isRaytracing())
+                command_list_->SetComputeRootSignature(gfx_kernel->root_signature_);
             else
-                command_list_->SetGraphicsRootSignature(gfx_kernel.root_signature_);
+                command_list_->SetGraphicsRootSignature(gfx_kernel->root_signature_);
         }
         bound_kernel_ = kernel; // bind kernel
         return kGfxResult_NoError;
@@ -3324,38 +3434,55 @@ public:
 
     GfxResult encodeBindIndexBuffer(GfxBuffer const &index_buffer)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!buffer_handles_.has_handle(index_buffer.handle))
+        if(!buffers_.has_handle(index_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot bind index data from invalid buffer object");
         if(index_buffer.size > 0xFFFFFFFFull)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot bind an index buffer object that's larger than 4GiB");
         if(index_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot bind an index buffer object that has read CPU access");
+#endif //! GFX_ENABLE_VALIDATION
+        if(recording_bundle_)
+            return recordBindBuffer(Bundle::kCommandType_BindIndexBuffer, index_buffer);
         bound_index_buffer_ = index_buffer;
         return kGfxResult_NoError;
     }
 
     GfxResult encodeBindVertexBuffer(GfxBuffer const &vertex_buffer)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!buffer_handles_.has_handle(vertex_buffer.handle))
+        if(!buffers_.has_handle(vertex_buffer.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot bind vertex data from invalid buffer object");
         if(vertex_buffer.size > 0xFFFFFFFFull)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot bind a vertex buffer object that's larger than 4GiB");
         if(vertex_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot bind a vertex buffer object that has read CPU access");
+#endif //! GFX_ENABLE_VALIDATION
+        if(recording_bundle_)
+            return recordBindBuffer(Bundle::kCommandType_BindVertexBuffer, vertex_buffer);
         bound_vertex_buffer_ = vertex_buffer;
         return kGfxResult_NoError;
     }
 
     GfxResult encodeSetViewport(float x, float y, float width, float height)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
         if(isnan(x) || isnan(y) || isnan(width) || isnan(height))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set viewport using invalid floating-point numbers");
+#endif //! GFX_ENABLE_VALIDATION
+        if(recording_bundle_)
+        {
+            Bundle::Command &command = recordCommand(Bundle::kCommandType_SetViewport);
+            command.viewport_[0] = x; command.viewport_[1] = y;
+            command.viewport_[2] = width; command.viewport_[3] = height;
+            return kGfxResult_NoError;
+        }
         viewport_.x_ = x;
         viewport_.y_ = y;
         viewport_.width_ = width;
@@ -3365,10 +3492,19 @@ public:
 
     GfxResult encodeSetScissorRect(int32_t x, int32_t y, int32_t width, int32_t height)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
         if(width < 0 || height < 0)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot set scissor rect using negative width/height values");
+#endif //! GFX_ENABLE_VALIDATION
+        if(recording_bundle_)
+        {
+            Bundle::Command &command = recordCommand(Bundle::kCommandType_SetScissorRect);
+            command.scissor_rect_[0] = x; command.scissor_rect_[1] = y;
+            command.scissor_rect_[2] = width; command.scissor_rect_[3] = height;
+            return kGfxResult_NoError;
+        }
         scissor_rect_.x_ = x;
         scissor_rect_.y_ = y;
         scissor_rect_.width_ = width;
@@ -3378,165 +3514,216 @@ public:
 
     GfxResult encodeDraw(uint32_t vertex_count, uint32_t instance_count, uint32_t base_vertex, uint32_t base_instance)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+#endif //! GFX_ENABLE_VALIDATION
         if(vertex_count == 0 || instance_count == 0)
             return kGfxResult_NoError;  // nothing to draw
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(recording_bundle_)
+            return recordDraw(Bundle::kCommandType_Draw, vertex_count, instance_count, 0, base_vertex, base_instance);
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isGraphics())
+        if(!gfx_kernel->isGraphics())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using a non-graphics kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip draw call
+        Kernel &kernel = *gfx_kernel;
         GFX_TRY(installShaderState(kernel));
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->DrawInstanced(vertex_count, instance_count, base_vertex, base_instance);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeDrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t base_vertex, uint32_t base_instance)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+#endif //! GFX_ENABLE_VALIDATION
         if(index_count == 0 || instance_count == 0)
             return kGfxResult_NoError;  // nothing to draw
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(recording_bundle_)
+            return recordDraw(Bundle::kCommandType_DrawIndexed, index_count, instance_count, first_index, base_vertex, base_instance);
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isGraphics())
+        if(!gfx_kernel->isGraphics())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using a non-graphics kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip draw call
+        Kernel &kernel = *gfx_kernel;
         GFX_TRY(installShaderState(kernel, true));
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->DrawIndexedInstanced(index_count, instance_count, first_index, base_vertex, base_instance);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeMultiDrawIndirect(GfxBuffer const &args_buffer, uint32_t args_count)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+#endif //! GFX_ENABLE_VALIDATION
         if(args_count == 0)
             return kGfxResult_NoError;  // nothing to draw
-        if(!buffer_handles_.has_handle(args_buffer.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Buffer *const gfx_args_buffer = buffers_.get(args_buffer.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_args_buffer == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot draw using an invalid arguments buffer object");
         if(args_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using an arguments buffer object with read CPU access");
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isGraphics())
+        if(!gfx_kernel->isGraphics())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using a non-graphics kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip multi-draw call
+        Kernel &kernel = *gfx_kernel;
         GFX_TRY(populateDrawIdBuffer(args_count));
-        Buffer &gfx_buffer = buffers_[args_buffer];
+        Buffer &gfx_buffer = *gfx_args_buffer;
         SetObjectName(gfx_buffer, args_buffer.name);
         GFX_TRY(installShaderState(kernel));
         if(args_buffer.cpu_access == kGfxCpuAccess_None)
             transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->ExecuteIndirect(multi_draw_signature_, args_count, gfx_buffer.resource_, gfx_buffer.data_offset_, nullptr, 0);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeMultiDrawIndexedIndirect(GfxBuffer const &args_buffer, uint32_t args_count)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+#endif //! GFX_ENABLE_VALIDATION
         if(args_count == 0)
             return kGfxResult_NoError;  // nothing to draw
-        if(!buffer_handles_.has_handle(args_buffer.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Buffer *const gfx_args_buffer = buffers_.get(args_buffer.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_args_buffer == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot draw using an invalid arguments buffer object");
         if(args_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using an arguments buffer object with read CPU access");
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isGraphics())
+        if(!gfx_kernel->isGraphics())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using a non-graphics kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip multi-draw call
+        Kernel &kernel = *gfx_kernel;
         GFX_TRY(populateDrawIdBuffer(args_count));
-        Buffer &gfx_buffer = buffers_[args_buffer];
+        Buffer &gfx_buffer = *gfx_args_buffer;
         SetObjectName(gfx_buffer, args_buffer.name);
         GFX_TRY(installShaderState(kernel, true));
         if(args_buffer.cpu_access == kGfxCpuAccess_None)
             transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->ExecuteIndirect(multi_draw_indexed_signature_, args_count, gfx_buffer.resource_, gfx_buffer.data_offset_, nullptr, 0);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeDispatch(uint32_t num_groups_x, uint32_t num_groups_y, uint32_t num_groups_z)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+#endif //! GFX_ENABLE_VALIDATION
         if(!num_groups_x || !num_groups_y || !num_groups_z)
             return kGfxResult_NoError;  // nothing to dispatch
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isCompute())
+        if(!gfx_kernel->isCompute())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch using a non-compute kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip dispatch call
+        Kernel &kernel = *gfx_kernel;
         GFX_TRY(installShaderState(kernel));
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->Dispatch(num_groups_x, num_groups_y, num_groups_z);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeDispatchIndirect(GfxBuffer args_buffer)
     {
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Buffer *const gfx_args_buffer = buffers_.get(args_buffer.handle);
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!buffer_handles_.has_handle(args_buffer.handle))
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+        if(gfx_args_buffer == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot dispatch using an invalid arguments buffer object");
         if(args_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch using an arguments buffer object with read CPU access");
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isCompute())
+        if(!gfx_kernel->isCompute())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch using a non-compute kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip dispatch call
-        Buffer &gfx_buffer = buffers_[args_buffer];
+        Kernel &kernel = *gfx_kernel;
+        Buffer &gfx_buffer = *gfx_args_buffer;
         SetObjectName(gfx_buffer, args_buffer.name);
         GFX_TRY(installShaderState(kernel));
         if(args_buffer.cpu_access == kGfxCpuAccess_None)
             transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->ExecuteIndirect(dispatch_signature_, 1, gfx_buffer.resource_, gfx_buffer.data_offset_, nullptr, 0);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeMultiDispatchIndirect(GfxBuffer args_buffer, uint32_t args_count)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+#endif //! GFX_ENABLE_VALIDATION
         if(args_count == 0)
             return kGfxResult_NoError;  // nothing to dispatch
-        if(!buffer_handles_.has_handle(args_buffer.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Buffer *const gfx_args_buffer = buffers_.get(args_buffer.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_args_buffer == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot dispatch using an invalid arguments buffer object");
         if(args_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch using an arguments buffer object with read CPU access");
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isCompute())
+        if(!gfx_kernel->isCompute())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch using a non-compute kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip multi-dispatch call
-        Buffer &gfx_buffer = buffers_[args_buffer];
+        Kernel &kernel = *gfx_kernel;
+        Buffer &gfx_buffer = *gfx_args_buffer;
         SetObjectName(gfx_buffer, args_buffer.name);
         GFX_TRY(installShaderState(kernel));
         if(args_buffer.cpu_access == kGfxCpuAccess_None)
             transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         uint32_t root_parameter_index = 0xFFFFFFFFu, destination_offset = 0;
         static uint64_t const dispatch_id_parameter = Hash("gfx_DispatchID");
         for(uint32_t i = 0; i < kernel.parameter_count_; ++i)
@@ -3569,20 +3756,28 @@ public:
     {
         if(dxr_command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!sbt_handles_.has_handle(sbt.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Sbt *const gfx_sbt_object = sbts_.get(sbt.handle);
+#if GFX_ENABLE_VALIDATION
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+        if(gfx_sbt_object == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot dispatch using an invalid sbt object");
+#endif //! GFX_ENABLE_VALIDATION
         if(!width || !height || !depth)
             return kGfxResult_NoError;  // nothing to dispatch
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+#if GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isRaytracing())
+        if(!gfx_kernel->isRaytracing())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch using a non-raytracing kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.state_object_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->state_object_ == nullptr)
             return kGfxResult_NoError;  // skip dispatch call
-        Sbt &gfx_sbt = sbts_[sbt];
+        Kernel &kernel = *gfx_kernel;
+        Sbt &gfx_sbt = *gfx_sbt_object;
         GFX_TRY(installShaderState(kernel, false, &gfx_sbt));
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         D3D12_DISPATCH_RAYS_DESC desc;
         desc.RayGenerationShaderRecord = gfx_sbt.ray_generation_shader_record_;
         desc.MissShaderTable = gfx_sbt.miss_shader_table_;
@@ -3597,80 +3792,309 @@ public:
 
     GfxResult encodeDispatchRaysIndirect(GfxSbt const &sbt, GfxBuffer args_buffer)
     {
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Buffer *const gfx_args_buffer = buffers_.get(args_buffer.handle);
+        Sbt *const gfx_sbt_object = sbts_.get(sbt.handle);
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
-        if(!sbt_handles_.has_handle(sbt.handle))
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+        if(gfx_sbt_object == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot dispatch using an invalid sbt object");
-        if(!buffer_handles_.has_handle(args_buffer.handle))
+        if(gfx_args_buffer == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot dispatch rays using an invalid arguments buffer object");
         if(args_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch rays using an arguments buffer object with read CPU access");
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch rays when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isRaytracing())
+        if(!gfx_kernel->isRaytracing())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot dispatch rays using non-raytracing kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.state_object_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->state_object_ == nullptr)
             return kGfxResult_NoError;  // skip dispatch rays call
-        Buffer &gfx_buffer = buffers_[args_buffer];
+        Kernel &kernel = *gfx_kernel;
+        Buffer &gfx_buffer = *gfx_args_buffer;
         SetObjectName(gfx_buffer, args_buffer.name);
-        Sbt &gfx_sbt = sbts_[sbt]; // get hold of sbt object
+        Sbt &gfx_sbt = *gfx_sbt_object; // get hold of sbt object
         GFX_TRY(installShaderState(kernel, false, &gfx_sbt));
         if(args_buffer.cpu_access == kGfxCpuAccess_None)
             transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->ExecuteIndirect(dispatch_rays_signature_, 1, gfx_buffer.resource_, gfx_buffer.data_offset_, nullptr, 0);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeDrawMesh(uint32_t num_groups_x, uint32_t num_groups_y, uint32_t num_groups_z)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+#endif //! GFX_ENABLE_VALIDATION
         if(mesh_command_list_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
         if(!num_groups_x || !num_groups_y || !num_groups_z)
             return kGfxResult_NoError;  // nothing to draw
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isMesh())
+        if(!gfx_kernel->isMesh())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using a non-mesh kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip draw call
+        Kernel &kernel = *gfx_kernel;
         GFX_TRY(installShaderState(kernel));
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         mesh_command_list_->DispatchMesh(num_groups_x, num_groups_y, num_groups_z);
         return kGfxResult_NoError;
     }
 
     GfxResult encodeDrawMeshIndirect(GfxBuffer args_buffer)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record indirect, dispatch or mesh commands into a bundle object");
+#endif //! GFX_ENABLE_VALIDATION
         if(mesh_command_list_ == nullptr)
             return kGfxResult_InvalidOperation; // avoid spamming console output
-        if(!buffer_handles_.has_handle(args_buffer.handle))
+        Kernel *const gfx_kernel = kernels_.get(bound_kernel_.handle);
+        Buffer *const gfx_args_buffer = buffers_.get(args_buffer.handle);
+#if GFX_ENABLE_VALIDATION
+        if(gfx_args_buffer == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot draw using an invalid arguments buffer object");
         if(args_buffer.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using an arguments buffer object with read CPU access");
-        if(!kernel_handles_.has_handle(bound_kernel_.handle))
+        if(gfx_kernel == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw when bound kernel object is invalid");
-        Kernel &kernel = kernels_[bound_kernel_];
-        if(!kernel.isMesh())
+        if(!gfx_kernel->isMesh())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw using a non-mesh kernel object");
-        if(kernel.root_signature_ == nullptr || kernel.pipeline_state_ == nullptr)
+#endif //! GFX_ENABLE_VALIDATION
+        if(gfx_kernel == nullptr || gfx_kernel->root_signature_ == nullptr || gfx_kernel->pipeline_state_ == nullptr)
             return kGfxResult_NoError;  // skip draw call
-        Buffer &gfx_buffer = buffers_[args_buffer];
+        Kernel &kernel = *gfx_kernel;
+        Buffer &gfx_buffer = *gfx_args_buffer;
         SetObjectName(gfx_buffer, args_buffer.name);
         GFX_TRY(installShaderState(kernel));
         if(args_buffer.cpu_access == kGfxCpuAccess_None)
             transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-        submitPipelineBarriers();   // transition our resources if needed
+        GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
         command_list_->ExecuteIndirect(draw_mesh_signature_, 1, gfx_buffer.resource_, gfx_buffer.data_offset_, nullptr, 0);
         return kGfxResult_NoError;
     }
 
+    GfxBundle beginBundle()
+    {
+        GfxBundle bundle = {};
+        if(recording_bundle_)
+        {
+            GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot begin a bundle object while already recording one");
+            return bundle;  // invalid operation
+        }
+        bundle.handle = bundles_.allocate_handle();
+        bundles_.insert(bundle);
+        recording_bundle_ = bundle;
+        recording_kernel_ = {};
+        recording_index_buffer_ = false;
+        return bundle;
+    }
+
+    GfxResult endBundle(GfxBundle const &bundle)
+    {
+        if(!bundles_.has_handle(bundle.handle))
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot end invalid bundle object");
+        if(recording_bundle_ != bundle)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot end a bundle object that is not being recorded");
+        Bundle &gfx_bundle = bundles_[bundle];
+        gfx_bundle.commands_.shrink_to_fit();
+        gfx_bundle.is_recorded_ = true;
+        recording_bundle_ = {};
+        recording_kernel_ = {};
+        recording_index_buffer_ = false;
+        return kGfxResult_NoError;
+    }
+
+    GfxResult destroyBundle(GfxBundle const &bundle)
+    {
+        if(!bundle)
+            return kGfxResult_NoError;
+        if(!bundles_.has_handle(bundle.handle))
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid bundle object");
+        if(recording_bundle_ == bundle)
+        {
+            recording_bundle_ = {};
+            recording_kernel_ = {};
+            recording_index_buffer_ = false;
+        }
+        bundles_.erase(bundle); // destroy bundle
+        bundles_.free_handle(bundle.handle);
+        return kGfxResult_NoError;
+    }
+
+    Bundle::Command &recordCommand(Bundle::CommandType type)
+    {
+        Bundle &gfx_bundle = bundles_[recording_bundle_];
+        gfx_bundle.commands_.push_back({});
+        Bundle::Command &command = gfx_bundle.commands_.back();
+        command.type_ = type;
+        return command;
+    }
+
+    GfxResult recordBindKernel(GfxKernel const &kernel)
+    {
+        if(!kernels_[kernel].isGraphics())
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record a non-graphics kernel object into a bundle object");
+        if(recording_kernel_.handle == kernel.handle) return kGfxResult_NoError;    // already bound
+        Bundle &gfx_bundle = bundles_[recording_bundle_];
+        recordCommand(Bundle::kCommandType_BindKernel).args_[0] = (uint32_t)gfx_bundle.kernels_.size();
+        gfx_bundle.kernels_.push_back(kernel);
+        recording_kernel_ = kernel;
+        return kGfxResult_NoError;
+    }
+
+    GfxResult recordBindBuffer(Bundle::CommandType type, GfxBuffer const &buffer)
+    {
+        Bundle &gfx_bundle = bundles_[recording_bundle_];
+        recordCommand(type).args_[0] = (uint32_t)gfx_bundle.buffers_.size();
+        gfx_bundle.buffers_.push_back(buffer);
+        if(type == Bundle::kCommandType_BindIndexBuffer)
+            recording_index_buffer_ = (buffer.handle != 0);
+        return kGfxResult_NoError;
+    }
+
+    GfxResult recordDraw(Bundle::CommandType type, uint32_t count, uint32_t instance_count, uint32_t first_index, uint32_t base_vertex, uint32_t base_instance)
+    {
+        if(!recording_kernel_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record a draw into a bundle object before binding a kernel object");
+        if(!kernels_.has_handle(recording_kernel_.handle) || !kernels_[recording_kernel_].isGraphics())
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record a draw into a bundle object using a non-graphics kernel object");
+        if(type == Bundle::kCommandType_DrawIndexed && !recording_index_buffer_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot record an indexed draw into a bundle object before binding an index buffer object");
+        Bundle::Command &command = recordCommand(type);
+        command.args_[0] = count;
+        command.args_[1] = instance_count;
+        command.args_[2] = first_index;
+        command.args_[3] = base_vertex;
+        command.args_[4] = base_instance;
+        return kGfxResult_NoError;
+    }
+
+    GfxResult encodeExecuteBundle(GfxBundle const &bundle)
+    {
+#if GFX_ENABLE_VALIDATION
+        if(command_list_ == nullptr)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
+        if(recording_bundle_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot execute a bundle object while recording one");
+        if(!bundles_.has_handle(bundle.handle))
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot execute invalid bundle object");
+        if(!bundles_[bundle].is_recorded_)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot execute a bundle object that was not ended");
+#endif //! GFX_ENABLE_VALIDATION
+        if(queue_ != kGfxQueue_Graphics)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot execute a bundle object when recording for the compute queue");
+        GfxKernel const kernel = bound_kernel_;
+        GfxBuffer const index_buffer = bound_index_buffer_;
+        GfxBuffer const vertex_buffer = bound_vertex_buffer_;
+        Viewport const viewport = viewport_;
+        ScissorRect const scissor_rect = scissor_rect_;
+        GfxResult const result = executeBundle(bundles_[bundle]);
+        if(bound_kernel_.handle != kernel.handle)
+        {
+            if(kernels_.has_handle(kernel.handle))
+                encodeBindKernel(kernel);   // re-install the pipeline state
+            else
+                bound_kernel_ = kernel;
+        }
+        bound_index_buffer_ = index_buffer; // the bundle's state does not leak into the live encoding
+        bound_vertex_buffer_ = vertex_buffer;
+        viewport_ = viewport;
+        scissor_rect_ = scissor_rect;
+        return result;
+    }
+
+    GfxResult executeBundle(Bundle const &gfx_bundle)
+    {
+        // The commands were validated when recorded, so only the referenced objects need checking here.
+        // Shader state is installed once per bound kernel (or viewport/scissor change) as the program
+        // parameters cannot change mid-bundle; the draws in between only update the input buffers.
+        Kernel *kernel = nullptr;
+        bool install_shader_state = true;
+        for(size_t i = 0; i < gfx_bundle.commands_.size(); ++i)
+        {
+            Bundle::Command const &command = gfx_bundle.commands_[i];
+            switch(command.type_)
+            {
+            case Bundle::kCommandType_BindKernel:
+                {
+                    GfxKernel const &bundle_kernel = gfx_bundle.kernels_[command.args_[0]];
+                    if(!kernels_.has_handle(bundle_kernel.handle))
+                        return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot execute a bundle object that references a destroyed kernel object");
+                    GFX_TRY(encodeBindKernel(bundle_kernel));
+                    kernel = &kernels_[bundle_kernel];
+                    install_shader_state = true;
+                }
+                break;
+            case Bundle::kCommandType_BindIndexBuffer:
+            case Bundle::kCommandType_BindVertexBuffer:
+                {
+                    GfxBuffer const &bundle_buffer = gfx_bundle.buffers_[command.args_[0]];
+                    if(!buffers_.has_handle(bundle_buffer.handle))
+                        return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot execute a bundle object that references a destroyed buffer object");
+                    if(command.type_ == Bundle::kCommandType_BindIndexBuffer)
+                        bound_index_buffer_ = bundle_buffer;
+                    else
+                        bound_vertex_buffer_ = bundle_buffer;
+                }
+                break;
+            case Bundle::kCommandType_SetViewport:
+                viewport_.x_ = command.viewport_[0];
+                viewport_.y_ = command.viewport_[1];
+                viewport_.width_ = command.viewport_[2];
+                viewport_.height_ = command.viewport_[3];
+                install_shader_state = true;
+                break;
+            case Bundle::kCommandType_SetScissorRect:
+                scissor_rect_.x_ = command.scissor_rect_[0];
+                scissor_rect_.y_ = command.scissor_rect_[1];
+                scissor_rect_.width_ = command.scissor_rect_[2];
+                scissor_rect_.height_ = command.scissor_rect_[3];
+                install_shader_state = true;
+                break;
+            case Bundle::kCommandType_Draw:
+            case Bundle::kCommandType_DrawIndexed:
+                {
+                    GFX_ASSERT(kernel != nullptr);  // validated when recorded
+                    if(kernel->root_signature_ == nullptr || kernel->pipeline_state_ == nullptr)
+                        break;  // skip draw call
+                    bool const indexed = (command.type_ == Bundle::kCommandType_DrawIndexed);
+                    if(install_shader_state)
+                    {
+                        GFX_TRY(installShaderState(*kernel, indexed));
+                        install_shader_state = false;
+                    }
+                    else
+                        installInputBuffers(*kernel, indexed);
+                    GFX_TRY(flushPipelineBarriers());   // transition our resources if needed
+                    if(indexed)
+                        command_list_->DrawIndexedInstanced(command.args_[0], command.args_[1], command.args_[2], command.args_[3], command.args_[4]);
+                    else
+                        command_list_->DrawInstanced(command.args_[0], command.args_[1], command.args_[3], command.args_[4]);
+                }
+                break;
+            default:
+                GFX_ASSERT(0);
+                break;
+            }
+        }
+        return kGfxResult_NoError;
+    }
+
     GfxTimestampQuery createTimestampQuery()
     {
         GfxTimestampQuery timestamp_query = {};
@@ -3679,7 +4103,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create timestamp query objects when using an interop context");
             return timestamp_query; // invalid operation
         }
-        timestamp_query.handle = timestamp_query_handles_.allocate_handle();
+        timestamp_query.handle = timestamp_queries_.allocate_handle();
         timestamp_queries_.insert(timestamp_query);
         return timestamp_query;
     }
@@ -3688,16 +4112,16 @@ public:
     {
         if(!timestamp_query)
             return kGfxResult_NoError;
-        if(!timestamp_query_handles_.has_handle(timestamp_query.handle))
+        if(!timestamp_queries_.has_handle(timestamp_query.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid timestamp query object");
         timestamp_queries_.erase(timestamp_query);  // destroy timestamp query
-        timestamp_query_handles_.free_handle(timestamp_query.handle);
+        timestamp_queries_.free_handle(timestamp_query.handle);
         return kGfxResult_NoError;
     }
 
     float getTimestampQueryDuration(GfxTimestampQuery const &timestamp_query)
     {
-        if(!timestamp_query_handles_.has_handle(timestamp_query.handle))
+        if(!timestamp_queries_.has_handle(timestamp_query.handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot get the duration of an invalid timestamp query object");
             return 0.0f;
@@ -3707,11 +4131,17 @@ public:
 
     GfxResult encodeBeginTimestampQuery(GfxTimestampQuery const &timestamp_query)
     {
-        if(!timestamp_query_handles_.has_handle(timestamp_query.handle))
+#if GFX_ENABLE_VALIDATION
+        if(!timestamp_queries_.has_handle(timestamp_query.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot begin a timed section using an invalid timestamp query object");
+#endif //! GFX_ENABLE_VALIDATION
         TimestampQuery &gfx_timestamp_query = timestamp_queries_[timestamp_query];
+#if GFX_ENABLE_VALIDATION
         if(gfx_timestamp_query.was_begun_)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot begin a timed section on a timestamp query object that was already open");
+#endif //! GFX_ENABLE_VALIDATION
+        if(queue_ != kGfxQueue_Graphics)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot begin a timed section when recording for the compute queue");
         TimestampQueryHeap &timestamp_query_heap = timestamp_query_heaps_[fence_index_];
         if(timestamp_query_heap.timestamp_queries_.find(timestamp_query.handle) != timestamp_query_heap.timestamp_queries_.end())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot use a timestamp query object more than once per frame");
@@ -3753,14 +4183,20 @@ public:
 
     GfxResult encodeEndTimestampQuery(GfxTimestampQuery const &timestamp_query)
     {
-        if(!timestamp_query_handles_.has_handle(timestamp_query.handle))
+#if GFX_ENABLE_VALIDATION
+        if(!timestamp_queries_.has_handle(timestamp_query.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot end a timed section using an invalid timestamp query object");
+#endif //! GFX_ENABLE_VALIDATION
         TimestampQuery &gfx_timestamp_query = timestamp_queries_[timestamp_query];
+#if GFX_ENABLE_VALIDATION
         if(!gfx_timestamp_query.was_begun_)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot end a timed section using a timestamp query object that was already closed");
+#endif //! GFX_ENABLE_VALIDATION
+        if(queue_ != kGfxQueue_Graphics)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot end a timed section when recording for the compute queue");
         TimestampQueryHeap &timestamp_query_heap = timestamp_query_heaps_[fence_index_];
         gfx_timestamp_query.was_begun_ = false; // timestamp query is now closed
-        std::map<uint64_t, std::pair<uint32_t, GfxTimestampQuery>>::const_iterator const it = timestamp_query_heap.timestamp_queries_.find(timestamp_query.handle);
+        GfxHashMap<uint64_t, std::pair<uint32_t, GfxTimestampQuery>>::const_iterator const it = timestamp_query_heap.timestamp_queries_.find(timestamp_query.handle);
         GFX_ASSERT(it != timestamp_query_heap.timestamp_queries_.end());
         if(it == timestamp_query_heap.timestamp_queries_.end())
             return kGfxResult_InternalError;    // should never happen
@@ -3804,6 +4240,7 @@ public:
 
     GfxResult encodeScan(OpType op_type, GfxDataType data_type, GfxBuffer const &dst, GfxBuffer const &src, GfxBuffer const *count)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
         if(data_type < 0 || data_type >= kGfxDataType_Count)
@@ -3814,10 +4251,11 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot scan buffer object of more than 4 billion keys");
         if(dst.cpu_access == kGfxCpuAccess_Read || src.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot scan buffer object with read CPU access");
-        if(!buffer_handles_.has_handle(dst.handle) || !buffer_handles_.has_handle(src.handle))
+        if(!buffers_.has_handle(dst.handle) || !buffers_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot scan when supplied buffer object is invalid");
-        if(count != nullptr && !buffer_handles_.has_handle(count->handle))
+        if(count != nullptr && !buffers_.has_handle(count->handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot scan when supplied count buffer object is invalid");
+#endif //! GFX_ENABLE_VALIDATION
         ScanKernels const &scan_kernels = getScanKernels(op_type, data_type, count);
         uint32_t const group_size = 256;
         uint32_t const keys_per_thread = 4;
@@ -3926,7 +4364,7 @@ public:
         destroyBuffer(scan_level_1_buffer); destroyBuffer(scan_level_2_buffer);
         destroyBuffer(scan_level_1_args_buffer); destroyBuffer(scan_level_2_args_buffer);
         destroyBuffer(num_groups_level_1_buffer); destroyBuffer(num_groups_level_2_buffer);
-        if(kernel_handles_.has_handle(bound_kernel.handle))
+        if(kernels_.has_handle(bound_kernel.handle))
             encodeBindKernel(bound_kernel);
         else
             bound_kernel_ = bound_kernel;
@@ -3935,6 +4373,7 @@ public:
 
     GfxResult encodeReduce(OpType op_type, GfxDataType data_type, GfxBuffer const &dst, GfxBuffer const &src, GfxBuffer const *count)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
         if(data_type < 0 || data_type >= kGfxDataType_Count)
@@ -3945,10 +4384,11 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot reduce buffer object of more than 4 billion keys");
         if(dst.cpu_access == kGfxCpuAccess_Read || src.cpu_access == kGfxCpuAccess_Read)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot reduce buffer object with read CPU access");
-        if(!buffer_handles_.has_handle(dst.handle) || !buffer_handles_.has_handle(src.handle))
+        if(!buffers_.has_handle(dst.handle) || !buffers_.has_handle(src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot reduce when supplied buffer object is invalid");
-        if(count != nullptr && !buffer_handles_.has_handle(count->handle))
+        if(count != nullptr && !buffers_.has_handle(count->handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot reduce when supplied count buffer object is invalid");
+#endif //! GFX_ENABLE_VALIDATION
         ScanKernels const &scan_kernels = getScanKernels(op_type, data_type, count);
         uint32_t const group_size = 256;
         uint32_t const keys_per_thread = 4;
@@ -4030,7 +4470,7 @@ public:
         destroyBuffer(reduce_level_1_buffer); destroyBuffer(reduce_level_2_buffer);
         destroyBuffer(num_groups_level_1_buffer); destroyBuffer(num_groups_level_2_buffer);
         destroyBuffer(reduce_level_1_args_buffer); destroyBuffer(reduce_level_2_args_buffer);
-        if(kernel_handles_.has_handle(bound_kernel.handle))
+        if(kernels_.has_handle(bound_kernel.handle))
             encodeBindKernel(bound_kernel);
         else
             bound_kernel_ = bound_kernel;
@@ -4039,6 +4479,7 @@ public:
 
     GfxResult encodeRadixSort(GfxBuffer const &keys_dst, GfxBuffer const &keys_src, GfxBuffer const *values_dst, GfxBuffer const *values_src, GfxBuffer const *count)
     {
+#if GFX_ENABLE_VALIDATION
         if(command_list_ == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot encode without a valid command list");
         if(keys_dst.size != keys_src.size)
@@ -4049,14 +4490,15 @@ public:
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot sort if source and destination buffer objects aren't of the same size");
         if((keys_dst.size >> 2) > 0xFFFFFFFFull)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot sort buffer object of more than 4 billion keys");
-        if(!buffer_handles_.has_handle(keys_dst.handle) || !buffer_handles_.has_handle(keys_src.handle))
+        if(!buffers_.has_handle(keys_dst.handle) || !buffers_.has_handle(keys_src.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot sort keys when supplied buffer object is invalid");
-        if((values_dst != nullptr && !buffer_handles_.has_handle(values_dst->handle)) || (values_src != nullptr && !buffer_handles_.has_handle(values_src->handle)))
+        if((values_dst != nullptr && !buffers_.has_handle(values_dst->handle)) || (values_src != nullptr && !buffers_.has_handle(values_src->handle)))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot sort values when supplied buffer object is invalid");
         if((values_dst != nullptr && values_src == nullptr) || (values_dst == nullptr && values_src != nullptr))
             return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot sort values if source or destination isn't a valid buffer object");
-        if(count != nullptr && !buffer_handles_.has_handle(count->handle))
+        if(count != nullptr && !buffers_.has_handle(count->handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot sort when supplied count buffer object is invalid");
+#endif //! GFX_ENABLE_VALIDATION
         SortKernels const &sort_kernels = getSortKernels(values_src != nullptr, count);
         uint32_t const group_size = 256;
         uint32_t const keys_per_thread = 4;
@@ -4125,7 +4567,7 @@ public:
         destroyBuffer(group_histograms);
         destroyBuffer(args_buffer); destroyBuffer(count_buffer);
         destroyBuffer(scratch_keys); destroyBuffer(scratch_values);
-        if(kernel_handles_.has_handle(bound_kernel.handle))
+        if(kernels_.has_handle(bound_kernel.handle))
             encodeBindKernel(bound_kernel);
         else
             bound_kernel_ = bound_kernel;
@@ -4139,11 +4581,12 @@ public:
             fence_index_ = (fence_index_ + 1) % max_frames_in_flight_;
         else
         {
+            GFX_TRY(setQueue(kGfxQueue_Graphics));  // end of frame is recorded on the graphics queue
             if(!timestamp_query_heaps_[fence_index_].timestamp_queries_.empty())
             {
-                for(std::map<uint64_t, std::pair<uint32_t, GfxTimestampQuery>>::const_iterator it = timestamp_query_heaps_[fence_index_].timestamp_queries_.begin(); it != timestamp_query_heaps_[fence_index_].timestamp_queries_.end(); ++it)
+                for(GfxHashMap<uint64_t, std::pair<uint32_t, GfxTimestampQuery>>::const_iterator it = timestamp_query_heaps_[fence_index_].timestamp_queries_.begin(); it != timestamp_query_heaps_[fence_index_].timestamp_queries_.end(); ++it)
                 {
-                    if(!timestamp_query_handles_.has_handle((*it).second.second.handle))
+                    if(!timestamp_queries_.has_handle((*it).second.second.handle))
                         continue;   // timestamp query object was destroyed
                     TimestampQuery const &timestamp_query = timestamp_queries_[(*it).second.second];
                     if(timestamp_query.was_begun_)  // was the query not closed properly?
@@ -4151,7 +4594,7 @@ public:
                     GFX_ASSERT(!timestamp_query.was_begun_);
                 }
                 uint32_t const timestamp_query_count = (uint32_t)timestamp_query_heaps_[fence_index_].timestamp_queries_.size();
-                GFX_ASSERT(buffer_handles_.has_handle(timestamp_query_heaps_[fence_index_].query_buffer_.handle));
+                GFX_ASSERT(buffers_.has_handle(timestamp_query_heaps_[fence_index_].query_buffer_.handle));
                 Buffer const &query_buffer = buffers_[timestamp_query_heaps_[fence_index_].query_buffer_];
                 command_list_->ResolveQueryData(timestamp_query_heaps_[fence_index_].query_heap_,
                     D3D12_QUERY_TYPE_TIMESTAMP, 0, 2 * timestamp_query_count, query_buffer.resource_, query_buffer.data_offset_);
@@ -4170,6 +4613,7 @@ public:
                 command_list_->Close(); // close command list for submit
                 ID3D12CommandList *const command_lists[] = { command_list_ };
                 command_queue_->ExecuteCommandLists(ARRAYSIZE(command_lists), command_lists);
+                submitComputeQueue();   // frame fence also covers the async compute work
                 command_queue_->Signal(fences_[fence_index_], ++fence_values_[fence_index_]);
                 swap_chain_->Present(vsync ? 1 : 0, vsync ? 0 : DXGI_PRESENT_ALLOW_TEARING);
                 uint32_t const window_width  = GFX_MAX(window_rect.right,  (LONG)8);
@@ -4184,6 +4628,7 @@ public:
                 }
                 command_allocators_[fence_index_]->Reset();
                 command_list_->Reset(command_allocators_[fence_index_], nullptr);
+                resetComputeQueue();
                 resource_barrier.Transition.pResource = back_buffers_[fence_index_];
                 resource_barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
                 resource_barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
@@ -4194,6 +4639,7 @@ public:
                 command_list_->Close(); // close command list for submit
                 ID3D12CommandList *const command_lists[] = { command_list_ };
                 command_queue_->ExecuteCommandLists(ARRAYSIZE(command_lists), command_lists);
+                submitComputeQueue();   // frame fence also covers the async compute work
                 command_queue_->Signal(fences_[fence_index_], ++fence_values_[fence_index_]);
                 fence_index_ = (fence_index_ + 1) % max_frames_in_flight_;
                 if(fences_[fence_index_]->GetCompletedValue() < fence_values_[fence_index_])
@@ -4203,17 +4649,18 @@ public:
                 }
                 command_allocators_[fence_index_]->Reset();
                 command_list_->Reset(command_allocators_[fence_index_], nullptr);
+                resetComputeQueue();
             }
             if(!timestamp_query_heaps_[fence_index_].timestamp_queries_.empty())
             {
                 double const ticks_per_milliseconds = timestamp_query_ticks_per_second_ / 1000.0;
-                for(std::map<uint64_t, std::pair<uint32_t, GfxTimestampQuery>>::const_iterator it = timestamp_query_heaps_[fence_index_].timestamp_queries_.begin(); it != timestamp_query_heaps_[fence_index_].timestamp_queries_.end(); ++it)
+                for(GfxHashMap<uint64_t, std::pair<uint32_t, GfxTimestampQuery>>::const_iterator it = timestamp_query_heaps_[fence_index_].timestamp_queries_.begin(); it != timestamp_query_heaps_[fence_index_].timestamp_queries_.end(); ++it)
                 {
-                    if(!timestamp_query_handles_.has_handle((*it).second.second.handle))
+                    if(!timestamp_queries_.has_handle((*it).second.second.handle))
                         continue;   // timestamp query object was destroyed
                     uint32_t const timestamp_query_index = (*it).second.first;
                     TimestampQuery &timestamp_query = timestamp_queries_[(*it).second.second];
-                    GFX_ASSERT(buffer_handles_.has_handle(timestamp_query_heaps_[fence_index_].query_buffer_.handle));
+                    GFX_ASSERT(buffers_.has_handle(timestamp_query_heaps_[fence_index_].query_buffer_.handle));
                     GFX_ASSERT(timestamp_query_index < timestamp_query_heaps_[fence_index_].timestamp_queries_.size());
                     Buffer const &query_buffer = buffers_[timestamp_query_heaps_[fence_index_].query_buffer_];
                     uint64_t const *timestamp_query_data = (uint64_t const *)((char const *)query_buffer.data_ + query_buffer.data_offset_);
@@ -4228,6 +4675,7 @@ public:
         }
         constant_buffer_pool_cursors_[fence_index_] = 0;
         resetState();   // re-install state
+        checkMemoryBudget();
         return runGarbageCollection();
     }
 
@@ -4235,16 +4683,62 @@ public:
     {
         if(isInterop())
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot synchronize commands when using an interop context");
+        GFX_TRY(setQueue(kGfxQueue_Graphics));
         command_list_->Close(); // close command list for submit
         ID3D12CommandList *const command_lists[] = { command_list_ };
         command_queue_->ExecuteCommandLists(ARRAYSIZE(command_lists), command_lists);
+        submitComputeQueue();
         GFX_TRY(sync());    // make sure GPU has gone through all pending work
         command_allocators_[fence_index_]->Reset();
         command_list_->Reset(command_allocators_[fence_index_], nullptr);
+        resetComputeQueue();
         resetState();   // re-install state
         return kGfxResult_NoError;
     }
 
+    GfxMemoryBudget getMemoryBudget()
+    {
+        GfxMemoryBudget memory_budget = {};
+        D3D12MA::Budget local_budget = {}, non_local_budget = {};
+        mem_allocator_->GetBudget(&local_budget, &non_local_budget);
+        memory_budget.usage_bytes = local_budget.UsageBytes;
+        memory_budget.budget_bytes = local_budget.BudgetBytes;
+        memory_budget.non_local_usage_bytes = non_local_budget.UsageBytes;
+        memory_budget.non_local_budget_bytes = non_local_budget.BudgetBytes;
+        return memory_tracker_.get_budget(memory_budget);
+    }
+
+    GfxMemoryStatistics getMemoryStatistics() const
+    {
+        return memory_tracker_.get_statistics();
+    }
+
+    GfxResult addMemoryBudgetCallback(float threshold, GfxMemoryBudgetCallback callback, void *user_data)
+    {
+        return memory_tracker_.add_callback(threshold, callback, user_data);
+    }
+
+    GfxResult removeMemoryBudgetCallback(GfxMemoryBudgetCallback callback, void *user_data)
+    {
+        return memory_tracker_.remove_callback(callback, user_data);
+    }
+
+    GfxResult setSimulatedMemoryBudget(uint64_t budget_bytes)
+    {
+        memory_tracker_.set_simulated_budget(budget_bytes);
+        return kGfxResult_NoError;
+    }
+
+    void checkMemoryBudget()
+    {
+        if(!memory_tracker_.has_callbacks()) return;    // nothing to notify
+        GfxMemoryBudget const memory_budget = getMemoryBudget();
+        memory_tracker_.check_budget(memory_budget, [&](GfxMemoryBudgetCallback callback, bool is_over_threshold, void *user_data)
+        {
+            callback(context_, memory_budget, is_over_threshold, user_data);
+        });
+    }
+
     inline ID3D12Device *getDevice() const
     {
         return device_;
@@ -4260,6 +4754,16 @@ public:
         return command_list_;
     }
 
+    inline ID3D12DescriptorHeap *getDescriptorHeap() const
+    {
+        return descriptors_.descriptor_heap_;
+    }
+
+    inline uint32_t getDescriptorRepopulationCount() const
+    {
+        return descriptor_repopulation_count_;
+    }
+
     GfxResult setCommandList(ID3D12GraphicsCommandList *command_list)
     {
         if(!isInterop())
@@ -4312,6 +4816,80 @@ public:
         return kGfxResult_NoError;
     }
 
+    GfxResult setQueue(GfxQueue queue)
+    {
+        if(queue >= kGfxQueue_Count)
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot select an invalid queue");
+        if(queue == queue_)
+            return kGfxResult_NoError;  // already recording for this queue
+        if(isInterop())
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot use the compute queue when using an interop context");
+        GFX_TRY(createComputeQueue());
+        submitPipelineBarriers();   // flush the pending barriers onto the current command list
+        compute_queue_hazard_ = false;
+        std::swap(command_list_, idle_command_list_);
+        std::swap(dxr_command_list_, idle_dxr_command_list_);
+        std::swap(mesh_command_list_, idle_mesh_command_list_);
+        queue_ = queue;
+        resetState();   // re-install state
+        return kGfxResult_NoError;
+    }
+
+    inline GfxQueue getQueue() const
+    {
+        return queue_;
+    }
+
+    GfxSyncPoint signal(GfxQueue queue)
+    {
+        GfxSyncPoint sync_point;
+        if(queue >= kGfxQueue_Count)
+        {
+            GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot signal an invalid queue");
+            return sync_point;  // invalid parameter
+        }
+        if(isInterop())
+        {
+            GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot signal a queue when using an interop context");
+            return sync_point;  // invalid operation
+        }
+        GfxQueue const current_queue = queue_;
+        if(createComputeQueue() != kGfxResult_NoError || setQueue(queue) != kGfxResult_NoError)
+        {
+            GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Unable to signal the %s queue", queue == kGfxQueue_Compute ? "compute" : "graphics");
+            return sync_point;  // invalid operation
+        }
+        if(queue == kGfxQueue_Graphics)
+            releaseGraphicsResourceStates();
+        submitPipelineBarriers();   // transition our resources if needed
+        ID3D12CommandQueue *command_queue = (queue == kGfxQueue_Compute ? compute_queue_ : command_queue_);
+        ID3D12CommandAllocator *command_allocator = (queue == kGfxQueue_Compute ? compute_command_allocators_ : command_allocators_)[fence_index_];
+        command_list_->Close(); // close command list for submit
+        ID3D12CommandList *const command_lists[] = { command_list_ };
+        command_queue->ExecuteCommandLists(ARRAYSIZE(command_lists), command_lists);
+        command_queue->Signal(queue_fences_[queue], ++queue_fence_values_[queue]);
+        command_list_->Reset(command_allocator, nullptr);
+        resetState();   // re-install state
+        setQueue(current_queue);
+        sync_point.fence_value = queue_fence_values_[queue];
+        sync_point.queue = queue;
+        return sync_point;
+    }
+
+    GfxResult wait(GfxQueue queue, GfxSyncPoint const &sync_point)
+    {
+        if(queue >= kGfxQueue_Count)
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot wait on an invalid queue");
+        if(!sync_point || sync_point.fence_value > queue_fence_values_[sync_point.queue])
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot wait for an invalid sync point");
+        if(sync_point.queue == queue)
+            return kGfxResult_NoError;  // queues execute their work in submission order
+        GFX_ASSERT(compute_queue_ != nullptr && queue_fences_[sync_point.queue] != nullptr);
+        ID3D12CommandQueue *command_queue = (queue == kGfxQueue_Compute ? compute_queue_ : command_queue_);
+        command_queue->Wait(queue_fences_[sync_point.queue], sync_point.fence_value);
+        return kGfxResult_NoError;
+    }
+
     GfxBuffer createBuffer(ID3D12Resource *resource, D3D12_RESOURCE_STATES resource_state)
     {
         GfxBuffer buffer = {};
@@ -4323,7 +4901,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create a buffer object from a non-buffer resource");
             return buffer;  // invalid operation
         }
-        buffer.handle = buffer_handles_.allocate_handle();
+        buffer.handle = buffers_.allocate_handle();
         Buffer &gfx_buffer = buffers_.insert(buffer);
         buffer.size = (uint64_t)resource_desc.Width;
         buffer.cpu_access = kGfxCpuAccess_None;
@@ -4362,7 +4940,7 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Multisample textures are not supported");
             return texture; // invalid operation
         }
-        texture.handle = texture_handles_.allocate_handle();
+        texture.handle = textures_.allocate_handle();
         Texture &gfx_texture = textures_.insert(texture);
         texture.width = (uint32_t)resource_desc.Width;
         texture.height = (uint32_t)resource_desc.Height;
@@ -4409,9 +4987,9 @@ public:
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot have a byte offset that is larger than the size of the buffer resource");
             return acceleration_structure;  // invalid operation
         }
-        acceleration_structure.handle = acceleration_structure_handles_.allocate_handle();
+        acceleration_structure.handle = acceleration_structures_.allocate_handle();
         AccelerationStructure &gfx_acceleration_structure = acceleration_structures_.insert(acceleration_structure);
-        gfx_acceleration_structure.bvh_buffer_.handle = buffer_handles_.allocate_handle();
+        gfx_acceleration_structure.bvh_buffer_.handle = buffers_.allocate_handle();
         Buffer &gfx_buffer = buffers_.insert(gfx_acceleration_structure.bvh_buffer_);
         gfx_acceleration_structure.bvh_buffer_.size = (uint32_t)resource_desc.Width;
         gfx_acceleration_structure.bvh_buffer_.cpu_access = kGfxCpuAccess_None;
@@ -4430,7 +5008,7 @@ public:
 
     ID3D12Resource *getBufferResource(GfxBuffer const &buffer)
     {
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
             return nullptr; // invalid buffer object
         Buffer const &gfx_buffer = buffers_[buffer];
         return gfx_buffer.resource_;
@@ -4438,7 +5016,7 @@ public:
 
     ID3D12Resource *getTextureResource(GfxTexture const &texture)
     {
-        if(!texture_handles_.has_handle(texture.handle))
+        if(!textures_.has_handle(texture.handle))
             return nullptr; // invalid texture object
         Texture const &gfx_texture = textures_[texture];
         return gfx_texture.resource_;
@@ -4446,10 +5024,10 @@ public:
 
     ID3D12Resource *getAccelerationStructureResource(GfxAccelerationStructure const &acceleration_structure)
     {
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
             return nullptr; // invalid acceleration structure object
         AccelerationStructure const &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
-        if(!buffer_handles_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle))
+        if(!buffers_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle))
             return nullptr; // acceleration structure wasn't built yet
         Buffer const &bvh_buffer = buffers_[gfx_acceleration_structure.bvh_buffer_];
         return bvh_buffer.resource_;
@@ -4457,7 +5035,7 @@ public:
 
     D3D12_RESOURCE_STATES getBufferResourceState(GfxBuffer const &buffer)
     {
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
             return D3D12_RESOURCE_STATE_COMMON; // invalid buffer object
         Buffer const &gfx_buffer = buffers_[buffer];
         return *gfx_buffer.resource_state_;
@@ -4465,7 +5043,7 @@ public:
 
     D3D12_RESOURCE_STATES getTextureResourceState(GfxTexture const &texture)
     {
-        if(!texture_handles_.has_handle(texture.handle))
+        if(!textures_.has_handle(texture.handle))
             return D3D12_RESOURCE_STATE_COMMON; // invalid texture object
         Texture const &gfx_texture = textures_[texture];
         return gfx_texture.resource_state_;
@@ -4474,7 +5052,7 @@ public:
     HANDLE createBufferSharedHandle(GfxBuffer const &buffer)
     {
         HANDLE handle = {};
-        if(!buffer_handles_.has_handle(buffer.handle))
+        if(!buffers_.has_handle(buffer.handle))
         {
             if(!!buffer)
                 GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Cannot create shared handle from invalid buffer object");
@@ -4562,10 +5140,10 @@ public:
 
     inline bool isInterop(GfxAccelerationStructure const &acceleration_structure) const
     {
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
             return false;   // not a valid acceleration structure object
         AccelerationStructure const &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
-        if(!buffer_handles_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle))
+        if(!buffers_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle))
             return false;   // not an interop acceleration structure object
         return buffers_[gfx_acceleration_structure.bvh_buffer_].isInterop();
     }
@@ -4574,7 +5152,7 @@ public:
 
     static void DispenseDrawState(GfxDrawState &draw_state)
     {
-        draw_state.handle = draw_state_handles_.allocate_handle();
+        draw_state.handle = draw_states_.allocate_handle();
         uint32_t const draw_state_index = static_cast<uint32_t>(draw_state.handle & 0xFFFFFFFFull);
         GFX_ASSERT(!draw_states_.has(draw_state_index));    // should never happen
         draw_states_.insert(draw_state_index).reference_count_ = 1;
@@ -4598,7 +5176,7 @@ public:
         if(--gfx_draw_state->reference_count_ == 0)
         {
             draw_states_.erase(draw_state_index);
-            draw_state_handles_.free_handle(draw_state.handle);
+            draw_states_.free_handle(draw_state.handle);
         }
     }
 
@@ -5092,12 +5670,32 @@ private:
                  : D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
     }
 
+    static inline D3D12_RESOURCE_STATES GetComputeResourceState(D3D12_RESOURCE_STATES resource_state)
+    {
+        return resource_state & ~(D3D12_RESOURCE_STATE_INDEX_BUFFER | D3D12_RESOURCE_STATE_RENDER_TARGET |
+                                  D3D12_RESOURCE_STATE_DEPTH_WRITE | D3D12_RESOURCE_STATE_DEPTH_READ |
+                                  D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_STREAM_OUT |
+                                  D3D12_RESOURCE_STATE_RESOLVE_DEST | D3D12_RESOURCE_STATE_RESOLVE_SOURCE);   // falls back to common
+    }
+
+    static inline bool IsGraphicsResourceState(D3D12_RESOURCE_STATES resource_state)
+    {
+        return GetComputeResourceState(resource_state) != resource_state;   // cannot be transitioned from the compute queue
+    }
+
     uint64_t getDescriptorHeapId() const
     {
         return (static_cast<uint64_t>(descriptors_.descriptor_heap_ != nullptr ? descriptors_.descriptor_heap_->GetDesc().NumDescriptors : 0) << 32) |
                (static_cast<uint64_t>(sampler_descriptors_.descriptor_heap_ != nullptr ? sampler_descriptors_.descriptor_heap_->GetDesc().NumDescriptors : 0));
     }
 
+    void collect(D3D12MA::Allocation *allocation)
+    {
+        if(allocation == nullptr) return;
+        untrackAllocation(allocation);
+        collect<D3D12MA::Allocation>(allocation);
+    }
+
     template<typename TYPE>
     void collect(TYPE *resource)
     {
@@ -5163,7 +5761,7 @@ private:
     {
         destroyBuffer(acceleration_structure.bvh_buffer_);
         for(size_t i = 0; i < acceleration_structure.raytracing_primitives_.size(); ++i)
-            if(raytracing_primitive_handles_.has_handle(acceleration_structure.raytracing_primitives_[i].handle))
+            if(raytracing_primitives_.has_handle(acceleration_structure.raytracing_primitives_[i].handle))
                 destroyRaytracingPrimitive(acceleration_structure.raytracing_primitives_[i]);
     }
 
@@ -5284,11 +5882,16 @@ private:
         uint32_t const size = (descriptors_.descriptor_heap_ != nullptr ? descriptors_.descriptor_heap_->GetDesc().NumDescriptors : 0);
         if(freelist_descriptors_.size() > size)
         {
+            // Unless disabled at context creation, the heap is reserved at the tier 1 limit on first use so
+            // that streaming in content never invalidates the descriptors already populated by the kernels
+            // and SBTs. Going past it falls back to recreating a 1.5x larger heap; the heap id then changes
+            // and every kernel and SBT re-populates its descriptors on its next installShaderState().
             ID3D12DescriptorHeap *descriptor_heap = nullptr;
             D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc = {};
             descriptor_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
             descriptor_heap_desc.NumDescriptors = freelist_descriptors_.size();
             descriptor_heap_desc.NumDescriptors += ((descriptor_heap_desc.NumDescriptors + 2) >> 1);
+            descriptor_heap_desc.NumDescriptors = GFX_MAX(descriptor_heap_desc.NumDescriptors, reserved_descriptor_count_);  // reserve up front, as growing invalidates all descriptors
             descriptor_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
             device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&descriptor_heap));
             if(descriptor_heap == nullptr) { freelist_descriptors_.free_slot(descriptor_slot); return 0xFFFFFFFFu; };
@@ -5372,6 +5975,7 @@ private:
             descriptor_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
             descriptor_heap_desc.NumDescriptors = freelist_sampler_descriptors_.size();
             descriptor_heap_desc.NumDescriptors += ((descriptor_heap_desc.NumDescriptors + 2) >> 1);
+            descriptor_heap_desc.NumDescriptors = GFX_MAX(descriptor_heap_desc.NumDescriptors, (uint32_t)D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE);    // reserve the hardware limit up front
             descriptor_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
             device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&descriptor_heap));
             if(descriptor_heap == nullptr) { freelist_sampler_descriptors_.free_slot(sampler_slot); return 0xFFFFFFFFu; };
@@ -6039,7 +6643,8 @@ private:
     {
         uint32_t root_constants[64];
         bool const is_compute = (kernel.isCompute() || kernel.isRaytracing());
-        if(!program_handles_.has_handle(kernel.program_.handle))
+        Program const *gfx_program = programs_.get(kernel.program_.handle);
+        if(gfx_program == nullptr)
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot %s with a %s kernel pointing to an invalid program object",
                 is_compute ? "dispatch" : "draw", is_compute ? "compute" : "graphics");
         if(!is_compute)
@@ -6058,9 +6663,10 @@ private:
                 {
                      // valid bound color target and draw state requires one
                     GfxTexture const &texture = bound_color_targets_[i].texture_;
-                    if(!texture_handles_.has_handle(texture.handle))
+                    Texture *gfx_target = textures_.get(texture.handle);
+                    if(gfx_target == nullptr)
                         return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to an invalid texture object; found at color target %u", i);
-                    Texture &gfx_texture = textures_[texture]; SetObjectName(gfx_texture, texture.name);
+                    Texture &gfx_texture = *gfx_target; SetObjectName(gfx_texture, texture.name);
                     GFX_TRY(ensureTextureHasRenderTargetView(texture, gfx_texture, bound_color_targets_[i].mip_level_, bound_color_targets_[i].slice_));
                     GFX_ASSERT(gfx_texture.rtv_descriptor_slots_[bound_color_targets_[i].mip_level_][bound_color_targets_[i].slice_] != 0xFFFFFFFFu);
                     color_targets[i] = rtv_descriptors_.getCPUHandle(gfx_texture.rtv_descriptor_slots_[bound_color_targets_[i].mip_level_][bound_color_targets_[i].slice_]);
@@ -6079,9 +6685,10 @@ private:
             else if(kernel.draw_state_.depth_stencil_format_ != DXGI_FORMAT_UNKNOWN)
             {
                 GfxTexture const &texture = bound_depth_stencil_target_.texture_;
-                if(!texture_handles_.has_handle(texture.handle))
+                Texture *gfx_target = textures_.get(texture.handle);
+                if(gfx_target == nullptr)
                     return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot draw to an invalid texture object; found at depth/stencil target");
-                Texture &gfx_texture = textures_[texture]; SetObjectName(gfx_texture, texture.name);
+                Texture &gfx_texture = *gfx_target; SetObjectName(gfx_texture, texture.name);
                 GFX_TRY(ensureTextureHasDepthStencilView(texture, gfx_texture, bound_depth_stencil_target_.mip_level_, bound_depth_stencil_target_.slice_));
                 GFX_ASSERT(gfx_texture.dsv_descriptor_slots_[bound_depth_stencil_target_.mip_level_][bound_depth_stencil_target_.slice_] != 0xFFFFFFFFu);
                 depth_stencil_target = dsv_descriptors_.getCPUHandle(gfx_texture.dsv_descriptor_slots_[bound_depth_stencil_target_.mip_level_][bound_depth_stencil_target_.slice_]);
@@ -6125,7 +6732,7 @@ private:
             command_list_->OMSetRenderTargets(color_target_count, color_targets, false, depth_stencil_target.ptr != 0 ? &depth_stencil_target : nullptr);
         }
         uint64_t const previous_descriptor_heap_id = getDescriptorHeapId();
-        Program const &program = programs_[kernel.program_];
+        Program const &program = *gfx_program;
         for(uint32_t i = 0; i < kernel.parameter_count_; ++i)
         {
             Kernel::Parameter &parameter = kernel.parameters_[i];
@@ -6171,18 +6778,18 @@ private:
                 case Kernel::Parameter::kType_RWTexture2DArray:
                     if(parameter.parameter_ != nullptr && parameter.id_ != parameter.parameter_->id_ && parameter.parameter_->type_ == Program::Parameter::kType_Image)
                         for(uint32_t j = 0; j < parameter.parameter_->data_.image_.texture_count; ++j)
-                            if(texture_handles_.has_handle(parameter.parameter_->data_.image_.textures_[j].handle))
-                                ensureTextureHasUsageFlag(textures_[parameter.parameter_->data_.image_.textures_[j]], D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+                        {
+                            Texture *texture = textures_.get(parameter.parameter_->data_.image_.textures_[j].handle);
+                            if(texture != nullptr)
+                                ensureTextureHasUsageFlag(*texture, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+                        }
                     break;
                 case Kernel::Parameter::kType_AccelerationStructure:
                     if(parameter.parameter_ != nullptr && parameter.id_ == parameter.parameter_->id_)
                     {
-                        if(acceleration_structure_handles_.has_handle(parameter.parameter_->data_.acceleration_structure_.bvh_.handle))
-                        {
-                            AccelerationStructure const &acceleration_structure = acceleration_structures_[parameter.parameter_->data_.acceleration_structure_.bvh_];
-                            if(acceleration_structure.bvh_buffer_.handle != parameter.parameter_->data_.acceleration_structure_.bvh_buffer_.handle)
-                                ++const_cast<Program::Parameter *>(parameter.parameter_)->id_;
-                        }
+                        AccelerationStructure const *acceleration_structure = acceleration_structures_.get(parameter.parameter_->data_.acceleration_structure_.bvh_.handle);
+                        if(acceleration_structure != nullptr && acceleration_structure->bvh_buffer_.handle != parameter.parameter_->data_.acceleration_structure_.bvh_buffer_.handle)
+                            ++const_cast<Program::Parameter *>(parameter.parameter_)->id_;
                     }
                     break;
                 default:
@@ -6200,6 +6807,7 @@ private:
         if(sbt)
         {
             bool const invalidate_sbt_descriptors = sbt->descriptor_heap_id_ != previous_descriptor_heap_id;
+            if(invalidate_sbt_descriptors && sbt->descriptor_heap_id_ != 0) ++descriptor_repopulation_count_;
             bool const invalidate_sbt_parameters = sbt->kernel_ != bound_kernel_;
             sbt->descriptor_heap_id_ = previous_descriptor_heap_id; // update descriptor heap id
             for(uint32_t i = 0; i < kGfxShaderGroupType_Count; ++i)
@@ -6219,7 +6827,8 @@ private:
                             {
                                 freeDescriptor(bound_parameter.descriptor_slot_);
                             }
-                            sbt_record.bound_parameters_ = kernel.local_parameters_[local_root_signature_association->second.local_root_signature_space].parameters_;
+                            std::vector<Kernel::Parameter> const &local_parameters = kernel.local_parameters_[local_root_signature_association->second.local_root_signature_space].parameters_;
+                            sbt_record.bound_parameters_.assign(local_parameters.begin(), local_parameters.end());
                         }
                         for(auto &parameter : sbt_record.bound_parameters_)
                         {
@@ -6264,6 +6873,7 @@ private:
         }
         if(descriptor_heap_id != previous_descriptor_heap_id) populateDummyDescriptors();
         bool const invalidate_descriptors = (kernel.descriptor_heap_id_ != descriptor_heap_id);
+        if(invalidate_descriptors && kernel.descriptor_heap_id_ != 0) ++descriptor_repopulation_count_;
         kernel.descriptor_heap_id_ = descriptor_heap_id;    // update descriptor heap id
         for(uint32_t i = 0; i < kernel.parameter_count_; ++i)
         {
@@ -6280,17 +6890,20 @@ private:
                         if(parameter.id_ != parameter.parameter_->id_)
                             GFX_PRINT_ERROR(kGfxResult_InvalidParameter, "Found unrelated type `%s' for parameter `%s' of program `%s/%s'; expected a sampler state object", parameter.parameter_->getTypeName(), parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
                     }
-                    else if(!sampler_state_handles_.has_handle(parameter.parameter_->data_.sampler_state_.handle))
-                    {
-                        if(parameter.parameter_->data_.sampler_state_.handle != 0)
-                            GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid sampler state object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
-                    }
                     else
                     {
-                        SamplerState const &sampler_state = sampler_states_[parameter.parameter_->data_.sampler_state_];
-                        GFX_ASSERT(sampler_state.descriptor_slot_ != 0xFFFFFFFFu);
-                        if(sampler_state.descriptor_slot_ != 0xFFFFFFFFu)
-                            descriptor_slot = sampler_state.descriptor_slot_;
+                        SamplerState const *sampler_state = sampler_states_.get(parameter.parameter_->data_.sampler_state_.handle);
+                        if(sampler_state == nullptr)
+                        {
+                            if(parameter.parameter_->data_.sampler_state_.handle != 0)
+                                GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid sampler state object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
+                        }
+                        else
+                        {
+                            GFX_ASSERT(sampler_state->descriptor_slot_ != 0xFFFFFFFFu);
+                            if(sampler_state->descriptor_slot_ != 0xFFFFFFFFu)
+                                descriptor_slot = sampler_state->descriptor_slot_;
+                        }
                     }
                     parameter.id_ = parameter.parameter_->id_;
                 }
@@ -6316,6 +6929,7 @@ private:
             ID3D12StateObjectProperties *state_object_properties = nullptr;
             kernel.state_object_->QueryInterface(IID_PPV_ARGS(&state_object_properties));
             bool const invalidate_sbt_descriptors = sbt->descriptor_heap_id_ != descriptor_heap_id;
+            if(invalidate_sbt_descriptors && sbt->descriptor_heap_id_ != 0) ++descriptor_repopulation_count_;
             bool const invalidate_sbt_parameters = sbt->kernel_ != bound_kernel_;
             sbt->descriptor_heap_id_ = descriptor_heap_id; // update descriptor heap id
             sbt->kernel_ = bound_kernel_; // update bound kernel
@@ -6381,55 +6995,60 @@ private:
             state_object_properties->Release();
         }
         if(kernel.isGraphics())
+            installInputBuffers(kernel, indexed);
+        return kGfxResult_NoError;
+    }
+
+    void installInputBuffers(Kernel const &kernel, bool indexed)
+    {
+        if(indexed && (force_install_index_buffer_ || bound_index_buffer_.handle != installed_index_buffer_.handle))
         {
-            if(indexed && (force_install_index_buffer_ || bound_index_buffer_.handle != installed_index_buffer_.handle))
+            D3D12_INDEX_BUFFER_VIEW ibv_desc = {};
+            Buffer *gfx_index_buffer = buffers_.get(bound_index_buffer_.handle);
+            if(gfx_index_buffer == nullptr)
             {
-                D3D12_INDEX_BUFFER_VIEW ibv_desc = {};
-                if(!buffer_handles_.has_handle(bound_index_buffer_.handle))
-                {
-                    bound_index_buffer_ = {};
-                    if(bound_index_buffer_.handle != 0)
-                        GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for use as index buffer");
-                }
-                else
-                {
-                    Buffer &gfx_buffer = buffers_[bound_index_buffer_];
-                    SetObjectName(gfx_buffer, bound_index_buffer_.name);
-                    ibv_desc.BufferLocation = gfx_buffer.resource_->GetGPUVirtualAddress() + gfx_buffer.data_offset_;
-                    ibv_desc.SizeInBytes = (uint32_t)bound_index_buffer_.size;
-                    ibv_desc.Format = (bound_index_buffer_.stride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT);
-                    if(bound_index_buffer_.cpu_access == kGfxCpuAccess_None)
-                        transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
-                }
-                command_list_->IASetIndexBuffer(&ibv_desc);
-                installed_index_buffer_ = bound_index_buffer_;
-                force_install_index_buffer_ = false;
+                bound_index_buffer_ = {};
+                if(bound_index_buffer_.handle != 0)
+                    GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for use as index buffer");
             }
-            if(kernel.vertex_stride_ > 0 && (force_install_vertex_buffer_ || bound_vertex_buffer_ != installed_vertex_buffer_))
+            else
             {
-                D3D12_VERTEX_BUFFER_VIEW vbv_desc = {};
-                if(!buffer_handles_.has_handle(bound_vertex_buffer_.handle))
-                {
-                    bound_vertex_buffer_ = {};
-                    if(bound_vertex_buffer_.handle != 0)
-                        GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for use as vertex buffer");
-                }
-                else
-                {
-                    Buffer &gfx_buffer = buffers_[bound_vertex_buffer_];
-                    SetObjectName(gfx_buffer, bound_vertex_buffer_.name);
-                    vbv_desc.BufferLocation = gfx_buffer.resource_->GetGPUVirtualAddress() + gfx_buffer.data_offset_;
-                    vbv_desc.SizeInBytes = (uint32_t)bound_vertex_buffer_.size;
-                    vbv_desc.StrideInBytes = GFX_MAX(bound_vertex_buffer_.stride, kernel.vertex_stride_);
-                    if(bound_vertex_buffer_.cpu_access == kGfxCpuAccess_None)
-                        transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-                }
-                command_list_->IASetVertexBuffers(0, 1, &vbv_desc);
-                installed_vertex_buffer_ = bound_vertex_buffer_;
-                force_install_vertex_buffer_ = false;
+                Buffer &gfx_buffer = *gfx_index_buffer;
+                SetObjectName(gfx_buffer, bound_index_buffer_.name);
+                ibv_desc.BufferLocation = gfx_buffer.resource_->GetGPUVirtualAddress() + gfx_buffer.data_offset_;
+                ibv_desc.SizeInBytes = (uint32_t)bound_index_buffer_.size;
+                ibv_desc.Format = (bound_index_buffer_.stride == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT);
+                if(bound_index_buffer_.cpu_access == kGfxCpuAccess_None)
+                    transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_INDEX_BUFFER);
             }
+            command_list_->IASetIndexBuffer(&ibv_desc);
+            installed_index_buffer_ = bound_index_buffer_;
+            force_install_index_buffer_ = false;
+        }
+        if(kernel.vertex_stride_ > 0 && (force_install_vertex_buffer_ || bound_vertex_buffer_ != installed_vertex_buffer_))
+        {
+            D3D12_VERTEX_BUFFER_VIEW vbv_desc = {};
+            Buffer *gfx_vertex_buffer = buffers_.get(bound_vertex_buffer_.handle);
+            if(gfx_vertex_buffer == nullptr)
+            {
+                bound_vertex_buffer_ = {};
+                if(bound_vertex_buffer_.handle != 0)
+                    GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for use as vertex buffer");
+            }
+            else
+            {
+                Buffer &gfx_buffer = *gfx_vertex_buffer;
+                SetObjectName(gfx_buffer, bound_vertex_buffer_.name);
+                vbv_desc.BufferLocation = gfx_buffer.resource_->GetGPUVirtualAddress() + gfx_buffer.data_offset_;
+                vbv_desc.SizeInBytes = (uint32_t)bound_vertex_buffer_.size;
+                vbv_desc.StrideInBytes = GFX_MAX(bound_vertex_buffer_.stride, kernel.vertex_stride_);
+                if(bound_vertex_buffer_.cpu_access == kGfxCpuAccess_None)
+                    transitionResource(gfx_buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+            }
+            command_list_->IASetVertexBuffers(0, 1, &vbv_desc);
+            installed_vertex_buffer_ = bound_vertex_buffer_;
+            force_install_vertex_buffer_ = false;
         }
-        return kGfxResult_NoError;
     }
 
     GfxResult ensureTextureHasUsageFlag(Texture &texture, D3D12_RESOURCE_FLAGS usage_flag)
@@ -6585,16 +7204,16 @@ private:
             Buffer &gfx_buffer = buffers_[raytracing_scratch_buffer_];
             SetObjectName(gfx_buffer, raytracing_scratch_buffer_.name);
         }
-        GFX_ASSERT(buffer_handles_.has_handle(raytracing_scratch_buffer_.handle));
+        GFX_ASSERT(buffers_.has_handle(raytracing_scratch_buffer_.handle));
         return kGfxResult_NoError;
     }
 
     GfxResult buildRaytracingPrimitive(GfxRaytracingPrimitive const &raytracing_primitive, RaytracingPrimitive &gfx_raytracing_primitive, bool update)
     {
         GFX_ASSERT(gfx_raytracing_primitive.type_ == RaytracingPrimitive::kType_Triangles); // should never happen
-        if(gfx_raytracing_primitive.triangles_.index_stride_ != 0 && !buffer_handles_.has_handle(gfx_raytracing_primitive.triangles_.index_buffer_.handle))
+        if(gfx_raytracing_primitive.triangles_.index_stride_ != 0 && !buffers_.has_handle(gfx_raytracing_primitive.triangles_.index_buffer_.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot update a raytracing primitive that's pointing to an invalid index buffer object");
-        if(!buffer_handles_.has_handle(gfx_raytracing_primitive.triangles_.vertex_buffer_.handle))
+        if(!buffers_.has_handle(gfx_raytracing_primitive.triangles_.vertex_buffer_.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot update a raytracing primitive that's pointing to an invalid vertex buffer object");
         GFX_ASSERT(gfx_raytracing_primitive.triangles_.index_stride_ == 0 || gfx_raytracing_primitive.triangles_.index_buffer_.size / gfx_raytracing_primitive.triangles_.index_stride_ <= 0xFFFFFFFFull);
         GFX_ASSERT(gfx_raytracing_primitive.triangles_.vertex_stride_ > 0 && gfx_raytracing_primitive.triangles_.vertex_buffer_.size / gfx_raytracing_primitive.triangles_.vertex_stride_ <= 0xFFFFFFFFull);
@@ -6642,7 +7261,7 @@ private:
             if(!gfx_raytracing_primitive.triangles_.bvh_buffer_)
             {
                 GfxAccelerationStructure const &acceleration_structure = gfx_raytracing_primitive.triangles_.acceleration_structure_;
-                GFX_ASSERT(acceleration_structure_handles_.has_handle(acceleration_structure.handle));  // checked in `updateRaytracingPrimitive()'
+                GFX_ASSERT(acceleration_structures_.has_handle(acceleration_structure.handle));  // checked in `updateRaytracingPrimitive()'
                 AccelerationStructure &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
                 gfx_acceleration_structure.needs_rebuild_ = true;   // raytracing primitive has been built, rebuild the acceleration structure
             }
@@ -6653,8 +7272,8 @@ private:
                 return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to create raytracing primitive buffer");
         }
         gfx_raytracing_primitive.triangles_.bvh_data_size_ = (uint64_t)blas_info.ResultDataMaxSizeInBytes;
-        GFX_ASSERT(buffer_handles_.has_handle(gfx_raytracing_primitive.triangles_.bvh_buffer_.handle));
-        GFX_ASSERT(buffer_handles_.has_handle(raytracing_scratch_buffer_.handle));
+        GFX_ASSERT(buffers_.has_handle(gfx_raytracing_primitive.triangles_.bvh_buffer_.handle));
+        GFX_ASSERT(buffers_.has_handle(raytracing_scratch_buffer_.handle));
         Buffer &gfx_buffer = buffers_[gfx_raytracing_primitive.triangles_.bvh_buffer_];
         Buffer &gfx_scratch_buffer = buffers_[raytracing_scratch_buffer_];
         SetObjectName(gfx_buffer, raytracing_primitive.name);
@@ -6662,7 +7281,7 @@ private:
             transitionResource(buffers_[gfx_raytracing_primitive.triangles_.index_buffer_], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         transitionResource(buffers_[gfx_raytracing_primitive.triangles_.vertex_buffer_], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         transitionResource(gfx_scratch_buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        submitPipelineBarriers();   // ensure scratch is not in use
+        GFX_TRY(flushPipelineBarriers());   // ensure scratch is not in use
         D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC build_desc = {};
         build_desc.DestAccelerationStructureData = gfx_buffer.resource_->GetGPUVirtualAddress() + gfx_buffer.data_offset_;
         build_desc.Inputs = blas_inputs;
@@ -6677,7 +7296,7 @@ private:
     GfxResult updateRaytracingPrimitive(GfxRaytracingPrimitive const &raytracing_primitive, RaytracingPrimitive &gfx_raytracing_primitive)
     {
         GfxAccelerationStructure const &acceleration_structure = getRaytracingPrimitiveAccelerationStructure(gfx_raytracing_primitive);
-        if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+        if(!acceleration_structures_.has_handle(acceleration_structure.handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot update a raytracing primitive that's pointing to an invalid acceleration structure object");
         AccelerationStructure &gfx_acceleration_structure = acceleration_structures_[acceleration_structure];
         if(gfx_raytracing_primitive.index_ >= (uint32_t)gfx_acceleration_structure.raytracing_primitives_.size() ||
@@ -6703,7 +7322,7 @@ private:
             return raytracing_primitive.triangles_.bvh_buffer_;
         case RaytracingPrimitive::kType_Instance:
             {
-                if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.instance_.parent_.handle))
+                if(!raytracing_primitives_.has_handle(raytracing_primitive.instance_.parent_.handle))
                     return invalid_buffer;  // cannot get buffer from an invalid raytracing primitive
                 RaytracingPrimitive const &parent_raytracing_primitive = raytracing_primitives_[raytracing_primitive.instance_.parent_];
                 GFX_ASSERT(parent_raytracing_primitive.type_ == RaytracingPrimitive::kType_Triangles);  // should never happen
@@ -6725,7 +7344,7 @@ private:
             return raytracing_primitive.triangles_.acceleration_structure_;
         case RaytracingPrimitive::kType_Instance:
             {
-                if(!raytracing_primitive_handles_.has_handle(raytracing_primitive.instance_.parent_.handle))
+                if(!raytracing_primitives_.has_handle(raytracing_primitive.instance_.parent_.handle))
                     return invalid_acceleration_structure;  // cannot get acceleration structure from an invalid raytracing primitive
                 RaytracingPrimitive const &parent_raytracing_primitive = raytracing_primitives_[raytracing_primitive.instance_.parent_];
                 GFX_ASSERT(parent_raytracing_primitive.type_ == RaytracingPrimitive::kType_Triangles);  // should never happen
@@ -6743,7 +7362,7 @@ private:
         auto const texture_type = texture.type;
         uint32_t const channels = GetChannelCount(texture.format);
         uint32_t const key = ((texture_type << 2) | channels);  // lookup key
-        std::map<uint32_t, MipKernels>::const_iterator const it = mip_kernels_.find(key);
+        GfxHashMap<uint32_t, MipKernels>::const_iterator const it = mip_kernels_.find(key);
         if(it != mip_kernels_.end()) return (*it).second;   // already compiled
         char const *texture_type_str = nullptr, *channel_type_str = nullptr, *did_type_str = nullptr, *select_string = nullptr;
         switch(texture_type)
@@ -6898,9 +7517,9 @@ private:
     ScanKernels const &getScanKernels(OpType op_type, GfxDataType data_type, GfxBuffer const *count)
     {
         GFX_ASSERT(op_type < kOpType_Count);    // should never happen
-        GFX_ASSERT(count == nullptr || buffer_handles_.has_handle(count->handle));
+        GFX_ASSERT(count == nullptr || buffers_.has_handle(count->handle));
         uint32_t const key = (data_type << 3) | (op_type << 1) | (count != nullptr ? 1 : 0);
-        std::map<uint32_t, ScanKernels>::const_iterator const it = scan_kernels_.find(key);
+        GfxHashMap<uint32_t, ScanKernels>::const_iterator const it = scan_kernels_.find(key);
         if(it != scan_kernels_.end()) return (*it).second;  // already compiled
         char const *data_type_str = nullptr, *identity_str = nullptr;
         switch(data_type)
@@ -7174,9 +7793,9 @@ private:
 
     SortKernels const &getSortKernels(bool sort_values, GfxBuffer const *count)
     {
-        GFX_ASSERT(count == nullptr || buffer_handles_.has_handle(count->handle));
+        GFX_ASSERT(count == nullptr || buffers_.has_handle(count->handle));
         uint32_t const key = ((sort_values ? 1 : 0) << 1) | (count != nullptr ? 1 : 0);
-        std::map<uint32_t, SortKernels>::const_iterator const it = sort_kernels_.find(key);
+        GfxHashMap<uint32_t, SortKernels>::const_iterator const it = sort_kernels_.find(key);
         if(it != sort_kernels_.end()) return (*it).second;  // already compiled
         std::string sort_program_source;
         sort_program_source +=
@@ -7423,7 +8042,7 @@ private:
                     else
                     {
                         GfxBuffer const &buffer = parameter.parameter_->data_.buffer_.buffers_[j];
-                        if(!buffer_handles_.has_handle(buffer.handle))
+                        if(!buffers_.has_handle(buffer.handle))
                         {
                             if(buffer.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7486,7 +8105,7 @@ private:
                     else
                     {
                         GfxBuffer const &buffer = parameter.parameter_->data_.buffer_.buffers_[j];
-                        if(!buffer_handles_.has_handle(buffer.handle))
+                        if(!buffers_.has_handle(buffer.handle))
                         {
                             if(buffer.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7557,7 +8176,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7617,7 +8236,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7682,7 +8301,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7743,7 +8362,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7809,7 +8428,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7869,7 +8488,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7935,7 +8554,7 @@ private:
                     else
                     {
                         GfxTexture const &texture = parameter.parameter_->data_.image_.textures_[j];
-                        if(!texture_handles_.has_handle(texture.handle))
+                        if(!textures_.has_handle(texture.handle))
                         {
                             if(texture.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid texture object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -7988,7 +8607,7 @@ private:
                     break;  // user set an unrelated parameter type
                 }
                 GfxAccelerationStructure const &acceleration_structure = parameter.parameter_->data_.acceleration_structure_.bvh_;
-                if(!acceleration_structure_handles_.has_handle(acceleration_structure.handle))
+                if(!acceleration_structures_.has_handle(acceleration_structure.handle))
                 {
                     if(acceleration_structure.handle != 0)
                         GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid acceleration structure object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -8006,10 +8625,10 @@ private:
                     parameter.descriptor_slot_ = 0xFFFFFFFFu;
                     break;  // acceleration structure hasn't been built yet
                 }
-                GFX_ASSERT(buffer_handles_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle));
+                GFX_ASSERT(buffers_.has_handle(gfx_acceleration_structure.bvh_buffer_.handle));
                 Buffer &buffer = buffers_[gfx_acceleration_structure.bvh_buffer_];
                 SetObjectName(buffer, acceleration_structure.name);
-                if(buffer_handles_.has_handle(raytracing_scratch_buffer_.handle))
+                if(buffers_.has_handle(raytracing_scratch_buffer_.handle))
                     transitionResource(buffers_[raytracing_scratch_buffer_], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
                 GFX_ASSERT(*buffer.resource_state_ == D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
                 if(!invalidate_descriptor) break;   // already up to date
@@ -8052,7 +8671,7 @@ private:
                             break;  // user set an invalid buffer object
                         }
                         GfxBuffer const &buffer = parameter.parameter_->data_.buffer_.buffers_[0];
-                        if(!buffer_handles_.has_handle(buffer.handle))
+                        if(!buffers_.has_handle(buffer.handle))
                         {
                             if(buffer.handle != 0)
                                 GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Found invalid buffer object for parameter `%s' of program `%s/%s'; cannot bind to pipeline", parameter.parameter_->name_.c_str(), program.file_path_.c_str(), program.file_name_.c_str());
@@ -8115,7 +8734,7 @@ private:
     {
         GFX_ASSERT(command_list_ != nullptr);
         if(!draw_id_buffer_) return;    // no need for drawID
-        GFX_ASSERT(buffer_handles_.has_handle(draw_id_buffer_.handle));
+        GFX_ASSERT(buffers_.has_handle(draw_id_buffer_.handle));
         Buffer &gfx_buffer = buffers_[draw_id_buffer_];
         SetObjectName(buffers_[draw_id_buffer_], draw_id_buffer_.name);
         D3D12_VERTEX_BUFFER_VIEW
@@ -8337,7 +8956,7 @@ private:
 
     void reloadKernel(Kernel &kernel)
     {
-        if(!program_handles_.has_handle(kernel.program_.handle)) return;
+        if(!programs_.has_handle(kernel.program_.handle)) return;
         Program const &program = programs_[kernel.program_];
         kernel.descriptor_heap_id_ = 0;
         if(kernel.cs_bytecode_ != nullptr) { kernel.cs_bytecode_->Release(); kernel.cs_bytecode_ = nullptr; }
@@ -8639,12 +9258,43 @@ private:
             *allocation = nullptr;  // D3D12MemoryAllocator leaves a dangling pointer to the allocation object upon failure
             return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to allocate memory to create resource");
         }
+        trackAllocation(*allocation, allocation_desc.HeapType, resource_desc);
         return kGfxResult_NoError;
     }
 
+    void trackAllocation(D3D12MA::Allocation *allocation, D3D12_HEAP_TYPE heap_type, D3D12_RESOURCE_DESC const &resource_desc)
+    {
+        GfxMemoryHeap const memory_heap = (heap_type == D3D12_HEAP_TYPE_UPLOAD   ? kGfxMemoryHeap_Upload   :
+                                           heap_type == D3D12_HEAP_TYPE_READBACK ? kGfxMemoryHeap_Readback :
+                                                                                   kGfxMemoryHeap_Default);
+        GfxMemoryResource const memory_resource = (resource_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? kGfxMemoryResource_Buffer :
+            (resource_desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0 ? kGfxMemoryResource_RenderTarget :
+                                                                                                                             kGfxMemoryResource_Texture);
+        allocation->SetPrivateData((void *)memory_tracker_.track(memory_heap, memory_resource, allocation->GetSize()));
+    }
+
+    void untrackAllocation(D3D12MA::Allocation *allocation)
+    {
+        memory_tracker_.untrack((uintptr_t)allocation->GetPrivateData(), allocation->GetSize());
+        allocation->SetPrivateData(nullptr);
+    }
+
     void transitionResource(Buffer &buffer, D3D12_RESOURCE_STATES resource_state)
     {
         GFX_ASSERT(buffer.data_ == nullptr); if(buffer.data_ != nullptr) return;
+        if(queue_ == kGfxQueue_Compute)
+        {
+            if(!buffer.compute_queue_)
+            {
+                buffer.compute_queue_ = true;
+                compute_queue_buffers_.push_back(buffers_.get_handle(buffers_.get_index((uint32_t)(&buffer - buffers_.data()))));
+            }
+            if(IsGraphicsResourceState(*buffer.resource_state_) && *buffer.resource_state_ != resource_state)
+            {
+                compute_queue_hazard_ = true;   // fail the encode; the buffer gets released on the next gfxSignal()
+                return; // invalid operation
+            }
+        }
         if(*buffer.resource_state_ == resource_state)
         {
             if(resource_state == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
@@ -8675,13 +9325,13 @@ private:
                 break;  // break barrier batches to avoid debug layer warnings
             }
         if(*buffer.resource_state_ == D3D12_RESOURCE_STATE_INDEX_BUFFER &&  // unbind if active index buffer to prevent debug layer errors
-           buffer_handles_.has_handle(bound_index_buffer_.handle) && buffers_[bound_index_buffer_].resource_ == buffer.resource_)
+           buffers_.has_handle(bound_index_buffer_.handle) && buffers_[bound_index_buffer_].resource_ == buffer.resource_)
         {
             command_list_->IASetIndexBuffer(nullptr);
             force_install_index_buffer_ = true;
         }
         if(*buffer.resource_state_ == D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER &&    // unbind if active vertex buffer to prevent debug layer errors
-           buffer_handles_.has_handle(bound_vertex_buffer_.handle) && buffers_[bound_vertex_buffer_].resource_ == buffer.resource_)
+           buffers_.has_handle(bound_vertex_buffer_.handle) && buffers_[bound_vertex_buffer_].resource_ == buffer.resource_)
         {
             command_list_->IASetVertexBuffers(0, 1, nullptr);
             force_install_vertex_buffer_ = true;
@@ -8698,6 +9348,19 @@ private:
 
     void transitionResource(Texture &texture, D3D12_RESOURCE_STATES resource_state)
     {
+        if(queue_ == kGfxQueue_Compute)
+        {
+            if(!texture.compute_queue_)
+            {
+                texture.compute_queue_ = true;
+                compute_queue_textures_.push_back(textures_.get_handle(textures_.get_index((uint32_t)(&texture - textures_.data()))));
+            }
+            if(IsGraphicsResourceState(texture.resource_state_) && texture.resource_state_ != resource_state)
+            {
+                compute_queue_hazard_ = true;   // fail the encode; the texture gets released on the next gfxSignal()
+                return; // invalid operation
+            }
+        }
         if(texture.resource_state_ == resource_state)
         {
             if(resource_state == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
@@ -8745,6 +9408,15 @@ private:
         resource_barriers_.clear();
     }
 
+    GfxResult flushPipelineBarriers()
+    {
+        submitPipelineBarriers();
+        if(!compute_queue_hazard_)
+            return kGfxResult_NoError;
+        compute_queue_hazard_ = false;
+        return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot use a resource on the compute queue before the graphics queue released it using gfxSignal()");
+    }
+
     GfxResult acquireSwapChainBuffers()
     {
         for(uint32_t i = 0; i < max_frames_in_flight_; ++i)
@@ -8804,8 +9476,94 @@ private:
         return kGfxResult_NoError;
     }
 
+    GfxResult createComputeQueue()
+    {
+        if(compute_queue_ != nullptr)
+            return kGfxResult_NoError;  // already created
+        GFX_ASSERT(queue_ == kGfxQueue_Graphics);
+        D3D12_COMMAND_QUEUE_DESC
+        queue_desc      = {};
+        queue_desc.Type = D3D12_COMMAND_LIST_TYPE_COMPUTE;
+        if(!SUCCEEDED(device_->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&compute_queue_))))
+            return GFX_SET_ERROR(kGfxResult_InternalError, "Unable to create compute queue");
+        SetDebugName(compute_queue_, "gfx_ComputeQueue");
+        compute_command_allocators_ = (ID3D12CommandAllocator **)gfxMalloc(max_frames_in_flight_ * sizeof(ID3D12CommandAllocator *));
+        memset(compute_command_allocators_, 0, max_frames_in_flight_ * sizeof(ID3D12CommandAllocator *));
+        for(uint32_t i = 0; i < max_frames_in_flight_; ++i)
+        {
+            char buffer[256];
+            GFX_SNPRINTF(buffer, sizeof(buffer), "gfx_ComputeCommandAllocator%u", i);
+            if(!SUCCEEDED(device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COMPUTE, IID_PPV_ARGS(&compute_command_allocators_[i]))))
+                return GFX_SET_ERROR(kGfxResult_InternalError, "Unable to create compute command allocator");
+            SetDebugName(compute_command_allocators_[i], buffer);
+        }
+        if(!SUCCEEDED(device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, compute_command_allocators_[fence_index_], nullptr, IID_PPV_ARGS(&idle_command_list_))))
+            return GFX_SET_ERROR(kGfxResult_InternalError, "Unable to create compute command list");
+        if(dxr_device_ != nullptr)
+            idle_command_list_->QueryInterface(IID_PPV_ARGS(&idle_dxr_command_list_));
+        SetDebugName(idle_command_list_, "gfx_ComputeCommandList");
+        for(uint32_t i = 0; i < ARRAYSIZE(queue_fences_); ++i)
+        {
+            if(!SUCCEEDED(device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&queue_fences_[i]))))
+                return GFX_SET_ERROR(kGfxResult_InternalError, "Unable to create queue fence object");
+            SetDebugName(queue_fences_[i], i == kGfxQueue_Compute ? "gfx_ComputeQueueFence" : "gfx_GraphicsQueueFence");
+        }
+        return kGfxResult_NoError;
+    }
+
+    void submitComputeQueue()
+    {
+        if(compute_queue_ == nullptr) return;   // async compute wasn't used
+        GFX_ASSERT(queue_ == kGfxQueue_Graphics);
+        idle_command_list_->Close();    // close command list for submit
+        ID3D12CommandList *const command_lists[] = { idle_command_list_ };
+        compute_queue_->ExecuteCommandLists(ARRAYSIZE(command_lists), command_lists);
+        compute_queue_->Signal(queue_fences_[kGfxQueue_Compute], ++queue_fence_values_[kGfxQueue_Compute]);
+        command_queue_->Wait(queue_fences_[kGfxQueue_Compute], queue_fence_values_[kGfxQueue_Compute]);
+    }
+
+    void resetComputeQueue()
+    {
+        if(compute_queue_ == nullptr) return;   // async compute wasn't used
+        compute_command_allocators_[fence_index_]->Reset();
+        idle_command_list_->Reset(compute_command_allocators_[fence_index_], nullptr);
+    }
+
+    void releaseGraphicsResourceStates()
+    {
+        GFX_ASSERT(queue_ == kGfxQueue_Graphics);
+        for(uint32_t i = 0; i < (uint32_t)compute_queue_buffers_.size();)
+        {
+            Buffer *buffer = buffers_.get(compute_queue_buffers_[i]);
+            if(buffer == nullptr)
+            {
+                compute_queue_buffers_[i] = compute_queue_buffers_.back();
+                compute_queue_buffers_.pop_back();
+                continue;   // buffer was destroyed
+            }
+            if(buffer->data_ == nullptr && IsGraphicsResourceState(*buffer->resource_state_))
+                transitionResource(*buffer, GetComputeResourceState(*buffer->resource_state_));
+            ++i;
+        }
+        for(uint32_t i = 0; i < (uint32_t)compute_queue_textures_.size();)
+        {
+            Texture *texture = textures_.get(compute_queue_textures_[i]);
+            if(texture == nullptr)
+            {
+                compute_queue_textures_[i] = compute_queue_textures_.back();
+                compute_queue_textures_.pop_back();
+                continue;   // texture was destroyed
+            }
+            if(IsGraphicsResourceState(texture->resource_state_))
+                transitionResource(*texture, GetComputeResourceState(texture->resource_state_));
+            ++i;
+        }
+    }
+
     GfxResult sync()
     {
+        if(compute_queue_ != nullptr)
+            command_queue_->Wait(queue_fences_[kGfxQueue_Compute], queue_fence_values_[kGfxQueue_Compute]);
         for(uint32_t i = 0; i < max_frames_in_flight_; ++i)
         {
             command_queue_->Signal(fences_[i], ++fence_values_[i]);
@@ -8895,8 +9653,7 @@ uint32_t const GfxInternal::kNumThreads_Invalid[] =
     1
 };
 
-GfxArray<GfxInternal::DrawState> GfxInternal::draw_states_;
-GfxHandles                       GfxInternal::draw_state_handles_("draw state");
+GfxSlotMap<GfxInternal::DrawState> GfxInternal::draw_states_("draw state");
 
 GfxContext gfxCreateContext(HWND window, GfxCreateContextFlags flags, IDXGIAdapter *adapter)
 {
@@ -9691,6 +10448,35 @@ GfxResult gfxCommandDrawMeshIndirect(GfxContext context, GfxBuffer args_buffer)
     return gfx->encodeDrawMeshIndirect(args_buffer);
 }
 
+GfxBundle gfxBeginBundle(GfxContext context)
+{
+    GfxBundle const bundle = {};
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return bundle; // invalid context
+    return gfx->beginBundle();
+}
+
+GfxResult gfxEndBundle(GfxContext context, GfxBundle bundle)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->endBundle(bundle);
+}
+
+GfxResult gfxDestroyBundle(GfxContext context, GfxBundle bundle)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->destroyBundle(bundle);
+}
+
+GfxResult gfxCommandExecuteBundle(GfxContext context, GfxBundle bundle)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->encodeExecuteBundle(bundle);
+}
+
 GfxTimestampQuery gfxCreateTimestampQuery(GfxContext context)
 {
     GfxTimestampQuery const timestamp_query = {};
@@ -9807,6 +10593,72 @@ GfxResult gfxCommandSortRadix(GfxContext context, GfxBuffer keys_dst, GfxBuffer
     return gfx->encodeRadixSort(keys_dst, keys_src, values_dst, values_src, count);
 }
 
+GfxResult gfxCommandSetQueue(GfxContext context, GfxQueue queue)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->setQueue(queue);
+}
+
+GfxQueue gfxCommandGetQueue(GfxContext context)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxQueue_Graphics; // invalid context
+    return gfx->getQueue();
+}
+
+GfxSyncPoint gfxSignal(GfxContext context, GfxQueue queue)
+{
+    GfxSyncPoint const sync_point;
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return sync_point; // invalid context
+    return gfx->signal(queue);
+}
+
+GfxResult gfxWait(GfxContext context, GfxQueue queue, GfxSyncPoint sync_point)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->wait(queue, sync_point);
+}
+
+GfxMemoryBudget gfxGetMemoryBudget(GfxContext context)
+{
+    GfxMemoryBudget const memory_budget = {};
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return memory_budget;  // invalid context
+    return gfx->getMemoryBudget();
+}
+
+GfxMemoryStatistics gfxGetMemoryStatistics(GfxContext context)
+{
+    GfxMemoryStatistics const memory_statistics = {};
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return memory_statistics;  // invalid context
+    return gfx->getMemoryStatistics();
+}
+
+GfxResult gfxAddMemoryBudgetCallback(GfxContext context, float threshold, GfxMemoryBudgetCallback callback, void *user_data)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->addMemoryBudgetCallback(threshold, callback, user_data);
+}
+
+GfxResult gfxRemoveMemoryBudgetCallback(GfxContext context, GfxMemoryBudgetCallback callback, void *user_data)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->removeMemoryBudgetCallback(callback, user_data);
+}
+
+GfxResult gfxSetSimulatedMemoryBudget(GfxContext context, uint64_t budget_bytes)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return kGfxResult_InvalidParameter;
+    return gfx->setSimulatedMemoryBudget(budget_bytes);
+}
+
 GfxResult gfxFrame(GfxContext context, bool vsync)
 {
     GfxInternal *gfx = GfxInternal::GetGfx(context);
@@ -9859,6 +10711,20 @@ ID3D12GraphicsCommandList *gfxGetCommandList(GfxContext context)
     return gfx->getCommandList();
 }
 
+ID3D12DescriptorHeap *gfxGetDescriptorHeap(GfxContext context)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return nullptr;    // invalid context
+    return gfx->getDescriptorHeap();
+}
+
+uint32_t gfxGetDescriptorRepopulationCount(GfxContext context)
+{
+    GfxInternal *gfx = GfxInternal::GetGfx(context);
+    if(!gfx) return 0;  // invalid context
+    return gfx->getDescriptorRepopulationCount();
+}
+
 GfxResult gfxSetCommandList(GfxContext context, ID3D12GraphicsCommandList *command_list)
 {
     GfxInternal *gfx = GfxInternal::GetGfx(context);
@@ -44,7 +44,8 @@ enum GfxCreateContextFlag
 {
     kGfxCreateContextFlag_EnableDebugLayer       = 1 << 0,
     kGfxCreateContextFlag_EnableShaderDebugging  = 1 << 1,
-    kGfxCreateContextFlag_EnableStablePowerState = 1 << 2
+    kGfxCreateContextFlag_EnableStablePowerState = 1 << 2,
+    kGfxCreateContextFlag_DisableDescriptorHeapReservation = 1 << 3   // grow the shader-visible descriptor heap on demand rather than reserving D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_1 descriptors up front
 };
 typedef uint32_t GfxCreateContextFlags;
 
@@ -393,6 +394,17 @@ GfxResult gfxCommandDispatchRaysIndirect(GfxContext context, GfxSbt sbt, GfxBuff
 GfxResult gfxCommandDrawMesh(GfxContext context, uint32_t num_groups_x, uint32_t num_groups_y, uint32_t num_groups_z);
 GfxResult gfxCommandDrawMeshIndirect(GfxContext context, GfxBuffer args_buffer);                                // expects a buffer of D3D12_DISPATCH_MESH_ARGUMENTS elements
 
+//!
+//! Command bundles.
+//!
+
+class GfxBundle { GFX_INTERNAL_HANDLE(GfxBundle); public: };
+
+GfxBundle gfxBeginBundle(GfxContext context);   // subsequent kernel/buffer binds, viewport/scissor sets and draws are validated and captured rather than encoded
+GfxResult gfxEndBundle(GfxContext context, GfxBundle bundle);
+GfxResult gfxDestroyBundle(GfxContext context, GfxBundle bundle);
+GfxResult gfxCommandExecuteBundle(GfxContext context, GfxBundle bundle);   // replays using the bound targets and current program parameters; the bound kernel, input buffers, viewport and scissor rect are restored afterwards
+
 //!
 //! Debug/profile API.
 //!
@@ -443,6 +455,41 @@ GfxResult gfxCommandReduceMax(GfxContext context, GfxDataType data_type, GfxBuff
 GfxResult gfxCommandReduceSum(GfxContext context, GfxDataType data_type, GfxBuffer dst, GfxBuffer src, GfxBuffer const *count = nullptr);
 GfxResult gfxCommandSortRadix(GfxContext context, GfxBuffer keys_dst, GfxBuffer keys_src, GfxBuffer const *values_dst = nullptr, GfxBuffer const *values_src = nullptr, GfxBuffer const *count = nullptr);
 
+//!
+//! Queue synchronization.
+//!
+
+enum GfxQueue
+{
+    kGfxQueue_Graphics = 0,
+    kGfxQueue_Compute,
+
+    kGfxQueue_Count
+};
+
+class GfxSyncPoint { friend class GfxInternal; uint64_t fence_value; GfxQueue queue; public:
+                     inline GfxSyncPoint() : fence_value(0), queue(kGfxQueue_Graphics) {}
+                     inline GfxQueue getQueue() const { return queue; }
+                     inline operator bool() const { return !!fence_value; } };
+
+GfxResult gfxCommandSetQueue(GfxContext context, GfxQueue queue);   // subsequent commands are recorded for the selected queue (bound kernel and targets are reset)
+GfxQueue gfxCommandGetQueue(GfxContext context);
+GfxSyncPoint gfxSignal(GfxContext context, GfxQueue queue);         // submits the commands recorded for the queue so far; graphics-only states of the resources used on the compute queue are released to it
+                                                                    // (encoding a compute queue command that uses a resource in a graphics-only state fails with kGfxResult_InvalidOperation)
+GfxResult gfxWait(GfxContext context, GfxQueue queue, GfxSyncPoint sync_point); // work submitted to the queue afterwards (including its pending commands) waits for the sync point
+
+//!
+//! Memory budget.
+//!
+
+typedef void (*GfxMemoryBudgetCallback)(GfxContext context, GfxMemoryBudget const &memory_budget, bool is_over_threshold, void *user_data);
+
+GfxMemoryBudget gfxGetMemoryBudget(GfxContext context);
+GfxMemoryStatistics gfxGetMemoryStatistics(GfxContext context);
+GfxResult gfxAddMemoryBudgetCallback(GfxContext context, float threshold, GfxMemoryBudgetCallback callback, void *user_data = nullptr); // fires from gfxFrame() when usage crosses threshold * budget (in either direction)
+GfxResult gfxRemoveMemoryBudgetCallback(GfxContext context, GfxMemoryBudgetCallback callback, void *user_data = nullptr);
+GfxResult gfxSetSimulatedMemoryBudget(GfxContext context, uint64_t budget_bytes);  // reports the tracked default heap usage against the given budget; 0 restores the OS budget
+
 //!
 //! Frame processing.
 //!
@@ -459,6 +506,8 @@ GfxContext gfxCreateContext(ID3D12Device *device, uint32_t max_frames_in_flight
 ID3D12Device *gfxGetDevice(GfxContext context);
 ID3D12CommandQueue *gfxGetCommandQueue(GfxContext context);
 ID3D12GraphicsCommandList *gfxGetCommandList(GfxContext context);
+ID3D12DescriptorHeap *gfxGetDescriptorHeap(GfxContext context);   // shader-visible CBV/SRV/UAV heap; only replaced past D3D12_MAX_SHADER_VISIBLE_DESCRIPTOR_HEAP_SIZE_TIER_1 descriptors, unless the reservation was disabled
+uint32_t gfxGetDescriptorRepopulationCount(GfxContext context);     // kernels and SBTs that had to re-populate their descriptors after the heap was replaced
 GfxResult gfxSetCommandList(GfxContext context, ID3D12GraphicsCommandList *command_list);
 GfxResult gfxResetCommandListState(GfxContext context); // call this function before returning to gfx after externally modifying the state on the command list
 
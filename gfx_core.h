@@ -27,8 +27,20 @@ SOFTWARE.
 #include <cstdio>       // vprintf, etc.
 #include <cstdarg>      // va_list, etc.
 #include <cstdint>      // uint32_t, etc.
+#include <cstdlib>      // malloc(), exit(), etc.
+#include <cstring>      // memcpy(), strlen(), etc.
 #include <algorithm>    // std::min(), std::max()
+#include <atomic>       // std::atomic
+#include <condition_variable>   // std::condition_variable
+#include <deque>        // std::deque
+#include <functional>   // std::function
+#include <iterator>     // std::distance()
+#include <memory>       // std::unique_ptr
+#include <mutex>        // std::mutex
 #include <string>       // std::string
+#include <string_view>  // std::string_view
+#include <thread>       // std::thread
+#include <type_traits>  // std::is_integral_v, etc.
 #include <utility>      // std::swap(), std::move()
 #include <vector>       // std::vector
 
@@ -68,8 +80,13 @@ enum GfxConstant
 
 #define GFX_MAX(X, Y)   ((std::max)(X, Y))
 
+#ifdef _MSC_VER
 #define GFX_SNPRINTF(BUFFER, SIZE, FORMAT, ...) \
     _snprintf_s(BUFFER, SIZE, _TRUNCATE, FORMAT, __VA_ARGS__)
+#else //! _MSC_VER
+#define GFX_SNPRINTF(BUFFER, SIZE, FORMAT, ...) \
+    snprintf(BUFFER, SIZE, FORMAT, __VA_ARGS__)
+#endif //! _MSC_VER
 
 #define GFX_NON_COPYABLE(TYPE)  \
     TYPE(TYPE const &) = delete; TYPE &operator =(TYPE const &) = delete
@@ -77,11 +94,15 @@ enum GfxConstant
 #define GFX_ALIGN(VAL, ALIGN)   \
     (((VAL) + (static_cast<decltype(VAL)>(ALIGN) - 1)) & ~(static_cast<decltype(VAL)>(ALIGN) - 1))
 
+#ifdef _WIN32
 #define GFX_BREAKPOINT          \
     GFX_MULTI_LINE_MACRO_BEGIN  \
         if(IsDebuggerPresent()) \
             DebugBreak();       \
     GFX_MULTI_LINE_MACRO_END
+#else //! _WIN32
+#define GFX_BREAKPOINT  // skip it
+#endif //! _WIN32
 
 #define GFX_TRY(X)                                                          \
     GFX_MULTI_LINE_MACRO_BEGIN                                              \
@@ -131,10 +152,29 @@ enum GfxConstant
 
 #endif //! _DEBUG
 
+//!
+//! Validation.
+//!
+
+// Only the handle, usage and state checks are compiled out; the capability checks (interop or
+// headless contexts, graphics-only commands recorded for the compute queue, missing mesh shader/
+// raytracing support, unimplemented texture types and unsupported formats) and the destroyed
+// object checks when replaying bundles always remain.
+#ifndef GFX_ENABLE_VALIDATION
+#define GFX_ENABLE_VALIDATION   1   // set to 0 to compile the error checking out of the command encoding paths
+#endif //! GFX_ENABLE_VALIDATION
+
+#ifdef _DEBUG
+#undef GFX_ENABLE_VALIDATION
+#define GFX_ENABLE_VALIDATION   1   // always validate in debug builds
+#endif //! _DEBUG
+
 //!
 //! Internal macros.
 //!
 
+#ifdef _MSC_VER
+
 #define GFX_MULTI_LINE_MACRO_BEGIN                                              \
     __pragma(warning(push))                                                     \
     __pragma(warning(disable:4127)) /* conditional expression is constant */    \
@@ -147,6 +187,18 @@ enum GfxConstant
     while(0)                        \
     __pragma(warning(pop))
 
+#else //! _MSC_VER
+
+#define GFX_MULTI_LINE_MACRO_BEGIN  \
+    do                              \
+    {
+
+#define GFX_MULTI_LINE_MACRO_END    \
+    }                               \
+    while(0)
+
+#endif //! _MSC_VER
+
 #define GFX_STRINGIFY(X)    GFX_STRINGIFY2(X)
 
 #define GFX_STRINGIFY2(X)   #X
@@ -209,7 +261,9 @@ static inline void GFX_PRINTLN_IMPL(char const *file_name, uint32_t line_number,
     snprintf(header + start, hsize - start, "%s", file_name + offset);
     snprintf(body, bsize - 1, "[%s:%-4u] %s\n", header, line_number, format);
     vsnprintf(message, sizeof(message), body, args);
+#ifdef _WIN32
     OutputDebugStringA(message);
+#endif //! _WIN32
     vprintf(body, args);
     va_end(args);
 }
@@ -228,7 +282,9 @@ static inline void GFX_PRINT_ERROR_IMPL(GfxResult result, char const *file_name,
     snprintf(header + start, hsize - start, "%s", file_name + offset);
     snprintf(body, bsize - 1, "[%s:%-4u] Error: %s (0x%x: %s)\n", header, line_number, format, (uint32_t)result, gfxResultGetString(result));
     vsnprintf(message, sizeof(message), body, args);
+#ifdef _WIN32
     OutputDebugStringA(message);
+#endif //! _WIN32
     vprintf(body, args);
     va_end(args);
 }
@@ -247,7 +303,9 @@ static inline GfxResult GFX_SET_ERROR_IMPL(GfxResult result, char const *file_na
     snprintf(header + start, hsize - start, "%s", file_name + offset);
     snprintf(body, bsize - 1, "[%s:%-4u] Error: %s (0x%x: %s)\n", header, line_number, format, (uint32_t)result, gfxResultGetString(result));
     vsnprintf(message, sizeof(message), body, args);
+#ifdef _WIN32
     OutputDebugStringA(message);
+#endif //! _WIN32
     vprintf(body, args);
     va_end(args);
     return result;
@@ -868,4 +926,1472 @@ void GfxHandles::grow(uint32_t handle_count)
     capacity_ = capacity;
 }
 
+//!
+//! Slot map container.
+//!
+
+template<typename TYPE>
+class GfxSlotMap
+{
+    GFX_NON_COPYABLE(GfxSlotMap);
+
+public:
+    GfxSlotMap();
+    explicit GfxSlotMap(char const *name);
+    ~GfxSlotMap();
+
+    TYPE *get(uint64_t handle);
+    TYPE const *get(uint64_t handle) const;
+
+    TYPE *at(uint32_t index);
+    TYPE &operator [](uint32_t index);
+    TYPE const *at(uint32_t index) const;
+    TYPE const &operator [](uint32_t index) const;
+    bool has(uint32_t index) const;
+    bool empty() const;
+
+    TYPE &insert(uint32_t index);
+    TYPE &insert(uint32_t index, TYPE const &object);
+    bool erase(uint32_t index);
+    void clear();
+
+    TYPE *data();
+    uint32_t size() const;
+    TYPE const *data() const;
+    uint32_t capacity() const;
+
+    uint32_t get_index(uint32_t packed_index) const;
+    uint32_t get_packed_index(uint32_t index) const;
+
+    uint64_t allocate_handle();
+    bool acquire_handle(uint64_t handle);
+    uint64_t get_handle(uint32_t index) const;
+    bool has_handle(uint64_t handle) const;
+    bool free_handle(uint64_t handle);
+
+    uint32_t calculate_free_handle_count() const;
+
+protected:
+    void grow(uint32_t slot_count = 1);
+    void reserve(uint32_t capacity);
+
+    struct Slot
+    {
+        uint32_t age_;
+        uint32_t packed_index_;
+    };
+
+    char *name_;
+    Slot *slots_;
+    uint32_t *next_slots_;
+    uint32_t next_slot_;
+    uint32_t slot_capacity_;
+    TYPE *data_;
+    uint32_t *indices_;
+    uint32_t size_;
+    uint32_t capacity_;
+};
+
+template<typename TYPE>
+GfxSlotMap<TYPE>::GfxSlotMap()
+    : name_(nullptr)
+    , slots_(nullptr)
+    , next_slots_(nullptr)
+    , next_slot_(0xFFFFFFFFu)
+    , slot_capacity_(0)
+    , data_(nullptr)
+    , indices_(nullptr)
+    , size_(0)
+    , capacity_(0)
+{
+}
+
+template<typename TYPE>
+GfxSlotMap<TYPE>::GfxSlotMap(char const *name)
+    : name_(name ? (char *)gfxMalloc(strlen(name) + 1) : nullptr)
+    , slots_(nullptr)
+    , next_slots_(nullptr)
+    , next_slot_(0xFFFFFFFFu)
+    , slot_capacity_(0)
+    , data_(nullptr)
+    , indices_(nullptr)
+    , size_(0)
+    , capacity_(0)
+{
+    if(name_) for(uint32_t i = 0; !i || name[i - 1]; ++i) name_[i] = name[i];
+}
+
+template<typename TYPE>
+GfxSlotMap<TYPE>::~GfxSlotMap()
+{
+#ifdef _DEBUG
+    uint32_t const free_handle_count = calculate_free_handle_count();
+    if(free_handle_count < slot_capacity_)
+        GFX_PRINTLN("Warning: %u %s(s) not freed properly; detected memory leak", slot_capacity_ - free_handle_count, name_ ? name_ : "handle");
+#endif //! _DEBUG
+    for(uint32_t i = 0; i < size_; ++i)
+        data_[i].~TYPE();
+    gfxFree(name_);
+    gfxFree(slots_);
+    gfxFree(next_slots_);
+    gfxFree(data_);
+    gfxFree(indices_);
+}
+
+template<typename TYPE>
+TYPE *GfxSlotMap<TYPE>::get(uint64_t handle)
+{
+    uint32_t const index = static_cast<uint32_t>(handle & 0xFFFFFFFFull);
+    if(!handle || index >= slot_capacity_) return nullptr;  // invalid handle
+    Slot const slot = slots_[index];    // age and packed index are read together
+    if(slot.age_ != static_cast<uint32_t>(handle >> 32) || slot.packed_index_ == 0xFFFFFFFFu) return nullptr;
+    return &data_[slot.packed_index_];
+}
+
+template<typename TYPE>
+TYPE const *GfxSlotMap<TYPE>::get(uint64_t handle) const
+{
+    uint32_t const index = static_cast<uint32_t>(handle & 0xFFFFFFFFull);
+    if(!handle || index >= slot_capacity_) return nullptr;  // invalid handle
+    Slot const slot = slots_[index];    // age and packed index are read together
+    if(slot.age_ != static_cast<uint32_t>(handle >> 32) || slot.packed_index_ == 0xFFFFFFFFu) return nullptr;
+    return &data_[slot.packed_index_];
+}
+
+template<typename TYPE>
+TYPE *GfxSlotMap<TYPE>::at(uint32_t index)
+{
+    if(index >= slot_capacity_)
+        return nullptr; // out of bounds
+    uint32_t const packed_index = slots_[index].packed_index_;
+    if(packed_index == 0xFFFFFFFFu)
+        return nullptr; // not found
+    return &data_[packed_index];
+}
+
+template<typename TYPE>
+TYPE &GfxSlotMap<TYPE>::operator [](uint32_t index)
+{
+    TYPE *object = at(index);
+    GFX_ASSERT(object != nullptr);
+    return *object;
+}
+
+template<typename TYPE>
+TYPE const *GfxSlotMap<TYPE>::at(uint32_t index) const
+{
+    if(index >= slot_capacity_)
+        return nullptr; // out of bounds
+    uint32_t const packed_index = slots_[index].packed_index_;
+    if(packed_index == 0xFFFFFFFFu)
+        return nullptr; // not found
+    return &data_[packed_index];
+}
+
+template<typename TYPE>
+TYPE const &GfxSlotMap<TYPE>::operator [](uint32_t index) const
+{
+    TYPE const *object = at(index);
+    GFX_ASSERT(object != nullptr);
+    return *object;
+}
+
+template<typename TYPE>
+bool GfxSlotMap<TYPE>::has(uint32_t index) const
+{
+    if(index >= slot_capacity_)
+        return false;   // out of bounds
+    return slots_[index].packed_index_ != 0xFFFFFFFFu;
+}
+
+template<typename TYPE>
+bool GfxSlotMap<TYPE>::empty() const
+{
+    return size_ == 0;
+}
+
+template<typename TYPE>
+TYPE &GfxSlotMap<TYPE>::insert(uint32_t index)
+{
+    GFX_ASSERT(index < 0xFFFFFFFFu);
+    if(index >= slot_capacity_) grow(index - slot_capacity_ + 1);
+    uint32_t const packed_index = slots_[index].packed_index_;
+    if(packed_index != 0xFFFFFFFFu)
+    {
+        data_[packed_index].~TYPE();
+        return *new(&data_[packed_index]) TYPE();
+    }
+    if(size_ >= capacity_) reserve(size_ + 1);
+    indices_[size_] = index;
+    slots_[index].packed_index_ = size_;
+    return *new(&data_[size_++]) TYPE();
+}
+
+template<typename TYPE>
+TYPE &GfxSlotMap<TYPE>::insert(uint32_t index, TYPE const &object)
+{
+    GFX_ASSERT(index < 0xFFFFFFFFu);
+    if(index >= slot_capacity_) grow(index - slot_capacity_ + 1);
+    uint32_t const packed_index = slots_[index].packed_index_;
+    if(packed_index != 0xFFFFFFFFu)
+    {
+        data_[packed_index].~TYPE();
+        return *new(&data_[packed_index]) TYPE(object);
+    }
+    if(size_ >= capacity_) reserve(size_ + 1);
+    indices_[size_] = index;
+    slots_[index].packed_index_ = size_;
+    return *new(&data_[size_++]) TYPE(object);
+}
+
+template<typename TYPE>
+bool GfxSlotMap<TYPE>::erase(uint32_t index)
+{
+    GFX_ASSERT(index < slot_capacity_);
+    if(index >= slot_capacity_) return false;
+    uint32_t const packed_index = slots_[index].packed_index_;
+    if(packed_index == 0xFFFFFFFFu) return false;
+    GFX_ASSERT(size_ > 0);  // should never happen
+    if(packed_index != size_ - 1)
+    {
+        std::swap(data_[packed_index], data_[size_ - 1]);
+        indices_[packed_index] = indices_[size_ - 1];
+        slots_[indices_[packed_index]].packed_index_ = packed_index;
+    }
+    data_[--size_].~TYPE();
+    slots_[index].packed_index_ = 0xFFFFFFFFu;
+    indices_[size_] = 0;
+    return true;
+}
+
+template<typename TYPE>
+void GfxSlotMap<TYPE>::clear()
+{
+    for(uint32_t i = 0; i < size_; ++i)
+    {
+        slots_[indices_[i]].packed_index_ = 0xFFFFFFFFu;
+        indices_[i] = 0;
+        data_[i].~TYPE();
+    }
+    size_ = 0;
+}
+
+template<typename TYPE>
+TYPE *GfxSlotMap<TYPE>::data()
+{
+    return data_;
+}
+
+template<typename TYPE>
+uint32_t GfxSlotMap<TYPE>::size() const
+{
+    return size_;
+}
+
+template<typename TYPE>
+TYPE const *GfxSlotMap<TYPE>::data() const
+{
+    return data_;
+}
+
+template<typename TYPE>
+uint32_t GfxSlotMap<TYPE>::capacity() const
+{
+    return slot_capacity_;
+}
+
+template<typename TYPE>
+uint32_t GfxSlotMap<TYPE>::get_index(uint32_t packed_index) const
+{
+    GFX_ASSERT(packed_index < size_);
+    return indices_[packed_index];
+}
+
+template<typename TYPE>
+uint32_t GfxSlotMap<TYPE>::get_packed_index(uint32_t index) const
+{
+    GFX_ASSERT(index < slot_capacity_);
+    return slots_[index].packed_index_;
+}
+
+template<typename TYPE>
+uint64_t GfxSlotMap<TYPE>::allocate_handle()
+{
+    if(next_slot_ == 0xFFFFFFFFu) grow();
+    uint32_t const index = next_slot_;
+    next_slot_ = next_slots_[index];
+    next_slots_[index] = 0xFFFFFFFFu;
+    uint64_t const handle = (static_cast<uint64_t>(slots_[index].age_) << 32) | static_cast<uint64_t>(index);
+    GFX_ASSERT(handle != 0);    // should never happen
+    return handle;
+}
+
+template<typename TYPE>
+bool GfxSlotMap<TYPE>::acquire_handle(uint64_t handle)
+{
+    if(!handle || !(handle >> 32)) return false;    // invalid handle
+    uint32_t const target_slot = static_cast<uint32_t>(handle & 0xFFFFFFFFull);
+    if(target_slot >= slot_capacity_) grow(target_slot - slot_capacity_ + 1); // grow our capacity
+    for(uint32_t previous_slot = 0xFFFFFFFFu, next_slot = next_slot_; next_slot != 0xFFFFFFFFu;
+        previous_slot = next_slot, next_slot = next_slots_[next_slot])
+        if(next_slot == target_slot)
+        {
+            if(previous_slot == 0xFFFFFFFFu)
+                next_slot_ = next_slots_[next_slot];
+            else
+                next_slots_[previous_slot] = next_slots_[next_slot];
+            next_slots_[next_slot] = 0xFFFFFFFFu;
+            slots_[next_slot].age_ = static_cast<uint32_t>(handle >> 32);
+            return true;
+        }
+    return false;
+}
+
+template<typename TYPE>
+uint64_t GfxSlotMap<TYPE>::get_handle(uint32_t index) const
+{
+    GFX_ASSERT(index < slot_capacity_); if(index >= slot_capacity_) return 0;
+    return (static_cast<uint64_t>(slots_[index].age_) << 32) | static_cast<uint64_t>(index);
+}
+
+template<typename TYPE>
+bool GfxSlotMap<TYPE>::has_handle(uint64_t handle) const
+{
+    if(!handle) return false;   // invalid handle
+    uint32_t const index = static_cast<uint32_t>(handle & 0xFFFFFFFFull);
+    GFX_ASSERT(index < slot_capacity_); if(index >= slot_capacity_) return false;
+    return slots_[index].age_ == static_cast<uint32_t>(handle >> 32);
+}
+
+template<typename TYPE>
+bool GfxSlotMap<TYPE>::free_handle(uint64_t handle)
+{
+    if(!handle) return false;   // invalid handle
+    uint32_t const index = static_cast<uint32_t>(handle & 0xFFFFFFFFull);
+    GFX_ASSERT(index < slot_capacity_); if(index >= slot_capacity_) return false;
+    uint32_t handle_age = slots_[index].age_;
+    if(handle_age != static_cast<uint32_t>(handle >> 32)) return false;
+    slots_[index].age_ = (handle_age < 0xFFFFFFFFu ? handle_age + 1 : 1);
+    next_slots_[index] = next_slot_;
+    next_slot_ = index; // insert back into freelist
+    return true;
+}
+
+template<typename TYPE>
+uint32_t GfxSlotMap<TYPE>::calculate_free_handle_count() const
+{
+    uint32_t free_handle_count = 0;
+    for(uint32_t next_slot = next_slot_; next_slot != 0xFFFFFFFFu; next_slot = next_slots_[next_slot])
+        ++free_handle_count;    // found an available slot
+    return free_handle_count;
+}
+
+template<typename TYPE>
+void GfxSlotMap<TYPE>::grow(uint32_t slot_count)
+{
+    uint32_t previous_slot = 0xFFFFFFFFu;
+    uint32_t capacity = slot_capacity_ + slot_count;
+    capacity += ((capacity + 2) >> 1);  // grow by half capacity
+    Slot *slots = (Slot *)gfxMalloc(capacity * sizeof(Slot));
+    uint32_t *next_slots = (uint32_t *)gfxMalloc(capacity * sizeof(uint32_t));
+    if(slot_capacity_ > 0)
+    {
+        memcpy(slots, slots_, slot_capacity_ * sizeof(Slot));
+        memcpy(next_slots, next_slots_, slot_capacity_ * sizeof(uint32_t));
+    }
+    for(uint32_t i = slot_capacity_; i < capacity; ++i)
+    {
+        slots[i].age_ = 1;
+        slots[i].packed_index_ = 0xFFFFFFFFu;
+        next_slots[i] = (i + 1 < capacity ? i + 1 : 0xFFFFFFFFu);
+    }
+    for(uint32_t next_slot = next_slot_; next_slot != 0xFFFFFFFFu; next_slot = next_slots[next_slot])
+        previous_slot = next_slot;
+    if(previous_slot == 0xFFFFFFFFu)
+        next_slot_ = slot_capacity_;
+    else
+    {
+        GFX_ASSERT(previous_slot < capacity);
+        next_slots[previous_slot] = slot_capacity_;
+    }
+    gfxFree(slots_);
+    gfxFree(next_slots_);
+    slots_ = slots;
+    next_slots_ = next_slots;
+    slot_capacity_ = capacity;
+}
+
+template<typename TYPE>
+void GfxSlotMap<TYPE>::reserve(uint32_t capacity)
+{
+    uint32_t const new_capacity = GFX_MAX(capacity_ + ((capacity_ + 2) >> 1), capacity);
+    TYPE *data = (TYPE *)gfxMalloc(new_capacity * sizeof(TYPE));
+    uint32_t *indices = (uint32_t *)gfxMalloc(new_capacity * sizeof(uint32_t));
+    for(uint32_t i = 0; i < size_; ++i)
+    {
+        new(&data[i]) TYPE(std::move(data_[i]));
+        data_[i].~TYPE();
+        indices[i] = indices_[i];
+    }
+    for(uint32_t i = size_; i < new_capacity; ++i)
+        indices[i] = 0;
+    gfxFree(data_);
+    gfxFree(indices_);
+    data_ = data;
+    indices_ = indices;
+    capacity_ = new_capacity;
+}
+
+//!
+//! Hash map container.
+//!
+
+static inline uint64_t gfxHashMix(uint64_t value)
+{
+    value ^= (value >> 30); value *= 0xBF58476D1CE4E5B9ull;    // splitmix64 finalizer
+    value ^= (value >> 27); value *= 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+static inline uint64_t gfxHashBytes(void const *data, size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;  // FNV-1a
+    for(size_t i = 0; i < size; ++i)
+        hash = (hash ^ static_cast<uint8_t const *>(data)[i]) * 0x100000001B3ull;
+    return gfxHashMix(hash);
+}
+
+template<typename TYPE>
+struct GfxHash
+{
+    static_assert(std::is_integral_v<TYPE> || std::is_enum_v<TYPE> || std::is_pointer_v<TYPE>, "Cannot hash type; a GfxHash<> specialization must be provided");
+    inline uint64_t operator ()(TYPE key) const
+    {
+        if constexpr(std::is_pointer_v<TYPE>)
+            return gfxHashMix(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)));
+        else
+            return gfxHashMix(static_cast<uint64_t>(key));
+    }
+};
+
+template<typename CHAR>
+struct GfxHash<std::basic_string<CHAR>>
+{
+    inline uint64_t operator ()(std::basic_string_view<CHAR> key) const { return gfxHashBytes(key.data(), key.size() * sizeof(CHAR)); }
+    inline uint64_t operator ()(std::basic_string<CHAR> const &key) const { return gfxHashBytes(key.data(), key.size() * sizeof(CHAR)); }
+    inline uint64_t operator ()(CHAR const *key) const { return operator ()(std::basic_string_view<CHAR>(key)); }
+};
+
+template<typename KEY, typename VALUE, typename HASH = GfxHash<KEY>>
+class GfxHashMap
+{
+    GFX_NON_COPYABLE(GfxHashMap);
+
+public:
+    typedef std::pair<KEY, VALUE> value_type;
+    typedef value_type *iterator;
+    typedef value_type const *const_iterator;
+
+    GfxHashMap();
+    ~GfxHashMap();
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    bool empty() const;
+    uint32_t size() const;
+
+    template<typename LOOKUP> iterator find(LOOKUP const &key);   // e.g., a string map can be searched with a `char const *' key
+    template<typename LOOKUP> const_iterator find(LOOKUP const &key) const;
+    template<typename LOOKUP> bool has(LOOKUP const &key) const;
+
+    VALUE &operator [](KEY const &key);
+    std::pair<iterator, bool> insert(KEY const &key, VALUE const &value);
+    bool erase(KEY const &key);     // the last entry is moved into the erased one's place
+    void clear();
+    void reserve(uint32_t capacity);
+
+protected:
+    struct Bucket
+    {
+        uint32_t entry_index;   // or 0xFFFFFFFF if the bucket is empty
+        uint32_t hash;
+    };
+
+    static inline uint32_t get_hash(uint64_t hash) { return static_cast<uint32_t>(hash ^ (hash >> 32)); }
+    inline uint32_t get_distance(uint32_t bucket_index) const { return (bucket_index - buckets_[bucket_index].hash) & bucket_mask_; }
+    template<typename LOOKUP> uint32_t find_bucket(LOOKUP const &key) const;
+    void insert_bucket(uint32_t entry_index, uint32_t hash);
+    void rehash(uint32_t bucket_count);
+
+    value_type *entries_;   // packed in insertion order, as long as nothing gets erased
+    uint32_t size_;
+    uint32_t capacity_;
+    Bucket *buckets_;       // robin hood hashing with linear probing
+    uint32_t bucket_mask_;
+};
+
+template<typename KEY, typename VALUE, typename HASH>
+GfxHashMap<KEY, VALUE, HASH>::GfxHashMap()
+    : entries_(nullptr)
+    , size_(0)
+    , capacity_(0)
+    , buckets_(nullptr)
+    , bucket_mask_(0)
+{
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+GfxHashMap<KEY, VALUE, HASH>::~GfxHashMap()
+{
+    clear();
+    gfxFree(entries_);
+    gfxFree(buckets_);
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+typename GfxHashMap<KEY, VALUE, HASH>::iterator GfxHashMap<KEY, VALUE, HASH>::begin()
+{
+    return entries_;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+typename GfxHashMap<KEY, VALUE, HASH>::iterator GfxHashMap<KEY, VALUE, HASH>::end()
+{
+    return entries_ + size_;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+typename GfxHashMap<KEY, VALUE, HASH>::const_iterator GfxHashMap<KEY, VALUE, HASH>::begin() const
+{
+    return entries_;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+typename GfxHashMap<KEY, VALUE, HASH>::const_iterator GfxHashMap<KEY, VALUE, HASH>::end() const
+{
+    return entries_ + size_;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+bool GfxHashMap<KEY, VALUE, HASH>::empty() const
+{
+    return size_ == 0;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+uint32_t GfxHashMap<KEY, VALUE, HASH>::size() const
+{
+    return size_;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+template<typename LOOKUP>
+typename GfxHashMap<KEY, VALUE, HASH>::iterator GfxHashMap<KEY, VALUE, HASH>::find(LOOKUP const &key)
+{
+    uint32_t const bucket_index = find_bucket(key);
+    return (bucket_index != 0xFFFFFFFFu ? entries_ + buckets_[bucket_index].entry_index : end());
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+template<typename LOOKUP>
+typename GfxHashMap<KEY, VALUE, HASH>::const_iterator GfxHashMap<KEY, VALUE, HASH>::find(LOOKUP const &key) const
+{
+    uint32_t const bucket_index = find_bucket(key);
+    return (bucket_index != 0xFFFFFFFFu ? entries_ + buckets_[bucket_index].entry_index : end());
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+template<typename LOOKUP>
+bool GfxHashMap<KEY, VALUE, HASH>::has(LOOKUP const &key) const
+{
+    return find_bucket(key) != 0xFFFFFFFFu;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+VALUE &GfxHashMap<KEY, VALUE, HASH>::operator [](KEY const &key)
+{
+    uint32_t const bucket_index = find_bucket(key);
+    if(bucket_index != 0xFFFFFFFFu) return entries_[buckets_[bucket_index].entry_index].second;
+    reserve(size_ + 1);
+    new(&entries_[size_]) value_type(key, VALUE());
+    insert_bucket(size_, get_hash(HASH()(key)));
+    return entries_[size_++].second;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+std::pair<typename GfxHashMap<KEY, VALUE, HASH>::iterator, bool> GfxHashMap<KEY, VALUE, HASH>::insert(KEY const &key, VALUE const &value)
+{
+    uint32_t const bucket_index = find_bucket(key);
+    if(bucket_index != 0xFFFFFFFFu) return std::make_pair(entries_ + buckets_[bucket_index].entry_index, false);
+    reserve(size_ + 1);
+    new(&entries_[size_]) value_type(key, value);
+    insert_bucket(size_, get_hash(HASH()(key)));
+    return std::make_pair(entries_ + size_++, true);
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+bool GfxHashMap<KEY, VALUE, HASH>::erase(KEY const &key)
+{
+    uint32_t bucket_index = find_bucket(key);
+    if(bucket_index == 0xFFFFFFFFu) return false;   // not found
+    uint32_t const entry_index = buckets_[bucket_index].entry_index;
+    for(uint32_t next_index = ((bucket_index + 1) & bucket_mask_);
+        buckets_[next_index].entry_index != 0xFFFFFFFFu && get_distance(next_index) > 0;
+        bucket_index = next_index, next_index = ((next_index + 1) & bucket_mask_))
+        buckets_[bucket_index] = buckets_[next_index];  // backward shift
+    buckets_[bucket_index].entry_index = 0xFFFFFFFFu;
+    if(entry_index + 1 < size_)
+    {
+        uint32_t last_index = get_hash(HASH()(entries_[size_ - 1].first)) & bucket_mask_;
+        while(buckets_[last_index].entry_index != size_ - 1) last_index = ((last_index + 1) & bucket_mask_);
+        buckets_[last_index].entry_index = entry_index;
+        entries_[entry_index] = std::move(entries_[size_ - 1]);
+    }
+    entries_[--size_].~value_type();
+    return true;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+void GfxHashMap<KEY, VALUE, HASH>::clear()
+{
+    for(uint32_t i = 0; i < size_; ++i)
+        entries_[i].~value_type();
+    for(uint32_t i = 0; buckets_ != nullptr && i <= bucket_mask_; ++i)
+        buckets_[i].entry_index = 0xFFFFFFFFu;
+    size_ = 0;
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+void GfxHashMap<KEY, VALUE, HASH>::reserve(uint32_t capacity)
+{
+    if(capacity <= capacity_) return;
+    capacity = GFX_MAX(capacity, capacity_ + (capacity_ >> 1));    // grow by half capacity
+    value_type *entries = (value_type *)gfxMalloc(capacity * sizeof(value_type));
+    for(uint32_t i = 0; i < size_; ++i)
+    {
+        new(&entries[i]) value_type(std::move(entries_[i]));
+        entries_[i].~value_type();
+    }
+    gfxFree(entries_);
+    entries_ = entries;
+    capacity_ = capacity;
+    uint32_t bucket_count = 16;
+    while(bucket_count - (bucket_count >> 3) < capacity) bucket_count <<= 1;   // keep the load factor under 7/8
+    if(buckets_ == nullptr || bucket_count > bucket_mask_ + 1) rehash(bucket_count);
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+template<typename LOOKUP>
+uint32_t GfxHashMap<KEY, VALUE, HASH>::find_bucket(LOOKUP const &key) const
+{
+    if(size_ == 0) return 0xFFFFFFFFu;
+    uint32_t const hash = get_hash(HASH()(key));
+    for(uint32_t bucket_index = (hash & bucket_mask_), distance = 0;; bucket_index = ((bucket_index + 1) & bucket_mask_), ++distance)
+    {
+        Bucket const &bucket = buckets_[bucket_index];
+        if(bucket.entry_index == 0xFFFFFFFFu || distance > get_distance(bucket_index))
+            return 0xFFFFFFFFu; // would have been stored before this bucket
+        if(bucket.hash == hash && entries_[bucket.entry_index].first == key)
+            return bucket_index;
+    }
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+void GfxHashMap<KEY, VALUE, HASH>::insert_bucket(uint32_t entry_index, uint32_t hash)
+{
+    Bucket inserted_bucket = { entry_index, hash };
+    for(uint32_t bucket_index = (hash & bucket_mask_), distance = 0;; bucket_index = ((bucket_index + 1) & bucket_mask_), ++distance)
+    {
+        Bucket &bucket = buckets_[bucket_index];
+        if(bucket.entry_index == 0xFFFFFFFFu)
+        {
+            bucket = inserted_bucket;
+            return; // found an empty bucket
+        }
+        uint32_t const bucket_distance = get_distance(bucket_index);
+        if(bucket_distance < distance)
+        {
+            std::swap(bucket, inserted_bucket); // take from the rich
+            distance = bucket_distance;
+        }
+    }
+}
+
+template<typename KEY, typename VALUE, typename HASH>
+void GfxHashMap<KEY, VALUE, HASH>::rehash(uint32_t bucket_count)
+{
+    gfxFree(buckets_);
+    buckets_ = (Bucket *)gfxMalloc(bucket_count * sizeof(Bucket));
+    bucket_mask_ = bucket_count - 1;
+    for(uint32_t i = 0; i < bucket_count; ++i)
+        buckets_[i].entry_index = 0xFFFFFFFFu;
+    for(uint32_t i = 0; i < size_; ++i)
+        insert_bucket(i, get_hash(HASH()(entries_[i].first)));
+}
+
+//!
+//! Small vector container.
+//!
+
+template<typename TYPE, uint32_t CAPACITY>
+class GfxSmallVector
+{
+    static_assert(CAPACITY > 0, "Cannot create a small vector without inline storage");
+
+public:
+    typedef TYPE value_type;
+    typedef TYPE *iterator;
+    typedef TYPE const *const_iterator;
+
+    GfxSmallVector();
+    GfxSmallVector(GfxSmallVector const &other);
+    GfxSmallVector(GfxSmallVector &&other) noexcept;
+    template<typename ITERATOR> GfxSmallVector(ITERATOR first, ITERATOR last);
+    ~GfxSmallVector();
+
+    GfxSmallVector &operator =(GfxSmallVector const &other);
+    GfxSmallVector &operator =(GfxSmallVector &&other) noexcept;
+
+    TYPE *data();
+    TYPE const *data() const;
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    bool empty() const;
+    uint32_t size() const;
+    uint32_t capacity() const;
+    bool is_inline() const;     // i.e., has not spilled onto the heap
+
+    TYPE &operator [](size_t index);
+    TYPE const &operator [](size_t index) const;
+    TYPE &front();
+    TYPE &back();
+    TYPE const &front() const;
+    TYPE const &back() const;
+
+    void push_back(TYPE const &object);
+    void push_back(TYPE &&object);
+    template<typename... ARGS> TYPE &emplace_back(ARGS &&... args);
+    void pop_back();
+    template<typename ITERATOR> void assign(ITERATOR first, ITERATOR last);
+    void resize(uint32_t size);
+    void resize(uint32_t size, TYPE const &object);
+    void reserve(uint32_t capacity);
+    void clear();
+
+protected:
+    TYPE *data_;    // points to the inline storage until it outgrows it
+    uint32_t size_;
+    uint32_t capacity_;
+    alignas(TYPE) char storage_[CAPACITY * sizeof(TYPE)];
+};
+
+template<typename TYPE, uint32_t CAPACITY>
+GfxSmallVector<TYPE, CAPACITY>::GfxSmallVector()
+    : data_((TYPE *)storage_)
+    , size_(0)
+    , capacity_(CAPACITY)
+{
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+GfxSmallVector<TYPE, CAPACITY>::GfxSmallVector(GfxSmallVector const &other)
+    : GfxSmallVector()
+{
+    assign(other.begin(), other.end());
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+GfxSmallVector<TYPE, CAPACITY>::GfxSmallVector(GfxSmallVector &&other) noexcept
+    : GfxSmallVector()
+{
+    *this = std::move(other);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+template<typename ITERATOR>
+GfxSmallVector<TYPE, CAPACITY>::GfxSmallVector(ITERATOR first, ITERATOR last)
+    : GfxSmallVector()
+{
+    assign(first, last);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+GfxSmallVector<TYPE, CAPACITY>::~GfxSmallVector()
+{
+    clear();
+    if(!is_inline()) gfxFree(data_);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+GfxSmallVector<TYPE, CAPACITY> &GfxSmallVector<TYPE, CAPACITY>::operator =(GfxSmallVector const &other)
+{
+    if(this != &other) assign(other.begin(), other.end());
+    return *this;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+GfxSmallVector<TYPE, CAPACITY> &GfxSmallVector<TYPE, CAPACITY>::operator =(GfxSmallVector &&other) noexcept
+{
+    if(this == &other) return *this;
+    clear();
+    if(!other.is_inline())
+    {
+        if(!is_inline()) gfxFree(data_);
+        data_ = other.data_; size_ = other.size_; capacity_ = other.capacity_;
+        other.data_ = (TYPE *)other.storage_; other.size_ = 0; other.capacity_ = CAPACITY;
+        return *this;   // steal the heap allocation
+    }
+    for(uint32_t i = 0; i < other.size_; ++i)
+        new(&data_[i]) TYPE(std::move(other.data_[i]));
+    size_ = other.size_;
+    other.clear();
+    return *this;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE *GfxSmallVector<TYPE, CAPACITY>::data()
+{
+    return data_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE const *GfxSmallVector<TYPE, CAPACITY>::data() const
+{
+    return data_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+typename GfxSmallVector<TYPE, CAPACITY>::iterator GfxSmallVector<TYPE, CAPACITY>::begin()
+{
+    return data_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+typename GfxSmallVector<TYPE, CAPACITY>::iterator GfxSmallVector<TYPE, CAPACITY>::end()
+{
+    return data_ + size_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+typename GfxSmallVector<TYPE, CAPACITY>::const_iterator GfxSmallVector<TYPE, CAPACITY>::begin() const
+{
+    return data_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+typename GfxSmallVector<TYPE, CAPACITY>::const_iterator GfxSmallVector<TYPE, CAPACITY>::end() const
+{
+    return data_ + size_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+bool GfxSmallVector<TYPE, CAPACITY>::empty() const
+{
+    return size_ == 0;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+uint32_t GfxSmallVector<TYPE, CAPACITY>::size() const
+{
+    return size_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+uint32_t GfxSmallVector<TYPE, CAPACITY>::capacity() const
+{
+    return capacity_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+bool GfxSmallVector<TYPE, CAPACITY>::is_inline() const
+{
+    return data_ == (TYPE const *)storage_;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE &GfxSmallVector<TYPE, CAPACITY>::operator [](size_t index)
+{
+    GFX_ASSERT(index < size_);
+    return data_[index];
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE const &GfxSmallVector<TYPE, CAPACITY>::operator [](size_t index) const
+{
+    GFX_ASSERT(index < size_);
+    return data_[index];
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE &GfxSmallVector<TYPE, CAPACITY>::front()
+{
+    GFX_ASSERT(size_ > 0);
+    return data_[0];
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE &GfxSmallVector<TYPE, CAPACITY>::back()
+{
+    GFX_ASSERT(size_ > 0);
+    return data_[size_ - 1];
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE const &GfxSmallVector<TYPE, CAPACITY>::front() const
+{
+    GFX_ASSERT(size_ > 0);
+    return data_[0];
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+TYPE const &GfxSmallVector<TYPE, CAPACITY>::back() const
+{
+    GFX_ASSERT(size_ > 0);
+    return data_[size_ - 1];
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::push_back(TYPE const &object)
+{
+    emplace_back(object);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::push_back(TYPE &&object)
+{
+    emplace_back(std::move(object));
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+template<typename... ARGS>
+TYPE &GfxSmallVector<TYPE, CAPACITY>::emplace_back(ARGS &&... args)
+{
+    if(size_ == capacity_)
+    {
+        TYPE object(std::forward<ARGS>(args)...);  // may be aliasing an element
+        reserve(size_ + 1);
+        return *new(&data_[size_++]) TYPE(std::move(object));
+    }
+    return *new(&data_[size_++]) TYPE(std::forward<ARGS>(args)...);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::pop_back()
+{
+    GFX_ASSERT(size_ > 0);
+    data_[--size_].~TYPE();
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+template<typename ITERATOR>
+void GfxSmallVector<TYPE, CAPACITY>::assign(ITERATOR first, ITERATOR last)
+{
+    clear();
+    reserve(static_cast<uint32_t>(std::distance(first, last)));
+    for(; first != last; ++first)
+        new(&data_[size_++]) TYPE(*first);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::resize(uint32_t size)
+{
+    reserve(size);
+    while(size_ > size) data_[--size_].~TYPE();
+    while(size_ < size) new(&data_[size_++]) TYPE();
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::resize(uint32_t size, TYPE const &object)
+{
+    reserve(size);
+    while(size_ > size) data_[--size_].~TYPE();
+    while(size_ < size) new(&data_[size_++]) TYPE(object);
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::reserve(uint32_t capacity)
+{
+    if(capacity <= capacity_) return;
+    capacity = GFX_MAX(capacity, capacity_ + (capacity_ >> 1));    // grow by half capacity
+    TYPE *data = (TYPE *)gfxMalloc(capacity * sizeof(TYPE));
+    for(uint32_t i = 0; i < size_; ++i)
+    {
+        new(&data[i]) TYPE(std::move(data_[i]));
+        data_[i].~TYPE();
+    }
+    if(!is_inline()) gfxFree(data_);
+    data_ = data;
+    capacity_ = capacity;
+}
+
+template<typename TYPE, uint32_t CAPACITY>
+void GfxSmallVector<TYPE, CAPACITY>::clear()
+{
+    while(size_ > 0) data_[--size_].~TYPE();
+}
+
+//!
+//! Memory budget tracking.
+//!
+
+enum GfxMemoryHeap
+{
+    kGfxMemoryHeap_Default = 0, // GPU-only memory (kGfxCpuAccess_None)
+    kGfxMemoryHeap_Upload,      // kGfxCpuAccess_Write
+    kGfxMemoryHeap_Readback,    // kGfxCpuAccess_Read
+
+    kGfxMemoryHeap_Count
+};
+
+enum GfxMemoryResource
+{
+    kGfxMemoryResource_Buffer = 0,
+    kGfxMemoryResource_Texture,
+    kGfxMemoryResource_RenderTarget,    // textures that may be bound as color or depth/stencil targets
+
+    kGfxMemoryResource_Count
+};
+
+struct GfxMemoryStatistics
+{
+    uint32_t allocation_count[kGfxMemoryHeap_Count][kGfxMemoryResource_Count] = {};
+    uint64_t allocation_bytes[kGfxMemoryHeap_Count][kGfxMemoryResource_Count] = {};
+};
+
+struct GfxMemoryBudget
+{
+    uint64_t usage_bytes = 0;               // local (i.e., video) memory used by the process
+    uint64_t budget_bytes = 0;              // local memory the OS lets the process use before demoting resources
+    uint64_t non_local_usage_bytes = 0;     // system memory used by the process
+    uint64_t non_local_budget_bytes = 0;
+};
+
+// Keeps the per-heap allocation statistics and the budget threshold callbacks; the device only feeds
+// it the allocations and the OS budget, so the accounting can be exercised without one.
+template<typename TYPE>
+class GfxMemoryTracker
+{
+    GFX_NON_COPYABLE(GfxMemoryTracker);
+
+public:
+    GfxMemoryTracker();
+
+    uintptr_t track(GfxMemoryHeap memory_heap, GfxMemoryResource memory_resource, uint64_t allocation_bytes);  // returns the (non-zero) tag to untrack the allocation with
+    void untrack(uintptr_t tag, uint64_t allocation_bytes);                                                     // a zero tag is ignored
+    GfxMemoryStatistics const &get_statistics() const;
+
+    GfxMemoryBudget get_budget(GfxMemoryBudget const &os_budget) const; // reports the tracked default heap usage against the simulated budget, if any
+    void set_simulated_budget(uint64_t budget_bytes);
+
+    GfxResult add_callback(float threshold, TYPE callback, void *user_data);
+    GfxResult remove_callback(TYPE callback, void *user_data);
+    bool has_callbacks() const;
+    template<typename INVOKE>
+    void check_budget(GfxMemoryBudget const &budget, INVOKE const &invoke);    // calls `invoke(callback, is_over_threshold, user_data)' for each threshold crossed since the last check
+
+protected:
+    struct Callback
+    {
+        float threshold_ = 1.0f;
+        TYPE callback_ = nullptr;
+        void *user_data_ = nullptr;
+        bool is_over_threshold_ = false;
+    };
+
+    std::vector<Callback> callbacks_;
+    GfxMemoryStatistics statistics_;
+    uint64_t simulated_budget_;
+};
+
+template<typename TYPE>
+GfxMemoryTracker<TYPE>::GfxMemoryTracker()
+    : simulated_budget_(0)
+{
+}
+
+template<typename TYPE>
+uintptr_t GfxMemoryTracker<TYPE>::track(GfxMemoryHeap memory_heap, GfxMemoryResource memory_resource, uint64_t allocation_bytes)
+{
+    GFX_ASSERT(memory_heap < kGfxMemoryHeap_Count && memory_resource < kGfxMemoryResource_Count);
+    ++statistics_.allocation_count[memory_heap][memory_resource];
+    statistics_.allocation_bytes[memory_heap][memory_resource] += allocation_bytes;
+    return (uintptr_t)memory_heap * kGfxMemoryResource_Count + memory_resource + 1;
+}
+
+template<typename TYPE>
+void GfxMemoryTracker<TYPE>::untrack(uintptr_t tag, uint64_t allocation_bytes)
+{
+    if(tag == 0) return;    // not tracked
+    uint32_t const memory_heap = (uint32_t)(tag - 1) / kGfxMemoryResource_Count;
+    uint32_t const memory_resource = (uint32_t)(tag - 1) % kGfxMemoryResource_Count;
+    GFX_ASSERT(memory_heap < kGfxMemoryHeap_Count);
+    GFX_ASSERT(statistics_.allocation_count[memory_heap][memory_resource] > 0);
+    GFX_ASSERT(statistics_.allocation_bytes[memory_heap][memory_resource] >= allocation_bytes);
+    --statistics_.allocation_count[memory_heap][memory_resource];
+    statistics_.allocation_bytes[memory_heap][memory_resource] -= allocation_bytes;
+}
+
+template<typename TYPE>
+GfxMemoryStatistics const &GfxMemoryTracker<TYPE>::get_statistics() const
+{
+    return statistics_;
+}
+
+template<typename TYPE>
+GfxMemoryBudget GfxMemoryTracker<TYPE>::get_budget(GfxMemoryBudget const &os_budget) const
+{
+    GfxMemoryBudget budget = os_budget;
+    if(simulated_budget_ > 0)
+    {
+        budget.usage_bytes = 0;
+        for(uint32_t i = 0; i < kGfxMemoryResource_Count; ++i)
+            budget.usage_bytes += statistics_.allocation_bytes[kGfxMemoryHeap_Default][i];
+        budget.budget_bytes = simulated_budget_;
+    }
+    return budget;
+}
+
+template<typename TYPE>
+void GfxMemoryTracker<TYPE>::set_simulated_budget(uint64_t budget_bytes)
+{
+    simulated_budget_ = budget_bytes;
+}
+
+template<typename TYPE>
+GfxResult GfxMemoryTracker<TYPE>::add_callback(float threshold, TYPE callback, void *user_data)
+{
+    if(callback == nullptr)
+        return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot add a memory budget callback without a callback function");
+    if(!(threshold > 0.0f))
+        return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot add a memory budget callback with a non-positive threshold");
+    Callback memory_budget_callback = {};
+    memory_budget_callback.threshold_ = threshold;
+    memory_budget_callback.callback_ = callback;
+    memory_budget_callback.user_data_ = user_data;
+    callbacks_.push_back(memory_budget_callback);
+    return kGfxResult_NoError;
+}
+
+template<typename TYPE>
+GfxResult GfxMemoryTracker<TYPE>::remove_callback(TYPE callback, void *user_data)
+{
+    for(typename std::vector<Callback>::const_iterator it = callbacks_.begin(); it != callbacks_.end(); ++it)
+        if((*it).callback_ == callback && (*it).user_data_ == user_data)
+        {
+            callbacks_.erase(it);
+            return kGfxResult_NoError;
+        }
+    return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot remove a memory budget callback that was not added");
+}
+
+template<typename TYPE>
+bool GfxMemoryTracker<TYPE>::has_callbacks() const
+{
+    return !callbacks_.empty();
+}
+
+template<typename TYPE>
+template<typename INVOKE>
+void GfxMemoryTracker<TYPE>::check_budget(GfxMemoryBudget const &budget, INVOKE const &invoke)
+{
+    if(budget.budget_bytes == 0) return;    // budget not available
+    std::vector<Callback> const callbacks = callbacks_; // callbacks may add/remove callbacks
+    for(typename std::vector<Callback>::const_iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+    {
+        bool const is_over_threshold = (budget.usage_bytes > (uint64_t)((double)(*it).threshold_ * budget.budget_bytes));
+        if(is_over_threshold == (*it).is_over_threshold_)
+            continue;   // threshold wasn't crossed
+        bool is_registered = false;
+        for(size_t i = 0; i < callbacks_.size(); ++i)
+            if(callbacks_[i].callback_ == (*it).callback_ && callbacks_[i].user_data_ == (*it).user_data_)
+            {
+                callbacks_[i].is_over_threshold_ = is_over_threshold;
+                is_registered = true;
+                break;
+            }
+        if(!is_registered)
+            continue;   // removed by a previous callback
+        invoke((*it).callback_, is_over_threshold, (*it).user_data_);
+    }
+}
+
+//!
+//! Job system.
+//!
+
+struct GfxJobScheduler
+{
+    void *user_data = nullptr;
+    uint32_t thread_count = 0;  // number of threads the host runs the jobs on, for splitting the work
+    void (*dispatch)(void *user_data, void (*execute)(void *job), void *job) = nullptr;    // the host must call `execute(job)' exactly once, from any thread
+};
+
+// When a scheduler is set, the jobs still go into the system's queues and the host only receives a
+// ticket per job that runs whichever job is pending; the tickets must all have run before the system
+// is destroyed. A thread that waits on a counter keeps running the queued jobs itself, so nested
+// parallel_for() calls complete even if all the host threads are busy.
+
+class GfxJobCounter
+{
+    GFX_NON_COPYABLE(GfxJobCounter);
+    friend class GfxJobSystem;
+
+public:
+    inline GfxJobCounter() : count_(0) {}
+    inline ~GfxJobCounter() { GFX_ASSERT(done()); }
+
+    inline bool done() const { return count_.load(std::memory_order_acquire) == 0; }
+
+protected:
+    std::atomic<uint32_t> count_;   // number of jobs not yet completed
+};
+
+class GfxJobSystem
+{
+    GFX_NON_COPYABLE(GfxJobSystem);
+
+public:
+    inline explicit GfxJobSystem(uint32_t thread_count = 0);   // 0 spawns one worker per core, minus the calling thread
+    inline ~GfxJobSystem();
+
+    inline void set_scheduler(GfxJobScheduler const &scheduler);    // routes the jobs to the host; must be set while no jobs are in flight
+    inline uint32_t get_thread_count() const;   // including the threads that wait
+
+    inline void run(std::function<void()> function, GfxJobCounter *counter = nullptr, GfxJobCounter *dependency = nullptr);
+    inline void wait(GfxJobCounter &counter);   // runs the pending jobs on the calling thread until the counter drops to zero
+
+    template<typename FUNCTION>
+    inline void parallel_for(uint32_t count, uint32_t grain_size, FUNCTION const &function);   // calls `function(index)' for each index in chunks of `grain_size', then waits
+
+protected:
+    struct Job
+    {
+        std::function<void()> function;
+        GfxJobCounter *counter;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    struct Dependencies
+    {
+        std::mutex mutex;   // the counters get decremented under it, so they may be destroyed as soon as they read as done
+        std::vector<std::pair<GfxJobCounter const *, Job>> jobs;
+    };
+
+    inline void push(Job &&job);
+    inline bool pop(uint32_t queue_index, Job &job);
+    inline bool try_run(uint32_t queue_index);
+    inline void execute(Job &job);
+    inline void worker(uint32_t queue_index);
+    inline uint32_t get_queue_index() const;
+    inline Dependencies &get_dependencies(GfxJobCounter const *counter);
+    static inline void execute_external(void *job_system);
+
+    uint32_t queue_count_;
+    std::unique_ptr<Queue[]> queues_;   // the first one is shared by the threads that don't belong to the system
+    Dependencies dependencies_[16];     // jobs waiting on a counter, striped by counter address
+    std::vector<std::thread> threads_;
+    std::atomic<uint32_t> pending_job_count_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_condition_;
+    bool stop_;
+    GfxJobScheduler scheduler_;
+
+    static inline thread_local GfxJobSystem const *tls_job_system_ = nullptr;
+    static inline thread_local uint32_t tls_queue_index_ = 0;
+};
+
+GfxJobSystem::GfxJobSystem(uint32_t thread_count)
+    : queue_count_((thread_count > 0 ? thread_count : GFX_MAX(std::thread::hardware_concurrency(), 2u) - 1) + 1)
+    , queues_(new Queue[queue_count_])
+    , pending_job_count_(0)
+    , stop_(false)
+{
+    for(uint32_t i = 1; i < queue_count_; ++i)
+        threads_.emplace_back(&GfxJobSystem::worker, this, i);
+}
+
+GfxJobSystem::~GfxJobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    sleep_condition_.notify_all();
+    for(std::thread &thread : threads_)
+        thread.join();
+}
+
+void GfxJobSystem::set_scheduler(GfxJobScheduler const &scheduler)
+{
+    GFX_ASSERT(pending_job_count_.load() == 0);
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    scheduler_ = scheduler; // our workers read it when going to sleep
+}
+
+uint32_t GfxJobSystem::get_thread_count() const
+{
+    if(scheduler_.dispatch != nullptr)
+        return GFX_MAX(scheduler_.thread_count, 1u);
+    return queue_count_;
+}
+
+void GfxJobSystem::run(std::function<void()> function, GfxJobCounter *counter, GfxJobCounter *dependency)
+{
+    if(counter != nullptr) counter->count_.fetch_add(1, std::memory_order_relaxed);
+    Job job = { std::move(function), counter };
+    if(dependency != nullptr)
+    {
+        Dependencies &dependencies = get_dependencies(dependency);
+        std::lock_guard<std::mutex> lock(dependencies.mutex);
+        if(!dependency->done())
+        {
+            dependencies.jobs.emplace_back(dependency, std::move(job));
+            return; // deferred until the dependency completes
+        }
+    }
+    push(std::move(job));
+}
+
+void GfxJobSystem::wait(GfxJobCounter &counter)
+{
+    uint32_t const queue_index = get_queue_index();
+    while(!counter.done())
+        if(!try_run(queue_index))
+            std::this_thread::yield();  // the remaining jobs are running on other threads
+}
+
+template<typename FUNCTION>
+void GfxJobSystem::parallel_for(uint32_t count, uint32_t grain_size, FUNCTION const &function)
+{
+    grain_size = GFX_MAX(grain_size, 1u);
+    if(count <= grain_size || get_thread_count() <= 1)
+    {
+        for(uint32_t i = 0; i < count; ++i) function(i);
+        return; // not worth splitting
+    }
+    GfxJobCounter counter;
+    for(uint32_t begin = grain_size; begin < count; begin += grain_size)
+    {
+        uint32_t const end = GFX_MIN(begin + grain_size, count);
+        run([&function, begin, end]() { for(uint32_t i = begin; i < end; ++i) function(i); }, &counter);
+    }
+    for(uint32_t i = 0; i < grain_size; ++i) function(i);   // the calling thread takes the first chunk
+    wait(counter);
+}
+
+void GfxJobSystem::push(Job &&job)
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        pending_job_count_.fetch_add(1, std::memory_order_relaxed);  // counted first so that it never goes negative when stolen right away
+    }
+    uint32_t const queue_index = get_queue_index();
+    {
+        std::lock_guard<std::mutex> lock(queues_[queue_index].mutex);
+        queues_[queue_index].jobs.push_back(std::move(job));
+    }
+    if(scheduler_.dispatch != nullptr)
+        scheduler_.dispatch(scheduler_.user_data, &GfxJobSystem::execute_external, this);
+    else
+        sleep_condition_.notify_one();
+}
+
+bool GfxJobSystem::pop(uint32_t queue_index, Job &job)
+{
+    for(uint32_t i = 0; i < queue_count_; ++i)
+    {
+        Queue &queue = queues_[(queue_index + i) % queue_count_];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.jobs.empty()) continue;
+        if(i == 0)
+        {
+            job = std::move(queue.jobs.back()); // own queue, newest first for locality
+            queue.jobs.pop_back();
+        }
+        else
+        {
+            job = std::move(queue.jobs.front());    // steal the oldest job, likely the largest one
+            queue.jobs.pop_front();
+        }
+        pending_job_count_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool GfxJobSystem::try_run(uint32_t queue_index)
+{
+    Job job;
+    if(!pop(queue_index, job))
+        return false;   // nothing to do
+    execute(job);
+    return true;
+}
+
+void GfxJobSystem::execute(Job &job)
+{
+    job.function();
+    GfxJobCounter const *counter = job.counter;
+    if(counter == nullptr) return;  // nothing to signal
+    std::vector<Job> dependent_jobs;
+    {
+        Dependencies &dependencies = get_dependencies(counter);
+        std::lock_guard<std::mutex> lock(dependencies.mutex);
+        if(job.counter->count_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return; // other jobs are still running
+        for(size_t i = 0; i < dependencies.jobs.size();)
+            if(dependencies.jobs[i].first != counter) ++i; else
+            {
+                dependent_jobs.push_back(std::move(dependencies.jobs[i].second));
+                dependencies.jobs.erase(dependencies.jobs.begin() + i);
+            }
+    }
+    for(Job &dependent_job : dependent_jobs)
+        push(std::move(dependent_job));
+}
+
+void GfxJobSystem::worker(uint32_t queue_index)
+{
+    tls_job_system_ = this;
+    tls_queue_index_ = queue_index;
+    for(;;)
+    {
+        if(try_run(queue_index)) continue;
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_condition_.wait(lock, [&]() { return stop_ || (scheduler_.dispatch == nullptr && pending_job_count_.load(std::memory_order_relaxed) > 0); });
+        if(stop_) break;
+    }
+}
+
+uint32_t GfxJobSystem::get_queue_index() const
+{
+    return (tls_job_system_ == this ? tls_queue_index_ : 0);
+}
+
+GfxJobSystem::Dependencies &GfxJobSystem::get_dependencies(GfxJobCounter const *counter)
+{
+    return dependencies_[((uintptr_t)counter / sizeof(GfxJobCounter)) % (sizeof(dependencies_) / sizeof(*dependencies_))];
+}
+
+void GfxJobSystem::execute_external(void *job_system)
+{
+    GfxJobSystem *self = (GfxJobSystem *)job_system;
+    self->try_run(self->get_queue_index()); // may find nothing left if a waiting thread got to it first
+}
+
+inline GfxJobSystem &gfxGetJobSystem()
+{
+    static GfxJobSystem job_system;  // spawned on first use
+    return job_system;
+}
+
 #endif //! GFX_INCLUDE_GFX_CORE_H
@@ -0,0 +1,105 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#ifndef GFX_INCLUDE_GFX_GLTF_H
+#define GFX_INCLUDE_GFX_GLTF_H
+
+#include "gfx_core.h"
+
+#include <cfloat>       // FLT_MAX
+
+// Must come after <cgltf.h>; kept apart from gfx_scene.cpp so that the accessor
+// unpacking can be checked against cgltf without a device.
+
+//!
+//! glTF accessor unpacking.
+//!
+
+static inline uint8_t const *gfxGltfGetAccessorData(cgltf_accessor const *accessor)
+{
+    if(accessor->is_sparse || accessor->buffer_view == nullptr) return nullptr;
+    cgltf_buffer_view const *buffer_view = accessor->buffer_view;
+    uint8_t const *data = (uint8_t const *)buffer_view->data;   // set when the view was decompressed
+    if(data == nullptr && buffer_view->buffer->data != nullptr)
+        data = (uint8_t const *)buffer_view->buffer->data + buffer_view->offset;
+    return (data != nullptr ? data + accessor->offset : nullptr);
+}
+
+template<typename COMPONENT>
+static inline void gfxGltfUnpackComponents(uint8_t const *data, cgltf_size stride, cgltf_size count, cgltf_size component_count, float scale, float minimum, float *output)
+{
+    COMPONENT components[16];
+    GFX_ASSERT(component_count <= sizeof(components) / sizeof(*components));
+    for(cgltf_size i = 0; i < count; ++i, data += stride, output += component_count)
+    {
+        memcpy(components, data, component_count * sizeof(COMPONENT));
+        for(cgltf_size j = 0; j < component_count; ++j)
+            output[j] = GFX_MAX((float)components[j] * scale, minimum);
+    }
+}
+
+// Unpacks `accessor->count' elements of `cgltf_num_components(accessor->type)' floats
+// each, like cgltf_accessor_unpack_floats() but with fast paths for the common layouts;
+// normalized signed components get clamped to -1 as the glTF specification mandates.
+static inline bool gfxGltfUnpackAccessor(cgltf_accessor const *accessor, float *output)
+{
+    cgltf_size const component_count = cgltf_num_components(accessor->type);
+    uint8_t const *data = gfxGltfGetAccessorData(accessor);
+    bool const is_padded_matrix = (accessor->type >= cgltf_type_mat2 && accessor->component_type != cgltf_component_type_r_32f &&
+                                   accessor->component_type != cgltf_component_type_r_32u);   // columns are aligned to 4 bytes
+    if(data != nullptr && component_count <= 16 && !is_padded_matrix)
+    {
+        bool const normalized = (accessor->normalized != 0);
+        switch(accessor->component_type)
+        {
+        case cgltf_component_type_r_32f:
+            if(accessor->stride == component_count * sizeof(float))
+                memcpy(output, data, accessor->count * accessor->stride);   // tightly packed
+            else
+                for(cgltf_size i = 0; i < accessor->count; ++i)
+                    memcpy(&output[i * component_count], &data[i * accessor->stride], component_count * sizeof(float));
+            return true;
+        case cgltf_component_type_r_8:
+            gfxGltfUnpackComponents<int8_t>(data, accessor->stride, accessor->count, component_count, normalized ? 1.0f / 127.0f : 1.0f, normalized ? -1.0f : -FLT_MAX, output);
+            return true;
+        case cgltf_component_type_r_8u:
+            gfxGltfUnpackComponents<uint8_t>(data, accessor->stride, accessor->count, component_count, normalized ? 1.0f / 255.0f : 1.0f, 0.0f, output);
+            return true;
+        case cgltf_component_type_r_16:
+            gfxGltfUnpackComponents<int16_t>(data, accessor->stride, accessor->count, component_count, normalized ? 1.0f / 32767.0f : 1.0f, normalized ? -1.0f : -FLT_MAX, output);
+            return true;
+        case cgltf_component_type_r_16u:
+            gfxGltfUnpackComponents<uint16_t>(data, accessor->stride, accessor->count, component_count, normalized ? 1.0f / 65535.0f : 1.0f, 0.0f, output);
+            return true;
+        case cgltf_component_type_r_32u:
+            gfxGltfUnpackComponents<uint32_t>(data, accessor->stride, accessor->count, component_count, 1.0f, 0.0f, output);
+            return true;
+        default:
+            break;  // fall back to cgltf
+        }
+    }
+    cgltf_size const floats_size = component_count * accessor->count;
+    return cgltf_accessor_unpack_floats(accessor, output, floats_size) >= floats_size;
+}
+
+#endif //! GFX_INCLUDE_GFX_GLTF_H
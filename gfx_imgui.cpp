@@ -202,9 +202,25 @@ public:
         return kGfxResult_NoError;
     }
 
+    bool reserveBuffer(GfxBuffer &buffer, uint64_t size, uint32_t stride, char const *type, uint32_t buffer_index)
+    {
+        if(size <= buffer.getSize())
+            return true;    // buffers are retained across frames and never shrink
+        uint64_t const capacity = GFX_ALIGN(GFX_MAX(size + ((size + 2) >> 1), 2 * buffer.getSize()), 65536);
+        GfxBuffer const new_buffer = gfxCreateBuffer(gfx_, capacity, nullptr, kGfxCpuAccess_Write);
+        if(!new_buffer)
+            return false;   // keep previous buffer
+        gfxDestroyBuffer(gfx_, buffer); // release previous memory
+        buffer = new_buffer;
+        char name[256];
+        GFX_SNPRINTF(name, sizeof(name), "gfx_ImGui%sBuffer%u", type, buffer_index);
+        buffer.setStride(stride);
+        buffer.setName(name);
+        return true;
+    }
+
     GfxResult render()
     {
-        char buffer[256];
         ImGuiIO &io = ImGui::GetIO();
         ImGui::Render();    // implicit ImGui::EndFrame()
         ImDrawData const *draw_data = ImGui::GetDrawData();
@@ -213,41 +229,16 @@ public:
         if(draw_data->TotalVtxCount > 0)
         {
             GfxBuffer &index_buffer = index_buffers_[buffer_index];
-            uint64_t const index_buffer_size = draw_data->TotalIdxCount * sizeof(ImDrawIdx);
-            if(index_buffer_size > index_buffer.getSize())
-            {
-                gfxDestroyBuffer(gfx_, index_buffer);   // release previous index memory
-                index_buffer = gfxCreateBuffer(gfx_, GFX_ALIGN(index_buffer_size + ((index_buffer_size + 2) >> 1), 65536), nullptr, kGfxCpuAccess_Write);
-                if(!index_buffer)
-                    return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to allocate buffer of %d indices to draw ImGui", draw_data->TotalIdxCount);
-                GFX_SNPRINTF(buffer, sizeof(buffer), "gfx_ImGuiIndexBuffer%u", buffer_index);
-                index_buffer.setStride((uint32_t)sizeof(ImDrawIdx));
-                index_buffer.setName(buffer);
-            }
+            if(!reserveBuffer(index_buffer, draw_data->TotalIdxCount * sizeof(ImDrawIdx), (uint32_t)sizeof(ImDrawIdx), "Index", buffer_index))
+                return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to allocate buffer of %d indices to draw ImGui", draw_data->TotalIdxCount);
             ImDrawIdx *draw_idx = (ImDrawIdx *)gfxBufferGetData(gfx_, index_buffer);
 
             GfxBuffer &vertex_buffer = vertex_buffers_[buffer_index];
-            uint64_t const vertex_buffer_size = draw_data->TotalVtxCount * sizeof(ImDrawVert);
-            if(vertex_buffer_size > vertex_buffer.getSize())
-            {
-                gfxDestroyBuffer(gfx_, vertex_buffer);  // release previous vertex memory
-                vertex_buffer = gfxCreateBuffer(gfx_, GFX_ALIGN(vertex_buffer_size + ((vertex_buffer_size + 2) >> 1), 65536), nullptr, kGfxCpuAccess_Write);
-                if(!vertex_buffer)
-                    return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to allocate buffer of %d vertices to draw ImGui", draw_data->TotalVtxCount);
-                GFX_SNPRINTF(buffer, sizeof(buffer), "gfx_ImGuiVertexBuffer%u", buffer_index);
-                vertex_buffer.setStride((uint32_t)sizeof(ImDrawVert));
-                vertex_buffer.setName(buffer);
-            }
+            if(!reserveBuffer(vertex_buffer, draw_data->TotalVtxCount * sizeof(ImDrawVert), (uint32_t)sizeof(ImDrawVert), "Vertex", buffer_index))
+                return GFX_SET_ERROR(kGfxResult_OutOfMemory, "Unable to allocate buffer of %d vertices to draw ImGui", draw_data->TotalVtxCount);
             ImDrawVert *draw_vtx = (ImDrawVert *)gfxBufferGetData(gfx_, vertex_buffer);
 
-            for(int32_t i = 0; i < draw_data->CmdListsCount; ++i)
-            {
-                ImDrawList const *cmd_list = draw_data->CmdLists[i];
-                memcpy(draw_idx, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-                memcpy(draw_vtx, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-                draw_idx += cmd_list->IdxBuffer.Size;
-                draw_vtx += cmd_list->VtxBuffer.Size;
-            }
+            gfxImGuiCopyDrawData(draw_data, draw_idx, draw_vtx);
 
             float const L = 0.0f;
             float const R = io.DisplaySize.x;
@@ -267,32 +258,16 @@ public:
             gfxCommandBindVertexBuffer(gfx_, vertex_buffer);
             gfxCommandSetViewport(gfx_);    // draw to back buffer
 
-            int32_t vtx_offset = 0;
-            int32_t idx_offset = 0;
-            for(int32_t i = 0; i < draw_data->CmdListsCount; ++i)
+            struct Encoder
             {
-                ImDrawList const *cmd_list = draw_data->CmdLists[i];
-                for(int32_t j = 0; j < cmd_list->CmdBuffer.Size; ++j)
-                {
-                    ImDrawCmd const *cmd = &cmd_list->CmdBuffer[j];
-                    if(cmd->UserCallback)
-                        cmd->UserCallback(cmd_list, cmd);
-                    else if(cmd->ClipRect.x != cmd->ClipRect.z &&
-                            cmd->ClipRect.y != cmd->ClipRect.w)
-                    {
-                        GfxTexture const *font_buffer = (GfxTexture const *)cmd->TextureId;
-                        if(font_buffer != nullptr)
-                            gfxProgramSetParameter(gfx_, imgui_program_, "FontBuffer", *font_buffer);
-                        gfxCommandSetScissorRect(gfx_, (int32_t)cmd->ClipRect.x,
-                                                       (int32_t)cmd->ClipRect.y,
-                                                       (int32_t)(cmd->ClipRect.z - cmd->ClipRect.x),
-                                                       (int32_t)(cmd->ClipRect.w - cmd->ClipRect.y));
-                        gfxCommandDrawIndexed(gfx_, cmd->ElemCount, 1, idx_offset, vtx_offset);
-                    }
-                    idx_offset += cmd->ElemCount;
-                }
-                vtx_offset += cmd_list->VtxBuffer.Size;
-            }
+                GfxContext gfx;
+                GfxProgram program;
+                void setTexture(ImTextureID texture_id) { gfxProgramSetParameter(gfx, program, "FontBuffer", *(GfxTexture const *)texture_id); }
+                void setScissorRect(ImVec4 const &clip_rect) { gfxCommandSetScissorRect(gfx, (int32_t)clip_rect.x, (int32_t)clip_rect.y, (int32_t)(clip_rect.z - clip_rect.x), (int32_t)(clip_rect.w - clip_rect.y)); }
+                void drawIndexed(uint32_t index_count, uint32_t first_index, int32_t base_vertex) { gfxCommandDrawIndexed(gfx, index_count, 1, first_index, base_vertex); }
+            };
+            Encoder encoder = { gfx_, imgui_program_ };
+            gfxImGuiEncodeDrawData(draw_data, encoder);
             gfxCommandSetScissorRect(gfx_); // reset scissor test
         }
 
@@ -340,3 +315,15 @@ bool gfxImGuiIsInitialized()
     GfxImGuiInternal *gfx_imgui = GfxImGuiInternal::GetGfxImGui();
     return (gfx_imgui != nullptr ? true : false);
 }
+
+void gfxImGuiCopyDrawData(ImDrawData const *draw_data, ImDrawIdx *draw_idx, ImDrawVert *draw_vtx)
+{
+    for(int32_t i = 0; i < draw_data->CmdListsCount; ++i)
+    {
+        ImDrawList const *cmd_list = draw_data->CmdLists[i];
+        memcpy(draw_idx, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        memcpy(draw_vtx, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        draw_idx += cmd_list->IdxBuffer.Size;
+        draw_vtx += cmd_list->VtxBuffer.Size;
+    }
+}
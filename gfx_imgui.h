@@ -44,6 +44,70 @@ GfxResult gfxImGuiRender();
 
 bool gfxImGuiIsInitialized();
 
+//!
+//! Draw data encoding.
+//!
+
+// Copies the geometry of all the draw lists back to back into the (mapped) index and vertex buffers.
+void gfxImGuiCopyDrawData(ImDrawData const *draw_data, ImDrawIdx *draw_idx, ImDrawVert *draw_vtx);
+
+// Walks the draw commands, merging the consecutive ones that share a texture and clip rectangle, and
+// skipping the fully clipped ones. The encoder only gets told about texture and scissor changes, which
+// user callbacks invalidate. Doesn't touch the device so that the batching can be tested on its own.
+template<typename ENCODER>
+void gfxImGuiEncodeDrawData(ImDrawData const *draw_data, ENCODER &encoder)
+{
+    int32_t vtx_offset = 0;
+    uint32_t idx_offset = 0;
+    ImVec4 scissor_rect(0.0f, 0.0f, 0.0f, 0.0f);
+    ImTextureID bound_texture = nullptr;
+    for(int32_t i = 0; i < draw_data->CmdListsCount; ++i)
+    {
+        ImDrawList const *cmd_list = draw_data->CmdLists[i];
+        for(int32_t j = 0; j < cmd_list->CmdBuffer.Size;)
+        {
+            ImDrawCmd const *cmd = &cmd_list->CmdBuffer[j++];
+            if(cmd->UserCallback)
+            {
+                cmd->UserCallback(cmd_list, cmd);
+                scissor_rect = ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
+                bound_texture = nullptr;    // callback may have changed the bindings
+                idx_offset += cmd->ElemCount;
+                continue;
+            }
+            // Merge the following commands that share the same texture and clip rectangle
+            uint32_t elem_count = cmd->ElemCount;
+            for(; j < cmd_list->CmdBuffer.Size; ++j)
+            {
+                ImDrawCmd const *next_cmd = &cmd_list->CmdBuffer[j];
+                if(next_cmd->UserCallback || next_cmd->TextureId != cmd->TextureId ||
+                   next_cmd->ClipRect.x != cmd->ClipRect.x || next_cmd->ClipRect.y != cmd->ClipRect.y ||
+                   next_cmd->ClipRect.z != cmd->ClipRect.z || next_cmd->ClipRect.w != cmd->ClipRect.w)
+                    break;
+                elem_count += next_cmd->ElemCount;
+            }
+            if(elem_count > 0 && cmd->ClipRect.x != cmd->ClipRect.z &&
+                                 cmd->ClipRect.y != cmd->ClipRect.w)
+            {
+                if(cmd->TextureId != nullptr && cmd->TextureId != bound_texture)
+                {
+                    encoder.setTexture(cmd->TextureId);
+                    bound_texture = cmd->TextureId;
+                }
+                if(cmd->ClipRect.x != scissor_rect.x || cmd->ClipRect.y != scissor_rect.y ||
+                   cmd->ClipRect.z != scissor_rect.z || cmd->ClipRect.w != scissor_rect.w)
+                {
+                    encoder.setScissorRect(cmd->ClipRect);
+                    scissor_rect = cmd->ClipRect;
+                }
+                encoder.drawIndexed(elem_count, idx_offset, vtx_offset);
+            }
+            idx_offset += elem_count;
+        }
+        vtx_offset += cmd_list->VtxBuffer.Size;
+    }
+}
+
 #endif //! GFX_INCLUDE_GFX_IMGUI_H
 
 //!
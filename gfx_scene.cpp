@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include <map>
 #include <set>
+#include <charconv>
 #include <functional>
 #include <ios>
 #include <fstream>
@@ -38,6 +39,7 @@ SOFTWARE.
 #ifdef _MSC_VER
 #   pragma warning(pop)
 #endif
+#include "gfx_gltf.h"
 #include <tiny_obj_loader.h>   // obj loader
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -77,8 +79,8 @@ class GfxSceneInternal
         GfxRef<GfxSkin> skin_;
         GfxRef<GfxLight> light_;
         GfxRef<GfxCamera> camera_;
-        std::vector<uint64_t> children_;
-        std::vector<GfxRef<GfxInstance>> instances_;
+        GfxSmallVector<uint64_t, 4> children_;
+        GfxSmallVector<GfxRef<GfxInstance>, 2> instances_;
         std::vector<float> default_weights_;
     };
 
@@ -87,6 +89,9 @@ class GfxSceneInternal
         glm::dvec3 translate_;
         glm::dquat rotate_;
         glm::dvec3 scale_;
+        glm::dvec3 default_translate_;  // rest pose that blended animations start from
+        glm::dquat default_rotate_;
+        glm::dvec3 default_scale_;
     };
 
     enum GltfAnimationChannelMode
@@ -119,7 +124,8 @@ class GfxSceneInternal
     struct GltfAnimation
     {
         std::vector<uint64_t> animated_root_nodes_;
-        std::vector<GfxRef<GfxSkin>> dependent_skins_;
+        std::vector<uint64_t> animated_instances_;  // instances below the animated root nodes, whose transforms get rewritten
+        GfxSmallVector<GfxRef<GfxSkin>, 2> dependent_skins_;
         std::vector<GltfAnimationChannel> channels_;
     };
 
@@ -129,105 +135,118 @@ class GfxSceneInternal
         std::vector<uint64_t> joints_;
     };
 
+    struct GltfAnimationState
+    {
+        std::vector<uint64_t> nodes_;               // copied hierarchy in depth-first order, so parents come before their children
+        std::vector<uint32_t> parents_;             // index of the parent in `nodes_', or 0xFFFFFFFF for a root
+        std::vector<uint32_t> node_poses_;          // index in `poses_', or 0xFFFFFFFF for a node that isn't animated
+        std::vector<uint32_t> node_instances_;      // range of each node's copied instances (one more entry than nodes)
+        std::vector<GltfAnimatedNode> poses_;
+        std::vector<glm::dmat4> world_transforms_;
+        std::vector<uint32_t> channel_nodes_;       // index in `nodes_' of each channel's target node, or 0xFFFFFFFF
+        std::vector<uint64_t> source_skins_;        // skins that were copied, providing the inverse bind matrices
+        std::vector<uint32_t> skin_joints_;         // range of each copied skin's joints (one more entry than skins)
+        std::vector<uint32_t> joints_;              // index in `nodes_' of each joint, or 0xFFFFFFFF for a joint outside of the hierarchy
+    };
+
     std::vector<uint64_t> scene_gltf_nodes_;
-    GfxArray<GltfNode> gltf_nodes_;
+    GfxSlotMap<GltfNode> gltf_nodes_;
     GfxArray<GltfAnimatedNode> gltf_animated_nodes_;
-    GfxHandles gltf_node_handles_;
     GfxArray<GltfAnimation> gltf_animations_;
     GfxArray<GltfSkin> gltf_skins_;
-
-    GfxArray<GfxAnimation> animations_;
+    GfxArray<GltfAnimationState> gltf_animation_states_;
+    std::vector<float> animation_mask_weights_;     // per-node scratch for masked animation layers
+    std::vector<glm::dvec2> animation_blend_weights_;   // per-node and per-channel type scratch for normalizing animation layers
+    std::vector<uint32_t> animation_node_owners_;   // per-node and per-skin scratch for partitioning animation batches
+    std::vector<uint32_t> animation_skin_owners_;
+    std::vector<uint64_t> animation_root_nodes_;
+    std::vector<GfxRef<GfxSkin>> animation_skins_;
+
+    GfxSlotMap<GfxAnimation> animations_;
     GfxArray<uint64_t> animation_refs_;
     GfxArray<GfxMetadata> animation_metadata_;
-    GfxHandles animation_handles_;
 
-    GfxArray<GfxSkin> skins_;
+    GfxSlotMap<GfxSkin> skins_;
     GfxArray<uint64_t> skin_refs_;
     GfxArray<GfxMetadata> skin_metadata_;
-    GfxHandles skin_handles_;
 
-    GfxArray<GfxCamera> cameras_;
+    GfxSlotMap<GfxCamera> cameras_;
     GfxArray<uint64_t> camera_refs_;
     GfxArray<GfxMetadata> camera_metadata_;
     GfxRef<GfxCamera> active_camera_;
-    GfxHandles camera_handles_;
 
-    GfxArray<GfxLight> lights_;
+    GfxSlotMap<GfxLight> lights_;
     GfxArray<uint64_t> light_refs_;
     GfxArray<GfxMetadata> light_metadata_;
-    GfxHandles light_handles_;
 
-    GfxArray<GfxImage> images_;
+    GfxSlotMap<GfxImage> images_;
     GfxArray<uint64_t> image_refs_;
     GfxArray<GfxMetadata> image_metadata_;
-    GfxHandles image_handles_;
 
-    GfxArray<GfxMaterial> materials_;
+    GfxSlotMap<GfxMaterial> materials_;
     GfxArray<uint64_t> material_refs_;
     GfxArray<GfxMetadata> material_metadata_;
-    GfxHandles material_handles_;
 
-    GfxArray<GfxMesh> meshes_;
+    GfxSlotMap<GfxMesh> meshes_;
     GfxArray<uint64_t> mesh_refs_;
     GfxArray<GfxMetadata> mesh_metadata_;
-    GfxHandles mesh_handles_;
 
-    GfxArray<GfxInstance> instances_;
+    GfxSlotMap<GfxInstance> instances_;
     GfxArray<uint64_t> instance_refs_;
     GfxArray<GfxMetadata> instance_metadata_;
-    GfxHandles instance_handles_;
+    std::vector<uint64_t> modified_instances_;      // instances whose transform changed since the last clear
+    std::vector<uint64_t> modified_instance_slots_; // per-instance, the handle it was listed under, or 0
 
-    static GfxArray<GfxScene> scenes_;
-    static GfxHandles scene_handles_;
+    GfxSlotMap<GfxAnimationState> animation_states_;
+    GfxArray<uint64_t> animation_state_refs_;
+    GfxArray<GfxMetadata> animation_state_metadata_;
 
-    template<typename TYPE> GfxArray<TYPE> &objects_();
+    static GfxSlotMap<GfxScene> scenes_;
+
+    template<typename TYPE> GfxSlotMap<TYPE> &objects_();
     template<typename TYPE> GfxArray<uint64_t> &object_refs_();
     template<typename TYPE> GfxArray<GfxMetadata> &object_metadata_();
-    template<typename TYPE> GfxHandles &object_handles_();
 
-    template<> inline GfxArray<GfxAnimation> &objects_<GfxAnimation>() { return animations_; }
+    template<> inline GfxSlotMap<GfxAnimation> &objects_<GfxAnimation>() { return animations_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxAnimation>() { return animation_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxAnimation>() { return animation_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxAnimation>() { return animation_handles_; }
 
-    template<> inline GfxArray<GfxSkin> &objects_<GfxSkin>() { return skins_; }
+    template<> inline GfxSlotMap<GfxSkin> &objects_<GfxSkin>() { return skins_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxSkin>() { return skin_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxSkin>() { return skin_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxSkin>() { return skin_handles_; }
 
-    template<> inline GfxArray<GfxCamera> &objects_<GfxCamera>() { return cameras_; }
+    template<> inline GfxSlotMap<GfxCamera> &objects_<GfxCamera>() { return cameras_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxCamera>() { return camera_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxCamera>() { return camera_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxCamera>() { return camera_handles_; }
 
-    template<> inline GfxArray<GfxLight>& objects_<GfxLight>() { return lights_; }
+    template<> inline GfxSlotMap<GfxLight> &objects_<GfxLight>() { return lights_; }
     template<> inline GfxArray<uint64_t>& object_refs_<GfxLight>() { return light_refs_; }
     template<> inline GfxArray<GfxMetadata>& object_metadata_<GfxLight>() { return light_metadata_; }
-    template<> inline GfxHandles& object_handles_<GfxLight>() { return light_handles_; }
 
-    template<> inline GfxArray<GfxImage> &objects_<GfxImage>() { return images_; }
+    template<> inline GfxSlotMap<GfxImage> &objects_<GfxImage>() { return images_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxImage>() { return image_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxImage>() { return image_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxImage>() { return image_handles_; }
 
-    template<> inline GfxArray<GfxMaterial> &objects_<GfxMaterial>() { return materials_; }
+    template<> inline GfxSlotMap<GfxMaterial> &objects_<GfxMaterial>() { return materials_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxMaterial>() { return material_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxMaterial>() { return material_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxMaterial>() { return material_handles_; }
 
-    template<> inline GfxArray<GfxMesh> &objects_<GfxMesh>() { return meshes_; }
+    template<> inline GfxSlotMap<GfxMesh> &objects_<GfxMesh>() { return meshes_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxMesh>() { return mesh_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxMesh>() { return mesh_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxMesh>() { return mesh_handles_; }
 
-    template<> inline GfxArray<GfxInstance> &objects_<GfxInstance>() { return instances_; }
+    template<> inline GfxSlotMap<GfxInstance> &objects_<GfxInstance>() { return instances_; }
     template<> inline GfxArray<uint64_t> &object_refs_<GfxInstance>() { return instance_refs_; }
     template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxInstance>() { return instance_metadata_; }
-    template<> inline GfxHandles &object_handles_<GfxInstance>() { return instance_handles_; }
+
+    template<> inline GfxSlotMap<GfxAnimationState> &objects_<GfxAnimationState>() { return animation_states_; }
+    template<> inline GfxArray<uint64_t> &object_refs_<GfxAnimationState>() { return animation_state_refs_; }
+    template<> inline GfxArray<GfxMetadata> &object_metadata_<GfxAnimationState>() { return animation_state_metadata_; }
 
 public:
-    GfxSceneInternal(GfxScene &scene) : gltf_node_handles_("gltf_node"), animation_handles_("animation"), skin_handles_("skin"), camera_handles_("camera")
-                                      , image_handles_("image"), material_handles_("material"), mesh_handles_("mesh"), instance_handles_("instance")
+    GfxSceneInternal(GfxScene &scene) : gltf_nodes_("gltf_node"), animations_("animation"), skins_("skin"), cameras_("camera")
+                                      , images_("image"), materials_("material"), meshes_("mesh"), instances_("instance")
+                                      , animation_states_("animation_state")
                                       { scene.handle = reinterpret_cast<uint64_t>(this); }
     ~GfxSceneInternal() { terminate(); }
 
@@ -280,6 +299,7 @@ public:
 
     GfxResult clear()
     {
+        clearObjects<GfxAnimationState>();
         clearObjects<GfxAnimation>();
         clearObjects<GfxSkin>();
         clearObjects<GfxCamera>();
@@ -289,25 +309,225 @@ public:
         clearObjects<GfxMesh>();
         clearObjects<GfxInstance>();
         clearNodes();
+        clearModifiedInstances();
 
         return kGfxResult_NoError;
     }
 
     GfxResult applyAnimation(uint64_t animation_handle, float time_in_seconds)
     {
-        if(!animation_handles_.has_handle(animation_handle))
+        if(!animations_.has_handle(animation_handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot apply animation of an invalid object");
         GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handle));
         if(gltf_animation == nullptr)
             return kGfxResult_NoError;
         applyAnimation(*gltf_animation, time_in_seconds);
         updateTransforms(*gltf_animation);
+        markInstancesModified(*gltf_animation);
+        return kGfxResult_NoError;
+    }
+
+    GfxResult applyAnimations(uint64_t const *animation_handles, float const *times_in_seconds, float const *weights, uint32_t animation_count, GfxAnimationLayer const *layers)
+    {
+        if(animation_count == 0)
+            return kGfxResult_NoError;  // nothing to apply
+        if(animation_handles == nullptr || times_in_seconds == nullptr)
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot apply animations without handles and times");
+        for(uint32_t i = 0; i < animation_count; ++i)
+            if(!animations_.has_handle(animation_handles[i]))
+                return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot apply animation of an invalid object");
+        // Start from the rest pose of every node that any of the animations touches
+        animation_root_nodes_.clear();
+        animation_skins_.clear();
+        for(uint32_t i = 0; i < animation_count; ++i)
+        {
+            GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handles[i]));
+            if(gltf_animation == nullptr) continue;
+            for(GltfAnimationChannel const &animation_channel : gltf_animation->channels_)
+            {
+                resetAnimatedNode(animation_channel);
+                if(!gltf_nodes_.has_handle(animation_channel.node_)) continue;
+                uint32_t const slot = GetAnimationBlendSlot(animation_channel);
+                if(slot >= animation_blend_weights_.size())
+                    animation_blend_weights_.resize(slot + 1);
+                animation_blend_weights_[slot] = glm::dvec2(0.0);
+            }
+            for(uint64_t node_handle : gltf_animation->animated_root_nodes_)
+                if(std::find(animation_root_nodes_.begin(), animation_root_nodes_.end(), node_handle) == animation_root_nodes_.end())
+                    animation_root_nodes_.push_back(node_handle);
+            for(GfxRef<GfxSkin> const &skin : gltf_animation->dependent_skins_)
+                if(std::find(animation_skins_.begin(), animation_skins_.end(), skin) == animation_skins_.end())
+                    animation_skins_.push_back(skin);
+        }
+        // Sum up the weights of the non-additive clips per channel, then blend each clip into the local poses,
+        // in order; these get normalized so that clips sharing a channel contribute in proportion to their
+        // weights, and the rest pose only fills in what remains when the weights add up to less than one
+        for(uint32_t pass = 0; pass < 2; ++pass)
+        for(uint32_t i = 0; i < animation_count; ++i)
+        {
+            GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handles[i]));
+            float const weight = (weights != nullptr ? weights[i] : 1.0f);
+            if(gltf_animation == nullptr || weight <= 0.0f) continue;
+            GfxAnimationLayer const layer = (layers != nullptr ? layers[i] : GfxAnimationLayer());
+            GltfSkin const *mask_skin = (layer.mask_skin_handle != 0 && layer.mask_weights != nullptr &&
+                skins_.has_handle(layer.mask_skin_handle) ? gltf_skins_.at(GetObjectIndex(layer.mask_skin_handle)) : nullptr);
+            if(mask_skin != nullptr)
+                for(size_t j = 0; j < mask_skin->joints_.size(); ++j)
+                {
+                    uint32_t const node_index = GetObjectIndex(mask_skin->joints_[j]);
+                    if(node_index >= animation_mask_weights_.size())
+                        animation_mask_weights_.resize(node_index + 1, 1.0f);
+                    animation_mask_weights_[node_index] = layer.mask_weights[j];
+                }
+            for(GltfAnimationChannel const &animation_channel : gltf_animation->channels_)
+            {
+                if(!gltf_nodes_.has_handle(animation_channel.node_)) continue;
+                uint32_t const node_index = GetObjectIndex(animation_channel.node_);
+                double const node_weight = (double)weight * (mask_skin != nullptr && node_index < animation_mask_weights_.size() ? animation_mask_weights_[node_index] : 1.0f);
+                if(node_weight <= 0.0) continue;
+                if(layer.additive)
+                {
+                    if(pass == 1) blendAnimationChannel(animation_channel, times_in_seconds[i], node_weight, true);
+                    continue;   // additive clips aren't normalized
+                }
+                glm::dvec2 &blend_weights = animation_blend_weights_[GetAnimationBlendSlot(animation_channel)];  // (total, accumulated)
+                if(pass == 0)
+                {
+                    blend_weights.x += node_weight;
+                    continue;   // only summing up
+                }
+                double const blended_weight = GFX_MAX(1.0 - blend_weights.x, 0.0) + blend_weights.y;  // rest pose and previous clips
+                blend_weights.y += node_weight;
+                blendAnimationChannel(animation_channel, times_in_seconds[i], node_weight / (blended_weight + node_weight), false);
+            }
+            if(mask_skin != nullptr)
+                for(size_t j = 0; j < mask_skin->joints_.size(); ++j)
+                    animation_mask_weights_[GetObjectIndex(mask_skin->joints_[j])] = 1.0f;
+        }
+        // And propagate the transforms down the hierarchy a single time
+        updateTransforms(animation_root_nodes_.data(), animation_root_nodes_.size(), animation_skins_.data(), animation_skins_.size());
+        for(uint32_t i = 0; i < animation_count; ++i)
+        {
+            GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handles[i]));
+            if(gltf_animation != nullptr)
+                markInstancesModified(*gltf_animation);
+        }
+        return kGfxResult_NoError;
+    }
+
+    GfxResult applyAnimationBatch(uint64_t const *animation_handles, float const *times_in_seconds, uint32_t animation_count, uint32_t thread_count)
+    {
+        if(animation_count == 0)
+            return kGfxResult_NoError;  // nothing to apply
+        if(animation_handles == nullptr || times_in_seconds == nullptr)
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot apply animations without handles and times");
+        for(uint32_t i = 0; i < animation_count; ++i)
+            if(!animations_.has_handle(animation_handles[i]))
+                return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot apply animation of an invalid object");
+        // Merge the animations that write (or read) the same nodes or skins into groups; a group is
+        // applied in order on a single thread so the result doesn't depend on the scheduling
+        std::vector<uint32_t> group_parents(animation_count);
+        std::vector<uint32_t> claimed_nodes, claimed_skins, node_stack;
+        auto const FindGroup = [&](uint32_t i)
+        {
+            while(group_parents[i] != i)
+                i = group_parents[i] = group_parents[group_parents[i]];
+            return i;
+        };
+        auto const Claim = [&](std::vector<uint32_t> &owners, std::vector<uint32_t> &claimed, uint32_t index, uint32_t i)
+        {
+            if(index >= owners.size())
+                owners.resize(index + 1, 0xFFFFFFFFu);
+            if(owners[index] == 0xFFFFFFFFu)
+            {
+                owners[index] = i;
+                claimed.push_back(index);
+                return;
+            }
+            uint32_t const lhs = FindGroup(owners[index]), rhs = FindGroup(i);
+            if(lhs != rhs) group_parents[GFX_MAX(lhs, rhs)] = GFX_MIN(lhs, rhs);   // keep the first animation as the group root
+        };
+        for(uint32_t i = 0; i < animation_count; ++i)
+        {
+            group_parents[i] = i;
+            GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handles[i]));
+            if(gltf_animation == nullptr) continue;
+            for(GltfAnimationChannel const &animation_channel : gltf_animation->channels_)
+                if(gltf_nodes_.has_handle(animation_channel.node_))
+                    Claim(animation_node_owners_, claimed_nodes, GetObjectIndex(animation_channel.node_), i);
+            for(uint64_t root_node : gltf_animation->animated_root_nodes_)
+            {
+                if(!gltf_nodes_.has_handle(root_node)) continue;
+                uint64_t const parent_node = gltf_nodes_[GetObjectIndex(root_node)].parent_;
+                if(parent_node != 0 && gltf_nodes_.has_handle(parent_node))
+                    Claim(animation_node_owners_, claimed_nodes, GetObjectIndex(parent_node), i);
+                node_stack.push_back(GetObjectIndex(root_node));
+                while(!node_stack.empty())
+                {
+                    uint32_t const node_index = node_stack.back();
+                    node_stack.pop_back();
+                    Claim(animation_node_owners_, claimed_nodes, node_index, i);
+                    for(uint64_t child_node : gltf_nodes_[node_index].children_)
+                        if(gltf_nodes_.has_handle(child_node))
+                            node_stack.push_back(GetObjectIndex(child_node));
+                }
+            }
+            for(GfxRef<GfxSkin> const &skin : gltf_animation->dependent_skins_)
+            {
+                Claim(animation_skin_owners_, claimed_skins, GetObjectIndex(skin), i);
+                GltfSkin const *gltf_skin = gltf_skins_.at(GetObjectIndex(skin));
+                if(gltf_skin != nullptr)
+                    for(uint64_t joint_node : gltf_skin->joints_)
+                        if(gltf_nodes_.has_handle(joint_node))
+                            Claim(animation_node_owners_, claimed_nodes, GetObjectIndex(joint_node), i);
+            }
+        }
+        for(uint32_t node_index : claimed_nodes) animation_node_owners_[node_index] = 0xFFFFFFFFu;
+        for(uint32_t skin_index : claimed_skins) animation_skin_owners_[skin_index] = 0xFFFFFFFFu;
+        // Lay the groups out contiguously, ordered by their first animation
+        std::vector<uint32_t> group_offsets(animation_count + 1, 0), group_animations(animation_count);
+        for(uint32_t i = 0; i < animation_count; ++i)
+            ++group_offsets[FindGroup(i) + 1];
+        for(uint32_t i = 0; i < animation_count; ++i)
+            group_offsets[i + 1] += group_offsets[i];
+        {
+            std::vector<uint32_t> group_cursors(group_offsets.begin(), group_offsets.end() - 1);
+            for(uint32_t i = 0; i < animation_count; ++i)
+                group_animations[group_cursors[FindGroup(i)]++] = i;
+        }
+        std::vector<uint32_t> groups;
+        for(uint32_t i = 0; i < animation_count; ++i)
+            if(group_offsets[i + 1] > group_offsets[i])
+                groups.push_back(i);
+        // Split the groups into one chunk per thread; a chunk runs as a single job, so no more than
+        // `thread_count' threads work on the batch at once (one job per group when left unbounded)
+        uint32_t const group_count = (uint32_t)groups.size();
+        uint32_t const chunk_count = (thread_count == 0 ? group_count : GFX_MIN(thread_count, group_count));
+        gfxGetJobSystem().parallel_for(chunk_count, 1, [&](uint32_t chunk)
+        {
+            uint32_t const end = (uint32_t)(((uint64_t)group_count * (chunk + 1)) / chunk_count);
+            for(uint32_t group = (uint32_t)(((uint64_t)group_count * chunk) / chunk_count); group < end; ++group)
+                for(uint32_t j = group_offsets[groups[group]]; j < group_offsets[groups[group] + 1]; ++j)
+                {
+                    uint32_t const i = group_animations[j];
+                    GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handles[i]));
+                    if(gltf_animation == nullptr) continue;
+                    applyAnimation(*gltf_animation, times_in_seconds[i]);
+                    updateTransforms(*gltf_animation);
+                }
+        });
+        for(uint32_t i = 0; i < animation_count; ++i)
+        {
+            GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handles[i]));
+            if(gltf_animation != nullptr)
+                markInstancesModified(*gltf_animation);
+        }
         return kGfxResult_NoError;
     }
 
     GfxResult resetAnimation(uint64_t animation_handle)
     {
-        if(!animation_handles_.has_handle(animation_handle))
+        if(!animations_.has_handle(animation_handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot reset animation of an invalid object");
         GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handle));
         if(gltf_animation != nullptr)
@@ -315,7 +535,7 @@ public:
             std::function<void(uint64_t, glm::dmat4 const &)> VisitNode;
             VisitNode = [&](uint64_t node_handle, glm::dmat4 const &parent_transform)
             {
-                if(!gltf_node_handles_.has_handle(node_handle)) return;
+                if(!gltf_nodes_.has_handle(node_handle)) return;
                 GltfNode const &node = gltf_nodes_[GetObjectIndex(node_handle)];
                 glm::dmat4 const transform = parent_transform * node.default_local_transform_;
                 for(size_t i = 0; i < node.children_.size(); ++i)
@@ -330,18 +550,19 @@ public:
             };
             for(size_t i = 0; i < gltf_animation->animated_root_nodes_.size(); ++i)
                 VisitNode(gltf_animation->animated_root_nodes_[i], glm::dmat4(1.0));
+            markInstancesModified(*gltf_animation);
             for(size_t i = 0; i < gltf_animation->channels_.size(); ++i)
             {
                 GltfAnimationChannel const &channel = gltf_animation->channels_[i];
-                if(!gltf_node_handles_.has_handle(channel.node_) || (channel.type_ != kGltfAnimationChannelType_Weights)) continue;
+                if(!gltf_nodes_.has_handle(channel.node_) || (channel.type_ != kGltfAnimationChannelType_Weights)) continue;
                 GltfNode const &node = gltf_nodes_[GetObjectIndex(channel.node_)];
                 for(size_t j = 0; j < node.instances_.size(); ++j)
                 {
                     if(!node.instances_[j]) continue;
                     if(!node.default_weights_.empty())
-                        node.instances_[j]->weights = node.default_weights_;
+                        node.instances_[j]->weights.assign(node.default_weights_.begin(), node.default_weights_.end());
                     else if(!node.instances_[j]->mesh->default_weights.empty())
-                        node.instances_[j]->weights = node.instances_[j]->mesh->default_weights;
+                        node.instances_[j]->weights.assign(node.instances_[j]->mesh->default_weights.begin(), node.instances_[j]->mesh->default_weights.end());
                     else
                         std::fill(node.instances_[j]->weights.begin(), node.instances_[j]->weights.end(), 0.0f);
                 }
@@ -363,7 +584,7 @@ public:
 
     float getAnimationLength(uint64_t animation_handle)
     {
-        if(!animation_handles_.has_handle(animation_handle))
+        if(!animations_.has_handle(animation_handle))
         {
             GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot get the duration of an invalid animation object");
             return 0.0f;    // invalid operation
@@ -377,6 +598,170 @@ public:
         return animation_length;
     }
 
+    GfxRef<GfxAnimationState> createAnimationState(GfxScene const &scene, uint64_t animation_handle)
+    {
+        GfxRef<GfxAnimationState> animation_state_ref = {};
+        if(!animations_.has_handle(animation_handle))
+        {
+            GFX_PRINT_ERROR(kGfxResult_InvalidOperation, "Cannot create animation state from an invalid animation object");
+            return animation_state_ref; // invalid operation
+        }
+        animation_state_ref = createObject<GfxAnimationState>(scene);
+        GfxAnimationState &animation_state = animation_states_[GetObjectIndex(animation_state_ref)];
+        GltfAnimationState &gltf_animation_state = gltf_animation_states_.insert(GetObjectIndex(animation_state_ref));
+        GfxRef<GfxAnimation> animation_ref;
+        animation_ref.handle = animation_handle;
+        animation_ref.scene = scene;
+        animation_state.animation = animation_ref;
+        GfxMetadata &animation_state_metadata = animation_state_metadata_[GetObjectIndex(animation_state_ref)];
+        animation_state_metadata = animation_metadata_[GetObjectIndex(animation_handle)];   // set up metadata
+        animation_state_metadata.is_valid = true;
+        GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(animation_handle));
+        if(gltf_animation == nullptr)
+            return animation_state_ref; // not a glTF animation, nothing to copy
+        // Gather the animated subtrees, along with the nodes instancing any of the skins the clip deforms
+        GfxHashMap<uint64_t, uint32_t> node_indices;
+        std::vector<std::pair<uint64_t, uint32_t>> node_stack;
+        auto const AddHierarchy = [&](uint64_t root_node)
+        {
+            node_stack.push_back(std::make_pair(root_node, 0xFFFFFFFFu));
+            while(!node_stack.empty())
+            {
+                std::pair<uint64_t, uint32_t> const node_entry = node_stack.back();
+                node_stack.pop_back();
+                if(!gltf_nodes_.has_handle(node_entry.first) || node_indices.has(node_entry.first)) continue;
+                uint32_t const node_index = (uint32_t)gltf_animation_state.nodes_.size();
+                node_indices.insert(node_entry.first, node_index);
+                gltf_animation_state.nodes_.push_back(node_entry.first);
+                gltf_animation_state.parents_.push_back(node_entry.second);
+                GltfNode const &node = gltf_nodes_[GetObjectIndex(node_entry.first)];
+                for(size_t i = node.children_.size(); i-- > 0;)
+                    node_stack.push_back(std::make_pair(node.children_[i], node_index));
+            }
+        };
+        for(uint64_t root_node : gltf_animation->animated_root_nodes_)
+            AddHierarchy(root_node);
+        if(!gltf_animation->dependent_skins_.empty())
+        {
+            std::vector<uint64_t> skinned_nodes, visit_stack(scene_gltf_nodes_.rbegin(), scene_gltf_nodes_.rend());
+            while(!visit_stack.empty())
+            {
+                uint64_t const node_handle = visit_stack.back();
+                visit_stack.pop_back();
+                if(!gltf_nodes_.has_handle(node_handle)) continue;
+                GltfNode const &node = gltf_nodes_[GetObjectIndex(node_handle)];
+                if(!node.instances_.empty() && std::find(gltf_animation->dependent_skins_.begin(),
+                    gltf_animation->dependent_skins_.end(), node.skin_) != gltf_animation->dependent_skins_.end())
+                    skinned_nodes.push_back(node_handle);
+                for(size_t i = node.children_.size(); i-- > 0;)
+                    visit_stack.push_back(node.children_[i]);
+            }
+            for(uint64_t node_handle : skinned_nodes)
+                AddHierarchy(node_handle);
+        }
+        // Each state starts from the rest pose and owns its local poses and world transforms
+        uint32_t const node_count = (uint32_t)gltf_animation_state.nodes_.size();
+        gltf_animation_state.node_poses_.resize(node_count, 0xFFFFFFFFu);
+        gltf_animation_state.world_transforms_.resize(node_count);
+        for(uint32_t i = 0; i < node_count; ++i)
+        {
+            uint64_t const node_handle = gltf_animation_state.nodes_[i];
+            gltf_animation_state.world_transforms_[i] = gltf_nodes_[GetObjectIndex(node_handle)].world_transform_;
+            GltfAnimatedNode const *animated_node = gltf_animated_nodes_.at(GetObjectIndex(node_handle));
+            if(animated_node == nullptr) continue;
+            gltf_animation_state.node_poses_[i] = (uint32_t)gltf_animation_state.poses_.size();
+            GltfAnimatedNode &pose = gltf_animation_state.poses_.emplace_back(*animated_node);
+            pose.translate_ = pose.default_translate_;
+            pose.rotate_ = pose.default_rotate_;
+            pose.scale_ = pose.default_scale_;
+        }
+        gltf_animation_state.channel_nodes_.resize(gltf_animation->channels_.size(), 0xFFFFFFFFu);
+        for(size_t i = 0; i < gltf_animation->channels_.size(); ++i)
+        {
+            GfxHashMap<uint64_t, uint32_t>::const_iterator const it = node_indices.find(gltf_animation->channels_[i].node_);
+            if(it != node_indices.end())
+                gltf_animation_state.channel_nodes_[i] = (*it).second;
+        }
+        // Copy the skins, which are then owned by the state...
+        gltf_animation_state.skin_joints_.push_back(0);
+        for(GfxRef<GfxSkin> const &source_skin : gltf_animation->dependent_skins_)
+        {
+            GltfSkin const *gltf_skin = gltf_skins_.at(GetObjectIndex(source_skin));
+            if(!skins_.has_handle(source_skin) || gltf_skin == nullptr) continue;
+            GfxRef<GfxSkin> const skin_ref = createObject<GfxSkin>(scene);
+            skins_[GetObjectIndex(skin_ref)] = skins_[GetObjectIndex(source_skin)];
+            skin_metadata_[GetObjectIndex(skin_ref)] = skin_metadata_[GetObjectIndex(source_skin)];
+            animation_state.skins.push_back(skin_ref);
+            gltf_animation_state.source_skins_.push_back(source_skin);
+            for(uint64_t joint_node : gltf_skin->joints_)
+            {
+                GfxHashMap<uint64_t, uint32_t>::const_iterator const it = node_indices.find(joint_node);
+                gltf_animation_state.joints_.push_back(it != node_indices.end() ? (*it).second : 0xFFFFFFFFu);
+            }
+            gltf_animation_state.skin_joints_.push_back((uint32_t)gltf_animation_state.joints_.size());
+        }
+        // ...as well as the instances, sharing their meshes and materials with the imported ones
+        gltf_animation_state.node_instances_.reserve(node_count + 1);
+        for(uint32_t i = 0; i < node_count; ++i)
+        {
+            gltf_animation_state.node_instances_.push_back((uint32_t)animation_state.instances.size());
+            GltfNode const &node = gltf_nodes_[GetObjectIndex(gltf_animation_state.nodes_[i])];
+            for(GfxRef<GfxInstance> const &source_instance : node.instances_)
+            {
+                if(!instances_.has_handle(source_instance)) continue;
+                GfxRef<GfxInstance> const instance_ref = createObject<GfxInstance>(scene);
+                GfxInstance &instance = instances_[GetObjectIndex(instance_ref)];
+                instance = instances_[GetObjectIndex(source_instance)];
+                instance_metadata_[GetObjectIndex(instance_ref)] = instance_metadata_[GetObjectIndex(source_instance)];
+                for(size_t j = 0; j < gltf_animation_state.source_skins_.size(); ++j)
+                    if((uint64_t)instance.skin == gltf_animation_state.source_skins_[j])
+                        instance.skin = animation_state.skins[j];
+                animation_state.instances.push_back(instance_ref);
+            }
+        }
+        gltf_animation_state.node_instances_.push_back((uint32_t)animation_state.instances.size());
+        return animation_state_ref;
+    }
+
+    GfxResult applyAnimationState(uint64_t animation_state_handle, float time_in_seconds)
+    {
+        if(!animation_states_.has_handle(animation_state_handle))
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot apply animation state of an invalid object");
+        GltfAnimationState *gltf_animation_state = gltf_animation_states_.at(GetObjectIndex(animation_state_handle));
+        if(gltf_animation_state != nullptr)
+        {
+            GfxAnimationState &animation_state = animation_states_[GetObjectIndex(animation_state_handle)];
+            applyAnimationState(animation_state, *gltf_animation_state, time_in_seconds);
+            markInstancesModified(animation_state);
+        }
+        return kGfxResult_NoError;
+    }
+
+    GfxResult applyAnimationStates(uint64_t const *animation_state_handles, float const *times_in_seconds, uint32_t animation_state_count)
+    {
+        if(animation_state_count == 0)
+            return kGfxResult_NoError;  // nothing to apply
+        if(animation_state_handles == nullptr || times_in_seconds == nullptr)
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot apply animation states without handles and times");
+        for(uint32_t i = 0; i < animation_state_count; ++i)
+            if(!animation_states_.has_handle(animation_state_handles[i]))
+                return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot apply animation state of an invalid object");
+        std::vector<uint64_t> sorted_handles(animation_state_handles, animation_state_handles + animation_state_count);
+        std::sort(sorted_handles.begin(), sorted_handles.end());
+        if(std::adjacent_find(sorted_handles.begin(), sorted_handles.end()) != sorted_handles.end())
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot apply the same animation state more than once per call");
+        // States only read the shared clips and nodes, and write to the poses, instances and skins they own
+        gfxGetJobSystem().parallel_for(animation_state_count, 1, [&](uint32_t i)
+        {
+            GltfAnimationState *gltf_animation_state = gltf_animation_states_.at(GetObjectIndex(animation_state_handles[i]));
+            if(gltf_animation_state != nullptr)
+                applyAnimationState(animation_states_[GetObjectIndex(animation_state_handles[i])], *gltf_animation_state, times_in_seconds[i]);
+        });
+        for(uint32_t i = 0; i < animation_state_count; ++i)
+            markInstancesModified(animation_states_[GetObjectIndex(animation_state_handles[i])]);
+        return kGfxResult_NoError;
+    }
+
     GfxResult setActiveCamera(GfxScene const &scene, uint64_t camera_handle)
     {
         active_camera_.handle = camera_handle;
@@ -390,11 +775,50 @@ public:
         return active_camera_;
     }
 
+    GfxResult markInstanceModified(uint64_t instance_handle)
+    {
+        if(!instances_.has_handle(instance_handle))
+            return GFX_SET_ERROR(kGfxResult_InvalidParameter, "Cannot mark an invalid instance object as modified");
+        recordModifiedInstance(instance_handle);
+        return kGfxResult_NoError;
+    }
+
+    void markInstancesModified(GltfAnimation const &gltf_animation)
+    {
+        for(uint64_t instance_handle : gltf_animation.animated_instances_)
+            recordModifiedInstance(instance_handle);
+    }
+
+    void markInstancesModified(GfxAnimationState const &animation_state)
+    {
+        for(GfxRef<GfxInstance> const &instance : animation_state.instances)
+            recordModifiedInstance(instance);
+    }
+
+    uint32_t getModifiedInstanceCount() const
+    {
+        return (uint32_t)modified_instances_.size();
+    }
+
+    uint64_t const *getModifiedInstances() const
+    {
+        return modified_instances_.data();
+    }
+
+    GfxResult clearModifiedInstances()
+    {
+        for(uint64_t instance_handle : modified_instances_)
+            if(modified_instance_slots_[GetObjectIndex(instance_handle)] == instance_handle)
+                modified_instance_slots_[GetObjectIndex(instance_handle)] = 0;
+        modified_instances_.clear();
+        return kGfxResult_NoError;
+    }
+
     template<typename TYPE>
     GfxRef<TYPE> createObject(GfxScene const &scene)
     {
         GfxRef<TYPE> object_ref = {};
-        object_ref.handle = object_handles_<TYPE>().allocate_handle();
+        object_ref.handle = objects_<TYPE>().allocate_handle();
         object_refs_<TYPE>().insert(GetObjectIndex(object_ref.handle), object_ref.handle);
         object_metadata_<TYPE>().insert(GetObjectIndex(object_ref.handle)).is_valid = true;
         objects_<TYPE>().insert(GetObjectIndex(object_ref.handle)) = {};
@@ -408,7 +832,7 @@ public:
     template<>
     GfxResult destroyObjectCallback<GfxAnimation>(uint64_t object_handle)
     {
-        GFX_ASSERT(animation_handles_.has_handle(object_handle));
+        GFX_ASSERT(animations_.has_handle(object_handle));
         GltfAnimation const *gltf_animation = gltf_animations_.at(GetObjectIndex(object_handle));
         if(gltf_animation != nullptr)
             gltf_animations_.erase(GetObjectIndex(object_handle));
@@ -418,25 +842,42 @@ public:
     template<>
     GfxResult destroyObjectCallback<GfxSkin>(uint64_t object_handle)
     {
-        GFX_ASSERT(skin_handles_.has_handle(object_handle));
+        GFX_ASSERT(skins_.has_handle(object_handle));
         GltfSkin const *gltf_skin = gltf_skins_.at(GetObjectIndex(object_handle));
         if(gltf_skin != nullptr)
             gltf_skins_.erase(GetObjectIndex(object_handle));
         return kGfxResult_NoError;
     }
 
+    template<>
+    GfxResult destroyObjectCallback<GfxAnimationState>(uint64_t object_handle)
+    {
+        GFX_ASSERT(animation_states_.has_handle(object_handle));
+        GfxAnimationState const &animation_state = animation_states_[GetObjectIndex(object_handle)];
+        for(GfxRef<GfxInstance> const &instance : animation_state.instances)
+            if(instances_.has_handle(instance))
+                destroyObject<GfxInstance>(instance);   // release copied instances
+        for(GfxRef<GfxSkin> const &skin : animation_state.skins)
+            if(skins_.has_handle(skin))
+                destroyObject<GfxSkin>(skin);   // release copied skins
+        GltfAnimationState const *gltf_animation_state = gltf_animation_states_.at(GetObjectIndex(object_handle));
+        if(gltf_animation_state != nullptr)
+            gltf_animation_states_.erase(GetObjectIndex(object_handle));
+        return kGfxResult_NoError;
+    }
+
     template<typename TYPE>
     GfxResult destroyObject(uint64_t object_handle)
     {
         if(object_handle == 0)
             return kGfxResult_NoError;
-        if(!object_handles_<TYPE>().has_handle(object_handle))
+        if(!objects_<TYPE>().has_handle(object_handle))
             return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Cannot destroy invalid scene object");
         destroyObjectCallback<TYPE>(object_handle);
         objects_<TYPE>().erase(GetObjectIndex(object_handle));
         object_refs_<TYPE>().erase(GetObjectIndex(object_handle));
         object_metadata_<TYPE>().erase(GetObjectIndex(object_handle));
-        object_handles_<TYPE>().free_handle(object_handle);
+        objects_<TYPE>().free_handle(object_handle);
         return kGfxResult_NoError;
     }
 
@@ -453,11 +894,11 @@ public:
         std::function<void(uint64_t)> VisitNode;
         VisitNode = [&](uint64_t node_handle)
         {
-            if(!gltf_node_handles_.has_handle(node_handle)) return;
+            if(!gltf_nodes_.has_handle(node_handle)) return;
             GltfNode const &node = gltf_nodes_[GetObjectIndex(node_handle)];
             for(uint64_t child_handle : node.children_)
                 VisitNode(child_handle);   // release child nodes
-            gltf_node_handles_.free_handle(node_handle);
+            gltf_nodes_.free_handle(node_handle);
             gltf_nodes_.erase(GetObjectIndex(node_handle));
             if(gltf_animated_nodes_.has(GetObjectIndex(node_handle)))
                 gltf_animated_nodes_.erase(GetObjectIndex(node_handle));
@@ -483,9 +924,7 @@ public:
     template<typename TYPE>
     TYPE *getObject(uint64_t object_handle)
     {
-        if(!object_handles_<TYPE>().has_handle(object_handle))
-            return nullptr; // invalid object handle
-        return objects_<TYPE>().at(GetObjectIndex(object_handle));
+        return objects_<TYPE>().get(object_handle);
     }
 
     template<typename TYPE>
@@ -503,7 +942,7 @@ public:
     GfxMetadata const &getObjectMetadata(uint64_t object_handle)
     {
         static GfxMetadata const metadata = {};
-        if(!object_handles_<TYPE>().has_handle(object_handle))
+        if(!objects_<TYPE>().has_handle(object_handle))
             return metadata;    // invalid object handle
         return object_metadata_<TYPE>()[GetObjectIndex(object_handle)];
     }
@@ -511,7 +950,7 @@ public:
     template<typename TYPE>
     bool setObjectMetadata(uint64_t object_handle, GfxMetadata const &metadata)
     {
-        if(!object_handles_<TYPE>().has_handle(object_handle))
+        if(!objects_<TYPE>().has_handle(object_handle))
             return false;   // invalid object handle
         GfxMetadata &object_metadata = object_metadata_<TYPE>()[GetObjectIndex(object_handle)];
         object_metadata = metadata; // commit metadata
@@ -916,8 +1355,8 @@ private:
         if(accessor == nullptr) return true;
         GFX_ASSERT(sizeof(T) == cgltf_num_components(accessor->type) * sizeof(float));
         buffer.resize(accessor->count);
-        cgltf_size floats_size = cgltf_num_components(accessor->type) * accessor->count;
-        if(cgltf_accessor_unpack_floats(accessor, (float*)&buffer[0], floats_size) < floats_size)
+        if(buffer.empty()) return true;
+        if(!gfxGltfUnpackAccessor(accessor, (float *)&buffer[0]))
         {
             GFX_PRINT_ERROR(kGfxResult_InternalError, "Failed to unpack sparse accessor");
             return false;
@@ -925,26 +1364,180 @@ private:
         return true;
     };
 
+    static inline bool UnpackIndices(cgltf_accessor const *accessor, std::vector<uint32_t> &indices)
+    {
+        indices.resize(accessor->count);
+        uint8_t const *data = gfxGltfGetAccessorData(accessor);
+        if(data != nullptr && cgltf_num_components(accessor->type) == 1)
+            switch(accessor->component_type)
+            {
+            case cgltf_component_type_r_8u:
+                for(cgltf_size i = 0; i < accessor->count; ++i)
+                    indices[i] = data[i * accessor->stride];
+                return true;
+            case cgltf_component_type_r_16u:
+                for(cgltf_size i = 0; i < accessor->count; ++i)
+                {
+                    uint16_t index; memcpy(&index, &data[i * accessor->stride], sizeof(index));
+                    indices[i] = index;
+                }
+                return true;
+            case cgltf_component_type_r_32u:
+                if(accessor->stride == sizeof(uint32_t))
+                    memcpy(indices.data(), data, accessor->count * sizeof(uint32_t));   // tightly packed
+                else
+                    for(cgltf_size i = 0; i < accessor->count; ++i)
+                        memcpy(&indices[i], &data[i * accessor->stride], sizeof(uint32_t));
+                return true;
+            default:
+                break;  // fall back to cgltf
+            }
+        for(cgltf_size i = 0; i < accessor->count; ++i)
+            if(!cgltf_accessor_read_uint(accessor, i, &indices[i], 1))
+                return false;
+        return true;
+    }
+
+    static inline double FindAnimationKeyframes(GltfAnimationChannel const &animation_channel, float time_in_seconds, size_t &previous_index, size_t &next_index)
+    {
+        intptr_t const keyframe = std::lower_bound(animation_channel.keyframes_.begin(),
+            animation_channel.keyframes_.end(), time_in_seconds) - animation_channel.keyframes_.begin();
+        previous_index = std::max(keyframe - 1, 0ll);
+        next_index = std::min(keyframe, (intptr_t)animation_channel.keyframes_.size() - 1);
+        double interpolate = 0.0;
+        if((animation_channel.mode_ == kGltfAnimationChannelMode_Linear) && (previous_index != next_index))
+        {
+            interpolate = ((double)time_in_seconds - (double)animation_channel.keyframes_[keyframe - 1]) /
+                ((double)animation_channel.keyframes_[keyframe] - (double)animation_channel.keyframes_[keyframe - 1]);
+        }
+        return interpolate;
+    }
+
+    static inline glm::dvec3 SampleAnimationVector(GltfAnimationChannel const &animation_channel, size_t previous_index, size_t next_index, double interpolate)
+    {
+        glm::dvec3 value;
+        for(uint32_t j = 0; j < 3; ++j)
+            value[j] = glm::mix((double)animation_channel.values_[3 * previous_index + j],
+                (double)animation_channel.values_[3 * next_index + j], interpolate);
+        return value;
+    }
+
+    static inline glm::dquat SampleAnimationRotation(GltfAnimationChannel const &animation_channel, size_t previous_index, size_t next_index, double interpolate)
+    {
+        glm::dquat const previous = glm::dquat(animation_channel.values_[4 * previous_index + 3], animation_channel.values_[4 * previous_index],
+            animation_channel.values_[4 * previous_index + 1], animation_channel.values_[4 * previous_index + 2]);
+        glm::dquat const next = glm::dquat(animation_channel.values_[4 * next_index + 3], animation_channel.values_[4 * next_index],
+            animation_channel.values_[4 * next_index + 1], animation_channel.values_[4 * next_index + 2]);
+        return glm::slerp(previous, next, interpolate);
+    }
+
+    static uint32_t GetAnimationBlendSlot(GltfAnimationChannel const &animation_channel)
+    {
+        return GetObjectIndex(animation_channel.node_) * kGltfAnimationChannelType_Count + (uint32_t)animation_channel.type_;
+    }
+
+    void resetAnimatedNode(GltfAnimationChannel const &animation_channel)
+    {
+        if(!gltf_nodes_.has_handle(animation_channel.node_)) return;
+        if(animation_channel.type_ == kGltfAnimationChannelType_Weights)
+        {
+            GltfNode const &node = gltf_nodes_[GetObjectIndex(animation_channel.node_)];
+            for(size_t j = 0; j < node.instances_.size(); ++j)
+            {
+                if(!node.instances_[j]) continue;
+                if(!node.default_weights_.empty())
+                    node.instances_[j]->weights.assign(node.default_weights_.begin(), node.default_weights_.end());
+                else if(!node.instances_[j]->mesh->default_weights.empty())
+                    node.instances_[j]->weights.assign(node.instances_[j]->mesh->default_weights.begin(), node.instances_[j]->mesh->default_weights.end());
+                else
+                    std::fill(node.instances_[j]->weights.begin(), node.instances_[j]->weights.end(), 0.0f);
+            }
+            return;
+        }
+        GltfAnimatedNode *animated_node = gltf_animated_nodes_.at(GetObjectIndex(animation_channel.node_));
+        if(animated_node == nullptr) return;
+        animated_node->translate_ = animated_node->default_translate_;
+        animated_node->rotate_ = animated_node->default_rotate_;
+        animated_node->scale_ = animated_node->default_scale_;
+    }
+
+    // Blends the sampled channel into the current local pose; additive channels apply their motion
+    // relative to the first keyframe on top of it instead.
+    void blendAnimationChannel(GltfAnimationChannel const &animation_channel, float time_in_seconds, double weight, bool additive)
+    {
+        if(!gltf_nodes_.has_handle(animation_channel.node_) || animation_channel.keyframes_.empty()) return;
+        size_t previous_index, next_index;
+        double const interpolate = FindAnimationKeyframes(animation_channel, time_in_seconds, previous_index, next_index);
+        weight = GFX_MIN(weight, 1.0);
+        if(animation_channel.type_ == kGltfAnimationChannelType_Weights)
+        {
+            size_t const weights_count = animation_channel.values_.size() / animation_channel.keyframes_.size();
+            GltfNode const &node = gltf_nodes_[GetObjectIndex(animation_channel.node_)];
+            for(size_t j = 0; j < node.instances_.size(); ++j)
+            {
+                if(!node.instances_[j]) continue;
+                GfxSmallVector<float, 8> &instance_weights = node.instances_[j]->weights;
+                instance_weights.resize((uint32_t)weights_count, 0.0f);
+                for(size_t k = 0; k < weights_count; ++k)
+                {
+                    double const value = glm::mix((double)animation_channel.values_[previous_index * weights_count + k],
+                        (double)animation_channel.values_[next_index * weights_count + k], interpolate);
+                    if(additive)
+                        instance_weights[k] += (float)(weight * (value - (double)animation_channel.values_[k]));
+                    else
+                        instance_weights[k] = (float)glm::mix((double)instance_weights[k], value, weight);
+                }
+            }
+            return;
+        }
+        GltfAnimatedNode *animated_node = gltf_animated_nodes_.at(GetObjectIndex(animation_channel.node_));
+        if(animated_node == nullptr) return;
+        if(animation_channel.type_ == kGltfAnimationChannelType_Rotate)
+        {
+            glm::dquat const rotate = SampleAnimationRotation(animation_channel, previous_index, next_index, interpolate);
+            if(additive)
+            {
+                glm::dquat const delta = glm::inverse(SampleAnimationRotation(animation_channel, 0, 0, 0.0)) * rotate;
+                animated_node->rotate_ = glm::normalize(animated_node->rotate_ * glm::slerp(glm::dquat(1.0, 0.0, 0.0, 0.0), delta, weight));
+            }
+            else
+                animated_node->rotate_ = glm::normalize(glm::slerp(animated_node->rotate_, rotate, weight));
+            return;
+        }
+        glm::dvec3 const value = SampleAnimationVector(animation_channel, previous_index, next_index, interpolate);
+        if(animation_channel.type_ == kGltfAnimationChannelType_Translate)
+        {
+            if(additive)
+                animated_node->translate_ += weight * (value - SampleAnimationVector(animation_channel, 0, 0, 0.0));
+            else
+                animated_node->translate_ = glm::mix(animated_node->translate_, value, weight);
+        }
+        else if(animation_channel.type_ == kGltfAnimationChannelType_Scale)
+        {
+            if(additive)
+            {
+                glm::dvec3 const reference = SampleAnimationVector(animation_channel, 0, 0, 0.0);
+                for(uint32_t j = 0; j < 3; ++j)
+                    if(reference[j] != 0.0)
+                        animated_node->scale_[j] *= glm::mix(1.0, value[j] / reference[j], weight);
+            }
+            else
+                animated_node->scale_ = glm::mix(animated_node->scale_, value, weight);
+        }
+    }
+
     void applyAnimation(GltfAnimation const &gltf_animation, float time_in_seconds)
     {
         for(size_t i = 0; i < gltf_animation.channels_.size(); ++i)
         {
             GltfAnimationChannel const &animation_channel = gltf_animation.channels_[i];
-            if(!gltf_node_handles_.has_handle(animation_channel.node_)) continue;   // invalid target node
+            if(!gltf_nodes_.has_handle(animation_channel.node_)) continue;   // invalid target node
             GltfAnimatedNode *animated_node = gltf_animated_nodes_.at(GetObjectIndex(animation_channel.node_));
             if(animation_channel.keyframes_.empty() || ((animation_channel.type_ != kGltfAnimationChannelType_Weights) &&
                 (animated_node == nullptr))) { GFX_ASSERT(0); continue; }
             if(animation_channel.keyframes_.empty()) { GFX_ASSERT(0); continue; }
-            intptr_t const keyframe = std::lower_bound(animation_channel.keyframes_.begin(),
-                animation_channel.keyframes_.end(), time_in_seconds) - animation_channel.keyframes_.begin();
-            size_t const previous_index = std::max(keyframe - 1, 0ll);
-            size_t const next_index = std::min(keyframe, (intptr_t)animation_channel.keyframes_.size() - 1);
-            double interpolate = 0.0;
-            if((animation_channel.mode_ == kGltfAnimationChannelMode_Linear) && (previous_index != next_index))
-            {
-                interpolate = ((double)time_in_seconds - (double)animation_channel.keyframes_[keyframe - 1]) /
-                    ((double)animation_channel.keyframes_[keyframe] - (double)animation_channel.keyframes_[keyframe - 1]);
-            }
+            size_t previous_index, next_index;
+            double const interpolate = FindAnimationKeyframes(animation_channel, time_in_seconds, previous_index, next_index);
             if(animation_channel.type_ == kGltfAnimationChannelType_Translate)
             {
                 for(uint32_t j = 0; j < 3; ++j)
@@ -972,8 +1565,8 @@ private:
             else
             {
                 size_t const weights_count = animation_channel.values_.size() / animation_channel.keyframes_.size();
-                std::vector<float> weights;
-                weights.resize(weights_count);
+                GfxSmallVector<float, 8> weights;
+                weights.resize((uint32_t)weights_count);
                 for(size_t j = 0; j < weights_count; ++j)
                 {
                     weights[j] = glm::mix(animation_channel.values_[previous_index * weights_count + j],
@@ -989,12 +1582,31 @@ private:
         }
     }
 
+    // Lists the instance once until the next clear; stale handles of destroyed instances are skipped.
+    void recordModifiedInstance(uint64_t instance_handle)
+    {
+        if(!instances_.has_handle(instance_handle)) return;
+        uint32_t const instance_index = GetObjectIndex(instance_handle);
+        if(instance_index >= modified_instance_slots_.size())
+            modified_instance_slots_.resize(instance_index + 1, 0);
+        if(modified_instance_slots_[instance_index] == instance_handle)
+            return; // already listed
+        modified_instance_slots_[instance_index] = instance_handle;
+        modified_instances_.push_back(instance_handle);
+    }
+
     void updateTransforms(GltfAnimation const &gltf_animation)
+    {
+        updateTransforms(gltf_animation.animated_root_nodes_.data(), gltf_animation.animated_root_nodes_.size(),
+            gltf_animation.dependent_skins_.data(), gltf_animation.dependent_skins_.size());
+    }
+
+    void updateTransforms(uint64_t const *root_nodes, size_t root_node_count, GfxRef<GfxSkin> const *skins, size_t skin_count)
     {
         std::function<void(uint64_t, glm::dmat4 const &)> VisitNode;
         VisitNode = [&](uint64_t node_handle, glm::dmat4 const &parent_transform)
         {
-            GFX_ASSERT(gltf_node_handles_.has_handle(node_handle));
+            GFX_ASSERT(gltf_nodes_.has_handle(node_handle));
             GltfNode &node = gltf_nodes_[GetObjectIndex(node_handle)];
             GltfAnimatedNode *animated_node = gltf_animated_nodes_.at(GetObjectIndex(node_handle));
             if(animated_node == nullptr)
@@ -1012,41 +1624,365 @@ private:
             if(node.light_)
                 TransformGltfLight(*node.light_, node.world_transform_);
         };
-        for(uint64_t node_handle : gltf_animation.animated_root_nodes_)
+        for(size_t i = 0; i < root_node_count; ++i)
         {
-            GFX_ASSERT(gltf_node_handles_.has_handle(node_handle));
+            uint64_t const node_handle = root_nodes[i];
+            GFX_ASSERT(gltf_nodes_.has_handle(node_handle));
             GltfNode &node = gltf_nodes_[GetObjectIndex(node_handle)];
-            if(!node.parent_ || !gltf_node_handles_.has_handle(node.parent_))
+            if(!node.parent_ || !gltf_nodes_.has_handle(node.parent_))
             {
                 VisitNode(node_handle, glm::dmat4(1.0));
                 continue;
             }
             VisitNode(node_handle, gltf_nodes_[GetObjectIndex(node.parent_)].world_transform_);
         }
-        for(auto const skin : gltf_animation.dependent_skins_)
+        for(size_t j = 0; j < skin_count; ++j)
         {
+            GfxRef<GfxSkin> const &skin = skins[j];
             GltfSkin const *gltf_skin = gltf_skins_.at(GetObjectIndex(skin));
             for(size_t i = 0; i < skin->joint_matrices.size(); ++i)
             {
-                GFX_ASSERT(gltf_node_handles_.has_handle(gltf_skin->joints_[i]));
+                GFX_ASSERT(gltf_nodes_.has_handle(gltf_skin->joints_[i]));
                 GltfNode const &joint_node = gltf_nodes_[GetObjectIndex(gltf_skin->joints_[i])];
                 skin->joint_matrices[i] = joint_node.world_transform_ * glm::dmat4(gltf_skin->inverse_bind_matrices_[i]);
             }
         }
     }
 
+    // Samples the clip into the state's own poses then updates its instances and skins; the shared
+    // node graph is only read from, so different states may be evaluated concurrently.
+    void applyAnimationState(GfxAnimationState &animation_state, GltfAnimationState &gltf_animation_state, float time_in_seconds)
+    {
+        GltfAnimation const *gltf_animation = (animations_.has_handle(animation_state.animation) ?
+            gltf_animations_.at(GetObjectIndex(animation_state.animation)) : nullptr);
+        if(gltf_animation == nullptr || gltf_animation->channels_.size() != gltf_animation_state.channel_nodes_.size())
+            return; // animation was destroyed
+        auto const GetInstance = [&](uint32_t instance_index)
+        {
+            return (instance_index < animation_state.instances.size() ? instances_.get(animation_state.instances[instance_index]) : nullptr);
+        };
+        for(size_t i = 0; i < gltf_animation->channels_.size(); ++i)
+        {
+            GltfAnimationChannel const &animation_channel = gltf_animation->channels_[i];
+            uint32_t const node_index = gltf_animation_state.channel_nodes_[i];
+            if(node_index == 0xFFFFFFFFu || animation_channel.keyframes_.empty()) continue;
+            size_t previous_index, next_index;
+            double const interpolate = FindAnimationKeyframes(animation_channel, time_in_seconds, previous_index, next_index);
+            if(animation_channel.type_ == kGltfAnimationChannelType_Weights)
+            {
+                size_t const weights_count = animation_channel.values_.size() / animation_channel.keyframes_.size();
+                for(uint32_t j = gltf_animation_state.node_instances_[node_index]; j < gltf_animation_state.node_instances_[node_index + 1]; ++j)
+                {
+                    GfxInstance *instance = GetInstance(j);
+                    if(instance == nullptr) continue;
+                    instance->weights.resize((uint32_t)weights_count);
+                    for(size_t k = 0; k < weights_count; ++k)
+                        instance->weights[k] = (float)glm::mix((double)animation_channel.values_[previous_index * weights_count + k],
+                            (double)animation_channel.values_[next_index * weights_count + k], interpolate);
+                }
+                continue;
+            }
+            uint32_t const pose_index = gltf_animation_state.node_poses_[node_index];
+            if(pose_index == 0xFFFFFFFFu) continue;
+            GltfAnimatedNode &pose = gltf_animation_state.poses_[pose_index];
+            if(animation_channel.type_ == kGltfAnimationChannelType_Translate)
+                pose.translate_ = SampleAnimationVector(animation_channel, previous_index, next_index, interpolate);
+            else if(animation_channel.type_ == kGltfAnimationChannelType_Rotate)
+                pose.rotate_ = SampleAnimationRotation(animation_channel, previous_index, next_index, interpolate);
+            else if(animation_channel.type_ == kGltfAnimationChannelType_Scale)
+                pose.scale_ = SampleAnimationVector(animation_channel, previous_index, next_index, interpolate);
+        }
+        // Parents come first, so the world transforms resolve in a single pass
+        glm::dmat4 const state_transform(animation_state.transform);
+        for(size_t i = 0; i < gltf_animation_state.nodes_.size(); ++i)
+        {
+            uint64_t const node_handle = gltf_animation_state.nodes_[i];
+            if(!gltf_nodes_.has_handle(node_handle)) continue;
+            GltfNode const &node = gltf_nodes_[GetObjectIndex(node_handle)];
+            uint32_t const pose_index = gltf_animation_state.node_poses_[i];
+            glm::dmat4 const local_transform = (pose_index == 0xFFFFFFFFu ? node.default_local_transform_ : CalculateNodeTransform(
+                gltf_animation_state.poses_[pose_index].translate_, gltf_animation_state.poses_[pose_index].rotate_, gltf_animation_state.poses_[pose_index].scale_));
+            uint32_t const parent_index = gltf_animation_state.parents_[i];
+            if(parent_index != 0xFFFFFFFFu)
+                gltf_animation_state.world_transforms_[i] = gltf_animation_state.world_transforms_[parent_index] * local_transform;
+            else if(node.parent_ != 0 && gltf_nodes_.has_handle(node.parent_))
+                gltf_animation_state.world_transforms_[i] = state_transform * gltf_nodes_[GetObjectIndex(node.parent_)].world_transform_ * local_transform;
+            else
+                gltf_animation_state.world_transforms_[i] = state_transform * local_transform;
+            for(uint32_t j = gltf_animation_state.node_instances_[i]; j < gltf_animation_state.node_instances_[i + 1]; ++j)
+            {
+                GfxInstance *instance = GetInstance(j);
+                if(instance != nullptr)
+                    instance->transform = glm::mat4(gltf_animation_state.world_transforms_[i]);
+            }
+        }
+        for(size_t i = 0; i < gltf_animation_state.source_skins_.size(); ++i)
+        {
+            GltfSkin const *gltf_skin = gltf_skins_.at(GetObjectIndex(gltf_animation_state.source_skins_[i]));
+            GfxSkin *skin = (i < animation_state.skins.size() ? skins_.get(animation_state.skins[i]) : nullptr);
+            if(gltf_skin == nullptr || skin == nullptr) continue;
+            uint32_t const joint_offset = gltf_animation_state.skin_joints_[i];
+            size_t const joint_count = GFX_MIN(GFX_MIN((size_t)gltf_animation_state.skin_joints_[i + 1] - joint_offset,
+                skin->joint_matrices.size()), gltf_skin->inverse_bind_matrices_.size());
+            for(size_t j = 0; j < joint_count; ++j)
+            {
+                uint32_t const node_index = gltf_animation_state.joints_[joint_offset + j];
+                if(node_index != 0xFFFFFFFFu)
+                    skin->joint_matrices[j] = gltf_animation_state.world_transforms_[node_index] * glm::dmat4(gltf_skin->inverse_bind_matrices_[j]);
+                else if(j < gltf_skin->joints_.size() && gltf_nodes_.has_handle(gltf_skin->joints_[j]))
+                    skin->joint_matrices[j] = state_transform * gltf_nodes_[GetObjectIndex(gltf_skin->joints_[j])].world_transform_ * glm::dmat4(gltf_skin->inverse_bind_matrices_[j]);
+            }
+        }
+    }
+
+    struct ObjIndex
+    {
+        uint32_t position_;
+        uint32_t normal_;
+        uint32_t texcoord_;
+        bool operator ==(ObjIndex const &other) const { return position_ == other.position_ && normal_ == other.normal_ && texcoord_ == other.texcoord_; }
+    };
+
+    struct ObjIndexHash
+    {
+        uint64_t operator ()(ObjIndex const &index) const { return gfxHashMix(((uint64_t)index.normal_ << 32) | index.position_) ^ gfxHashMix(index.texcoord_); }
+    };
+
+    struct ObjTriangle
+    {
+        uint64_t mesh_key_; // shape index in the upper bits, material index in the lower bits
+        ObjIndex indices_[3];
+    };
+
+    struct ObjChunk
+    {
+        char const *begin_;
+        char const *end_;
+        uint32_t position_count_;
+        uint32_t normal_count_;
+        uint32_t texcoord_count_;
+        std::vector<std::string_view> shape_names_;
+        std::string_view last_material_;
+        bool has_material_;
+        std::vector<std::string_view> material_libraries_;
+        std::vector<ObjTriangle> triangles_;
+        uint32_t first_position_;   // state at the start of the chunk, resolved once all the chunks were scanned
+        uint32_t first_normal_;
+        uint32_t first_texcoord_;
+        uint32_t first_shape_;
+        uint32_t first_material_;
+    };
+
+    struct ObjFile
+    {
+        HANDLE file_ = INVALID_HANDLE_VALUE;
+        HANDLE mapping_ = nullptr;
+        char const *data_ = nullptr;
+        size_t size_ = 0;
+        ~ObjFile() { if(data_ != nullptr) UnmapViewOfFile(data_); if(mapping_ != nullptr) CloseHandle(mapping_); if(file_ != INVALID_HANDLE_VALUE) CloseHandle(file_); }
+    };
+
+    static inline char const *SkipObjSpaces(char const *it, char const *end)
+    {
+        while(it < end && (*it == ' ' || *it == '\t')) ++it;
+        return it;
+    }
+
+    static inline std::string_view GetObjToken(char const *it, char const *end)
+    {
+        it = SkipObjSpaces(it, end);
+        char const *token_end = end;
+        while(token_end > it && (token_end[-1] == ' ' || token_end[-1] == '\t')) --token_end;
+        return std::string_view(it, token_end - it);    // the rest of the line, trimmed
+    }
+
+    static inline bool IsObjKeyword(char const *it, char const *end, char const *keyword, size_t keyword_length)
+    {
+        if((size_t)(end - it) < keyword_length || memcmp(it, keyword, keyword_length) != 0) return false;
+        return (it + keyword_length == end || it[keyword_length] == ' ' || it[keyword_length] == '\t');
+    }
+
+    static inline bool ParseObjFloat(char const *&it, char const *end, float &value)
+    {
+        it = SkipObjSpaces(it, end);
+        if(it < end && *it == '+') ++it;    // not accepted by std::from_chars()
+        std::from_chars_result const result = std::from_chars(it, end, value);
+        if(result.ec != std::errc()) return false;
+        it = result.ptr;
+        return true;
+    }
+
+    static inline uint32_t ParseObjIndex(char const *&it, char const *end, uint32_t count, uint32_t total_count)
+    {
+        int64_t index = 0;
+        std::from_chars_result const result = std::from_chars(it, end, index);
+        if(result.ec != std::errc()) return 0xFFFFFFFFu;
+        it = result.ptr;
+        index = (index < 0 ? (int64_t)count + index : index - 1);   // negative indices are relative to the current count
+        return (index >= 0 && index < (int64_t)total_count ? (uint32_t)index : 0xFFFFFFFFu);
+    }
+
+    template<typename FUNCTION>
+    static inline void ForEachObjLine(char const *begin, char const *end, FUNCTION const &function)
+    {
+        for(char const *line = begin; line < end;)
+        {
+            char const *line_end = (char const *)memchr(line, '\n', end - line);
+            char const *next_line = (line_end != nullptr ? line_end + 1 : end);
+            if(line_end == nullptr) line_end = end;
+            if(line_end > line && line_end[-1] == '\r') --line_end;
+            char const *it = SkipObjSpaces(line, line_end);
+            if(it < line_end) function(it, line_end);
+            line = next_line;
+        }
+    }
+
+    static inline void ScanObjChunk(ObjChunk &chunk)
+    {
+        ForEachObjLine(chunk.begin_, chunk.end_, [&](char const *it, char const *end)
+        {
+            switch(*it)
+            {
+            case 'v':
+                if(IsObjKeyword(it, end, "v", 1)) ++chunk.position_count_;
+                else if(IsObjKeyword(it, end, "vn", 2)) ++chunk.normal_count_;
+                else if(IsObjKeyword(it, end, "vt", 2)) ++chunk.texcoord_count_;
+                break;
+            case 'o':
+            case 'g':
+                if(IsObjKeyword(it, end, *it == 'o' ? "o" : "g", 1)) chunk.shape_names_.push_back(GetObjToken(it + 1, end));
+                break;
+            case 'u':
+                if(IsObjKeyword(it, end, "usemtl", 6)) { chunk.last_material_ = GetObjToken(it + 6, end); chunk.has_material_ = true; }
+                break;
+            case 'm':
+                if(IsObjKeyword(it, end, "mtllib", 6)) chunk.material_libraries_.push_back(GetObjToken(it + 6, end));
+                break;
+            default:
+                break;
+            }
+        });
+    }
+
+    static inline void ParseObjChunk(ObjChunk &chunk, GfxHashMap<std::string, int> const &material_map,
+        std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals, std::vector<glm::vec2> &texcoords)
+    {
+        GfxSmallVector<ObjIndex, 8> face;
+        uint32_t position_count = chunk.first_position_;
+        uint32_t normal_count = chunk.first_normal_;
+        uint32_t texcoord_count = chunk.first_texcoord_;
+        uint32_t shape_index = chunk.first_shape_;
+        uint32_t material_index = chunk.first_material_;
+        ForEachObjLine(chunk.begin_, chunk.end_, [&](char const *it, char const *end)
+        {
+            switch(*it)
+            {
+            case 'v':
+                if(IsObjKeyword(it, end, "v", 1))
+                {
+                    glm::vec3 &position = positions[position_count++]; ++it;
+                    if(!ParseObjFloat(it, end, position.x) || !ParseObjFloat(it, end, position.y) || !ParseObjFloat(it, end, position.z))
+                        position = glm::vec3(0.0f); // malformed vertex
+                }
+                else if(IsObjKeyword(it, end, "vn", 2))
+                {
+                    glm::vec3 &normal = normals[normal_count++]; it += 2;
+                    if(!ParseObjFloat(it, end, normal.x) || !ParseObjFloat(it, end, normal.y) || !ParseObjFloat(it, end, normal.z))
+                        normal = glm::vec3(0.0f);   // malformed normal
+                }
+                else if(IsObjKeyword(it, end, "vt", 2))
+                {
+                    glm::vec2 &texcoord = texcoords[texcoord_count++]; it += 2;
+                    if(!ParseObjFloat(it, end, texcoord.x)) texcoord.x = 0.0f;
+                    if(!ParseObjFloat(it, end, texcoord.y)) texcoord.y = 0.0f;
+                    texcoord.y = 1.0f - texcoord.y;
+                }
+                break;
+            case 'f':
+                if(IsObjKeyword(it, end, "f", 1))
+                {
+                    face.clear(); ++it;
+                    for(it = SkipObjSpaces(it, end); it < end; it = SkipObjSpaces(it, end))
+                    {
+                        ObjIndex index = { ParseObjIndex(it, end, position_count, (uint32_t)positions.size()), 0xFFFFFFFFu, 0xFFFFFFFFu };
+                        if(it < end && *it == '/')
+                        {
+                            if(++it < end && *it != '/') index.texcoord_ = ParseObjIndex(it, end, texcoord_count, (uint32_t)texcoords.size());
+                            if(it < end && *it == '/') index.normal_ = ParseObjIndex(++it, end, normal_count, (uint32_t)normals.size());
+                        }
+                        while(it < end && *it != ' ' && *it != '\t') ++it;  // skip whatever could not be parsed
+                        face.push_back(index);
+                    }
+                    for(uint32_t i = 0; i < face.size(); ++i)
+                        if(face[i].position_ == 0xFFFFFFFFu) return;    // invalid face
+                    for(uint32_t i = 2; i < face.size(); ++i)
+                        chunk.triangles_.push_back({ ((uint64_t)shape_index << 32) | material_index, { face[0], face[i - 1], face[i] } });   // triangulate as a fan
+                }
+                break;
+            case 'o':
+            case 'g':
+                if(IsObjKeyword(it, end, *it == 'o' ? "o" : "g", 1)) ++shape_index;
+                break;
+            case 'u':
+                if(IsObjKeyword(it, end, "usemtl", 6))
+                {
+                    GfxHashMap<std::string, int>::const_iterator const material = material_map.find(GetObjToken(it + 6, end));
+                    material_index = (material != material_map.end() ? (uint32_t)(*material).second : 0xFFFFFFFFu);
+                }
+                break;
+            default:
+                break;
+            }
+        });
+    }
+
     GfxResult importObj(GfxScene const &scene, char const *asset_file)
     {
-        tinyobj::ObjReader obj_reader;
         GFX_ASSERT(asset_file != nullptr);
-        tinyobj::ObjReaderConfig obj_reader_config;
-        obj_reader_config.vertex_color = false;
-        if(!obj_reader.ParseFromFile(asset_file, obj_reader_config))
-            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Failed to load obj file `%s'", obj_reader.Error().c_str());
-        if(!obj_reader.Warning().empty())
-            GFX_PRINTLN("Parsed obj file `%s' with warnings:\r\n%s", asset_file, obj_reader.Warning().c_str());
+        ObjFile obj_file;
+        obj_file.file_ = CreateFileA(asset_file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER file_size = {};
+        if(obj_file.file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(obj_file.file_, &file_size))
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Failed to open obj file `%s'", asset_file);
+        obj_file.size_ = (size_t)file_size.QuadPart;
+        if(obj_file.size_ == 0)
+            return kGfxResult_NoError;  // nothing needs loading
+        obj_file.mapping_ = CreateFileMappingA(obj_file.file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        obj_file.data_ = (obj_file.mapping_ != nullptr ? (char const *)MapViewOfFile(obj_file.mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr);
+        if(obj_file.data_ == nullptr)
+            return GFX_SET_ERROR(kGfxResult_InvalidOperation, "Failed to map obj file `%s'", asset_file);
+        size_t const chunk_size = ((size_t)4 << 20);
+        std::vector<ObjChunk> chunks((obj_file.size_ + chunk_size - 1) / chunk_size);
+        for(size_t i = 0; i < chunks.size(); ++i)
+        {
+            char const *end = obj_file.data_ + obj_file.size_;
+            chunks[i].begin_ = (i > 0 ? chunks[i - 1].end_ : obj_file.data_);
+            chunks[i].end_ = chunks[i].begin_ + GFX_MIN(chunk_size, (size_t)(end - chunks[i].begin_));
+            while(chunks[i].end_ < end && chunks[i].end_[-1] != '\n') ++chunks[i].end_;  // split on line boundaries
+        }
+        gfxGetJobSystem().parallel_for((uint32_t)chunks.size(), 1, [&](uint32_t chunk_index) { ScanObjChunk(chunks[chunk_index]); });
         char const *file = GFX_MAX(strrchr(asset_file, '/'), strrchr(asset_file, '\\'));    // retrieve file name
         std::string const texture_path = (file == nullptr ? "./" : std::string(asset_file, file - asset_file + 1));
+        std::vector<tinyobj::material_t> obj_materials;
+        std::map<std::string, int> obj_material_map;
+        for(size_t i = 0; i < chunks.size(); ++i)
+            for(std::string_view const &material_library : chunks[i].material_libraries_)
+            {
+                std::ifstream material_stream(texture_path + std::string(material_library));
+                if(!material_stream.is_open()) material_stream.open(std::string(material_library));
+                if(!material_stream.is_open())
+                {
+                    GFX_PRINTLN("Parsed obj file `%s' with warnings:\r\nMaterial file `%s' not found", asset_file, std::string(material_library).c_str());
+                    continue;
+                }
+                std::string warning, error;
+                tinyobj::LoadMtl(&obj_material_map, &obj_materials, &material_stream, &warning, &error);
+                if(!warning.empty() || !error.empty())
+                    GFX_PRINTLN("Parsed obj file `%s' with warnings:\r\n%s%s", asset_file, warning.c_str(), error.c_str());
+            }
+        GfxHashMap<std::string, int> material_map;
+        for(auto const &material : obj_material_map)
+            material_map[material.first] = material.second;
         auto const LoadImage = [&](std::string const &texname, GfxConstRef<GfxImage> &image)
         {
             if(texname.empty()) return; // no image to be loaded
@@ -1057,11 +1993,11 @@ private:
                 return; // unable to load image file
             image = gfxSceneFindObjectByAssetFile<GfxImage>(scene, texture_file.c_str());
         };
-        std::vector<GfxConstRef<GfxMaterial>> materials(obj_reader.GetMaterials().size());
-        for(size_t i = 0; i < obj_reader.GetMaterials().size(); ++i)
+        std::vector<GfxConstRef<GfxMaterial>> materials(obj_materials.size());
+        for(size_t i = 0; i < obj_materials.size(); ++i)
         {
             GfxRef<GfxMaterial> material_ref = gfxSceneCreateMaterial(scene);
-            tinyobj::material_t const &obj_material = obj_reader.GetMaterials()[i];
+            tinyobj::material_t const &obj_material = obj_materials[i];
             GfxMetadata &material_metadata = material_metadata_[material_ref];
             material_metadata.asset_file = asset_file;  // set up metadata
             material_metadata.object_name = obj_material.name;
@@ -1098,98 +2034,119 @@ private:
             }
             materials[i] = material_ref;    // append the new material
         }
-        for(size_t i = 0; i < obj_reader.GetShapes().size(); ++i)
-        {
-            uint32_t first_index = 0;
-            tinyobj::shape_t const &obj_shape = obj_reader.GetShapes()[i];
-            if(obj_shape.mesh.indices.empty()) continue;    // only support indexed meshes for now
-            typedef std::map<std::tuple<int32_t, int32_t, int32_t>, std::pair<uint32_t, GfxVertex>> VertexMap;
-            std::map<uint32_t, VertexMap> mesh_map; // based on material index
-            std::map<uint32_t, std::vector<uint32_t>> index_map;
-            for(size_t j = 0; j < obj_shape.mesh.num_face_vertices.size(); ++j)
-            {
-                uint32_t const index_offset = first_index;
-                first_index += obj_shape.mesh.num_face_vertices[j];
-                if(obj_shape.mesh.num_face_vertices[j] != 3) continue;  // only support triangle meshes
-                uint32_t const material_idx = (j < obj_shape.mesh.material_ids.size() ? obj_shape.mesh.material_ids[j] : 0xFFFFFFFFu);
-                VertexMap &vertex_map = mesh_map[material_idx]; // get hold of the vertex map
-                std::vector<uint32_t> &indices = index_map[material_idx];
-                for(uint32_t k = index_offset; k < index_offset + 3; ++k)
-                {
-                    std::tuple<int32_t, int32_t, int32_t> const key(obj_shape.mesh.indices[k].vertex_index,
-                                                                    obj_shape.mesh.indices[k].normal_index,
-                                                                    obj_shape.mesh.indices[k].texcoord_index);
-                    VertexMap::const_iterator const it = vertex_map.find(key);
-                    if(it != vertex_map.end())
-                        indices.push_back((*it).second.first);
-                    else
-                    {
-                        GfxVertex vertex = {};
-                        if(std::get<0>(key) >= 0)
-                        {
-                            vertex.position.x = obj_reader.GetAttrib().vertices[3ull * std::get<0>(key) + 0];
-                            vertex.position.y = obj_reader.GetAttrib().vertices[3ull * std::get<0>(key) + 1];
-                            vertex.position.z = obj_reader.GetAttrib().vertices[3ull * std::get<0>(key) + 2];
-                        }
-                        if(std::get<1>(key) >= 0)
-                        {
-                            vertex.normal.x = obj_reader.GetAttrib().normals[3ull * std::get<1>(key) + 0];
-                            vertex.normal.y = obj_reader.GetAttrib().normals[3ull * std::get<1>(key) + 1];
-                            vertex.normal.z = obj_reader.GetAttrib().normals[3ull * std::get<1>(key) + 2];
-                        }
-                        if(std::get<2>(key) >= 0)
-                        {
-                            vertex.uv.x = obj_reader.GetAttrib().texcoords[2ull * std::get<2>(key) + 0];
-                            vertex.uv.y = 1.0f - obj_reader.GetAttrib().texcoords[2ull * std::get<2>(key) + 1];
-                        }
-                        uint32_t const index = (uint32_t)vertex_map.size();
-                        vertex_map[key] = std::pair<uint32_t, GfxVertex>(index, vertex);
-                        indices.push_back(index);   // append index to new vertex
-                    }
-                }
+        std::vector<std::string_view> shape_names(1);   // faces are assigned to an unnamed shape until the first `o' or `g' statement
+        uint32_t position_count = 0, normal_count = 0, texcoord_count = 0, material_index = 0xFFFFFFFFu;
+        for(size_t i = 0; i < chunks.size(); ++i)
+        {
+            ObjChunk &chunk = chunks[i];
+            chunk.first_position_ = position_count;
+            chunk.first_normal_ = normal_count;
+            chunk.first_texcoord_ = texcoord_count;
+            chunk.first_shape_ = (uint32_t)shape_names.size() - 1;
+            chunk.first_material_ = material_index;
+            position_count += chunk.position_count_;
+            normal_count += chunk.normal_count_;
+            texcoord_count += chunk.texcoord_count_;
+            shape_names.insert(shape_names.end(), chunk.shape_names_.begin(), chunk.shape_names_.end());
+            if(chunk.has_material_)
+            {
+                GfxHashMap<std::string, int>::const_iterator const material = material_map.find(chunk.last_material_);
+                material_index = (material != material_map.end() ? (uint32_t)(*material).second : 0xFFFFFFFFu);
             }
-            uint32_t mesh_id = 0;
-            for(std::map<uint32_t, VertexMap>::const_iterator it = mesh_map.begin(); it != mesh_map.end(); ++it, ++mesh_id)
+        }
+        std::vector<glm::vec3> positions(position_count);
+        std::vector<glm::vec3> normals(normal_count);
+        std::vector<glm::vec2> texcoords(texcoord_count);
+        gfxGetJobSystem().parallel_for((uint32_t)chunks.size(), 1, [&](uint32_t chunk_index) { ParseObjChunk(chunks[chunk_index], material_map, positions, normals, texcoords); });
+        struct ObjMesh
+        {
+            uint64_t mesh_key_;
+            uint32_t triangle_count_;
+            std::vector<std::pair<ObjTriangle const *, uint32_t>> triangle_runs_;   // consecutive triangles that share a shape and material
+            GfxRef<GfxMesh> mesh_;
+        };
+        std::vector<ObjMesh> obj_meshes;
+        GfxHashMap<uint64_t, uint32_t> obj_mesh_indices;
+        for(size_t i = 0; i < chunks.size(); ++i)
+            for(size_t j = 0; j < chunks[i].triangles_.size();)
             {
-                VertexMap const &vertices = (*it).second;
-                std::vector<uint32_t> &indices = index_map[(*it).first];
-                if(indices.empty()) continue;   // do not create empty meshes
-                GfxRef<GfxMesh> mesh_ref = gfxSceneCreateMesh(scene);
-                std::swap(mesh_ref->indices, indices);
-                mesh_ref->vertices.resize(vertices.size());
-                GfxMetadata &mesh_metadata = mesh_metadata_[mesh_ref];
-                mesh_metadata.asset_file = asset_file;  // set up metadata
-                mesh_metadata.object_name = obj_shape.name;
-                if(mesh_id > 0)
-                {
-                    mesh_metadata.object_name += ".";
-                    mesh_metadata.object_name += std::to_string(mesh_id);
-                }
-                glm::vec3 bounds_min(FLT_MAX), bounds_max(-FLT_MAX);
-                for(VertexMap::const_iterator it2 = vertices.begin(); it2 != vertices.end(); ++it2)
+                uint64_t const mesh_key = chunks[i].triangles_[j].mesh_key_;
+                size_t const first_triangle = j;
+                while(j < chunks[i].triangles_.size() && chunks[i].triangles_[j].mesh_key_ == mesh_key) ++j;
+                GfxHashMap<uint64_t, uint32_t>::const_iterator const it = obj_mesh_indices.find(mesh_key);
+                uint32_t const obj_mesh_index = (it != obj_mesh_indices.end() ? (*it).second : (uint32_t)obj_meshes.size());
+                if(it == obj_mesh_indices.end())
                 {
-                    uint32_t const index = (*it2).second.first;
-                    GfxVertex const &vertex = (*it2).second.second;
-                    bounds_min = glm::min(bounds_min, vertex.position);
-                    bounds_max = glm::max(bounds_max, vertex.position);
-                    mesh_ref->vertices[index] = vertex; // append vertex
-                }
-                mesh_ref->bounds_min = bounds_min;
-                mesh_ref->bounds_max = bounds_max;
-                GfxRef<GfxInstance> instance_ref = gfxSceneCreateInstance(scene);
-                instance_ref->mesh = mesh_ref;  // .obj does not support instancing, so simply create one instance per mesh
-                if((*it).first < materials.size())
-                    instance_ref->material = materials[(*it).first];
-                GfxMetadata &instance_metadata = instance_metadata_[instance_ref];
-                instance_metadata.asset_file = asset_file;  // set up metadata
-                instance_metadata.object_name = obj_shape.name;
-                if(mesh_id > 0)
-                {
-                    instance_metadata.object_name += ".";
-                    instance_metadata.object_name += std::to_string(mesh_id);
+                    obj_mesh_indices.insert(mesh_key, obj_mesh_index);
+                    obj_meshes.emplace_back().mesh_key_ = mesh_key;
                 }
+                obj_meshes[obj_mesh_index].triangle_count_ += (uint32_t)(j - first_triangle);
+                obj_meshes[obj_mesh_index].triangle_runs_.push_back(std::make_pair(&chunks[i].triangles_[first_triangle], (uint32_t)(j - first_triangle)));
+            }
+        std::sort(obj_meshes.begin(), obj_meshes.end(), [](ObjMesh const &lhs, ObjMesh const &rhs) { return lhs.mesh_key_ < rhs.mesh_key_; });
+        uint32_t mesh_id = 0;
+        for(size_t i = 0; i < obj_meshes.size(); ++i, ++mesh_id)
+        {
+            uint32_t const shape_index = (uint32_t)(obj_meshes[i].mesh_key_ >> 32);
+            uint32_t const material_idx = (uint32_t)(obj_meshes[i].mesh_key_ & 0xFFFFFFFFull);
+            if(i > 0 && shape_index != (uint32_t)(obj_meshes[i - 1].mesh_key_ >> 32)) mesh_id = 0;
+            std::string const shape_name(shape_names[shape_index]);
+            GfxRef<GfxMesh> mesh_ref = gfxSceneCreateMesh(scene);
+            GfxMetadata &mesh_metadata = mesh_metadata_[mesh_ref];
+            mesh_metadata.asset_file = asset_file;  // set up metadata
+            mesh_metadata.object_name = shape_name;
+            if(mesh_id > 0)
+            {
+                mesh_metadata.object_name += ".";
+                mesh_metadata.object_name += std::to_string(mesh_id);
+            }
+            GfxRef<GfxInstance> instance_ref = gfxSceneCreateInstance(scene);
+            instance_ref->mesh = mesh_ref;  // .obj does not support instancing, so simply create one instance per mesh
+            if(material_idx < materials.size())
+                instance_ref->material = materials[material_idx];
+            GfxMetadata &instance_metadata = instance_metadata_[instance_ref];
+            instance_metadata.asset_file = asset_file;  // set up metadata
+            instance_metadata.object_name = shape_name;
+            if(mesh_id > 0)
+            {
+                instance_metadata.object_name += ".";
+                instance_metadata.object_name += std::to_string(mesh_id);
             }
+            obj_meshes[i].mesh_ = mesh_ref;
         }
+        gfxGetJobSystem().parallel_for((uint32_t)obj_meshes.size(), 1, [&](uint32_t obj_mesh_index)
+        {
+            ObjMesh const &obj_mesh = obj_meshes[obj_mesh_index];
+            GfxMesh &mesh = *obj_mesh.mesh_;
+            GfxHashMap<ObjIndex, uint32_t, ObjIndexHash> vertex_map;
+            mesh.indices.reserve(3 * (size_t)obj_mesh.triangle_count_);
+            glm::vec3 bounds_min(FLT_MAX), bounds_max(-FLT_MAX);
+            for(std::pair<ObjTriangle const *, uint32_t> const &triangle_run : obj_mesh.triangle_runs_)
+                for(uint32_t j = 0; j < triangle_run.second; ++j)
+                    for(ObjIndex const &key : triangle_run.first[j].indices_)
+                    {
+                        GfxHashMap<ObjIndex, uint32_t, ObjIndexHash>::const_iterator const it = vertex_map.find(key);
+                        if(it != vertex_map.end())
+                            mesh.indices.push_back((*it).second);
+                        else
+                        {
+                            GfxVertex vertex = {};
+                            vertex.position = positions[key.position_];
+                            if(key.normal_ != 0xFFFFFFFFu)
+                                vertex.normal = normals[key.normal_];
+                            if(key.texcoord_ != 0xFFFFFFFFu)
+                                vertex.uv = texcoords[key.texcoord_];
+                            bounds_min = glm::min(bounds_min, vertex.position);
+                            bounds_max = glm::max(bounds_max, vertex.position);
+                            uint32_t const index = (uint32_t)mesh.vertices.size();
+                            vertex_map.insert(key, index);
+                            mesh.vertices.push_back(vertex);
+                            mesh.indices.push_back(index);  // append index to new vertex
+                        }
+                    }
+            mesh.bounds_min = bounds_min;
+            mesh.bounds_max = bounds_max;
+        });
         return kGfxResult_NoError;
     }
 
@@ -1690,6 +2647,13 @@ private:
             std::vector<TargetAccessors> targets;
         };
         std::map<MeshAccessors, GfxConstRef<GfxMesh>> meshInstances;
+        struct MeshBuild
+        {
+            MeshAccessors const *accessors;
+            cgltf_mesh const *gltf_mesh;
+            GfxRef<GfxMesh> mesh;
+        };
+        std::vector<MeshBuild> mesh_builds;    // unpacked in parallel once all the meshes are created
         for(size_t i = 0; i < gltf_model->meshes_count; ++i)
         {
             cgltf_mesh const &gltf_mesh = gltf_model->meshes[i];
@@ -1735,90 +2699,7 @@ private:
                 auto mesh_it = meshInstances.find(accessors);
                 if(mesh_it == meshInstances.end())
                 {
-                    MeshData mesh_data;
-                    bool unpacked;
-                    unpacked = UnpackAccessor(accessors.positions, mesh_data.positions); GFX_ASSERT(unpacked);
-                    unpacked = UnpackAccessor(accessors.normals, mesh_data.normals); GFX_ASSERT(unpacked);
-                    unpacked = UnpackAccessor(accessors.uvs, mesh_data.uvs); GFX_ASSERT(unpacked);
-                    unpacked = UnpackAccessor(accessors.joints, mesh_data.joints); GFX_ASSERT(unpacked);
-                    unpacked = UnpackAccessor(accessors.weights, mesh_data.weights); GFX_ASSERT(unpacked);
-                    mesh_data.targets.resize(accessors.targets.size());
-                    for(size_t k = 0; k < accessors.targets.size(); ++k)
-                    {
-                        unpacked = UnpackAccessor(accessors.targets[k].positions, mesh_data.targets[k].positions); GFX_ASSERT(unpacked);
-                        unpacked = UnpackAccessor(accessors.targets[k].normals, mesh_data.targets[k].normals); GFX_ASSERT(unpacked);
-                        unpacked = UnpackAccessor(accessors.targets[k].uvs, mesh_data.targets[k].uvs); GFX_ASSERT(unpacked);
-                    }
-                    bool skinned_mesh = accessors.joints != nullptr;
                     GfxRef<GfxMesh> mesh_ref = gfxSceneCreateMesh(scene);
-                    GfxMesh &mesh = *mesh_ref;
-                    mesh.default_weights = std::vector<float>(gltf_mesh.weights, gltf_mesh.weights + gltf_mesh.weights_count);
-                    auto unpack_vertex = [&](size_t const gltf_index) {
-                        GfxVertex vertex = {};
-                        vertex.position = mesh_data.positions[gltf_index];
-                        if(!mesh_data.normals.empty())
-                            vertex.normal = mesh_data.normals[gltf_index];
-                        if(!mesh_data.uvs.empty())
-                            vertex.uv = mesh_data.uvs[gltf_index];
-                        uint32_t const index = (uint32_t)mesh.vertices.size();
-                        if(index == 0)
-                        {
-                            mesh.bounds_min = vertex.position;
-                            mesh.bounds_max = vertex.position;
-                        }
-                        else
-                        {
-                            mesh.bounds_min = glm::min(mesh.bounds_min, vertex.position);
-                            mesh.bounds_max = glm::max(mesh.bounds_max, vertex.position);
-                        }
-                        mesh.vertices.push_back(vertex);
-                        mesh.indices.push_back(index);
-                        for(size_t k = 0; k < mesh_data.targets.size(); ++k)
-                        {
-                            GfxVertex target_vertex = {};
-                            if(!mesh_data.targets[k].positions.empty())
-                                target_vertex.position = mesh_data.targets[k].positions[gltf_index];
-                            if(!mesh_data.targets[k].normals.empty())
-                                target_vertex.normal = mesh_data.targets[k].normals[gltf_index];
-                            if(!mesh_data.targets[k].uvs.empty())
-                                target_vertex.uv = mesh_data.targets[k].uvs[gltf_index];
-                            mesh.morph_targets.push_back(target_vertex);
-                        }
-                        if(skinned_mesh)
-                        {
-                            GfxJoint joint = {};
-                            if(!mesh_data.joints.empty())
-                                joint.joints = mesh_data.joints[gltf_index];
-                            if(!mesh_data.weights.empty())
-                                joint.weights = mesh_data.weights[gltf_index];
-                            mesh.joints.push_back(joint);
-                        }
-                    };
-                    if(accessors.indices != nullptr)
-                    {
-                        std::map<cgltf_uint, uint32_t> indices;
-                        for(size_t k = 0; k < accessors.indices->count; ++k)
-                        {
-                            cgltf_uint gltf_index = 0;
-                            cgltf_bool read = cgltf_accessor_read_uint(accessors.indices, k, &gltf_index, 1);
-                            GFX_ASSERT(read); (void)read;
-                            std::map<cgltf_uint, uint32_t>::const_iterator const it2 = indices.find(gltf_index);
-                            if(it2 != indices.end())
-                                mesh.indices.push_back((*it2).second);
-                            else
-                            {
-                                unpack_vertex(gltf_index);
-                                indices[gltf_index] = mesh.indices.back();
-                            }
-                        }
-                    }
-                    else
-                    {
-                        for(size_t k = 0; k < mesh_data.positions.size(); ++k)
-                        {
-                            unpack_vertex(k);
-                        }
-                    }
                     GfxMetadata &mesh_metadata = mesh_metadata_[mesh_ref];
                     mesh_metadata.asset_file = asset_file;  // set up metadata
                     mesh_metadata.object_name = (gltf_mesh.name != nullptr) ? gltf_mesh.name : "Mesh" + std::to_string(i);
@@ -1827,8 +2708,9 @@ private:
                         mesh_metadata.object_name += ".";
                         mesh_metadata.object_name += std::to_string(j);
                     }
-                    current_mesh             = mesh_ref;
-                    meshInstances[accessors] = mesh_ref;
+                    current_mesh = mesh_ref;
+                    mesh_it = meshInstances.emplace(std::move(accessors), mesh_ref).first;
+                    mesh_builds.push_back({ &mesh_it->first, &gltf_mesh, mesh_ref });
                 }
                 else
                 {
@@ -1844,9 +2726,106 @@ private:
                 mesh_list.push_back(std::make_pair(current_mesh, material));
             }
         }
+        gfxGetJobSystem().parallel_for((uint32_t)mesh_builds.size(), 1, [&](uint32_t build_index)
+        {
+            MeshAccessors const &accessors = *mesh_builds[build_index].accessors;
+            cgltf_mesh const &gltf_mesh = *mesh_builds[build_index].gltf_mesh;
+            GfxMesh &mesh = *mesh_builds[build_index].mesh;
+            mesh.default_weights = std::vector<float>(gltf_mesh.weights, gltf_mesh.weights + gltf_mesh.weights_count);
+            MeshData mesh_data;
+            bool unpacked;
+            unpacked = UnpackAccessor(accessors.positions, mesh_data.positions); GFX_ASSERT(unpacked);
+            unpacked = UnpackAccessor(accessors.normals, mesh_data.normals); GFX_ASSERT(unpacked);
+            unpacked = UnpackAccessor(accessors.uvs, mesh_data.uvs); GFX_ASSERT(unpacked);
+            unpacked = UnpackAccessor(accessors.joints, mesh_data.joints); GFX_ASSERT(unpacked);
+            unpacked = UnpackAccessor(accessors.weights, mesh_data.weights); GFX_ASSERT(unpacked);
+            mesh_data.targets.resize(accessors.targets.size());
+            for(size_t k = 0; k < accessors.targets.size(); ++k)
+            {
+                unpacked = UnpackAccessor(accessors.targets[k].positions, mesh_data.targets[k].positions); GFX_ASSERT(unpacked);
+                unpacked = UnpackAccessor(accessors.targets[k].normals, mesh_data.targets[k].normals); GFX_ASSERT(unpacked);
+                unpacked = UnpackAccessor(accessors.targets[k].uvs, mesh_data.targets[k].uvs); GFX_ASSERT(unpacked);
+            }
+            bool skinned_mesh = accessors.joints != nullptr;
+            auto unpack_vertex = [&](size_t const gltf_index) {
+                GfxVertex vertex = {};
+                vertex.position = mesh_data.positions[gltf_index];
+                if(!mesh_data.normals.empty())
+                    vertex.normal = mesh_data.normals[gltf_index];
+                if(!mesh_data.uvs.empty())
+                    vertex.uv = mesh_data.uvs[gltf_index];
+                uint32_t const index = (uint32_t)mesh.vertices.size();
+                if(index == 0)
+                {
+                    mesh.bounds_min = vertex.position;
+                    mesh.bounds_max = vertex.position;
+                }
+                else
+                {
+                    mesh.bounds_min = glm::min(mesh.bounds_min, vertex.position);
+                    mesh.bounds_max = glm::max(mesh.bounds_max, vertex.position);
+                }
+                mesh.vertices.push_back(vertex);
+                mesh.indices.push_back(index);
+                for(size_t k = 0; k < mesh_data.targets.size(); ++k)
+                {
+                    GfxVertex target_vertex = {};
+                    if(!mesh_data.targets[k].positions.empty())
+                        target_vertex.position = mesh_data.targets[k].positions[gltf_index];
+                    if(!mesh_data.targets[k].normals.empty())
+                        target_vertex.normal = mesh_data.targets[k].normals[gltf_index];
+                    if(!mesh_data.targets[k].uvs.empty())
+                        target_vertex.uv = mesh_data.targets[k].uvs[gltf_index];
+                    mesh.morph_targets.push_back(target_vertex);
+                }
+                if(skinned_mesh)
+                {
+                    GfxJoint joint = {};
+                    if(!mesh_data.joints.empty())
+                        joint.joints = mesh_data.joints[gltf_index];
+                    if(!mesh_data.weights.empty())
+                        joint.weights = mesh_data.weights[gltf_index];
+                    mesh.joints.push_back(joint);
+                }
+            };
+            if(accessors.indices != nullptr)
+            {
+                std::vector<uint32_t> gltf_indices;
+                unpacked = UnpackIndices(accessors.indices, gltf_indices); GFX_ASSERT(unpacked);
+                GfxHashMap<cgltf_uint, uint32_t> indices;
+                indices.reserve((uint32_t)GFX_MIN(gltf_indices.size(), mesh_data.positions.size()));
+                for(size_t k = 0; k < gltf_indices.size(); ++k)
+                {
+                    cgltf_uint const gltf_index = gltf_indices[k];
+                    GfxHashMap<cgltf_uint, uint32_t>::const_iterator const it2 = indices.find(gltf_index);
+                    if(it2 != indices.end())
+                        mesh.indices.push_back((*it2).second);
+                    else
+                    {
+                        unpack_vertex(gltf_index);
+                        indices[gltf_index] = mesh.indices.back();
+                    }
+                }
+            }
+            else
+            {
+                for(size_t k = 0; k < mesh_data.positions.size(); ++k)
+                {
+                    unpack_vertex(k);
+                }
+            }
+        });
         std::map<cgltf_node const *, std::set<GfxConstRef<GfxAnimation>>> node_animations;
         std::map<cgltf_node const *, uint64_t /*gfx node handle*/>        node_handles;
         std::map<uint64_t /*gltf ID*/, GfxConstRef<GfxAnimation>>         animations;
+        struct AnimationSampler
+        {
+            uint32_t animation_index;
+            uint32_t channel_index;
+            cgltf_accessor const *input;
+            cgltf_accessor const *output;
+        };
+        std::vector<AnimationSampler> animation_samplers;   // unpacked in parallel once all the channels are created
         for(size_t i = 0; i < gltf_model->animations_count; ++i)
         {
             GfxRef<GfxAnimation> animation_ref;
@@ -1887,7 +2866,7 @@ private:
                     animated_node_handle = (*it).second;
                 else
                 {
-                    animated_node_handle = gltf_node_handles_.allocate_handle();
+                    animated_node_handle = gltf_nodes_.allocate_handle();
                     node_handles[gltf_animation_channel.target_node] = animated_node_handle;
                     gltf_animated_nodes_.insert(GetObjectIndex(animated_node_handle));
                 }
@@ -1903,23 +2882,32 @@ private:
                 if(type != kGltfAnimationChannelType_Weights)
                     node_animations[gltf_animation_channel.target_node].insert(animation_ref);
                 GFX_ASSERT(animation_object != nullptr);
+                animation_samplers.push_back({ GetObjectIndex(animation_ref), (uint32_t)animation_object->channels_.size(), input_buffer, output_buffer });
                 animation_object->channels_.emplace_back();
                 GltfAnimationChannel &animation_channel = animation_object->channels_.back();
-                animation_channel.keyframes_.resize(input_buffer->count);
-                cgltf_accessor_unpack_floats(input_buffer, &animation_channel.keyframes_[0], input_buffer->count);
-                cgltf_size const num_components = cgltf_num_components(output_buffer->type);
-                GFX_ASSERT(((type == kGltfAnimationChannelType_Translate) && (num_components == 3)) ||
-                    ((type == kGltfAnimationChannelType_Rotate) && (num_components == 4)) ||
-                    ((type == kGltfAnimationChannelType_Scale) && (num_components == 3)) ||
-                    ((type == kGltfAnimationChannelType_Weights) && (num_components == 1)));
-                animation_channel.values_.resize(num_components * output_buffer->count);
-                for(uint32_t k = 0; k < output_buffer->count; ++k)
-                    cgltf_accessor_read_float(output_buffer, k, (float*)&animation_channel.values_[num_components * k], num_components);
                 animation_channel.node_ = animated_node_handle;
                 animation_channel.mode_ = mode;
                 animation_channel.type_ = type;
             }
         }
+        gfxGetJobSystem().parallel_for((uint32_t)animation_samplers.size(), 4, [&](uint32_t sampler_index)
+        {
+            AnimationSampler const &animation_sampler = animation_samplers[sampler_index];
+            GltfAnimationChannel &animation_channel = gltf_animations_[animation_sampler.animation_index].channels_[animation_sampler.channel_index];
+            cgltf_size const num_components = cgltf_num_components(animation_sampler.output->type);
+            GFX_ASSERT(((animation_channel.type_ == kGltfAnimationChannelType_Translate) && (num_components == 3)) ||
+                ((animation_channel.type_ == kGltfAnimationChannelType_Rotate) && (num_components == 4)) ||
+                ((animation_channel.type_ == kGltfAnimationChannelType_Scale) && (num_components == 3)) ||
+                ((animation_channel.type_ == kGltfAnimationChannelType_Weights) && (num_components == 1)));
+            animation_channel.keyframes_.resize(animation_sampler.input->count);
+            animation_channel.values_.resize(num_components * animation_sampler.output->count);
+            bool unpacked;
+            unpacked = UnpackAccessor(animation_sampler.input, animation_channel.keyframes_.data()); GFX_ASSERT(unpacked);
+            if(!animation_channel.values_.empty())
+            {
+                unpacked = UnpackAccessor(animation_sampler.output, animation_channel.values_.data()); GFX_ASSERT(unpacked);
+            }
+        });
         std::function<uint64_t (cgltf_node const *gltf_node, glm::mat4 const &parent_transform,
             std::vector<GfxConstRef<GfxAnimation>> const &parent_animations, uint64_t parent_handle)> VisitNode;
         VisitNode = [&](cgltf_node const *gltf_node, glm::mat4 const &parent_transform,
@@ -1927,7 +2915,7 @@ private:
         {
             glm::mat4 local_transform(1.0); // default to identity
             cgltf_node_transform_local(gltf_node, (float*)&local_transform);
-            std::vector<GfxRef<GfxInstance>> instances;
+            GfxSmallVector<GfxRef<GfxInstance>, 2> instances;
             glm::mat4 const transform = parent_transform * local_transform;
             GfxRef<GfxSkin> skin;
             if(gltf_node->skin != nullptr)
@@ -1943,7 +2931,7 @@ private:
                 std::map<cgltf_mesh const *, std::vector<instance_pair>>::const_iterator const it = meshes.find(gltf_node->mesh);
                 if(it != meshes.end())
                 {
-                    instances.reserve((*it).second.size());
+                    instances.reserve((uint32_t)(*it).second.size());
                     for(size_t i = 0; i < (*it).second.size(); ++i)
                     {
                         GfxRef<GfxInstance> instance_ref = gfxSceneCreateInstance(scene);
@@ -1956,11 +2944,11 @@ private:
                         if(!mesh->morph_targets.empty())
                         {
                             if(gltf_node->weights != nullptr)
-                                instance_ref->weights = std::vector<float>(gltf_node->weights, gltf_node->weights + gltf_node->weights_count);
+                                instance_ref->weights.assign(gltf_node->weights, gltf_node->weights + gltf_node->weights_count);
                             else if(!mesh->default_weights.empty())
-                                instance_ref->weights = mesh->default_weights;
+                                instance_ref->weights.assign(mesh->default_weights.begin(), mesh->default_weights.end());
                             else
-                                instance_ref->weights = std::vector<float>(mesh->morph_targets.size() / mesh->vertices.size(), 0.0f);
+                                instance_ref->weights.resize((uint32_t)(mesh->morph_targets.size() / mesh->vertices.size()), 0.0f);
                         }
                         GfxMetadata &instance_metadata = instance_metadata_[instance_ref];
                         GfxMetadata const *mesh_metadata = mesh_metadata_.at(it->second[i].first);
@@ -2005,11 +2993,14 @@ private:
                     glm::dvec3(local_transform[1]) / animated_node->scale_[1],
                     glm::dvec3(local_transform[2]) / animated_node->scale_[2]);
                 animated_node->rotate_ = glm::quat_cast(rotMtx);
+                animated_node->default_translate_ = animated_node->translate_;
+                animated_node->default_rotate_ = animated_node->rotate_;
+                animated_node->default_scale_ = animated_node->scale_;
             }
             else
             {
                 GFX_ASSERT(node_animations.find(gltf_node) == node_animations.end());
-                node_handle = gltf_node_handles_.allocate_handle();
+                node_handle = gltf_nodes_.allocate_handle();
                 node_handles[gltf_node] = node_handle;
             }
             std::vector<GfxConstRef<GfxAnimation>> propagate_parent_animations;
@@ -2034,8 +3025,8 @@ private:
             {
                 propagate_parent_animations = parent_animations;
             }
-            std::vector<uint64_t> children;
-            children.reserve(gltf_node->children_count);
+            GfxSmallVector<uint64_t, 4> children;
+            children.reserve((uint32_t)gltf_node->children_count);
             for(size_t i = 0; i < gltf_node->children_count; ++i)
             {
                 if(gltf_node->children[i] == nullptr) continue;
@@ -2086,8 +3077,20 @@ private:
             std::set<uint64_t> animated_nodes;
             for(auto const &channel : animation_object.channels_)
                 animated_nodes.insert(channel.node_);
+            std::vector<uint64_t> visit_stack(animation_object.animated_root_nodes_.begin(), animation_object.animated_root_nodes_.end());
+            while(!visit_stack.empty())
+            {
+                uint64_t const node_handle = visit_stack.back();
+                visit_stack.pop_back();
+                if(!gltf_nodes_.has_handle(node_handle)) continue;
+                GltfNode const &node = gltf_nodes_[GetObjectIndex(node_handle)];
+                for(uint32_t i = 0; i < node.instances_.size(); ++i)
+                    if(node.instances_[i])
+                        animation_object.animated_instances_.push_back(node.instances_[i]);
+                visit_stack.insert(visit_stack.end(), node.children_.begin(), node.children_.end());
+            }
             std::set<uint64_t> dependent_skinned_nodes;
-            animation_object.dependent_skins_.reserve(gltf_model->skins_count);
+            animation_object.dependent_skins_.reserve((uint32_t)gltf_model->skins_count);
             for(auto const &skin_data : skins)
             {
                 GltfSkin const &skin = *gltf_skins_.at(GetObjectIndex(skin_data.second));
@@ -2109,7 +3112,7 @@ private:
             if(gltf_nodes_.has(node_index)) continue;
             if(gltf_animated_nodes_.has(node_index))
                 gltf_animated_nodes_.erase(node_index);
-            gltf_node_handles_.free_handle(node_handle);
+            gltf_nodes_.free_handle(node_handle);
         }
         cgltf_free(gltf_model);
         return kGfxResult_NoError;
@@ -2999,8 +4002,7 @@ private:
     }
 };
 
-GfxArray<GfxScene> GfxSceneInternal::scenes_;
-GfxHandles         GfxSceneInternal::scene_handles_("scene");
+GfxSlotMap<GfxScene> GfxSceneInternal::scenes_("scene");
 
 template<typename TYPE>
 GfxResult GfxSceneInternal::destroyObjectCallback(uint64_t object_handle)
@@ -3075,6 +4077,20 @@ GfxResult gfxSceneApplyAnimation(GfxScene scene, uint64_t animation_handle, floa
     return gfx_scene->applyAnimation(animation_handle, time_in_seconds);
 }
 
+GfxResult gfxSceneApplyAnimations(GfxScene scene, uint64_t const *animation_handles, float const *times_in_seconds, float const *weights, uint32_t animation_count, GfxAnimationLayer const *layers)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->applyAnimations(animation_handles, times_in_seconds, weights, animation_count, layers);
+}
+
+GfxResult gfxSceneApplyAnimationBatch(GfxScene scene, uint64_t const *animation_handles, float const *times_in_seconds, uint32_t animation_count, uint32_t thread_count)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->applyAnimationBatch(animation_handles, times_in_seconds, animation_count, thread_count);
+}
+
 GfxResult gfxSceneResetAllAnimation(GfxScene scene)
 {
     GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
@@ -3609,3 +4625,111 @@ bool gfxSceneSetInstanceMetadata(GfxScene scene, uint64_t instance_handle, GfxMe
     if(!gfx_scene) return false;    // invalid parameter
     return gfx_scene->setObjectMetadata<GfxInstance>(instance_handle, metadata);
 }
+
+GfxResult gfxSceneMarkInstanceModified(GfxScene scene, uint64_t instance_handle)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->markInstanceModified(instance_handle);
+}
+
+uint32_t gfxSceneGetModifiedInstanceCount(GfxScene scene)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return 0;    // invalid parameter
+    return gfx_scene->getModifiedInstanceCount();
+}
+
+uint64_t const *gfxSceneGetModifiedInstances(GfxScene scene)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return nullptr;  // invalid parameter
+    return gfx_scene->getModifiedInstances();
+}
+
+GfxResult gfxSceneClearModifiedInstances(GfxScene scene)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->clearModifiedInstances();
+}
+
+GfxRef<GfxAnimationState> gfxSceneCreateAnimationState(GfxScene scene, uint64_t animation_handle)
+{
+    GfxRef<GfxAnimationState> const animation_state_ref = {};
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return animation_state_ref;  // invalid parameter
+    return gfx_scene->createAnimationState(scene, animation_handle);
+}
+
+GfxResult gfxSceneDestroyAnimationState(GfxScene scene, uint64_t animation_state_handle)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->destroyObject<GfxAnimationState>(animation_state_handle);
+}
+
+GfxResult gfxSceneDestroyAllAnimationStates(GfxScene scene)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->clearObjects<GfxAnimationState>();
+}
+
+GfxResult gfxSceneApplyAnimationState(GfxScene scene, uint64_t animation_state_handle, float time_in_seconds)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->applyAnimationState(animation_state_handle, time_in_seconds);
+}
+
+GfxResult gfxSceneApplyAnimationStates(GfxScene scene, uint64_t const *animation_state_handles, float const *times_in_seconds, uint32_t animation_state_count)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return kGfxResult_InvalidParameter;
+    return gfx_scene->applyAnimationStates(animation_state_handles, times_in_seconds, animation_state_count);
+}
+
+uint32_t gfxSceneGetAnimationStateCount(GfxScene scene)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return 0;    // invalid parameter
+    return gfx_scene->getObjectCount<GfxAnimationState>();
+}
+
+GfxAnimationState const *gfxSceneGetAnimationStates(GfxScene scene)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return nullptr;  // invalid parameter
+    return gfx_scene->getObjects<GfxAnimationState>();
+}
+
+GfxAnimationState *gfxSceneGetAnimationState(GfxScene scene, uint64_t animation_state_handle)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return nullptr;  // invalid parameter
+    return gfx_scene->getObject<GfxAnimationState>(animation_state_handle);
+}
+
+GfxRef<GfxAnimationState> gfxSceneGetAnimationStateHandle(GfxScene scene, uint32_t animation_state_index)
+{
+    GfxRef<GfxAnimationState> const animation_state_ref = {};
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return animation_state_ref;  // invalid parameter
+    return gfx_scene->getObjectHandle<GfxAnimationState>(scene, animation_state_index);
+}
+
+GfxMetadata const &gfxSceneGetAnimationStateMetadata(GfxScene scene, uint64_t animation_state_handle)
+{
+    static GfxMetadata const metadata = {};
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return metadata; // invalid parameter
+    return gfx_scene->getObjectMetadata<GfxAnimationState>(animation_state_handle);
+}
+
+bool gfxSceneSetAnimationStateMetadata(GfxScene scene, uint64_t animation_state_handle, GfxMetadata const &metadata)
+{
+    GfxSceneInternal *gfx_scene = GfxSceneInternal::GetGfxScene(scene);
+    if(!gfx_scene) return false;    // invalid parameter
+    return gfx_scene->setObjectMetadata<GfxAnimationState>(animation_state_handle, metadata);
+}
@@ -123,7 +123,18 @@ GfxRef<GfxAnimation> gfxSceneCreateAnimation(GfxScene scene);
 GfxResult gfxSceneDestroyAnimation(GfxScene scene, uint64_t animation_handle);
 GfxResult gfxSceneDestroyAllAnimations(GfxScene scene);
 
+struct GfxAnimationLayer
+{
+    bool            additive         = false;   // adds the clip's motion relative to its first keyframe rather than blending towards it
+    uint64_t        mask_skin_handle = 0;       // optional per-joint mask...
+    float const    *mask_weights     = nullptr; // ...with one weight per joint of the skin, scaling the layer's weight
+};
+
 GfxResult gfxSceneApplyAnimation(GfxScene scene, uint64_t animation_handle, float time_in_seconds);
+GfxResult gfxSceneApplyAnimations(GfxScene scene, uint64_t const *animation_handles, float const *times_in_seconds, float const *weights,
+                                  uint32_t animation_count, GfxAnimationLayer const *layers = nullptr);  // blends the clips in order starting from the rest pose, then updates the transforms once; the weights of the non-additive clips are normalized per channel when they add up to more than one
+GfxResult gfxSceneApplyAnimationBatch(GfxScene scene, uint64_t const *animation_handles, float const *times_in_seconds,
+                                      uint32_t animation_count, uint32_t thread_count = 0); // applies independent animations in parallel on the job system, on at most `thread_count' threads at once (0 for all of them); those with overlapping hierarchies get applied in order on the same thread
 GfxResult gfxSceneResetAllAnimation(GfxScene scene);
 
 float gfxSceneGetAnimationLength(GfxScene scene, uint64_t animation_handle);    // in secs
@@ -417,7 +428,7 @@ struct GfxInstance
     GfxConstRef<GfxMesh>     mesh;
     GfxConstRef<GfxMaterial> material;
     GfxConstRef<GfxSkin>     skin;
-    std::vector<float>       weights;
+    GfxSmallVector<float, 8> weights;   // morph target weights, stored inline for up to 8 targets
 
     glm::mat4 transform = glm::mat4(1.0f);
 };
@@ -433,6 +444,39 @@ GfxRef<GfxInstance> gfxSceneGetInstanceHandle(GfxScene scene, uint32_t instance_
 GfxMetadata const &gfxSceneGetInstanceMetadata(GfxScene scene, uint64_t instance_handle);
 bool gfxSceneSetInstanceMetadata(GfxScene scene, uint64_t instance_handle, GfxMetadata const &metadata);
 
+GfxResult gfxSceneMarkInstanceModified(GfxScene scene, uint64_t instance_handle);  // records a transform change made through the instance's reference; animations record theirs
+uint32_t gfxSceneGetModifiedInstanceCount(GfxScene scene);
+uint64_t const *gfxSceneGetModifiedInstances(GfxScene scene);  // each instance once, in order of modification since the last clear; may contain instances that got destroyed since
+GfxResult gfxSceneClearModifiedInstances(GfxScene scene);
+
+//!
+//! Animation state object.
+//!
+
+struct GfxAnimationState
+{
+    GfxConstRef<GfxAnimation>        animation;     // the clip being played; its keyframes are shared with all the other states
+    std::vector<GfxRef<GfxInstance>> instances;     // copies of the instances animated by the clip, sharing their meshes and materials
+    std::vector<GfxRef<GfxSkin>>     skins;         // copies of the skins deformed by the clip, holding this state's joint matrices
+
+    glm::mat4 transform = glm::mat4(1.0f);  // places the copy relative to the imported hierarchy
+};
+
+GfxRef<GfxAnimationState> gfxSceneCreateAnimationState(GfxScene scene, uint64_t animation_handle);
+GfxResult gfxSceneDestroyAnimationState(GfxScene scene, uint64_t animation_state_handle);  // also destroys the copied instances and skins
+GfxResult gfxSceneDestroyAllAnimationStates(GfxScene scene);
+
+GfxResult gfxSceneApplyAnimationState(GfxScene scene, uint64_t animation_state_handle, float time_in_seconds);
+GfxResult gfxSceneApplyAnimationStates(GfxScene scene, uint64_t const *animation_state_handles, float const *times_in_seconds,
+                                       uint32_t animation_state_count); // states don't share any data they write to, so they get evaluated in parallel
+
+uint32_t gfxSceneGetAnimationStateCount(GfxScene scene);
+GfxAnimationState const *gfxSceneGetAnimationStates(GfxScene scene);
+GfxAnimationState *gfxSceneGetAnimationState(GfxScene scene, uint64_t animation_state_handle);
+GfxRef<GfxAnimationState> gfxSceneGetAnimationStateHandle(GfxScene scene, uint32_t animation_state_index);
+GfxMetadata const &gfxSceneGetAnimationStateMetadata(GfxScene scene, uint64_t animation_state_handle);
+bool gfxSceneSetAnimationStateMetadata(GfxScene scene, uint64_t animation_state_handle, GfxMetadata const &metadata);
+
 //!
 //! Template specializations.
 //!
@@ -493,6 +537,13 @@ template<> inline GfxRef<GfxInstance> gfxSceneGetObjectHandle<GfxInstance>(GfxSc
 template<> inline GfxMetadata const &gfxSceneGetObjectMetadata<GfxInstance>(GfxScene scene, uint64_t object_handle) { return gfxSceneGetInstanceMetadata(scene, object_handle); }
 template<> inline bool gfxSceneSetObjectMetadata<GfxInstance>(GfxScene scene, uint64_t object_handle, GfxMetadata const &metadata) { return gfxSceneSetInstanceMetadata(scene, object_handle, metadata); }
 
+template<> inline uint32_t gfxSceneGetObjectCount<GfxAnimationState>(GfxScene scene) { return gfxSceneGetAnimationStateCount(scene); }
+template<> inline GfxAnimationState const *gfxSceneGetObjects<GfxAnimationState>(GfxScene scene) { return gfxSceneGetAnimationStates(scene); }
+template<> inline GfxAnimationState *gfxSceneGetObject<GfxAnimationState>(GfxScene scene, uint64_t object_handle) { return gfxSceneGetAnimationState(scene, object_handle); }
+template<> inline GfxRef<GfxAnimationState> gfxSceneGetObjectHandle<GfxAnimationState>(GfxScene scene, uint32_t object_index) { return gfxSceneGetAnimationStateHandle(scene, object_index); }
+template<> inline GfxMetadata const &gfxSceneGetObjectMetadata<GfxAnimationState>(GfxScene scene, uint64_t object_handle) { return gfxSceneGetAnimationStateMetadata(scene, object_handle); }
+template<> inline bool gfxSceneSetObjectMetadata<GfxAnimationState>(GfxScene scene, uint64_t object_handle, GfxMetadata const &metadata) { return gfxSceneSetAnimationStateMetadata(scene, object_handle, metadata); }
+
 template<typename TYPE> uint32_t gfxSceneGetObjectCount(GfxScene scene) { static_assert(std::is_void_v<TYPE>, "Cannot get object count for unsupported object type"); }
 template<typename TYPE> TYPE const *gfxSceneGetObjects(GfxScene scene) { static_assert(std::is_void_v<TYPE>, "Cannot get object list for unsupported object type"); }
 template<typename TYPE> TYPE *gfxSceneGetObject(GfxScene scene, uint64_t object_handle) { static_assert(std::is_void_v<TYPE>, "Cannot get scene object for unsupported object type"); }
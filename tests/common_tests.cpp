@@ -0,0 +1,927 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gfx_core.h"
+#include "blas_sharing_map.h"
+#include "culling.h"
+#include "draw_list.h"
+#include "gpu_allocator.h"
+#include "joint_palette.h"
+#include "light_clusters.h"
+#include "occlusion.h"
+#include "texture_atlas.h"
+#include "gfx_test.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+
+//!
+//! Range allocator.
+//!
+
+GFX_TEST(RangeAllocatorFirstFit)
+{
+    RangeAllocator allocator(100);
+    uint32_t a = 0, b = 0, c = 0, d = 0;
+    GFX_CHECK(allocator.allocate(10, a) && a == 0);
+    GFX_CHECK(allocator.allocate(20, b) && b == 10);
+    GFX_CHECK(allocator.allocate(30, c) && c == 30);
+    GFX_CHECK(!allocator.allocate(41, d));  // only 40 left
+    allocator.free(b, 20);
+    GFX_CHECK(allocator.getFreeRangeCount() == 2 && allocator.getLargestFreeRange() == 40);
+    GFX_CHECK(allocator.allocate(15, d) && d == 10);    // first fit goes into the hole
+    allocator.free(a, 10);
+    allocator.free(d, 15);
+    GFX_CHECK(allocator.getFreeRangeCount() == 2 && allocator.getLargestFreeRange() == 40);   // [0, 30) coalesced
+    allocator.grow(200);
+    GFX_CHECK(allocator.getCapacity() == 200 && allocator.getFreeCount() == 170 && allocator.getLargestFreeRange() == 140);
+    allocator.free(c, 30);
+    GFX_CHECK(allocator.getFreeRangeCount() == 1 && allocator.getFreeCount() == 200);
+}
+
+GFX_TEST(RangeAllocatorRandom)
+{
+    uint32_t const capacity = 4096;
+    RangeAllocator allocator(capacity);
+    std::vector<bool> used(capacity, false);    // reference occupancy
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    std::mt19937 rng(1);
+    uint32_t overlap_count = 0;
+    for(uint32_t i = 0; i < 100000; ++i)
+    {
+        if(ranges.empty() || (rng() % 2) == 0)
+        {
+            uint32_t offset = 0;
+            uint32_t const count = 1 + rng() % 64;
+            if(!allocator.allocate(count, offset)) continue;    // full
+            for(uint32_t j = offset; j < offset + count; ++j)
+            {
+                overlap_count += (used[j] ? 1 : 0);
+                used[j] = true;
+            }
+            ranges.emplace_back(offset, count);
+        }
+        else
+        {
+            size_t const index = rng() % ranges.size();
+            allocator.free(ranges[index].first, ranges[index].second);
+            std::fill(used.begin() + ranges[index].first, used.begin() + ranges[index].first + ranges[index].second, false);
+            ranges[index] = ranges.back();
+            ranges.pop_back();
+        }
+    }
+    GFX_CHECK(overlap_count == 0);
+    GFX_CHECK(allocator.getFreeCount() == (uint32_t)std::count(used.begin(), used.end(), false));
+    for(std::pair<uint32_t, uint32_t> const &range : ranges)
+        allocator.free(range.first, range.second);
+    GFX_CHECK(allocator.getFreeRangeCount() == 1 && allocator.getLargestFreeRange() == capacity);
+}
+
+GFX_TEST(RangeAllocatorBenchmark)
+{
+    uint32_t const live_count = 10000;  // meshes resident in the pool
+    uint32_t const operation_count = gfxTestIterations(1000000);
+    RangeAllocator allocator(live_count * 64);
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    std::mt19937 rng(1);
+    for(uint32_t i = 0; i < live_count; ++i)
+    {
+        uint32_t offset = 0, count = 1 + rng() % 64;
+        if(allocator.allocate(count, offset)) ranges.emplace_back(offset, count);
+    }
+    uint32_t failure_count = 0;
+    double const start = gfxTestSeconds();
+    for(uint32_t i = 0; i < operation_count; ++i)
+    {
+        size_t const index = rng() % ranges.size();     // replace a random mesh with one of a different size
+        allocator.free(ranges[index].first, ranges[index].second);
+        ranges[index].second = 1 + rng() % 64;
+        if(!allocator.allocate(ranges[index].second, ranges[index].first))
+        {
+            allocator.grow(allocator.getCapacity() + ranges[index].second);
+            allocator.allocate(ranges[index].second, ranges[index].first);
+            ++failure_count;
+        }
+    }
+    double const seconds = gfxTestSeconds() - start;
+    printf("%u live ranges: %.1f ns per free+allocate, %u free ranges, %u grows (%u operations)\n", live_count,
+        1e9 * seconds / operation_count, allocator.getFreeRangeCount(), failure_count, operation_count);
+}
+
+//!
+//! BLAS sharing map.
+//!
+
+static uint64_t MakeHandle(uint32_t index, uint32_t age = 1)
+{
+    return ((uint64_t)age << 32) | index;
+}
+
+GFX_TEST(BlasSharingMapInstancing)
+{
+    BlasSharingMap map;
+    BlasSharingMap::Changes changes;
+    uint32_t const instance_count = 1000;
+    std::vector<uint64_t> instances(instance_count), meshes(instance_count, MakeHandle(7));
+    for(uint32_t i = 0; i < instance_count; ++i)
+        instances[i] = MakeHandle(i);
+    map.update(instances.data(), meshes.data(), instance_count, changes);
+    GFX_CHECK(changes.added_meshes.size() == 1 && changes.added_meshes[0] == MakeHandle(7));   // one BLAS for all the instances
+    GFX_CHECK(changes.added_instances.size() == instance_count && changes.removed_instances.empty() && changes.removed_meshes.empty());
+    GFX_CHECK(map.getMeshReferenceCount(MakeHandle(7)) == instance_count && map.getMeshCount() == 1);
+    map.update(instances.data(), meshes.data(), instance_count, changes);
+    GFX_CHECK(changes.added_meshes.empty() && changes.added_instances.empty() && changes.removed_instances.empty() && changes.removed_meshes.empty());
+    map.update(instances.data(), meshes.data(), instance_count - 1, changes);  // last instance removed
+    GFX_CHECK(changes.removed_instances.size() == 1 && changes.removed_instances[0] == MakeHandle(instance_count - 1) && changes.removed_meshes.empty());
+    GFX_CHECK(map.getMeshReferenceCount(MakeHandle(7)) == instance_count - 1 && map.getInstanceMesh(MakeHandle(instance_count - 1)) == 0);
+    map.update(nullptr, nullptr, 0, changes);
+    GFX_CHECK(changes.removed_instances.size() == instance_count - 1 && changes.removed_meshes.size() == 1 && map.getMeshCount() == 0);
+}
+
+GFX_TEST(BlasSharingMapChanges)
+{
+    BlasSharingMap map;
+    BlasSharingMap::Changes changes;
+    uint64_t instances[] = { MakeHandle(0), MakeHandle(1) };
+    uint64_t meshes[] = { MakeHandle(10), MakeHandle(11) };
+    map.update(instances, meshes, 2, changes);
+    GFX_CHECK(changes.added_meshes.size() == 2 && map.getInstanceCount() == 2);
+    meshes[1] = MakeHandle(10);     // second instance switches mesh, releasing the last reference to its old one
+    map.update(instances, meshes, 2, changes);
+    GFX_CHECK(changes.removed_instances.size() == 1 && changes.removed_instances[0] == MakeHandle(1));
+    GFX_CHECK(changes.added_instances.size() == 1 && changes.added_instances[0] == MakeHandle(1));
+    GFX_CHECK(changes.removed_meshes.size() == 1 && changes.removed_meshes[0] == MakeHandle(11) && changes.added_meshes.empty());
+    GFX_CHECK(map.getMeshReferenceCount(MakeHandle(10)) == 2 && map.getInstanceMesh(MakeHandle(1)) == MakeHandle(10));
+    instances[0] = MakeHandle(0, 2);    // slot reused by a new instance of the same mesh, which keeps its BLAS
+    map.update(instances, meshes, 2, changes);
+    GFX_CHECK(changes.removed_instances.size() == 1 && changes.removed_instances[0] == MakeHandle(0, 1));
+    GFX_CHECK(changes.added_instances.size() == 1 && changes.added_instances[0] == MakeHandle(0, 2));
+    GFX_CHECK(changes.added_meshes.empty() && changes.removed_meshes.empty() && map.getMeshReferenceCount(MakeHandle(10)) == 2);
+    instances[0] = MakeHandle(0, 3);    // same, with a mesh that's only referenced by this instance
+    meshes[0] = MakeHandle(12);
+    meshes[1] = MakeHandle(12);
+    map.update(instances, meshes, 2, changes);
+    GFX_CHECK(changes.added_meshes.size() == 1 && changes.added_meshes[0] == MakeHandle(12));
+    GFX_CHECK(changes.removed_meshes.size() == 1 && changes.removed_meshes[0] == MakeHandle(10));
+}
+
+GFX_TEST(BlasSharingMapBenchmark)
+{
+    uint32_t const instance_count = 100000, mesh_count = 1000;
+    uint32_t const update_count = gfxTestIterations(1000);
+    std::vector<uint64_t> instances(instance_count), meshes(instance_count);
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        instances[i] = MakeHandle(i);
+        meshes[i] = MakeHandle(i % mesh_count);
+    }
+    BlasSharingMap map;
+    BlasSharingMap::Changes changes;
+    map.update(instances.data(), meshes.data(), instance_count, changes);
+    GFX_CHECK(changes.added_meshes.size() == mesh_count);
+    uint32_t const churn_count = instance_count / 100;  // 1% of the instances get replaced each update
+    double const start = gfxTestSeconds();
+    for(uint32_t update = 0; update < update_count; ++update)
+    {
+        for(uint32_t i = 0; i < churn_count; ++i)
+        {
+            uint32_t const index = (update * churn_count + i) % instance_count;
+            instances[index] = MakeHandle(index, (uint32_t)(instances[index] >> 32) + 1);
+        }
+        map.update(instances.data(), meshes.data(), instance_count, changes);
+    }
+    double const seconds = gfxTestSeconds() - start;
+    GFX_CHECK(map.getInstanceCount() == instance_count && map.getMeshCount() == mesh_count);
+    printf("%u instances of %u meshes, %u replaced per update: %.3f ms/update (%u updates)\n", instance_count, mesh_count, churn_count,
+        1e3 * seconds / update_count, update_count);
+}
+
+//!
+//! Draw list builder.
+//!
+
+static std::vector<DrawItem> MakeRandomDraws(uint32_t draw_count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<DrawItem> draw_items(draw_count);
+    for(uint32_t i = 0; i < draw_count; ++i)
+    {
+        DrawItem &draw_item = draw_items[i];
+        draw_item.pass        = rng() % 3;
+        draw_item.kernel      = rng() % 8;
+        draw_item.material    = rng() % 500;
+        draw_item.mesh        = rng() % 5000;
+        draw_item.depth       = (float)(rng() % 10000) / 10.0f;
+        draw_item.instance_id = i;
+        draw_item.index_count = 3 * (1 + rng() % 1000);
+        draw_item.first_index = rng() % 100000;
+    }
+    return draw_items;
+}
+
+GFX_TEST(DrawListBuilderSort)
+{
+    for(uint32_t draw_count : { 0u, 1u, 1000u, 100000u })
+        for(uint32_t thread_count : { 0u, 1u, 3u, 8u })
+        {
+            std::vector<DrawItem> const draw_items = MakeRandomDraws(draw_count, draw_count);
+            DrawListBuilder builder;
+            for(DrawItem const &draw_item : draw_items) builder.addDraw(draw_item);
+            builder.build(thread_count);
+            std::vector<uint32_t> expected(draw_count);
+            for(uint32_t i = 0; i < draw_count; ++i) expected[i] = i;
+            std::stable_sort(expected.begin(), expected.end(), [&](uint32_t lhs, uint32_t rhs)
+                { return DrawListBuilder::CalculateSortKey(draw_items[lhs]) < DrawListBuilder::CalculateSortKey(draw_items[rhs]); });
+            GFX_CHECK(builder.getInstanceIds() == expected);    // the radix sort is stable, so ties keep their order
+            uint32_t batched_count = 0, mismatch_count = 0;
+            for(DrawBatch const &batch : builder.getBatches())
+            {
+                GFX_CHECK(batch.first_draw == batched_count && batch.draw_count > 0);
+                for(uint32_t i = 0; i < batch.draw_count; ++i)
+                {
+                    DrawItem const &draw_item = draw_items[expected[batch.first_draw + i]];
+                    DrawIndexedArguments const &arguments = builder.getArguments()[batch.first_draw + i];
+                    mismatch_count += (draw_item.pass != batch.pass || draw_item.kernel != batch.kernel ? 1 : 0);
+                    mismatch_count += (arguments.start_instance_location != i || arguments.instance_count != 1 ? 1 : 0);
+                    mismatch_count += (arguments.index_count_per_instance != draw_item.index_count || arguments.start_index_location != draw_item.first_index ? 1 : 0);
+                }
+                batched_count += batch.draw_count;
+            }
+            GFX_CHECK(batched_count == draw_count && mismatch_count == 0);
+            for(size_t i = 1; i < builder.getBatches().size(); ++i)
+            {
+                DrawBatch const &previous = builder.getBatches()[i - 1], &batch = builder.getBatches()[i];
+                GFX_CHECK(previous.pass != batch.pass || previous.kernel != batch.kernel);  // runs are merged
+            }
+        }
+}
+
+GFX_TEST(DrawListBuilderBenchmark)
+{
+    uint32_t const draw_count = 1000000;
+    uint32_t const iteration_count = gfxTestIterations(200);
+    DrawListBuilder builder;
+    builder.reserve(draw_count);
+    for(DrawItem const &draw_item : MakeRandomDraws(draw_count, 1)) builder.addDraw(draw_item);
+    for(uint32_t thread_count : { 1u, 0u })
+    {
+        builder.build(thread_count);    // warm up the allocations
+        double const start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            builder.build(thread_count);
+        double const seconds = gfxTestSeconds() - start;
+        printf("%u draws, %u threads: %.2f ms per sort and compaction into %u batches (%u iterations)\n", draw_count,
+            thread_count > 0 ? thread_count : gfxGetJobSystem().get_thread_count(), 1e3 * seconds / iteration_count,
+            (uint32_t)builder.getBatches().size(), iteration_count);
+    }
+}
+
+//!
+//! Instance culling.
+//!
+
+static void MakeRandomSpheres(CullingBounds &bounds, uint32_t count, float extent, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-extent, extent), radius(0.1f, 4.0f);
+    bounds.resize(count);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        float const x = position(rng), y = 0.02f * position(rng), z = position(rng);
+        bounds.setSphere(i, glm::vec3(x, y, z), radius(rng));
+    }
+}
+
+static std::vector<CullingView> MakeCascadeViews(uint32_t view_count)
+{
+    std::vector<CullingView> views;
+    glm::vec3 const eye(0.0f, 10.0f, 0.0f);
+    glm::mat4 const proj = glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 10000.0f);
+    for(uint32_t v = 0; v < view_count; ++v)    // main view first, then tighter cascade-like views
+    {
+        glm::vec3 const target(100.0f * (float)v, 0.0f, 400.0f);
+        views.push_back(CreateCullingView(proj * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)), eye, v == 0 ? 3.402823466e+38f : 250.0f * (float)v));
+    }
+    return views;
+}
+
+GFX_TEST(CullInstancesBruteForce)
+{
+    uint32_t const count = 100003;  // not a multiple of the block size, and enough blocks for a few jobs
+    CullingBounds bounds;
+    MakeRandomSpheres(bounds, count, 1000.0f, 7);
+    std::vector<CullingView> const views = MakeCascadeViews(3);
+    // Reference in double precision; spheres within a hair of a plane may go either way
+    std::vector<uint32_t> expected[3], ambiguous[3];
+    for(uint32_t v = 0; v < 3; ++v)
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            CullingView const &view = views[v];
+            double const x = bounds.getCentersX()[i], y = bounds.getCentersY()[i], z = bounds.getCentersZ()[i], r = bounds.getRadii()[i];
+            double margin = (double)view.max_distance + r - std::sqrt((x - view.eye.x) * (x - view.eye.x) + (y - view.eye.y) * (y - view.eye.y) + (z - view.eye.z) * (z - view.eye.z));
+            for(glm::vec4 const &plane : view.planes)
+                margin = std::min(margin, plane.x * x + plane.y * y + plane.z * z + plane.w + r);
+            if(std::abs(margin) < 1e-2) ambiguous[v].push_back(i);
+            else if(margin > 0.0) expected[v].push_back(i);
+        }
+    GFX_CHECK(expected[0].size() > 1000 && expected[0].size() < count / 2);
+    GFX_CHECK(expected[2].size() > 100 && expected[2].size() < expected[0].size());
+    GFX_CHECK(ambiguous[0].size() + ambiguous[1].size() + ambiguous[2].size() < count / 1000);
+    for(uint32_t thread_count : { 1u, 2u, 3u, 0u })
+    {
+        std::vector<uint32_t> visible[3];
+        CullInstances(bounds, views.data(), 3, visible, thread_count);
+        for(uint32_t v = 0; v < 3; ++v)
+        {
+            GFX_CHECK(std::is_sorted(visible[v].begin(), visible[v].end()) && std::adjacent_find(visible[v].begin(), visible[v].end()) == visible[v].end());
+            std::vector<uint32_t> certain;
+            std::set_difference(visible[v].begin(), visible[v].end(), ambiguous[v].begin(), ambiguous[v].end(), std::back_inserter(certain));
+            GFX_CHECK(certain == expected[v]);
+        }
+    }
+}
+
+GFX_TEST(CullInstancesBenchmark)
+{
+    uint32_t const count = 1000000;
+    uint32_t const iteration_count = gfxTestIterations(500);
+    CullingBounds bounds;
+    MakeRandomSpheres(bounds, count, 2000.0f, 1);
+    std::vector<CullingView> const views = MakeCascadeViews(4);
+    std::vector<uint32_t> visible[4];
+    for(uint32_t view_count : { 1u, 4u })
+        for(uint32_t thread_count : { 1u, 0u })
+        {
+            CullInstances(bounds, views.data(), view_count, visible, thread_count);   // warm up the allocations
+            double const start = gfxTestSeconds();
+            for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+                CullInstances(bounds, views.data(), view_count, visible, thread_count);
+            double const seconds = gfxTestSeconds() - start;
+            printf("%u instances, %u views, %u threads: %.2f ms per cull, %u visible in the main view (%u iterations)\n", count, view_count,
+                thread_count > 0 ? thread_count : gfxGetJobSystem().get_thread_count(), 1e3 * seconds / iteration_count, (uint32_t)visible[0].size(), iteration_count);
+        }
+}
+
+//!
+//! Occlusion buffer.
+//!
+
+// Street-level view down a grid of buildings of random heights, each a unit cube occluder scaled into place.
+struct OcclusionCity
+{
+    OcclusionCity(uint32_t block_count, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> height(10.0f, 80.0f);
+        for(uint32_t i = 0; i < block_count; ++i)
+            for(uint32_t j = 0; j < block_count; ++j)
+            {
+                glm::vec3 const center(40.0f * ((float)i - 0.5f * (float)block_count), 0.0f, 40.0f * (float)j + 40.0f);
+                glm::vec3 const size(30.0f, height(rng), 30.0f);
+                building_mins.push_back(center - glm::vec3(0.5f * size.x, 0.0f, 0.5f * size.z));
+                building_maxs.push_back(center + glm::vec3(0.5f * size.x, size.y, 0.5f * size.z));
+            }
+        for(uint32_t i = 0; i < 8; ++i)
+            for(uint32_t axis = 0; axis < 3; ++axis) cube_positions[3 * i + axis] = ((i >> axis) & 1) != 0 ? 1.0f : 0.0f;
+        uint32_t const faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+        for(uint32_t face = 0; face < 6; ++face)
+        {
+            uint32_t const quad[6] = { faces[face][0], faces[face][1], faces[face][2], faces[face][0], faces[face][2], faces[face][3] };
+            for(uint32_t i = 0; i < 6; ++i) cube_indices[6 * face + i] = quad[i];
+        }
+        eye = glm::vec3(20.0f, 2.0f, 0.0f);     // in the middle of a street
+        forward = glm::normalize(glm::vec3(0.15f, 0.0f, 1.0f));
+        right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+        up = glm::cross(right, forward);
+        view_proj = glm::perspectiveZO(kFovY, kAspect, 0.1f, 10000.0f) * glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    void rasterize(OcclusionBuffer &occlusion_buffer, uint32_t thread_count) const
+    {
+        occlusion_buffer.begin(view_proj);
+        for(size_t i = 0; i < building_mins.size(); ++i)
+        {
+            glm::mat4 const transform = glm::scale(glm::translate(glm::mat4(1.0f), building_mins[i]), building_maxs[i] - building_mins[i]);
+            occlusion_buffer.addOccluder(cube_positions, 3 * sizeof(float), cube_indices, 36, transform);
+        }
+        occlusion_buffer.rasterize(thread_count);
+    }
+
+    // Distance along the ray to the nearest building, or FLT_MAX
+    float trace(glm::vec3 const &direction) const
+    {
+        float nearest = 3.402823466e+38f;
+        for(size_t i = 0; i < building_mins.size(); ++i)
+        {
+            float t_min = 0.0f, t_max = nearest;
+            for(uint32_t axis = 0; axis < 3 && t_min <= t_max; ++axis)
+            {
+                float const t0 = (building_mins[i][axis] - eye[axis]) / direction[axis];
+                float const t1 = (building_maxs[i][axis] - eye[axis]) / direction[axis];
+                t_min = std::max(t_min, std::min(t0, t1));
+                t_max = std::min(t_max, std::max(t0, t1));
+            }
+            if(t_min <= t_max) nearest = t_min;
+        }
+        return nearest;
+    }
+
+    // Ray through the given pixel offset from the projection of `point'
+    glm::vec3 getRay(glm::vec3 const &point, float pixel_x, float pixel_y, uint32_t width, uint32_t height) const
+    {
+        glm::vec4 const clip = view_proj * glm::vec4(point, 1.0f);
+        float const tan_y = std::tan(0.5f * kFovY);
+        float const ndc_x = clip.x / clip.w + 2.0f * pixel_x / (float)width;
+        float const ndc_y = clip.y / clip.w - 2.0f * pixel_y / (float)height;
+        return glm::normalize(forward + (ndc_x * kAspect * tan_y) * right + (ndc_y * tan_y) * up);
+    }
+
+    static constexpr float kFovY = 1.0f;
+    static constexpr float kAspect = 2.0f;
+
+    std::vector<glm::vec3> building_mins;
+    std::vector<glm::vec3> building_maxs;
+    float cube_positions[24];
+    uint32_t cube_indices[36];
+    glm::vec3 eye, forward, right, up;
+    glm::mat4 view_proj;
+};
+
+GFX_TEST(OcclusionBufferThreadInvariance)
+{
+    OcclusionCity const city(24, 3);
+    std::vector<float> reference;
+    for(uint32_t thread_count : { 1u, 2u, 5u, 16u, 0u })
+    {
+        OcclusionBuffer occlusion_buffer;
+        occlusion_buffer.resize(256, 128);
+        city.rasterize(occlusion_buffer, thread_count);
+        std::vector<float> depth;
+        for(uint32_t y = 0; y < occlusion_buffer.getHeight(); ++y)
+            for(uint32_t x = 0; x < occlusion_buffer.getWidth(); ++x) depth.push_back(occlusion_buffer.getDepth(x, y));
+        if(reference.empty()) reference = depth;
+        GFX_CHECK(depth == reference);  // the binning jobs don't change what gets rasterized
+    }
+    GFX_CHECK(std::count(reference.begin(), reference.end(), 1.0f) < (std::ptrdiff_t)reference.size() / 2);
+}
+
+GFX_TEST(OcclusionBufferAccuracy)
+{
+    uint32_t const width = 256, height = 128, object_count = 300;
+    OcclusionCity const city(24, 3);
+    OcclusionBuffer occlusion_buffer;
+    occlusion_buffer.resize(width, height);
+    city.rasterize(occlusion_buffer, 0);
+    // Classify random objects in the streets by tracing rays near their projection: an object is clearly visible
+    // when nothing lies in front of it within a few pixels of its center, and clearly hidden when buildings cover
+    // its whole screen bounds with a margin. Visible objects must never be culled; most hidden ones should be.
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> x(-480.0f, 480.0f), z(5.0f, 960.0f), radius(0.5f, 3.0f);
+    uint32_t visible_count = 0, false_cull_count = 0, hidden_count = 0, hidden_cull_count = 0;
+    while(visible_count < object_count || hidden_count < object_count)
+    {
+        float const r = radius(rng);
+        glm::vec3 const center(x(rng), r, z(rng));
+        bool inside = false;
+        for(size_t i = 0; i < city.building_mins.size(); ++i)
+        {
+            bool overlaps = true;
+            for(uint32_t axis = 0; axis < 3; ++axis)
+                overlaps &= (center[axis] + r > city.building_mins[i][axis] && center[axis] - r < city.building_maxs[i][axis]);
+            inside |= overlaps;
+        }
+        glm::vec4 const clip = city.view_proj * glm::vec4(center, 1.0f);
+        if(inside || clip.w < 10.0f || std::abs(clip.x) > 0.8f * clip.w || std::abs(clip.y) > 0.8f * clip.w) continue;
+        float const distance = glm::length(center - city.eye);
+        float const pixel_radius = r / (distance * std::tan(0.5f * OcclusionCity::kFovY)) * 0.5f * (float)height;
+        int32_t const extent = (int32_t)std::ceil(pixel_radius) + 2;
+        if(extent > 12) continue;
+        // The ray through the center decides which of the two classifications is worth checking
+        float const center_hit = city.trace(city.getRay(center, 0.0f, 0.0f, width, height));
+        bool const maybe_visible = (center_hit > distance + r && visible_count < object_count);
+        bool const maybe_hidden = (center_hit < 0.9f * (distance - r) && hidden_count < object_count);
+        if(!maybe_visible && !maybe_hidden) continue;
+        int32_t const trace_extent = (maybe_visible ? 2 : extent);
+        bool classified = true;
+        for(int32_t py = -trace_extent; py <= trace_extent && classified; ++py)
+            for(int32_t px = -trace_extent; px <= trace_extent && classified; ++px)
+            {
+                float const hit = city.trace(city.getRay(center, (float)px, (float)py, width, height));
+                classified = (maybe_visible ? hit > distance + r : hit < 0.9f * (distance - r));
+            }
+        if(!classified) continue;
+        bool const culled = !occlusion_buffer.isVisible(center, r);
+        if(maybe_visible) { ++visible_count; false_cull_count += (culled ? 1 : 0); }
+        else { ++hidden_count; hidden_cull_count += (culled ? 1 : 0); }
+    }
+    GFX_CHECK(false_cull_count == 0);
+    GFX_CHECK(hidden_cull_count > hidden_count / 2);
+    printf("%u of %u clearly hidden objects culled\n", hidden_cull_count, hidden_count);
+}
+
+GFX_TEST(OcclusionBufferBenchmark)
+{
+    uint32_t const object_count = 100000;
+    uint32_t const iteration_count = gfxTestIterations(200);
+    OcclusionCity const city(64, 1);    // 4096 buildings, 49152 occluder triangles
+    CullingBounds bounds;
+    MakeRandomSpheres(bounds, object_count, 1000.0f, 2);
+    std::vector<uint32_t> all_indices(object_count), visible_indices;
+    for(uint32_t i = 0; i < object_count; ++i) all_indices[i] = i;
+    OcclusionBuffer occlusion_buffer;
+    occlusion_buffer.resize(512, 256);
+    for(uint32_t thread_count : { 1u, 0u })
+    {
+        city.rasterize(occlusion_buffer, thread_count);   // warm up the allocations
+        double const start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            city.rasterize(occlusion_buffer, thread_count);
+        double const rasterize_seconds = gfxTestSeconds() - start;
+        visible_indices = all_indices;
+        double const test_start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            visible_indices = all_indices;
+            CullOccludedInstances(occlusion_buffer, bounds, visible_indices);
+        }
+        double const test_seconds = gfxTestSeconds() - test_start;
+        printf("%u buildings at %ux%u, %u threads: %.2f ms per rasterization, %.2f ms to test %u objects, %u left (%u iterations)\n",
+            (uint32_t)city.building_mins.size(), occlusion_buffer.getWidth(), occlusion_buffer.getHeight(),
+            thread_count > 0 ? thread_count : gfxGetJobSystem().get_thread_count(), 1e3 * rasterize_seconds / iteration_count,
+            1e3 * test_seconds / iteration_count, object_count, (uint32_t)visible_indices.size(), iteration_count);
+    }
+}
+
+//!
+//! Light clusters.
+//!
+
+static void MakeRandomLights(CullingBounds &light_bounds, uint32_t light_count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> x(-200.0f, 200.0f), y(-20.0f, 20.0f), z(-400.0f, 50.0f), radius(1.0f, 11.0f);
+    light_bounds.resize(light_count);
+    for(uint32_t i = 0; i < light_count; ++i)
+        light_bounds.setSphere(i, glm::vec3(x(rng), y(rng), z(rng)), i % 100 == 0 ? -1.0f : radius(rng));   // a few directional lights
+}
+
+GFX_TEST(LightClustersBruteForce)
+{
+    uint32_t const light_count = 2000;
+    float const near_z = 0.1f, far_z = 500.0f;
+    CullingBounds light_bounds;
+    MakeRandomLights(light_bounds, light_count, 1);
+    glm::mat4 const view = glm::lookAt(glm::vec3(-3.0f, 2.0f, 0.0f), glm::vec3(-3.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 const proj = glm::perspectiveZO(0.8f, 16.0f / 9.0f, near_z, 1000.0f);
+    LightClusters reference;
+    reference.resize(16, 9, 24);
+    reference.build(light_bounds, view, proj, near_z, far_z, 1);
+    std::vector<uint32_t> const reference_indices(reference.getLightIndices(), reference.getLightIndices() + reference.getLightIndexCount());
+    for(uint32_t thread_count : { 2u, 3u, 0u })
+    {
+        LightClusters light_clusters;
+        light_clusters.resize(16, 9, 24);
+        light_clusters.build(light_bounds, view, proj, near_z, far_z, thread_count);
+        uint32_t mismatch_count = 0;
+        for(uint32_t i = 0; i < reference.getClusterCount(); ++i)
+            mismatch_count += (light_clusters.getClusters()[i].offset != reference.getClusters()[i].offset || light_clusters.getClusters()[i].count != reference.getClusters()[i].count ? 1 : 0);
+        GFX_CHECK(mismatch_count == 0);
+        GFX_CHECK(std::equal(reference_indices.begin(), reference_indices.end(), light_clusters.getLightIndices(), light_clusters.getLightIndices() + light_clusters.getLightIndexCount()));
+    }
+    // Every light containing a point must be listed in the point's cluster
+    std::vector<glm::vec3> view_centers(light_count);
+    for(uint32_t i = 0; i < light_count; ++i)
+        view_centers[i] = glm::vec3(view * glm::vec4(light_bounds.getCentersX()[i], light_bounds.getCentersY()[i], light_bounds.getCentersZ()[i], 1.0f));
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    uint32_t checked_count = 0, missing_count = 0, unsorted_count = 0, directional_count = 0;
+    for(uint32_t sample = 0; sample < 20000; ++sample)
+    {
+        float const ndc_x = 2.0f * u(rng) - 1.0f, ndc_y = 2.0f * u(rng) - 1.0f, depth = near_z * std::pow(far_z / near_z, u(rng));
+        glm::vec3 const point(ndc_x * depth / proj[0][0], ndc_y * depth / proj[1][1], -depth);
+        uint32_t const x = std::min((uint32_t)((0.5f * ndc_x + 0.5f) * 16.0f), 15u);
+        uint32_t const y = std::min((uint32_t)((0.5f - 0.5f * ndc_y) * 9.0f), 8u);
+        LightCluster const cluster = reference.getClusters()[reference.getClusterIndex(x, y, reference.getSlice(depth))];
+        uint32_t const *first = reference.getLightIndices() + cluster.offset, *last = first + cluster.count;
+        unsorted_count += (std::is_sorted(first, last) ? 0 : 1);
+        for(uint32_t i = 0; i < light_count; ++i)
+        {
+            float const radius = light_bounds.getRadii()[i];
+            glm::vec3 const offset = point - view_centers[i];
+            if(radius < 0.0f) directional_count += (std::binary_search(first, last, i) ? 1 : 0);
+            else if(glm::dot(offset, offset) <= 0.999f * radius * radius)
+            {
+                ++checked_count;
+                missing_count += (std::binary_search(first, last, i) ? 0 : 1);
+            }
+        }
+    }
+    GFX_CHECK(checked_count > 2000);
+    GFX_CHECK(missing_count == 0 && unsorted_count == 0 && directional_count == 0);
+}
+
+GFX_TEST(LightClustersBenchmark)
+{
+    uint32_t const light_count = 10000;
+    uint32_t const iteration_count = gfxTestIterations(500);
+    CullingBounds light_bounds;
+    MakeRandomLights(light_bounds, light_count, 3);
+    glm::mat4 const view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 const proj = glm::perspectiveZO(0.8f, 16.0f / 9.0f, 0.1f, 1000.0f);
+    LightClusters light_clusters;
+    light_clusters.resize(16, 9, 24);
+    for(uint32_t thread_count : { 1u, 0u })
+    {
+        light_clusters.build(light_bounds, view, proj, 0.1f, 500.0f, thread_count);  // warm up the allocations
+        double const start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            light_clusters.build(light_bounds, view, proj, 0.1f, 500.0f, thread_count);
+        double const seconds = gfxTestSeconds() - start;
+        printf("%u lights into %ux%ux%u clusters, %u threads: %.2f ms per build, %u light indices (%u iterations)\n", light_count,
+            light_clusters.getCountX(), light_clusters.getCountY(), light_clusters.getCountZ(), thread_count > 0 ? thread_count : gfxGetJobSystem().get_thread_count(),
+            1e3 * seconds / iteration_count, light_clusters.getLightIndexCount(), iteration_count);
+    }
+}
+
+//!
+//! Texture atlas packer.
+//!
+
+static std::vector<AtlasImage> MakeRandomAtlasImages(uint32_t image_count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    uint32_t const sizes[] = { 1, 2, 4, 8, 16, 24, 32, 48, 64, 100, 128 };
+    std::vector<AtlasImage> images(image_count);
+    for(AtlasImage &image : images)
+    {
+        image.width  = sizes[rng() % (sizeof(sizes) / sizeof(*sizes))];
+        image.height = (rng() % 4 == 0 ? sizes[rng() % (sizeof(sizes) / sizeof(*sizes))] : image.width);
+    }
+    return images;
+}
+
+// Bytes of RGBA8 texels with a full mip chain, optionally rounded up to the 64KiB placement alignment of
+// a standalone texture, which is how gpu_scene accounts for the images it doesn't pack
+static uint64_t CalculateAtlasTestTextureBytes(uint32_t width, uint32_t height, bool standalone)
+{
+    uint64_t bytes = 0;
+    for(;; width = std::max(width >> 1, 1u), height = std::max(height >> 1, 1u))
+    {
+        bytes += 4ull * width * height;
+        if(width == 1 && height == 1) break;
+    }
+    return (standalone ? (bytes + 65535) & ~65535ull : bytes);
+}
+
+GFX_TEST(TextureAtlasPackerLayout)
+{
+    std::vector<AtlasImage> images = MakeRandomAtlasImages(3000, 1);
+    images.push_back(AtlasImage { 0, 16 });     // empty
+    images.push_back(AtlasImage { 1022, 8 });   // too large for the atlas once bordered
+    uint32_t const max_atlas_size = 1024, border = TextureAtlasPacker::kDefaultBorder;
+    float const max_waste = TextureAtlasPacker::kDefaultMaxWaste;
+    TextureAtlasPacker packer;
+    uint32_t const atlas_count = packer.pack(images.data(), (uint32_t)images.size(), max_atlas_size, border);
+    uint32_t const atlas_width = packer.getAtlasWidth();
+    GFX_CHECK(atlas_count > 1 && atlas_width == max_atlas_size);
+    GFX_CHECK(packer.getPlacements()[3000].atlas == TextureAtlasPacker::kInvalidAtlas && packer.getPlacements()[3001].atlas == TextureAtlasPacker::kInvalidAtlas);
+    // Cells must keep their mips apart, stay within the waste budget and never overlap
+    std::vector<std::vector<uint8_t>> used(atlas_count);
+    for(uint32_t atlas = 0; atlas < atlas_count; ++atlas)
+        used[atlas].resize((size_t)atlas_width * packer.getAtlasHeight(atlas));
+    uint32_t bad_cell_count = 0, overlap_count = 0, packed_count = 0;
+    uint64_t used_area = 0, atlas_area = 0;
+    for(uint32_t i = 0; i < 3000; ++i)
+    {
+        AtlasPlacement const &placement = packer.getPlacements()[i];
+        uint32_t const lod_size = 1u << placement.max_lod, b = packer.getImageBorder(i);
+        uint32_t const cell_width = images[i].width + 2 * b, cell_height = images[i].height + 2 * b;
+        double const waste = 1.0 - (double)images[i].width * images[i].height / ((double)cell_width * cell_height);
+        if(placement.atlas == TextureAtlasPacker::kInvalidAtlas)
+        {
+            bad_cell_count += (waste <= max_waste ? 1 : 0);     // only left out when even a 1-texel border is too much
+            continue;
+        }
+        ++packed_count;
+        uint32_t const cell_x = placement.x - b, cell_y = placement.y - b;
+        uint32_t const atlas_height = (placement.atlas < atlas_count ? packer.getAtlasHeight(placement.atlas) : 0);
+        bad_cell_count += (placement.atlas >= atlas_count || cell_x + cell_width > atlas_width || cell_y + cell_height > atlas_height || waste > max_waste ? 1 : 0);
+        bad_cell_count += (b != lod_size || placement.x % lod_size != 0 || placement.y % lod_size != 0 || images[i].width % lod_size != 0 || images[i].height % lod_size != 0 ? 1 : 0);  // mips stay within the cell
+        if(placement.atlas >= atlas_count) continue;
+        for(uint32_t y = cell_y; y < cell_y + cell_height && y < atlas_height; ++y)
+            for(uint32_t x = cell_x; x < cell_x + cell_width && x < atlas_width; ++x) overlap_count += used[placement.atlas][(size_t)y * atlas_width + x]++;
+        used_area += (uint64_t)cell_width * cell_height;
+    }
+    GFX_CHECK(bad_cell_count == 0 && overlap_count == 0 && packed_count > 1500);
+    for(uint32_t atlas = 0; atlas < atlas_count; ++atlas) atlas_area += used[atlas].size();
+    GFX_CHECK(used_area > atlas_area * 3 / 4);  // shelves leave little room unused
+    // Everything fitting in a single atlas makes it only as large as needed
+    AtlasImage const small_images[] = { { 16, 16 }, { 8, 8 }, { 8, 8 } };   // 20x20 and two 10x10 cells
+    GFX_CHECK(packer.pack(small_images, 3, max_atlas_size, border) == 1 && packer.getAtlasWidth() == 32 && packer.getAtlasHeight(0) == 32);
+    GFX_CHECK(packer.getPlacements()[0].max_lod == 1 && packer.getPlacements()[1].max_lod == 0);   // borders narrowed to the waste budget
+    AtlasImage const wide_image = { 56, 8 };    // 60x12 cell
+    GFX_CHECK(packer.pack(&wide_image, 1, max_atlas_size, border) == 1 && packer.getAtlasWidth() == 64 && packer.getAtlasHeight(0) == 16);
+    // Tiny images only get packed when the caller accepts mostly-border cells
+    AtlasImage const tiny_image = { 1, 1 };
+    GFX_CHECK(packer.pack(&tiny_image, 1, max_atlas_size, border) == 0 && packer.getPlacements()[0].atlas == TextureAtlasPacker::kInvalidAtlas);
+    GFX_CHECK(packer.pack(&tiny_image, 1, max_atlas_size, border, 0.9f) == 1 && packer.getImageBorder(0) == 1 && packer.getAtlasWidth() == 4);
+}
+
+GFX_TEST(TextureAtlasPackerMemory)
+{
+    // Packed images never take more memory than they would as standalone textures, and their cells no more
+    // than the waste budget allows over the bare texels
+    std::vector<AtlasImage> const images = MakeRandomAtlasImages(5000, 4);
+    for(float const max_waste : { TextureAtlasPacker::kDefaultMaxWaste, 0.9f })
+    {
+        TextureAtlasPacker packer;
+        uint32_t const atlas_count = packer.pack(images.data(), (uint32_t)images.size(), 2048, TextureAtlasPacker::kDefaultBorder, max_waste);
+        uint64_t image_bytes = 0, standalone_bytes = 0, cell_bytes = 0, atlas_bytes = 0;
+        for(uint32_t i = 0; i < (uint32_t)images.size(); ++i)
+        {
+            if(packer.getPlacements()[i].atlas == TextureAtlasPacker::kInvalidAtlas) continue;
+            uint32_t const b = packer.getImageBorder(i);
+            image_bytes += CalculateAtlasTestTextureBytes(images[i].width, images[i].height, false);
+            standalone_bytes += CalculateAtlasTestTextureBytes(images[i].width, images[i].height, true);
+            cell_bytes += 4ull * (images[i].width + 2 * b) * (images[i].height + 2 * b);
+        }
+        for(uint32_t atlas = 0; atlas < atlas_count; ++atlas)
+            atlas_bytes += CalculateAtlasTestTextureBytes(packer.getAtlasWidth(), packer.getAtlasHeight(atlas), true);
+        GFX_CHECK(atlas_count > 0 && atlas_bytes <= standalone_bytes);
+        GFX_CHECK((double)cell_bytes * (1.0 - max_waste) <= 4.0 * image_bytes);
+    }
+}
+
+GFX_TEST(TextureAtlasPackerCopy)
+{
+    std::vector<AtlasImage> const images = MakeRandomAtlasImages(200, 2);
+    uint32_t const border = 3;
+    TextureAtlasPacker packer;
+    uint32_t const atlas_count = packer.pack(images.data(), (uint32_t)images.size(), 4096, border, 1.0f);
+    uint32_t const atlas_width = packer.getAtlasWidth();
+    GFX_CHECK(atlas_count == 1);
+    std::vector<uint32_t> atlas((size_t)atlas_width * packer.getAtlasHeight(0));
+    for(uint32_t i = 0; i < (uint32_t)images.size(); ++i)
+    {
+        std::vector<uint32_t> texels((size_t)images[i].width * images[i].height);
+        for(uint32_t y = 0; y < images[i].height; ++y)
+            for(uint32_t x = 0; x < images[i].width; ++x) texels[(size_t)y * images[i].width + x] = (i << 16) | (y << 8) | x;
+        packer.copyImage(i, texels.data(), sizeof(uint32_t), atlas.data());
+    }
+    // Each image and its border of wrapped texels
+    uint32_t mismatch_count = 0;
+    for(uint32_t i = 0; i < (uint32_t)images.size(); ++i)
+    {
+        AtlasPlacement const &placement = packer.getPlacements()[i];
+        int32_t const width = (int32_t)images[i].width, height = (int32_t)images[i].height, b = (int32_t)packer.getImageBorder(i);
+        mismatch_count += (placement.atlas != 0 || b > (int32_t)border ? 1 : 0);
+        for(int32_t y = -b; y < height + b; ++y)
+            for(int32_t x = -b; x < width + b; ++x)
+            {
+                uint32_t const expected = (i << 16) | ((uint32_t)((y % height + height) % height) << 8) | (uint32_t)((x % width + width) % width);
+                mismatch_count += (atlas[(size_t)(placement.y + y) * atlas_width + (placement.x + x)] != expected ? 1 : 0);
+            }
+    }
+    GFX_CHECK(mismatch_count == 0);
+}
+
+GFX_TEST(TextureAtlasPackerBenchmark)
+{
+    uint32_t const image_count = 10000;
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    std::vector<AtlasImage> const images = MakeRandomAtlasImages(image_count, 3);
+    TextureAtlasPacker packer;
+    uint32_t atlas_count = packer.pack(images.data(), image_count, 4096);
+    double const start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+        atlas_count = packer.pack(images.data(), image_count, 4096);
+    double const seconds = gfxTestSeconds() - start;
+    uint32_t packed_count = 0;
+    uint64_t image_bytes = 0, standalone_bytes = 0, cell_bytes = 0, atlas_bytes = 0;
+    for(uint32_t i = 0; i < image_count; ++i)
+    {
+        if(packer.getPlacements()[i].atlas == TextureAtlasPacker::kInvalidAtlas) continue;
+        uint32_t const b = packer.getImageBorder(i);
+        ++packed_count;
+        image_bytes += 4ull * images[i].width * images[i].height;
+        standalone_bytes += CalculateAtlasTestTextureBytes(images[i].width, images[i].height, true);
+        cell_bytes += 4ull * (images[i].width + 2 * b) * (images[i].height + 2 * b);
+    }
+    for(uint32_t atlas = 0; atlas < atlas_count; ++atlas)
+        atlas_bytes += 4ull * packer.getAtlasWidth() * packer.getAtlasHeight(atlas);
+    printf("%u of %u images into %u atlases %u wide: %.3f ms per pack, %u fewer descriptors; RGBA8 texels take %.1f MiB, their cells %.1f MiB and the atlases %.1f MiB"
+        " (standalone textures with mips: %.1f MiB) (%u iterations)\n",
+        packed_count, image_count, atlas_count, packer.getAtlasWidth(), 1e3 * seconds / iteration_count, packed_count - atlas_count,
+        image_bytes / 1048576.0, cell_bytes / 1048576.0, atlas_bytes / 1048576.0, standalone_bytes / 1048576.0, iteration_count);
+}
+
+//!
+//! Joint palette.
+//!
+
+GFX_TEST(JointPaletteDirtyTracking)
+{
+    JointPalette palette;
+    std::vector<glm::mat4> joint_matrices(10, glm::mat4(1.0f));
+    GFX_CHECK(palette.updateSkin(0, 100, joint_matrices.data(), 10) && palette.getDirtySkins().size() == 1);
+    GFX_CHECK(palette.updateSkin(3, 103, joint_matrices.data(), 4) && palette.getDirtySkins().size() == 2);
+    GFX_CHECK(palette.getSkinRange(0).count == 10 && palette.getSkinRange(3).count == 4 && palette.getSkinHandles()[3] == 103);
+    palette.clearDirtySkins();
+    GFX_CHECK(!palette.updateSkin(0, 100, joint_matrices.data(), 10) && palette.getDirtySkins().empty());    // unchanged
+    joint_matrices[5][3][0] = 2.0f;     // translation ends up in the w of the first row
+    GFX_CHECK(!palette.updateSkin(0, 100, joint_matrices.data(), 10) && palette.getDirtySkins().size() == 1);
+    GFX_CHECK(!palette.updateSkin(0, 100, joint_matrices.data(), 10) && palette.getDirtySkins().size() == 1);   // marked once
+    GFX_CHECK(palette.getRows()[palette.getSkinRange(0).offset + 5].rows[0].w == 2.0f);
+    palette.clearDirtySkins();
+    palette.releaseSkin(0);
+    GFX_CHECK(palette.getSkinHandles()[0] == 0 && palette.getSkinRange(0).count == 0);
+    GFX_CHECK(palette.updateSkin(1, 101, joint_matrices.data(), 6) && palette.getSkinRange(1).offset == 0);  // reuses the freed range
+    GFX_CHECK(palette.updateSkin(3, 203, joint_matrices.data(), 4));    // slot reused by another skin
+    GFX_CHECK(palette.updateSkin(3, 203, joint_matrices.data(), 8));    // joint count changed
+    GFX_CHECK(palette.getDirtySkins() == std::vector<uint32_t>({ 1, 3 }));
+}
+
+GFX_TEST(JointPaletteRandom)
+{
+    uint32_t const skin_count = 64;
+    std::mt19937 rng(11);
+    JointPalette palette;
+    std::vector<std::vector<glm::mat4>> skins(skin_count);
+    std::vector<uint64_t> handles(skin_count, 0);
+    uint64_t next_handle = 1;
+    for(uint32_t frame = 0; frame < 200; ++frame)
+    {
+        std::vector<uint32_t> expected_dirty_skins;
+        for(uint32_t update = 0; update < 16; ++update)
+        {
+            uint32_t const skin_id = rng() % skin_count;
+            uint32_t const action = rng() % 8;
+            if(action == 0)
+            {
+                palette.releaseSkin(skin_id);
+                skins[skin_id].clear();
+                handles[skin_id] = 0;
+                continue;
+            }
+            bool const is_new = (handles[skin_id] == 0 || action == 1);
+            if(is_new)
+            {
+                handles[skin_id] = next_handle++;
+                skins[skin_id].assign(1 + rng() % 100, glm::mat4(1.0f));
+            }
+            bool const is_changed = (is_new || action < 5);
+            if(is_changed) skins[skin_id][rng() % skins[skin_id].size()][3][1] = (float)(16 * frame + update + 1);  // never the previous value
+            GFX_CHECK(palette.updateSkin(skin_id, handles[skin_id], skins[skin_id].data(), (uint32_t)skins[skin_id].size()) == is_new);
+            if(is_changed && std::find(expected_dirty_skins.begin(), expected_dirty_skins.end(), skin_id) == expected_dirty_skins.end())
+                expected_dirty_skins.push_back(skin_id);
+        }
+        // Skins released after being marked may linger in the list; the resident ones must match in order
+        std::vector<uint32_t> resident_dirty_skins, expected_resident_dirty_skins;
+        for(uint32_t skin_id : palette.getDirtySkins())
+            if(handles[skin_id] != 0) resident_dirty_skins.push_back(skin_id);
+        for(uint32_t skin_id : expected_dirty_skins)
+            if(handles[skin_id] != 0) expected_resident_dirty_skins.push_back(skin_id);
+        GFX_CHECK(resident_dirty_skins == expected_resident_dirty_skins);
+        palette.clearDirtySkins();
+        // Resident skins own disjoint ranges holding their latest matrices
+        std::vector<uint8_t> used(palette.getCapacity());
+        uint32_t overlap_count = 0, mismatch_count = 0;
+        for(uint32_t skin_id = 0; skin_id < skin_count; ++skin_id)
+        {
+            if(handles[skin_id] == 0) continue;
+            SkinRange const &skin_range = palette.getSkinRange(skin_id);
+            GFX_CHECK(palette.getSkinHandles()[skin_id] == handles[skin_id] && skin_range.count == skins[skin_id].size());
+            GFX_CHECK(skin_range.offset + skin_range.count <= palette.getCapacity());
+            for(uint32_t i = 0; i < skin_range.count && skin_range.offset + i < palette.getCapacity(); ++i)
+            {
+                overlap_count += used[skin_range.offset + i]++;
+                JointRows const &joint_rows = palette.getRows()[skin_range.offset + i];
+                mismatch_count += (joint_rows.rows[1].w != skins[skin_id][i][3][1] || joint_rows.rows[0].x != 1.0f ? 1 : 0);
+            }
+        }
+        GFX_CHECK(overlap_count == 0 && mismatch_count == 0);
+    }
+}
@@ -0,0 +1,661 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gfx_core.h"
+#include "gfx_test.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <unordered_map>
+
+//!
+//! Job system.
+//!
+
+// A minimal thread pool standing in for the host's scheduler.
+class HostThreadPool
+{
+    GFX_NON_COPYABLE(HostThreadPool);
+
+public:
+    explicit HostThreadPool(uint32_t thread_count)
+    {
+        for(uint32_t i = 0; i < thread_count; ++i)
+            threads_.emplace_back([this]()
+            {
+                for(;;)
+                {
+                    std::pair<void (*)(void *), void *> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        condition_.wait(lock, [&]() { return stop_ || !tasks_.empty(); });
+                        if(tasks_.empty()) break;   // stopped and drained
+                        task = tasks_.front();
+                        tasks_.pop_front();
+                    }
+                    task.first(task.second);
+                }
+            });
+    }
+
+    ~HostThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for(std::thread &thread : threads_)
+            thread.join();
+    }
+
+    GfxJobScheduler getScheduler()
+    {
+        GfxJobScheduler scheduler;
+        scheduler.user_data = this;
+        scheduler.thread_count = (uint32_t)threads_.size();
+        scheduler.dispatch = &HostThreadPool::dispatch;
+        return scheduler;
+    }
+
+    template<typename FUNCTION>
+    void submit(FUNCTION const &function)  // must outlive its execution
+    {
+        dispatch(this, [](void *data) { (*(FUNCTION const *)data)(); }, (void *)&function);
+    }
+
+private:
+    static void dispatch(void *user_data, void (*execute)(void *job), void *job)
+    {
+        HostThreadPool *self = (HostThreadPool *)user_data;
+        {
+            std::lock_guard<std::mutex> lock(self->mutex_);
+            self->tasks_.emplace_back(execute, job);
+        }
+        self->condition_.notify_one();
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::pair<void (*)(void *), void *>> tasks_;
+    std::vector<std::thread> threads_;
+    bool stop_ = false;
+};
+
+GFX_TEST(JobSystemParallelFor)
+{
+    GfxJobSystem job_system(3);
+    uint32_t const count = 10000;
+    std::vector<std::atomic<uint32_t>> visits(count);
+    for(uint32_t grain_size : { 1u, 7u, 64u, count })
+    {
+        for(std::atomic<uint32_t> &visit : visits) visit = 0;
+        job_system.parallel_for(count, grain_size, [&](uint32_t i) { visits[i].fetch_add(1, std::memory_order_relaxed); });
+        uint32_t bad_count = 0;
+        for(std::atomic<uint32_t> const &visit : visits) bad_count += (visit.load() != 1 ? 1 : 0);
+        GFX_CHECK(bad_count == 0);  // each index visited exactly once
+    }
+}
+
+GFX_TEST(JobSystemDependencies)
+{
+    GfxJobSystem job_system(3);
+    for(uint32_t iteration = 0; iteration < 100; ++iteration)
+    {
+        uint32_t values[3] = {};
+        GfxJobCounter first, second, third;
+        job_system.run([&]() { values[0] = 1; }, &first);
+        job_system.run([&]() { values[1] = values[0] + 1; }, &second, &first);
+        job_system.run([&]() { values[2] = values[1] + 1; }, &third, &second);
+        job_system.wait(third);
+        job_system.wait(second);
+        job_system.wait(first);
+        GFX_CHECK(values[0] == 1 && values[1] == 2 && values[2] == 3);
+    }
+}
+
+GFX_TEST(JobSystemNestedParallelFor)
+{
+    GfxJobSystem job_system(3);
+    std::atomic<uint32_t> total(0);
+    job_system.parallel_for(64, 1, [&](uint32_t)
+    {
+        job_system.parallel_for(64, 1, [&](uint32_t) { total.fetch_add(1, std::memory_order_relaxed); });
+    });
+    GFX_CHECK(total.load() == 64 * 64);
+}
+
+GFX_TEST(JobSystemHostSchedulerNested)
+{
+    // Every host thread blocks in an outer chunk waiting on its inner loop, so the inner
+    // chunks can only complete if the waiting threads run them themselves.
+    uint32_t const host_thread_count = 2;
+    GfxJobSystem job_system(1);
+    HostThreadPool host(host_thread_count);    // joined first, so that it drains its tickets while the job system is alive
+    job_system.set_scheduler(host.getScheduler());
+    std::atomic<uint32_t> total(0);
+    std::atomic<uint32_t> done_count(0);
+    auto const outer_loop = [&]()
+    {
+        job_system.parallel_for(16, 1, [&](uint32_t)
+        {
+            job_system.parallel_for(16, 1, [&](uint32_t) { total.fetch_add(1, std::memory_order_relaxed); });
+        });
+        done_count.fetch_add(1, std::memory_order_release);
+    };
+    for(uint32_t i = 0; i < host_thread_count; ++i)
+        host.submit(outer_loop);
+    while(done_count.load(std::memory_order_acquire) != host_thread_count)
+        std::this_thread::yield();
+    GFX_CHECK(total.load() == host_thread_count * 16 * 16);
+}
+
+GFX_TEST(JobSystemOverheadBenchmark)
+{
+    GfxJobSystem job_system;
+    uint32_t const job_count = 10000;
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    std::atomic<uint32_t> sink(0);
+    double run_seconds = 0.0, parallel_for_seconds = 0.0, serial_seconds = 0.0;
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        double const run_start = gfxTestSeconds();
+        GfxJobCounter counter;
+        for(uint32_t i = 0; i < job_count; ++i)
+            job_system.run([&sink]() { sink.fetch_add(1, std::memory_order_relaxed); }, &counter);
+        job_system.wait(counter);
+        double const parallel_for_start = gfxTestSeconds();
+        job_system.parallel_for(job_count, 1, [&sink](uint32_t) { sink.fetch_add(1, std::memory_order_relaxed); });
+        double const serial_start = gfxTestSeconds();
+        for(uint32_t i = 0; i < job_count; ++i)
+            sink.fetch_add(1, std::memory_order_relaxed);
+        double const serial_end = gfxTestSeconds();
+        run_seconds += parallel_for_start - run_start;
+        parallel_for_seconds += serial_start - parallel_for_start;
+        serial_seconds += serial_end - serial_start;
+    }
+    GFX_CHECK(sink.load() == 3 * job_count * iteration_count);
+    double const job_total = (double)job_count * iteration_count;
+    printf("%u threads: run+wait %.3f us/job, parallel_for %.3f us/index (grain 1), inline loop %.3f us/index (%u iterations)\n",
+        job_system.get_thread_count(), 1e6 * run_seconds / job_total, 1e6 * parallel_for_seconds / job_total, 1e6 * serial_seconds / job_total,
+        iteration_count);
+}
+
+//!
+//! Slot map.
+//!
+
+GFX_TEST(SlotMapHandles)
+{
+    GfxSlotMap<uint32_t> slot_map;
+    uint64_t const handle = slot_map.allocate_handle();
+    uint32_t const index = (uint32_t)(handle & 0xFFFFFFFFull);
+    GFX_CHECK(handle != 0 && slot_map.has_handle(handle) && slot_map.get(handle) == nullptr);  // no object yet
+    slot_map.insert(index, 42u);
+    GFX_CHECK(slot_map.get(handle) != nullptr && *slot_map.get(handle) == 42u && slot_map.get_handle(index) == handle);
+    GFX_CHECK(slot_map.get(0) == nullptr && slot_map.get(handle + 1) == nullptr);
+    GFX_CHECK(slot_map.erase(index) && slot_map.free_handle(handle));
+    GFX_CHECK(!slot_map.has_handle(handle) && slot_map.get(handle) == nullptr);
+    uint64_t const reused_handle = slot_map.allocate_handle();  // same slot, next generation
+    GFX_CHECK(reused_handle != handle && (uint32_t)(reused_handle & 0xFFFFFFFFull) == index);
+    slot_map.insert(index, 7u);
+    GFX_CHECK(slot_map.get(handle) == nullptr && *slot_map.get(reused_handle) == 7u);   // stale handles stay invalid
+    uint64_t const acquired_handle = (3ull << 32) | 10;
+    GFX_CHECK(slot_map.acquire_handle(acquired_handle) && slot_map.has_handle(acquired_handle) && !slot_map.acquire_handle(acquired_handle));
+    GFX_CHECK(slot_map.calculate_free_handle_count() == slot_map.capacity() - 2);
+}
+
+GFX_TEST(SlotMapRandom)
+{
+    struct Object { uint64_t handle; uint32_t value; };
+    std::mt19937 rng(3);
+    GfxSlotMap<Object> slot_map;
+    std::vector<uint64_t> live_handles, dead_handles;
+    uint32_t mismatch_count = 0;
+    for(uint32_t i = 0; i < 50000; ++i)
+    {
+        if(live_handles.empty() || rng() % 3 != 0)
+        {
+            uint64_t const handle = slot_map.allocate_handle();
+            slot_map.insert((uint32_t)(handle & 0xFFFFFFFFull), Object { handle, i });
+            live_handles.push_back(handle);
+        }
+        else
+        {
+            size_t const victim = rng() % live_handles.size();
+            uint64_t const handle = live_handles[victim];
+            mismatch_count += (slot_map.erase((uint32_t)(handle & 0xFFFFFFFFull)) && slot_map.free_handle(handle) ? 0 : 1);
+            live_handles[victim] = live_handles.back();
+            live_handles.pop_back();
+            dead_handles.push_back(handle);
+        }
+    }
+    GFX_CHECK(mismatch_count == 0 && slot_map.size() == (uint32_t)live_handles.size());
+    for(uint64_t handle : live_handles)
+        mismatch_count += (slot_map.get(handle) == nullptr || slot_map.get(handle)->handle != handle ? 1 : 0);
+    for(uint64_t handle : dead_handles)
+        mismatch_count += (slot_map.get(handle) != nullptr ? 1 : 0);
+    for(uint32_t packed_index = 0; packed_index < slot_map.size(); ++packed_index)    // the dense array stays packed
+        mismatch_count += (slot_map.get_packed_index(slot_map.get_index(packed_index)) != packed_index || slot_map.get_handle(slot_map.get_index(packed_index)) != slot_map.data()[packed_index].handle ? 1 : 0);
+    GFX_CHECK(mismatch_count == 0);
+}
+
+// Compares a validated lookup through the slot map with the handles+array pairs it replaced.
+GFX_TEST(SlotMapBenchmark)
+{
+    struct Object { float data[12]; };   // 48 bytes
+    uint32_t const object_count = 100000;
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    GfxSlotMap<Object> slot_map;
+    GfxHandles handles;
+    GfxArray<Object> objects;
+    std::vector<uint64_t> slot_map_handles(object_count), array_handles(object_count);
+    for(uint32_t i = 0; i < object_count; ++i)
+    {
+        slot_map_handles[i] = slot_map.allocate_handle();
+        slot_map.insert((uint32_t)(slot_map_handles[i] & 0xFFFFFFFFull)).data[0] = (float)i;
+        array_handles[i] = handles.allocate_handle();
+        objects.insert((uint32_t)(array_handles[i] & 0xFFFFFFFFull)).data[0] = (float)i;
+    }
+    std::vector<uint32_t> orders[2] = { std::vector<uint32_t>(object_count), std::vector<uint32_t>(object_count) };
+    for(uint32_t i = 0; i < object_count; ++i) orders[0][i] = orders[1][i] = i;
+    std::shuffle(orders[1].begin(), orders[1].end(), std::mt19937(4));
+    char const *order_names[] = { "sequential", "random" };
+    for(uint32_t order = 0; order < 2; ++order)
+    {
+        float sum = 0.0f;
+        double const slot_map_start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            for(uint32_t i : orders[order])
+            {
+                Object const *object = slot_map.get(slot_map_handles[i]);
+                sum += (object != nullptr ? object->data[0] : 0.0f);
+            }
+        double const array_start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            for(uint32_t i : orders[order])
+            {
+                uint64_t const handle = array_handles[i];
+                Object const *object = (handles.has_handle(handle) ? objects.at((uint32_t)(handle & 0xFFFFFFFFull)) : nullptr);
+                sum += (object != nullptr ? object->data[0] : 0.0f);
+            }
+        double const array_end = gfxTestSeconds();
+        GFX_CHECK(sum > 0.0f);
+        double const lookup_count = (double)object_count * iteration_count;
+        printf("%u objects of 48 bytes, %s lookups: slot map %.2f ns, handles+array %.2f ns (%u iterations)\n", object_count, order_names[order],
+            1e9 * (array_start - slot_map_start) / lookup_count, 1e9 * (array_end - array_start) / lookup_count, iteration_count);
+    }
+}
+
+//!
+//! Hash map.
+//!
+
+GFX_TEST(HashMapRandom)
+{
+    std::mt19937 rng(1);
+    for(uint32_t round = 0; round < 20; ++round)
+    {
+        GfxHashMap<uint32_t, uint32_t> hash_map;
+        std::map<uint32_t, uint32_t> reference;
+        uint32_t mismatch_count = 0;
+        for(uint32_t i = 0; i < 20000; ++i)
+        {
+            uint32_t const key = rng() % 3000;
+            switch(rng() % 4)
+            {
+            case 0:
+                mismatch_count += (hash_map.erase(key) != (reference.erase(key) != 0) ? 1 : 0);
+                break;
+            case 1:
+                hash_map[key] = reference[key] = i;
+                break;
+            case 2:
+                {
+                    auto const result = hash_map.insert(key, i);
+                    auto const reference_result = reference.insert(std::make_pair(key, i));
+                    mismatch_count += (result.second != reference_result.second || result.first->second != reference_result.first->second ? 1 : 0);
+                }
+                break;
+            default:
+                {
+                    auto const it = hash_map.find(key);
+                    auto const reference_it = reference.find(key);
+                    mismatch_count += ((it == hash_map.end()) != (reference_it == reference.end()) || (it != hash_map.end() && it->second != reference_it->second) ? 1 : 0);
+                }
+                break;
+            }
+        }
+        GFX_CHECK(mismatch_count == 0 && hash_map.size() == reference.size());
+        for(auto const &entry : hash_map)
+            mismatch_count += (reference.at(entry.first) != entry.second ? 1 : 0);
+        GFX_CHECK(mismatch_count == 0);
+    }
+}
+
+GFX_TEST(HashMapStringKeys)
+{
+    GfxHashMap<std::string, uint32_t> hash_map;
+    hash_map["hello"] = 1;
+    hash_map[std::string("world")] = 2;
+    GFX_CHECK(hash_map.find("hello")->second == 1);  // looked up without building a std::string
+    GFX_CHECK(hash_map.has(std::string_view("world")) && !hash_map.has("hello world"));
+    GfxHashMap<std::wstring, uint32_t> wide_hash_map;
+    wide_hash_map[L"wide"] = 3;
+    GFX_CHECK(wide_hash_map.find(L"wide")->second == 3);
+    GFX_CHECK(hash_map.insert("hello", 4).second == false && hash_map.size() == 2);
+    GFX_CHECK(hash_map.erase("hello") && hash_map.begin()->first == "world");  // the last entry moved into the erased one's place
+}
+
+// Finds each key and inserts it when missing, half of the keys being repeats.
+template<typename MAP>
+static double RunHashMapBenchmark(std::vector<uint32_t> const &keys, uint32_t iteration_count, uint64_t &sum)
+{
+    double const start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        MAP map;
+        for(uint32_t key : keys)
+        {
+            auto const it = map.find(key);
+            if(it == map.end()) map[key] = key;
+            else sum += it->second;
+        }
+    }
+    return (gfxTestSeconds() - start) / iteration_count;
+}
+
+GFX_TEST(HashMapBenchmark)
+{
+    uint32_t const key_count = 200000;
+    uint32_t const iteration_count = gfxTestIterations(100);
+    std::mt19937 rng(2);
+    std::vector<uint32_t> keys(key_count);
+    for(uint32_t &key : keys) key = rng() % (2 * key_count);
+    uint64_t sum = 0;
+    double const map_seconds = RunHashMapBenchmark<std::map<uint32_t, uint32_t>>(keys, iteration_count, sum);
+    double const unordered_map_seconds = RunHashMapBenchmark<std::unordered_map<uint32_t, uint32_t>>(keys, iteration_count, sum);
+    double const hash_map_seconds = RunHashMapBenchmark<GfxHashMap<uint32_t, uint32_t>>(keys, iteration_count, sum);
+    GFX_CHECK(sum > 0);
+    printf("%u mixed find/insert with uint32 keys: std::map %.2f ms, std::unordered_map %.2f ms, GfxHashMap %.2f ms (%u iterations)\n",
+        key_count, 1e3 * map_seconds, 1e3 * unordered_map_seconds, 1e3 * hash_map_seconds, iteration_count);
+}
+
+//!
+//! Small vector.
+//!
+
+// Counts its live instances so that leaks and double destructions show up.
+struct SmallVectorObject
+{
+    static int32_t &LiveCount() { static int32_t live_count = 0; return live_count; }
+    SmallVectorObject(uint32_t value = 0) : value(value) { ++LiveCount(); }
+    SmallVectorObject(SmallVectorObject const &other) : value(other.value) { ++LiveCount(); }
+    SmallVectorObject(SmallVectorObject &&other) noexcept : value(other.value) { other.value = 0xDEADu; ++LiveCount(); }
+    ~SmallVectorObject() { --LiveCount(); }
+    SmallVectorObject &operator =(SmallVectorObject const &other) = default;
+    uint32_t value;
+};
+
+typedef GfxSmallVector<SmallVectorObject, 4> SmallObjectVector;
+
+static bool SmallVectorEquals(SmallObjectVector const &vector, uint32_t first, uint32_t count)
+{
+    if(vector.size() != count) return false;
+    for(uint32_t i = 0; i < count; ++i)
+        if(vector[i].value != first + i) return false;
+    return true;
+}
+
+GFX_TEST(SmallVectorSpill)
+{
+    static_assert(std::is_nothrow_move_constructible<SmallObjectVector>::value && std::is_nothrow_move_assignable<SmallObjectVector>::value);
+    {
+        SmallObjectVector inline_vector, heap_vector;
+        for(uint32_t i = 0; i < 4; ++i) inline_vector.emplace_back(i);
+        GFX_CHECK(inline_vector.is_inline() && inline_vector.capacity() == 4);
+        for(uint32_t i = 0; i < 9; ++i) heap_vector.push_back(SmallVectorObject(100 + i));
+        GFX_CHECK(!heap_vector.is_inline() && SmallVectorEquals(heap_vector, 100, 9));
+        heap_vector.push_back(heap_vector[0]);  // aliases the storage it may reallocate
+        GFX_CHECK(heap_vector.back().value == 100);
+        heap_vector.pop_back();
+        // Copies across the spill boundary, both ways
+        SmallObjectVector copy(heap_vector);
+        GFX_CHECK(!copy.is_inline() && SmallVectorEquals(copy, 100, 9));
+        copy = inline_vector;   // keeps its heap storage
+        GFX_CHECK(SmallVectorEquals(copy, 0, 4));
+        SmallObjectVector inline_copy;
+        inline_copy = heap_vector;
+        GFX_CHECK(!inline_copy.is_inline() && SmallVectorEquals(inline_copy, 100, 9));
+        // Moves steal the heap storage, and move the elements out of the inline one
+        SmallVectorObject const *heap_data = heap_vector.data();
+        SmallObjectVector moved(std::move(heap_vector));
+        GFX_CHECK(moved.data() == heap_data && SmallVectorEquals(moved, 100, 9) && heap_vector.empty() && heap_vector.is_inline());
+        SmallObjectVector moved_inline(std::move(inline_vector));
+        GFX_CHECK(moved_inline.is_inline() && SmallVectorEquals(moved_inline, 0, 4) && inline_vector.empty());
+        moved = std::move(moved_inline);    // inline source into a spilled destination
+        GFX_CHECK(SmallVectorEquals(moved, 0, 4) && moved_inline.empty());
+        moved_inline = std::move(inline_copy);  // spilled source into an inline destination
+        GFX_CHECK(!moved_inline.is_inline() && SmallVectorEquals(moved_inline, 100, 9) && inline_copy.empty() && inline_copy.is_inline());
+        moved = std::move(moved);
+        GFX_CHECK(SmallVectorEquals(moved, 0, 4));
+        // Assign and resize
+        std::vector<SmallVectorObject> const objects = { 7, 8, 9, 10, 11, 12 };
+        SmallObjectVector assigned;
+        assigned.assign(objects.begin(), objects.begin() + 3);
+        GFX_CHECK(assigned.is_inline() && SmallVectorEquals(assigned, 7, 3));
+        assigned.assign(objects.begin(), objects.end());
+        GFX_CHECK(!assigned.is_inline() && SmallVectorEquals(assigned, 7, 6));
+        assigned.assign(objects.begin() + 4, objects.end());
+        GFX_CHECK(SmallVectorEquals(assigned, 11, 2));
+        SmallObjectVector resized;
+        resized.resize(3, SmallVectorObject(5));
+        GFX_CHECK(resized.is_inline() && resized.size() == 3 && resized[2].value == 5);
+        resized.resize(10);
+        GFX_CHECK(!resized.is_inline() && resized.size() == 10 && resized[2].value == 5 && resized[9].value == 0);
+        resized.resize(1);
+        GFX_CHECK(resized.size() == 1 && resized[0].value == 5 && resized.capacity() >= 10);
+        resized.clear();
+        GFX_CHECK(resized.empty());
+        GFX_CHECK(SmallVectorObject::LiveCount() == (int32_t)(objects.size() + copy.size() + moved.size() + moved_inline.size() + assigned.size()));
+    }
+    GFX_CHECK(SmallVectorObject::LiveCount() == 0);
+}
+
+// Counts the allocations made by a standard container.
+template<typename TYPE>
+struct SmallVectorCountingAllocator
+{
+    typedef TYPE value_type;
+    SmallVectorCountingAllocator(uint64_t &allocation_count) : allocation_count(&allocation_count) {}
+    template<typename OTHER> SmallVectorCountingAllocator(SmallVectorCountingAllocator<OTHER> const &other) : allocation_count(other.allocation_count) {}
+    TYPE *allocate(size_t count) { ++*allocation_count; return std::allocator<TYPE>().allocate(count); }
+    void deallocate(TYPE *pointer, size_t count) { std::allocator<TYPE>().deallocate(pointer, count); }
+    template<typename OTHER> bool operator ==(SmallVectorCountingAllocator<OTHER> const &other) const { return allocation_count == other.allocation_count; }
+    template<typename OTHER> bool operator !=(SmallVectorCountingAllocator<OTHER> const &other) const { return allocation_count != other.allocation_count; }
+    uint64_t *allocation_count;
+};
+
+GFX_TEST(SmallVectorBenchmark)
+{
+    // The morph target weights of a scene's instances: copied from their mesh on import, most meshes having
+    // a handful of targets at most
+    uint32_t const instance_count = 100000;
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    std::mt19937 rng(3);
+    std::vector<uint32_t> weight_counts(instance_count);
+    for(uint32_t &weight_count : weight_counts) weight_count = (rng() % 8 == 0 ? 16 : rng() % 9);   // 1 in 8 has more targets than fit inline
+    float const default_weights[16] = {};
+    uint64_t vector_allocation_count = 0, small_vector_allocation_count = 0;
+    typedef std::vector<float, SmallVectorCountingAllocator<float>> CountedVector;
+    double const vector_start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        std::vector<CountedVector> instances(instance_count, CountedVector(SmallVectorCountingAllocator<float>(vector_allocation_count)));
+        for(uint32_t i = 0; i < instance_count; ++i)
+            instances[i].assign(default_weights, default_weights + weight_counts[i]);
+    }
+    double const small_vector_start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        std::vector<GfxSmallVector<float, 8>> instances(instance_count);
+        for(uint32_t i = 0; i < instance_count; ++i)
+        {
+            instances[i].assign(default_weights, default_weights + weight_counts[i]);
+            small_vector_allocation_count += (instances[i].is_inline() ? 0 : 1);
+        }
+    }
+    double const small_vector_end = gfxTestSeconds();
+    GFX_CHECK(small_vector_allocation_count < vector_allocation_count);
+    printf("%u instance weight lists: std::vector %.2f ms and %.0f allocations, GfxSmallVector<float, 8> %.2f ms and %.0f allocations (%u iterations)\n",
+        instance_count, 1e3 * (small_vector_start - vector_start) / iteration_count, (double)vector_allocation_count / iteration_count,
+        1e3 * (small_vector_end - small_vector_start) / iteration_count, (double)small_vector_allocation_count / iteration_count, iteration_count);
+}
+
+//!
+//! Memory tracker.
+//!
+
+typedef void (*MemoryTrackerCallback)(bool is_over_threshold, void *user_data);
+
+struct MemoryTrackerEvents
+{
+    std::vector<bool> crossings;
+    GfxMemoryTracker<MemoryTrackerCallback> *remove_from = nullptr;   // removes `RecordCrossing' from within the callback
+};
+
+static void RecordCrossing(bool is_over_threshold, void *user_data)
+{
+    MemoryTrackerEvents *events = (MemoryTrackerEvents *)user_data;
+    events->crossings.push_back(is_over_threshold);
+    if(events->remove_from != nullptr)
+        events->remove_from->remove_callback(RecordCrossing, user_data);
+}
+
+static void CheckMemoryBudget(GfxMemoryTracker<MemoryTrackerCallback> &tracker, GfxMemoryBudget const &os_budget)
+{
+    tracker.check_budget(tracker.get_budget(os_budget), [](MemoryTrackerCallback callback, bool is_over_threshold, void *user_data)
+        { callback(is_over_threshold, user_data); });
+}
+
+GFX_TEST(MemoryTrackerStatistics)
+{
+    GfxMemoryTracker<MemoryTrackerCallback> tracker;
+    std::mt19937 rng(5);
+    std::vector<std::pair<uintptr_t, uint64_t>> allocations;
+    uint32_t expected_count[kGfxMemoryHeap_Count][kGfxMemoryResource_Count] = {};
+    uint64_t expected_bytes[kGfxMemoryHeap_Count][kGfxMemoryResource_Count] = {};
+    for(uint32_t i = 0; i < 10000; ++i)
+    {
+        if(!allocations.empty() && rng() % 3 == 0)
+        {
+            size_t const j = rng() % allocations.size();
+            uint32_t const memory_heap = (uint32_t)(allocations[j].first - 1) / kGfxMemoryResource_Count;
+            uint32_t const memory_resource = (uint32_t)(allocations[j].first - 1) % kGfxMemoryResource_Count;
+            tracker.untrack(allocations[j].first, allocations[j].second);
+            --expected_count[memory_heap][memory_resource];
+            expected_bytes[memory_heap][memory_resource] -= allocations[j].second;
+            allocations[j] = allocations.back();
+            allocations.pop_back();
+            continue;
+        }
+        GfxMemoryHeap const memory_heap = (GfxMemoryHeap)(rng() % kGfxMemoryHeap_Count);
+        GfxMemoryResource const memory_resource = (GfxMemoryResource)(rng() % kGfxMemoryResource_Count);
+        uint64_t const allocation_bytes = 65536 * (1 + rng() % 256);
+        uintptr_t const tag = tracker.track(memory_heap, memory_resource, allocation_bytes);
+        GFX_CHECK(tag != 0);
+        allocations.push_back(std::make_pair(tag, allocation_bytes));
+        ++expected_count[memory_heap][memory_resource];
+        expected_bytes[memory_heap][memory_resource] += allocation_bytes;
+    }
+    tracker.untrack(0, 65536);  // not tracked, e.g., a back buffer untracked earlier
+    for(uint32_t memory_heap = 0; memory_heap < kGfxMemoryHeap_Count; ++memory_heap)
+        for(uint32_t memory_resource = 0; memory_resource < kGfxMemoryResource_Count; ++memory_resource)
+        {
+            GFX_CHECK(tracker.get_statistics().allocation_count[memory_heap][memory_resource] == expected_count[memory_heap][memory_resource]);
+            GFX_CHECK(tracker.get_statistics().allocation_bytes[memory_heap][memory_resource] == expected_bytes[memory_heap][memory_resource]);
+        }
+    for(std::pair<uintptr_t, uint64_t> const &allocation : allocations)
+        tracker.untrack(allocation.first, allocation.second);
+    uint64_t remaining_count = 0, remaining_bytes = 0;
+    for(uint32_t memory_heap = 0; memory_heap < kGfxMemoryHeap_Count; ++memory_heap)
+        for(uint32_t memory_resource = 0; memory_resource < kGfxMemoryResource_Count; ++memory_resource)
+        {
+            remaining_count += tracker.get_statistics().allocation_count[memory_heap][memory_resource];
+            remaining_bytes += tracker.get_statistics().allocation_bytes[memory_heap][memory_resource];
+        }
+    GFX_CHECK(remaining_count == 0 && remaining_bytes == 0);
+}
+
+GFX_TEST(MemoryTrackerBudget)
+{
+    GfxMemoryTracker<MemoryTrackerCallback> tracker;
+    GfxMemoryBudget os_budget = {};
+    os_budget.usage_bytes = 100;
+    os_budget.budget_bytes = 1000;
+    uintptr_t const buffer = tracker.track(kGfxMemoryHeap_Default, kGfxMemoryResource_Buffer, 300);
+    uintptr_t const render_target = tracker.track(kGfxMemoryHeap_Default, kGfxMemoryResource_RenderTarget, 200);
+    tracker.track(kGfxMemoryHeap_Upload, kGfxMemoryResource_Buffer, 5000);     // not counted against the budget
+    GFX_CHECK(tracker.get_budget(os_budget).usage_bytes == 100 && tracker.get_budget(os_budget).budget_bytes == 1000);
+    tracker.set_simulated_budget(600);
+    GFX_CHECK(tracker.get_budget(os_budget).usage_bytes == 500 && tracker.get_budget(os_budget).budget_bytes == 600);
+    MemoryTrackerEvents events, removed_events;
+    GFX_CHECK(tracker.add_callback(0.0f, RecordCrossing, &events) == kGfxResult_InvalidParameter);
+    GFX_CHECK(tracker.add_callback(1.0f, nullptr, &events) == kGfxResult_InvalidParameter);
+    GFX_CHECK(tracker.remove_callback(RecordCrossing, &events) == kGfxResult_InvalidParameter);
+    GFX_CHECK(tracker.add_callback(0.9f, RecordCrossing, &events) == kGfxResult_NoError && tracker.has_callbacks());
+    CheckMemoryBudget(tracker, os_budget);
+    GFX_CHECK(events.crossings.empty());    // 500 <= 0.9 * 600
+    uintptr_t const texture = tracker.track(kGfxMemoryHeap_Default, kGfxMemoryResource_Texture, 100);
+    CheckMemoryBudget(tracker, os_budget);
+    CheckMemoryBudget(tracker, os_budget);
+    GFX_CHECK(events.crossings == std::vector<bool>({ true }));     // fires once when crossing up
+    tracker.untrack(texture, 100);
+    CheckMemoryBudget(tracker, os_budget);
+    GFX_CHECK(events.crossings == std::vector<bool>({ true, false }));  // and once when crossing down
+    tracker.set_simulated_budget(0);
+    os_budget.budget_bytes = 0;
+    CheckMemoryBudget(tracker, os_budget);
+    GFX_CHECK(events.crossings.size() == 2);    // no budget, no notification
+    // A callback removing itself still sees its own crossing, but never the next ones
+    os_budget.budget_bytes = 1000;
+    os_budget.usage_bytes = 950;
+    removed_events.remove_from = &tracker;
+    GFX_CHECK(tracker.add_callback(0.5f, RecordCrossing, &removed_events) == kGfxResult_NoError);
+    CheckMemoryBudget(tracker, os_budget);
+    GFX_CHECK(events.crossings == std::vector<bool>({ true, false, true }) && removed_events.crossings == std::vector<bool>({ true }));
+    os_budget.usage_bytes = 100;
+    CheckMemoryBudget(tracker, os_budget);
+    GFX_CHECK(events.crossings.size() == 4 && removed_events.crossings.size() == 1);
+    GFX_CHECK(tracker.remove_callback(RecordCrossing, &events) == kGfxResult_NoError && !tracker.has_callbacks());
+    tracker.untrack(buffer, 300);
+    tracker.untrack(render_target, 200);
+    GFX_CHECK(tracker.get_statistics().allocation_count[kGfxMemoryHeap_Default][kGfxMemoryResource_Buffer] == 0);
+    GFX_CHECK(tracker.get_statistics().allocation_bytes[kGfxMemoryHeap_Upload][kGfxMemoryResource_Buffer] == 5000);
+}
+
+int main(int argc, char **argv)
+{
+    return gfxTestMain(argc, argv);
+}
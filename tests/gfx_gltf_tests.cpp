@@ -0,0 +1,163 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+
+#include "gfx_gltf.h"
+#include "gfx_test.h"
+
+#include <cmath>
+#include <random>
+
+//!
+//! Accessor unpacking.
+//!
+
+static cgltf_size GetGltfComponentSize(cgltf_component_type component_type)
+{
+    return (component_type == cgltf_component_type_r_8 || component_type == cgltf_component_type_r_8u ? 1 :
+            component_type == cgltf_component_type_r_16 || component_type == cgltf_component_type_r_16u ? 2 : 4);
+}
+
+// Byte offset of a component within its element; matrix columns are aligned to 4 bytes.
+static cgltf_size GetGltfComponentOffset(cgltf_type type, cgltf_component_type component_type, cgltf_size component)
+{
+    cgltf_size const component_size = GetGltfComponentSize(component_type);
+    if(type < cgltf_type_mat2) return component * component_size;
+    cgltf_size const row_count = (type == cgltf_type_mat2 ? 2 : type == cgltf_type_mat3 ? 3 : 4);
+    return (component / row_count) * ((row_count * component_size + 3) & ~3) + (component % row_count) * component_size;
+}
+
+// Fills an accessor of random components, leaving random bytes in its padding and between its elements.
+static void FillGltfAccessor(std::mt19937 &rng, cgltf_accessor const &accessor, std::vector<uint8_t> &bytes)
+{
+    for(uint8_t &byte : bytes) byte = (uint8_t)rng();
+    cgltf_size const component_count = cgltf_num_components(accessor.type);
+    for(cgltf_size i = 0; i < accessor.count; ++i)
+        for(cgltf_size j = 0; j < component_count; ++j)
+        {
+            uint8_t *component = &bytes[accessor.buffer_view->offset + accessor.offset + i * accessor.stride + GetGltfComponentOffset(accessor.type, accessor.component_type, j)];
+            int8_t const i8 = (int8_t)((int32_t)(rng() % 255) - 127);   // the most negative values are below -1 once normalized
+            int16_t const i16 = (int16_t)((int32_t)(rng() % 65535) - 32767);
+            uint32_t const u32 = (uint32_t)(rng() & 0xFFFFFFu);     // cgltf reads these through a signed int, keep them exact
+            float const f32 = std::uniform_real_distribution<float>(-100.0f, 100.0f)(rng);
+            switch(accessor.component_type)
+            {
+            case cgltf_component_type_r_8: memcpy(component, &i8, sizeof(i8)); break;
+            case cgltf_component_type_r_16: memcpy(component, &i16, sizeof(i16)); break;
+            case cgltf_component_type_r_32u: memcpy(component, &u32, sizeof(u32)); break;
+            case cgltf_component_type_r_32f: memcpy(component, &f32, sizeof(f32)); break;
+            default: break;     // any bit pattern will do
+            }
+        }
+}
+
+GFX_TEST(GltfAccessorUnpack)
+{
+    cgltf_component_type const component_types[] = { cgltf_component_type_r_8, cgltf_component_type_r_8u, cgltf_component_type_r_16,
+                                                      cgltf_component_type_r_16u, cgltf_component_type_r_32u, cgltf_component_type_r_32f };
+    cgltf_type const types[] = { cgltf_type_scalar, cgltf_type_vec2, cgltf_type_vec3, cgltf_type_vec4, cgltf_type_mat2, cgltf_type_mat3, cgltf_type_mat4 };
+    std::mt19937 rng(1);
+    uint32_t case_count = 0, mismatch_count = 0;
+    for(cgltf_component_type const component_type : component_types)
+        for(cgltf_type const type : types)
+            for(int32_t normalized = 0; normalized < (GetGltfComponentSize(component_type) < 4 ? 2 : 1); ++normalized)
+                for(bool const is_strided : { false, true })
+                {
+                    cgltf_size const component_count = cgltf_num_components(type);
+                    cgltf_size const element_size = GetGltfComponentOffset(type, component_type, component_count - 1) + GetGltfComponentSize(component_type);
+                    cgltf_size const tight_size = (type < cgltf_type_mat2 ? element_size : (element_size + 3) & ~3);
+                    cgltf_size const stride = (is_strided ? ((tight_size + 6) + 3) & ~3 : tight_size);
+                    cgltf_accessor accessor = {};
+                    cgltf_buffer_view buffer_view = {};
+                    cgltf_buffer buffer = {};
+                    std::vector<uint8_t> bytes(8 + 37 * stride);
+                    buffer.data = bytes.data();
+                    buffer.size = bytes.size();
+                    buffer_view.buffer = &buffer;
+                    buffer_view.offset = 4;
+                    buffer_view.size = bytes.size() - 4;
+                    buffer_view.stride = (is_strided ? stride : 0);
+                    accessor.component_type = component_type;
+                    accessor.normalized = (cgltf_bool)normalized;
+                    accessor.type = type;
+                    accessor.offset = 4;
+                    accessor.count = 37;
+                    accessor.stride = stride;
+                    accessor.buffer_view = &buffer_view;
+                    FillGltfAccessor(rng, accessor, bytes);
+                    std::vector<float> expected(component_count * accessor.count), unpacked(expected.size());
+                    GFX_CHECK(cgltf_accessor_unpack_floats(&accessor, expected.data(), expected.size()) == expected.size());
+                    GFX_CHECK(gfxGltfUnpackAccessor(&accessor, unpacked.data()));
+                    for(size_t i = 0; i < expected.size(); ++i)
+                        mismatch_count += (std::fabs(unpacked[i] - expected[i]) > 1e-6f * std::max(1.0f, std::fabs(expected[i])) ? 1 : 0);
+                    ++case_count;
+                }
+    GFX_CHECK(case_count == 2 * 7 * (4 * 2 + 2) && mismatch_count == 0);
+}
+
+GFX_TEST(GltfAccessorUnpackBenchmark)
+{
+    // The usual vertex attributes of a quantized mesh next to a plain one
+    struct { cgltf_type type; cgltf_component_type component_type; bool normalized; char const *name; } const formats[] =
+    {
+        { cgltf_type_vec3, cgltf_component_type_r_32f, false, "float3" },
+        { cgltf_type_vec3, cgltf_component_type_r_16, true, "snorm16x3" },
+        { cgltf_type_vec2, cgltf_component_type_r_16u, true, "unorm16x2" },
+        { cgltf_type_vec4, cgltf_component_type_r_8u, false, "uint8x4" },
+    };
+    cgltf_size const vertex_count = 1000000;
+    uint32_t const iteration_count = gfxTestIterations(100);
+    std::mt19937 rng(2);
+    for(auto const &format : formats)
+    {
+        cgltf_size const component_count = cgltf_num_components(format.type);
+        cgltf_size const stride = component_count * GetGltfComponentSize(format.component_type);
+        std::vector<uint8_t> bytes(vertex_count * stride);
+        cgltf_buffer buffer = {};
+        cgltf_buffer_view buffer_view = {};
+        cgltf_accessor accessor = {};
+        buffer.data = bytes.data();
+        buffer.size = bytes.size();
+        buffer_view.buffer = &buffer;
+        buffer_view.size = bytes.size();
+        accessor.component_type = format.component_type;
+        accessor.normalized = format.normalized;
+        accessor.type = format.type;
+        accessor.count = vertex_count;
+        accessor.stride = stride;
+        accessor.buffer_view = &buffer_view;
+        FillGltfAccessor(rng, accessor, bytes);
+        std::vector<float> output(component_count * vertex_count);
+        double const cgltf_start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            GFX_CHECK(cgltf_accessor_unpack_floats(&accessor, output.data(), output.size()) == output.size());
+        double const unpack_start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+            GFX_CHECK(gfxGltfUnpackAccessor(&accessor, output.data()));
+        double const unpack_end = gfxTestSeconds();
+        printf("%zu %s vertices: cgltf_accessor_unpack_floats %.2f ms, gfxGltfUnpackAccessor %.2f ms (%u iterations)\n", (size_t)vertex_count, format.name,
+            1e3 * (unpack_start - cgltf_start) / iteration_count, 1e3 * (unpack_end - unpack_start) / iteration_count, iteration_count);
+    }
+}
@@ -0,0 +1,125 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gfx_imgui.h"
+#include "gfx_test.h"
+
+#include <string>
+
+//!
+//! Draw data encoding.
+//!
+
+struct ImGuiRecordingEncoder
+{
+    std::string log;
+    void setTexture(ImTextureID texture_id) { log += "t" + std::to_string((uintptr_t)texture_id) + " "; }
+    void setScissorRect(ImVec4 const &clip_rect) { log += "s" + std::to_string((int32_t)clip_rect.z) + "x" + std::to_string((int32_t)clip_rect.w) + " "; }
+    void drawIndexed(uint32_t index_count, uint32_t first_index, int32_t base_vertex) { log += "d" + std::to_string(index_count) + "," + std::to_string(first_index) + "," + std::to_string(base_vertex) + " "; }
+};
+
+static void PushImGuiDrawCmd(ImDrawList &draw_list, uintptr_t texture_id, ImVec4 const &clip_rect, uint32_t elem_count, ImDrawCallback callback = nullptr, void *callback_data = nullptr)
+{
+    ImDrawCmd cmd;
+    cmd.TextureId = (ImTextureID)texture_id;
+    cmd.ClipRect = clip_rect;
+    cmd.ElemCount = elem_count;
+    cmd.UserCallback = callback;
+    cmd.UserCallbackData = callback_data;
+    draw_list.CmdBuffer.push_back(cmd);
+}
+
+GFX_TEST(ImGuiDrawBatching)
+{
+    ImGuiRecordingEncoder encoder;
+    ImVec4 const clip_rect(0.0f, 0.0f, 64.0f, 32.0f), empty_rect(8.0f, 8.0f, 8.0f, 32.0f);
+    ImDrawCallback const callback = [](ImDrawList const *, ImDrawCmd const *cmd) { *(std::string *)cmd->UserCallbackData += "c "; };
+    ImDrawList first_list(nullptr), second_list(nullptr);
+    first_list.VtxBuffer.resize(4);
+    PushImGuiDrawCmd(first_list, 1, clip_rect, 6);
+    PushImGuiDrawCmd(first_list, 1, clip_rect, 3);      // merged with the previous one
+    PushImGuiDrawCmd(first_list, 1, empty_rect, 6);     // fully clipped, but its indices still get skipped over
+    PushImGuiDrawCmd(first_list, 0, clip_rect, 0, callback, &encoder.log);
+    PushImGuiDrawCmd(first_list, 1, clip_rect, 3);      // same state as before the callback, set again anyway
+    PushImGuiDrawCmd(first_list, 2, clip_rect, 6);      // texture change only
+    PushImGuiDrawCmd(second_list, 2, clip_rect, 3);     // state carries over to the next list
+    ImDrawData draw_data;
+    draw_data.CmdLists.push_back(&first_list);
+    draw_data.CmdLists.push_back(&second_list);
+    draw_data.CmdListsCount = draw_data.CmdLists.Size;
+    gfxImGuiEncodeDrawData(&draw_data, encoder);
+    GFX_CHECK(encoder.log == "t1 s64x32 d9,0,0 c t1 s64x32 d3,15,0 t2 d6,18,0 d3,24,4 ");
+    draw_data.CmdLists.clear();     // not owned
+}
+
+GFX_TEST(ImGuiDrawBenchmark)
+{
+    // A busy UI: many windows, each alternating between a couple of textures and clip rectangles
+    uint32_t const list_count = 100, cmd_count = 200, index_count = 60, vertex_count = 40;
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    std::vector<ImDrawList *> draw_lists;
+    ImDrawData draw_data;
+    for(uint32_t i = 0; i < list_count; ++i)
+    {
+        ImDrawList *draw_list = new ImDrawList(nullptr);
+        draw_list->IdxBuffer.resize(cmd_count * index_count);
+        draw_list->VtxBuffer.resize(cmd_count * vertex_count);
+        for(int32_t j = 0; j < draw_list->IdxBuffer.Size; ++j) draw_list->IdxBuffer[j] = (ImDrawIdx)(j % (cmd_count * vertex_count));
+        memset(draw_list->VtxBuffer.Data, 0, draw_list->VtxBuffer.size_in_bytes());
+        for(uint32_t j = 0; j < cmd_count; ++j)
+            PushImGuiDrawCmd(*draw_list, 1 + (j / 20) % 2, ImVec4(0.0f, 0.0f, 512.0f, (float)(256 + 16 * ((j / 8) % 4))), index_count);
+        draw_data.CmdLists.push_back(draw_list);
+        draw_data.TotalIdxCount += draw_list->IdxBuffer.Size;
+        draw_data.TotalVtxCount += draw_list->VtxBuffer.Size;
+        draw_lists.push_back(draw_list);
+    }
+    draw_data.CmdListsCount = draw_data.CmdLists.Size;
+    struct CountingEncoder
+    {
+        uint32_t texture_count = 0, scissor_count = 0, draw_count = 0;
+        void setTexture(ImTextureID) { ++texture_count; }
+        void setScissorRect(ImVec4 const &) { ++scissor_count; }
+        void drawIndexed(uint32_t, uint32_t, int32_t) { ++draw_count; }
+    };
+    std::vector<ImDrawIdx> draw_idx(draw_data.TotalIdxCount);
+    std::vector<ImDrawVert> draw_vtx(draw_data.TotalVtxCount);
+    double copy_seconds = 0.0, encode_seconds = 0.0;
+    CountingEncoder encoder;
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        double const start = gfxTestSeconds();
+        gfxImGuiCopyDrawData(&draw_data, draw_idx.data(), draw_vtx.data());
+        double const middle = gfxTestSeconds();
+        encoder = CountingEncoder();
+        gfxImGuiEncodeDrawData(&draw_data, encoder);
+        copy_seconds += middle - start;
+        encode_seconds += gfxTestSeconds() - middle;
+    }
+    GFX_CHECK(draw_idx.back() == draw_lists.back()->IdxBuffer.back());
+    GFX_CHECK(encoder.draw_count > 0 && encoder.draw_count < list_count * cmd_count);
+    printf("%u draw lists of %u commands (%d indices, %d vertices): %.3f ms copy, %.3f ms encode, %u draws, %u texture and %u scissor changes (%u iterations)\n",
+        list_count, cmd_count, draw_data.TotalIdxCount, draw_data.TotalVtxCount, 1e3 * copy_seconds / iteration_count, 1e3 * encode_seconds / iteration_count,
+        encoder.draw_count, encoder.texture_count, encoder.scissor_count, iteration_count);
+    draw_data.CmdLists.clear();     // not owned
+    for(ImDrawList *draw_list : draw_lists) delete draw_list;
+}
@@ -0,0 +1,612 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gfx_scene.h"
+#include "gfx_test.h"
+
+#include <psapi.h>
+#include <string>
+#include <tiny_obj_loader.h>
+
+//!
+//! Animation.
+//!
+
+// Writes a glTF file with `chain_count' independent node chains, each
+// `chain_length' deep and animated by `clips_per_chain' clips that rotate
+// every node of the chain.
+static bool WriteAnimatedGltf(char const *path, uint32_t chain_count, uint32_t chain_length, uint32_t clips_per_chain = 1)
+{
+    std::string nodes, roots, animations;
+    for(uint32_t a = 0; a < chain_count; ++a)
+    {
+        std::string channels;
+        for(uint32_t d = 0; d < chain_length; ++d)
+        {
+            uint32_t const node = a * chain_length + d;
+            nodes += (node > 0 ? "," : "") + std::string("{") + (d + 1 < chain_length ? "\"children\":[" + std::to_string(node + 1) + "]," : "") + "\"translation\":[0,1,0]}";
+            channels += (d > 0 ? "," : "") + std::string("{\"sampler\":0,\"target\":{\"node\":") + std::to_string(node) + ",\"path\":\"rotation\"}}";
+        }
+        roots += (a > 0 ? "," : "") + std::to_string(a * chain_length);
+        for(uint32_t c = 0; c < clips_per_chain; ++c)
+            animations += (a > 0 || c > 0 ? "," : "") + std::string("{\"samplers\":[{\"input\":0,\"output\":1,\"interpolation\":\"LINEAR\"}],\"channels\":[") + channels + "]}";
+    }
+    FILE *file = fopen(path, "w");
+    if(file == nullptr) return false;
+    fprintf(file, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[%s]}],\"nodes\":[%s],\"animations\":[%s],"
+        "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":2,\"type\":\"SCALAR\",\"min\":[0],\"max\":[1]},"
+        "{\"bufferView\":1,\"componentType\":5126,\"count\":2,\"type\":\"VEC4\"}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":8},{\"buffer\":0,\"byteOffset\":8,\"byteLength\":32}],"
+        "\"buffers\":[{\"byteLength\":40,\"uri\":\"data:application/octet-stream;base64,AAAAAAAAgD8AAAAAAAAAAAAAAAAAAIA/AAAAAPMENT8AAAAA8wQ1Pw==\"}]}",
+        roots.c_str(), nodes.c_str(), animations.c_str());
+    fclose(file);
+    return true;
+}
+
+// Writes a glTF file with a `joint_count' long chain of joints, all rotated by a
+// single clip, skinning a mesh of `vertex_count' vertices that goes into a .bin
+// file next to it.
+static bool WriteSkinnedGltf(char const *path, char const *bin_path, uint32_t joint_count, uint32_t vertex_count)
+{
+    vertex_count -= vertex_count % 3;   // a triangle list
+    std::vector<float> animation = { 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.7071068f, 0.7071068f };
+    std::vector<glm::mat4> inverse_bind_matrices(joint_count, glm::mat4(1.0f));
+    std::vector<glm::vec3> positions(vertex_count);
+    std::vector<uint16_t> joints(4 * vertex_count);
+    std::vector<glm::vec4> weights(vertex_count, glm::vec4(0.75f, 0.25f, 0.0f, 0.0f));
+    std::vector<uint32_t> indices(vertex_count);
+    for(uint32_t i = 0; i < joint_count; ++i)
+        inverse_bind_matrices[i][3][1] = -(float)(i + 1);   // undoes the joint's rest translation
+    for(uint32_t i = 0; i < vertex_count; ++i)
+    {
+        positions[i] = glm::vec3((i % 3 == 1 ? 0.1f : 0.0f), 1.0f + (float)joint_count * (float)i / (float)vertex_count, (i % 3 == 2 ? 0.1f : 0.0f));
+        joints[4 * i + 0] = (uint16_t)GFX_MIN((uint32_t)positions[i].y - 1, joint_count - 1);
+        joints[4 * i + 1] = (uint16_t)GFX_MIN((uint32_t)positions[i].y, joint_count - 1);
+        indices[i] = i;
+    }
+    size_t const sizes[] = { 2 * sizeof(float), 8 * sizeof(float), inverse_bind_matrices.size() * sizeof(glm::mat4), positions.size() * sizeof(glm::vec3),
+                             joints.size() * sizeof(uint16_t), weights.size() * sizeof(glm::vec4), indices.size() * sizeof(uint32_t) };
+    void const *data[] = { animation.data(), animation.data() + 2, inverse_bind_matrices.data(), positions.data(), joints.data(), weights.data(), indices.data() };
+    FILE *bin_file = fopen(bin_path, "wb");
+    if(bin_file == nullptr) return false;
+    std::string buffer_views;
+    size_t offset = 0;
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); offset += sizes[i++])
+    {
+        fwrite(data[i], 1, sizes[i], bin_file);
+        buffer_views += (i > 0 ? "," : "") + std::string("{\"buffer\":0,\"byteOffset\":") + std::to_string(offset) + ",\"byteLength\":" + std::to_string(sizes[i]) + "}";
+    }
+    fclose(bin_file);
+    std::string nodes, joint_nodes, channels;
+    for(uint32_t i = 0; i < joint_count; ++i)
+    {
+        nodes += std::string("{") + (i + 1 < joint_count ? "\"children\":[" + std::to_string(i + 1) + "]," : "") + "\"translation\":[0,1,0]},";
+        joint_nodes += (i > 0 ? "," : "") + std::to_string(i);
+        channels += (i > 0 ? "," : "") + std::string("{\"sampler\":0,\"target\":{\"node\":") + std::to_string(i) + ",\"path\":\"rotation\"}}";
+    }
+    nodes += "{\"mesh\":0,\"skin\":0}";
+    FILE *file = fopen(path, "w");
+    if(file == nullptr) return false;
+    fprintf(file, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0,%u]}],\"nodes\":[%s],"
+        "\"skins\":[{\"joints\":[%s],\"inverseBindMatrices\":2}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":3,\"JOINTS_0\":4,\"WEIGHTS_0\":5},\"indices\":6}]}],"
+        "\"animations\":[{\"samplers\":[{\"input\":0,\"output\":1,\"interpolation\":\"LINEAR\"}],\"channels\":[%s]}],"
+        "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":2,\"type\":\"SCALAR\",\"min\":[0],\"max\":[1]},"
+        "{\"bufferView\":1,\"componentType\":5126,\"count\":2,\"type\":\"VEC4\"},"
+        "{\"bufferView\":2,\"componentType\":5126,\"count\":%u,\"type\":\"MAT4\"},"
+        "{\"bufferView\":3,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[0,1,0],\"max\":[0.1,%u,0.1]},"
+        "{\"bufferView\":4,\"componentType\":5123,\"count\":%u,\"type\":\"VEC4\"},"
+        "{\"bufferView\":5,\"componentType\":5126,\"count\":%u,\"type\":\"VEC4\"},"
+        "{\"bufferView\":6,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}],"
+        "\"bufferViews\":[%s],\"buffers\":[{\"byteLength\":%zu,\"uri\":\"%s\"}]}",
+        joint_count, nodes.c_str(), joint_nodes.c_str(), channels.c_str(), joint_count, vertex_count, joint_count + 1, vertex_count, vertex_count, vertex_count,
+        buffer_views.c_str(), offset, bin_path);
+    fclose(file);
+    return true;
+}
+
+static uint32_t CountMatrixMismatches(glm::mat4 const &lhs, glm::mat4 const &rhs)
+{
+    uint32_t mismatch_count = 0;
+    for(uint32_t i = 0; i < 4; ++i)
+        for(uint32_t j = 0; j < 4; ++j)
+            mismatch_count += (fabsf(lhs[i][j] - rhs[i][j]) > 1e-5f * GFX_MAX(1.0f, fabsf(rhs[i][j])) ? 1 : 0);
+    return mismatch_count;
+}
+
+// Batches mixing independent imports with animations listed more than once (and so sharing
+// their hierarchy) pose every skin like applying the animations one after the other.
+GFX_TEST(AnimationBatchMatchesSerial)
+{
+    uint32_t const import_count = 8;
+    char const *path = "animation_batch_test.gltf", *bin_path = "animation_batch_test.bin";
+    GFX_CHECK(WriteSkinnedGltf(path, bin_path, 16, 300));
+    GfxScene batch_scene = gfxCreateScene(), serial_scene = gfxCreateScene();
+    for(uint32_t i = 0; i < import_count; ++i)
+    {
+        GFX_CHECK(gfxSceneImport(batch_scene, path) == kGfxResult_NoError);
+        GFX_CHECK(gfxSceneImport(serial_scene, path) == kGfxResult_NoError);
+    }
+    remove(path);
+    remove(bin_path);
+    GFX_CHECK(gfxSceneGetAnimationCount(batch_scene) == import_count && gfxSceneGetSkinCount(batch_scene) == import_count);
+    GFX_CHECK(gfxSceneGetAnimationCount(serial_scene) == import_count && gfxSceneGetSkinCount(serial_scene) == import_count);
+    std::vector<uint64_t> batch_handles, serial_handles;
+    std::vector<float> times;
+    for(uint32_t i = 0; i < 3 * import_count; ++i)
+        if(i < import_count || (i % 3) != 0)   // the odd import out gets applied once only
+        {
+            batch_handles.push_back(gfxSceneGetAnimationHandle(batch_scene, i % import_count));
+            serial_handles.push_back(gfxSceneGetAnimationHandle(serial_scene, i % import_count));
+            times.push_back((float)(i % 7) / 6.0f);
+        }
+    uint32_t mismatch_count = 0;
+    for(uint32_t thread_count : { 0u, 1u, 3u, 64u })
+    {
+        GFX_CHECK(gfxSceneResetAllAnimation(batch_scene) == kGfxResult_NoError && gfxSceneResetAllAnimation(serial_scene) == kGfxResult_NoError);
+        GFX_CHECK(gfxSceneApplyAnimationBatch(batch_scene, batch_handles.data(), times.data(), (uint32_t)batch_handles.size(), thread_count) == kGfxResult_NoError);
+        for(size_t i = 0; i < serial_handles.size(); ++i)
+            GFX_CHECK(gfxSceneApplyAnimation(serial_scene, serial_handles[i], times[i]) == kGfxResult_NoError);
+        for(uint32_t i = 0; i < import_count; ++i)
+        {
+            GfxSkin const &batch_skin = *gfxSceneGetSkin(batch_scene, gfxSceneGetSkinHandle(batch_scene, i));
+            GfxSkin const &serial_skin = *gfxSceneGetSkin(serial_scene, gfxSceneGetSkinHandle(serial_scene, i));
+            GFX_CHECK(batch_skin.joint_matrices.size() == serial_skin.joint_matrices.size());
+            for(size_t j = 0; j < batch_skin.joint_matrices.size() && j < serial_skin.joint_matrices.size(); ++j)
+                mismatch_count += CountMatrixMismatches(batch_skin.joint_matrices[j], serial_skin.joint_matrices[j]);
+        }
+    }
+    GFX_CHECK(mismatch_count == 0);
+    gfxDestroyScene(batch_scene);
+    gfxDestroyScene(serial_scene);
+}
+
+GFX_TEST(AnimationBatchScalingBenchmark)
+{
+    uint32_t const animation_count = 256, chain_length = 64;
+    char const *path = "animation_batch_benchmark.gltf";
+    GFX_CHECK(WriteAnimatedGltf(path, animation_count, chain_length));
+    GfxScene scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    remove(path);
+    GFX_CHECK(gfxSceneGetAnimationCount(scene) == animation_count);
+    std::vector<uint64_t> animation_handles(gfxSceneGetAnimationCount(scene));
+    for(uint32_t i = 0; i < (uint32_t)animation_handles.size(); ++i)
+        animation_handles[i] = gfxSceneGetAnimationHandle(scene, i);
+    std::vector<float> times(animation_handles.size());
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    double baseline_seconds = 0.0;
+    for(uint32_t thread_count = 1; thread_count <= 16; thread_count *= 2)
+    {
+        double const start = gfxTestSeconds();
+        for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+        {
+            for(uint32_t i = 0; i < (uint32_t)times.size(); ++i)
+                times[i] = (float)((iteration + i) % 100) / 100.0f;
+            GFX_CHECK(gfxSceneApplyAnimationBatch(scene, animation_handles.data(), times.data(), (uint32_t)animation_handles.size(), thread_count) == kGfxResult_NoError);
+        }
+        double const seconds = gfxTestSeconds() - start;
+        if(thread_count == 1) baseline_seconds = seconds;
+        printf("%u animations x %u nodes, %2u threads: %.3f ms/batch, %.2fx (%u iterations, %u job system threads)\n", animation_count, chain_length,
+            thread_count, 1e3 * seconds / iteration_count, baseline_seconds / seconds, iteration_count, gfxGetJobSystem().get_thread_count());
+    }
+    gfxDestroyScene(scene);
+}
+
+GFX_TEST(AnimationLayerBlendBenchmark)
+{
+    uint32_t const layer_count = 4, chain_length = 256;
+    char const *path = "animation_layer_benchmark.gltf";
+    GFX_CHECK(WriteAnimatedGltf(path, 1, chain_length, layer_count));
+    GfxScene scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    remove(path);
+    GFX_CHECK(gfxSceneGetAnimationCount(scene) == layer_count);
+    uint64_t animation_handles[layer_count] = {};
+    for(uint32_t i = 0; i < gfxSceneGetAnimationCount(scene) && i < layer_count; ++i)
+        animation_handles[i] = gfxSceneGetAnimationHandle(scene, i);
+    float const weights[layer_count] = { 1.0f, 0.5f, 0.5f, 0.25f };
+    uint32_t const iteration_count = gfxTestIterations(10000);
+    float times[layer_count] = {};
+    double const single_start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+        GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handles[0], (float)(iteration % 100) / 100.0f) == kGfxResult_NoError);
+    double const layered_start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        for(uint32_t i = 0; i < layer_count; ++i)
+            times[i] = (float)((iteration + 25 * i) % 100) / 100.0f;
+        GFX_CHECK(gfxSceneApplyAnimations(scene, animation_handles, times, weights, layer_count) == kGfxResult_NoError);
+    }
+    double const layered_end = gfxTestSeconds();
+    printf("%u nodes: single clip %.3f us/apply, %u blended layers %.3f us/apply (%u iterations)\n", chain_length,
+        1e6 * (layered_start - single_start) / iteration_count, layer_count, 1e6 * (layered_end - layered_start) / iteration_count, iteration_count);
+    gfxDestroyScene(scene);
+}
+
+// Blending a single clip at full weight poses the skin exactly like applying the clip.
+GFX_TEST(AnimationBlendMatchesSingleClip)
+{
+    char const *path = "animation_blend_test.gltf", *bin_path = "animation_blend_test.bin";
+    GFX_CHECK(WriteSkinnedGltf(path, bin_path, 16, 300));
+    GfxScene scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    remove(path);
+    remove(bin_path);
+    GFX_CHECK(gfxSceneGetAnimationCount(scene) == 1 && gfxSceneGetSkinCount(scene) == 1);
+    uint64_t const animation_handle = gfxSceneGetAnimationHandle(scene, 0), skin_handle = gfxSceneGetSkinHandle(scene, 0);
+    float const weight = 1.0f;
+    uint32_t mismatch_count = 0;
+    for(float time : { 0.0f, 0.25f, 0.6f, 1.0f, 1.5f })
+    {
+        GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handle, time) == kGfxResult_NoError);
+        std::vector<glm::mat4> const joint_matrices = gfxSceneGetSkin(scene, skin_handle)->joint_matrices;
+        GFX_CHECK(gfxSceneApplyAnimations(scene, &animation_handle, &time, &weight, 1) == kGfxResult_NoError);
+        GfxSkin const &skin = *gfxSceneGetSkin(scene, skin_handle);
+        GFX_CHECK(skin.joint_matrices.size() == joint_matrices.size());
+        for(size_t i = 0; i < skin.joint_matrices.size() && i < joint_matrices.size(); ++i)
+            mismatch_count += CountMatrixMismatches(skin.joint_matrices[i], joint_matrices[i]);
+    }
+    GFX_CHECK(mismatch_count == 0);
+    gfxDestroyScene(scene);
+}
+
+// The clip rotates every joint by 90 degrees around z from an identity first keyframe, so
+// adding it on top of itself at half time reaches the end pose, and a mask pins the joints
+// it zeroes out to the rest pose.
+GFX_TEST(AnimationAdditiveAndMaskedLayers)
+{
+    uint32_t const joint_count = 16;
+    char const *path = "animation_layer_test.gltf", *bin_path = "animation_layer_test.bin";
+    GFX_CHECK(WriteSkinnedGltf(path, bin_path, joint_count, 300));
+    GfxScene scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    remove(path);
+    remove(bin_path);
+    GFX_CHECK(gfxSceneGetAnimationCount(scene) == 1 && gfxSceneGetSkinCount(scene) == 1);
+    uint64_t const animation_handle = gfxSceneGetAnimationHandle(scene, 0), skin_handle = gfxSceneGetSkinHandle(scene, 0);
+    GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handle, 0.0f) == kGfxResult_NoError);
+    std::vector<glm::mat4> const rest_matrices = gfxSceneGetSkin(scene, skin_handle)->joint_matrices;
+    GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handle, 1.0f) == kGfxResult_NoError);
+    std::vector<glm::mat4> const end_matrices = gfxSceneGetSkin(scene, skin_handle)->joint_matrices;
+    GFX_CHECK(rest_matrices.size() == joint_count && end_matrices.size() == joint_count);
+    auto CountMismatches = [&](std::vector<glm::mat4> const &expected_matrices, uint32_t first_joint, uint32_t end_joint)
+    {
+        GfxSkin const &skin = *gfxSceneGetSkin(scene, skin_handle);
+        uint32_t mismatch_count = 0;
+        for(uint32_t i = first_joint; i < end_joint && i < skin.joint_matrices.size() && i < expected_matrices.size(); ++i)
+            mismatch_count += CountMatrixMismatches(skin.joint_matrices[i], expected_matrices[i]);
+        return mismatch_count;
+    };
+    uint64_t const animation_handles[] = { animation_handle, animation_handle };
+    float const weights[] = { 1.0f, 1.0f };
+    GfxAnimationLayer layers[2];
+    layers[1].additive = true;
+    // Adding the first keyframe is a no-op, and the clip adds onto the rest pose as a whole
+    float const first_times[] = { 1.0f, 0.0f };
+    GFX_CHECK(gfxSceneApplyAnimations(scene, animation_handles, first_times, weights, 2, layers) == kGfxResult_NoError);
+    GFX_CHECK(CountMismatches(end_matrices, 0, joint_count) == 0);
+    GFX_CHECK(gfxSceneApplyAnimations(scene, &animation_handles[1], &first_times[0], &weights[1], 1, &layers[1]) == kGfxResult_NoError);
+    GFX_CHECK(CountMismatches(end_matrices, 0, joint_count) == 0);
+    // Half the rotation added on top of the other half
+    float const half_times[] = { 0.5f, 0.5f };
+    GFX_CHECK(gfxSceneApplyAnimations(scene, animation_handles, half_times, weights, 2, layers) == kGfxResult_NoError);
+    GFX_CHECK(CountMismatches(end_matrices, 0, joint_count) == 0);
+    // A zero weight leaves the base layer alone
+    float const zero_weights[] = { 1.0f, 0.0f };
+    GFX_CHECK(gfxSceneApplyAnimations(scene, animation_handles, half_times, zero_weights, 2, layers) == kGfxResult_NoError);
+    GFX_CHECK(CountMismatches(end_matrices, 0, joint_count) > 0);
+    // Masking out the first half of the chain keeps it at rest while the other half moves
+    std::vector<float> mask_weights(joint_count, 1.0f);
+    for(uint32_t i = 0; i < joint_count / 2; ++i)
+        mask_weights[i] = 0.0f;
+    GfxAnimationLayer masked_layer;
+    masked_layer.mask_skin_handle = skin_handle;
+    masked_layer.mask_weights = mask_weights.data();
+    float const end_time = 1.0f;
+    GFX_CHECK(gfxSceneApplyAnimations(scene, &animation_handle, &end_time, &weights[0], 1, &masked_layer) == kGfxResult_NoError);
+    GFX_CHECK(CountMismatches(rest_matrices, 0, joint_count / 2) == 0);
+    GFX_CHECK(CountMismatches(rest_matrices, joint_count / 2, joint_count) > 0);
+    // And the mask doesn't leak into the next application
+    GFX_CHECK(gfxSceneApplyAnimations(scene, &animation_handle, &end_time, &weights[0], 1) == kGfxResult_NoError);
+    GFX_CHECK(CountMismatches(end_matrices, 0, joint_count) == 0);
+    gfxDestroyScene(scene);
+}
+
+//!
+//! OBJ import.
+//!
+
+// Writes a `grid_size' x `grid_size' quad grid split into `shape_count' objects,
+// with a position, a texture coordinate and a normal per vertex.
+static bool WriteGridObj(char const *path, uint32_t grid_size, uint32_t shape_count)
+{
+    FILE *file = fopen(path, "w");
+    if(file == nullptr) return false;
+    for(uint32_t y = 0; y < grid_size; ++y)
+        for(uint32_t x = 0; x < grid_size; ++x)
+            fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.0 1.0 0.0\n", (float)x, 0.01f * (float)((x * 7 + y * 13) % 100), (float)y,
+                (float)x / (float)grid_size, (float)y / (float)grid_size);
+    uint32_t const rows_per_shape = (grid_size - 1 + shape_count - 1) / shape_count;
+    for(uint32_t y = 0; y + 1 < grid_size; ++y)
+    {
+        if(y % rows_per_shape == 0)
+            fprintf(file, "o shape%u\n", y / rows_per_shape);
+        for(uint32_t x = 0; x + 1 < grid_size; ++x)
+        {
+            uint32_t const i = y * grid_size + x + 1;   // indices are 1-based
+            fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", i, i, i, i + grid_size, i + grid_size, i + grid_size,
+                i + grid_size + 1, i + grid_size + 1, i + grid_size + 1, i + 1, i + 1, i + 1);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static double GetPeakWorkingSetMiB()
+{
+    PROCESS_MEMORY_COUNTERS memory_counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &memory_counters, sizeof(memory_counters));
+    return (double)memory_counters.PeakWorkingSetSize / 1048576.0;
+}
+
+// The old import path was built on tinyobj::ObjReader and is gone, so its parse step
+// alone is timed on the same file; the mesh rebuild it was followed by came on top.
+GFX_TEST(ObjImportBenchmark)
+{
+    uint32_t const grid_size = (gfxTestBenchmarkMode() ? 2048 : 128), shape_count = 16;
+    char const *path = "obj_import_benchmark.obj";
+    GFX_CHECK(WriteGridObj(path, grid_size, shape_count));
+    double const start_peak = GetPeakWorkingSetMiB();
+    GfxScene scene = gfxCreateScene();
+    double const import_start = gfxTestSeconds();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    double const import_seconds = gfxTestSeconds() - import_start;
+    double const import_peak = GetPeakWorkingSetMiB();
+    size_t index_count = 0;
+    for(uint32_t i = 0; i < gfxSceneGetMeshCount(scene); ++i)
+        index_count += gfxSceneGetMeshes(scene)[i].indices.size();
+    GFX_CHECK(gfxSceneGetMeshCount(scene) == shape_count);
+    GFX_CHECK(index_count == 6ull * (grid_size - 1) * (grid_size - 1));
+    gfxDestroyScene(scene);
+    tinyobj::ObjReader obj_reader;
+    double const reader_start = gfxTestSeconds();
+    GFX_CHECK(obj_reader.ParseFromFile(path));
+    double const reader_seconds = gfxTestSeconds() - reader_start;
+    double const reader_peak = GetPeakWorkingSetMiB();
+    remove(path);
+    printf("%u^2 vertex grid: gfxSceneImport %.1f ms, tinyobj::ObjReader parse only %.1f ms; peak working set %.1f MiB before, %.1f MiB after the import, %.1f MiB after the parse\n",
+        grid_size, 1e3 * import_seconds, 1e3 * reader_seconds, start_peak, import_peak, reader_peak);
+}
+
+//!
+//! Animation states.
+//!
+
+static double GetPrivateBytesMiB()
+{
+    PROCESS_MEMORY_COUNTERS_EX memory_counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS *)&memory_counters, sizeof(memory_counters));
+    return (double)memory_counters.PrivateUsage / 1048576.0;
+}
+
+// A state with an identity transform poses its copies exactly like the clip poses the
+// imported instances and skins.
+GFX_TEST(AnimationStateMatchesSharedGraph)
+{
+    char const *path = "animation_state_test.gltf", *bin_path = "animation_state_test.bin";
+    GFX_CHECK(WriteSkinnedGltf(path, bin_path, 16, 300));
+    GfxScene scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    remove(path);
+    remove(bin_path);
+    GFX_CHECK(gfxSceneGetAnimationCount(scene) == 1 && gfxSceneGetInstanceCount(scene) == 1 && gfxSceneGetSkinCount(scene) == 1);
+    uint64_t const animation_handle = gfxSceneGetAnimationHandle(scene, 0);
+    uint64_t const instance_handle = gfxSceneGetInstanceHandle(scene, 0), skin_handle = gfxSceneGetSkinHandle(scene, 0);
+    GfxRef<GfxAnimationState> const animation_state_ref = gfxSceneCreateAnimationState(scene, animation_handle);
+    GFX_CHECK(animation_state_ref && animation_state_ref->instances.size() == 1 && animation_state_ref->skins.size() == 1);
+    GFX_CHECK(gfxSceneGetMeshCount(scene) == 1 && animation_state_ref->instances[0]->mesh == gfxSceneGetInstance(scene, instance_handle)->mesh);
+    GFX_CHECK((uint64_t)animation_state_ref->instances[0]->skin == (uint64_t)animation_state_ref->skins[0]);
+    uint32_t mismatch_count = 0;
+    for(float time : { 0.0f, 0.25f, 0.6f, 1.0f, 1.5f })
+    {
+        GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handle, time) == kGfxResult_NoError);
+        GFX_CHECK(gfxSceneApplyAnimationState(scene, animation_state_ref, time) == kGfxResult_NoError);
+        GfxSkin const &skin = *gfxSceneGetSkin(scene, skin_handle), &state_skin = *animation_state_ref->skins[0];
+        GFX_CHECK(skin.joint_matrices.size() == 16 && state_skin.joint_matrices.size() == 16);
+        for(size_t i = 0; i < skin.joint_matrices.size() && i < state_skin.joint_matrices.size(); ++i)
+            mismatch_count += CountMatrixMismatches(state_skin.joint_matrices[i], skin.joint_matrices[i]);
+        mismatch_count += CountMatrixMismatches(animation_state_ref->instances[0]->transform, gfxSceneGetInstance(scene, instance_handle)->transform);
+    }
+    GFX_CHECK(mismatch_count == 0);
+    // Applying the state leaves the imported pose alone
+    GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handle, 0.0f) == kGfxResult_NoError);
+    glm::mat4 const rest_joint_matrix = gfxSceneGetSkin(scene, skin_handle)->joint_matrices[15];
+    GFX_CHECK(gfxSceneApplyAnimationState(scene, animation_state_ref, 1.0f) == kGfxResult_NoError);
+    GFX_CHECK(CountMatrixMismatches(gfxSceneGetSkin(scene, skin_handle)->joint_matrices[15], rest_joint_matrix) == 0);
+    GFX_CHECK(CountMatrixMismatches(animation_state_ref->skins[0]->joint_matrices[15], rest_joint_matrix) > 0);
+    gfxDestroyScene(scene);
+}
+
+// Poses `copy_count' copies of a skinned character at different times, once as animation
+// states of a single import and once as that many imports of the same file.
+GFX_TEST(AnimationStateCopiesBenchmark)
+{
+    uint32_t const copy_count = (gfxTestBenchmarkMode() ? 256 : 16), joint_count = 64, vertex_count = 20000;
+    uint32_t const iteration_count = gfxTestIterations(1000);
+    char const *path = "animation_state_benchmark.gltf", *bin_path = "animation_state_benchmark.bin";
+    GFX_CHECK(WriteSkinnedGltf(path, bin_path, joint_count, vertex_count));
+    std::vector<float> times(copy_count);
+    // N states of one import
+    double const state_start_bytes = GetPrivateBytesMiB();
+    GfxScene state_scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(state_scene, path) == kGfxResult_NoError && gfxSceneGetAnimationCount(state_scene) == 1);
+    std::vector<uint64_t> state_handles(copy_count);
+    for(uint32_t i = 0; i < copy_count; ++i)
+        state_handles[i] = gfxSceneCreateAnimationState(state_scene, gfxSceneGetAnimationHandle(state_scene, 0));
+    GFX_CHECK(gfxSceneGetAnimationStateCount(state_scene) == copy_count && gfxSceneGetMeshCount(state_scene) == 1);
+    GFX_CHECK(gfxSceneGetSkinCount(state_scene) == copy_count + 1 && gfxSceneGetInstanceCount(state_scene) == copy_count + 1);
+    double const state_bytes = GetPrivateBytesMiB() - state_start_bytes;
+    double const state_start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        for(uint32_t i = 0; i < copy_count; ++i)
+            times[i] = (float)((iteration + i) % 100) / 100.0f;
+        GFX_CHECK(gfxSceneApplyAnimationStates(state_scene, state_handles.data(), times.data(), copy_count) == kGfxResult_NoError);
+    }
+    double const state_seconds = (gfxTestSeconds() - state_start) / iteration_count;
+    gfxDestroyScene(state_scene);
+    // N imports
+    double const import_start_bytes = GetPrivateBytesMiB();
+    GfxScene import_scene = gfxCreateScene();
+    for(uint32_t i = 0; i < copy_count; ++i)
+        GFX_CHECK(gfxSceneImport(import_scene, path) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneGetAnimationCount(import_scene) == copy_count && gfxSceneGetMeshCount(import_scene) == copy_count);
+    double const import_bytes = GetPrivateBytesMiB() - import_start_bytes;
+    std::vector<uint64_t> animation_handles(copy_count);
+    for(uint32_t i = 0; i < copy_count; ++i)
+        animation_handles[i] = gfxSceneGetAnimationHandle(import_scene, i);
+    double const import_start = gfxTestSeconds();
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+        for(uint32_t i = 0; i < copy_count; ++i)
+            GFX_CHECK(gfxSceneApplyAnimation(import_scene, animation_handles[i], (float)((iteration + i) % 100) / 100.0f) == kGfxResult_NoError);
+    double const import_seconds = (gfxTestSeconds() - import_start) / iteration_count;
+    gfxDestroyScene(import_scene);
+    remove(path);
+    remove(bin_path);
+    printf("%u copies of a %u-joint, %u-vertex skinned mesh: states %.2f MiB, %.3f ms/frame; imports %.2f MiB, %.3f ms/frame (%u iterations)\n", copy_count,
+        joint_count, vertex_count, state_bytes, 1e3 * state_seconds, import_bytes, 1e3 * import_seconds, iteration_count);
+}
+
+//!
+//! Modified instances.
+//!
+
+GFX_TEST(ModifiedInstancesTracking)
+{
+    char const *path = "modified_instances_test.gltf", *bin_path = "modified_instances_test.bin";
+    GFX_CHECK(WriteSkinnedGltf(path, bin_path, 16, 300));
+    GfxScene scene = gfxCreateScene();
+    GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+    remove(path);
+    remove(bin_path);
+    GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 0);
+    // Marking lists each instance once until cleared
+    uint64_t const instance_handle = gfxSceneGetInstanceHandle(scene, 0);
+    GFX_CHECK(gfxSceneMarkInstanceModified(scene, instance_handle) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneMarkInstanceModified(scene, instance_handle) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 1 && gfxSceneGetModifiedInstances(scene)[0] == instance_handle);
+    GFX_CHECK(gfxSceneClearModifiedInstances(scene) == kGfxResult_NoError && gfxSceneGetModifiedInstanceCount(scene) == 0);
+    // The skinned mesh isn't below the joints, so posing them doesn't move it
+    uint64_t const animation_handle = gfxSceneGetAnimationHandle(scene, 0);
+    GFX_CHECK(gfxSceneApplyAnimation(scene, animation_handle, 0.5f) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 0);
+    // But an animation state places its copy of it
+    GfxRef<GfxAnimationState> const animation_state_ref = gfxSceneCreateAnimationState(scene, animation_handle);
+    GFX_CHECK(animation_state_ref && animation_state_ref->instances.size() == 1);
+    animation_state_ref->transform[3][0] = 1.0f;
+    GFX_CHECK(gfxSceneApplyAnimationState(scene, animation_state_ref, 0.5f) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 1 && gfxSceneGetModifiedInstances(scene)[0] == (uint64_t)animation_state_ref->instances[0]);
+    GFX_CHECK(gfxSceneClearModifiedInstances(scene) == kGfxResult_NoError);
+    // Destroyed instances may stay listed, but can't be marked anymore
+    GfxRef<GfxInstance> const instance_ref = gfxSceneCreateInstance(scene);
+    GFX_CHECK(gfxSceneMarkInstanceModified(scene, instance_ref) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneDestroyInstance(scene, instance_ref) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 1 && gfxSceneGetInstance(scene, gfxSceneGetModifiedInstances(scene)[0]) == nullptr);
+    GFX_CHECK(gfxSceneMarkInstanceModified(scene, instance_ref) != kGfxResult_NoError);
+    GfxRef<GfxInstance> const new_instance_ref = gfxSceneCreateInstance(scene);
+    GFX_CHECK(gfxSceneMarkInstanceModified(scene, new_instance_ref) == kGfxResult_NoError);
+    GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 2 && gfxSceneGetModifiedInstances(scene)[1] == (uint64_t)new_instance_ref);
+    gfxDestroyScene(scene);
+}
+
+//!
+//! Morph targets.
+//!
+
+// Writes a glTF file with `instance_count' nodes sharing a triangle mesh that has
+// `target_count' morph targets, its geometry going into a .bin file next to it.
+static bool WriteMorphedGltf(char const *path, char const *bin_path, uint32_t instance_count, uint32_t target_count)
+{
+    std::vector<float> positions(9 * (1 + target_count), 0.0f);
+    positions[3] = positions[7] = 1.0f;
+    FILE *bin_file = fopen(bin_path, "wb");
+    if(bin_file == nullptr) return false;
+    fwrite(positions.data(), sizeof(float), positions.size(), bin_file);
+    fclose(bin_file);
+    std::string nodes, roots, targets, weights, accessors = "{\"bufferView\":0,\"componentType\":5126,\"count\":3,\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[1,1,0]}";
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        nodes += (i > 0 ? "," : "") + std::string("{\"mesh\":0,\"translation\":[") + std::to_string(i) + ",0,0]}";
+        roots += (i > 0 ? "," : "") + std::to_string(i);
+    }
+    for(uint32_t i = 0; i < target_count; ++i)
+    {
+        targets += (i > 0 ? "," : "") + std::string("{\"POSITION\":") + std::to_string(i + 1) + "}";
+        weights += (i > 0 ? ",0.5" : "0.5");
+        accessors += ",{\"bufferView\":0,\"byteOffset\":" + std::to_string(36 * (i + 1)) + ",\"componentType\":5126,\"count\":3,\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[0,0,0]}";
+    }
+    FILE *file = fopen(path, "w");
+    if(file == nullptr) return false;
+    fprintf(file, "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[%s]}],\"nodes\":[%s],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"targets\":[%s]}],\"weights\":[%s]}],\"accessors\":[%s],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu}],\"buffers\":[{\"byteLength\":%zu,\"uri\":\"%s\"}]}",
+        roots.c_str(), nodes.c_str(), targets.c_str(), weights.c_str(), accessors.c_str(), positions.size() * sizeof(float), positions.size() * sizeof(float), bin_path);
+    fclose(file);
+    return true;
+}
+
+// The per-instance weights are copied from the mesh on import; with few enough targets
+// they stay within the instance rather than taking an allocation each.
+GFX_TEST(MorphWeightsImportBenchmark)
+{
+    uint32_t const instance_count = (gfxTestBenchmarkMode() ? 100000 : 10000), target_count = 4;
+    uint32_t const iteration_count = gfxTestIterations(500);
+    char const *path = "morph_weights_benchmark.gltf", *bin_path = "morph_weights_benchmark.bin";
+    GFX_CHECK(WriteMorphedGltf(path, bin_path, instance_count, target_count));
+    double import_seconds = 0.0, instance_bytes = 0.0;
+    uint32_t inline_count = 0;
+    for(uint32_t iteration = 0; iteration < iteration_count; ++iteration)
+    {
+        double const start_bytes = GetPrivateBytesMiB();
+        GfxScene scene = gfxCreateScene();
+        double const start = gfxTestSeconds();
+        GFX_CHECK(gfxSceneImport(scene, path) == kGfxResult_NoError);
+        import_seconds += gfxTestSeconds() - start;
+        instance_bytes += GetPrivateBytesMiB() - start_bytes;
+        GFX_CHECK(gfxSceneGetInstanceCount(scene) == instance_count);
+        inline_count = 0;
+        for(uint32_t i = 0; i < gfxSceneGetInstanceCount(scene); ++i)
+        {
+            GfxInstance const &instance = gfxSceneGetInstances(scene)[i];
+            GFX_CHECK(instance.weights.size() == target_count && instance.weights[0] == 0.5f);
+            inline_count += (instance.weights.is_inline() ? 1 : 0);
+        }
+        gfxDestroyScene(scene);
+    }
+    remove(path);
+    remove(bin_path);
+    GFX_CHECK(inline_count == instance_count);
+    printf("%u instances with %u morph targets: %.2f ms per import, %.2f MiB private bytes, weights inline for %u instances (%u iterations)\n",
+        instance_count, target_count, 1e3 * import_seconds / iteration_count, instance_bytes / iteration_count, inline_count, iteration_count);
+}
@@ -0,0 +1,126 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#ifndef GFX_INCLUDE_GFX_TEST_H
+#define GFX_INCLUDE_GFX_TEST_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//!
+//! Test registry.
+//!
+
+// Each test/benchmark executable lists its cases with GFX_TEST() and gets run
+// by ctest with no arguments (all cases) or with a case name prefix as a filter.
+// Benchmarks are plain cases that print their timings; they run a reduced
+// iteration count unless the executable is launched with `--bench'.
+
+struct GfxTestCase
+{
+    char const *name;
+    void (*function)();
+};
+
+inline std::vector<GfxTestCase> &gfxTestCases()
+{
+    static std::vector<GfxTestCase> test_cases;
+    return test_cases;
+}
+
+inline bool &gfxTestBenchmarkMode()
+{
+    static bool benchmark_mode = false;
+    return benchmark_mode;
+}
+
+inline uint32_t &gfxTestFailureCount()
+{
+    static uint32_t failure_count = 0;
+    return failure_count;
+}
+
+struct GfxTestRegistrar
+{
+    GfxTestRegistrar(char const *name, void (*function)()) { gfxTestCases().push_back({ name, function }); }
+};
+
+#define GFX_TEST(NAME)                                                      \
+    static void GfxTest_##NAME();                                           \
+    static GfxTestRegistrar const gfx_test_registrar_##NAME(#NAME, GfxTest_##NAME); \
+    static void GfxTest_##NAME()
+
+#define GFX_CHECK(X)                                                                    \
+    do                                                                                  \
+    {                                                                                   \
+        if(!(X))                                                                        \
+        {                                                                               \
+            printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #X);            \
+            ++gfxTestFailureCount();                                                    \
+        }                                                                               \
+    } while(0)
+
+// Picks the iteration count of a benchmark: the full count when launched with
+// `--bench', a small one otherwise so that ctest stays fast.
+inline uint32_t gfxTestIterations(uint32_t iteration_count)
+{
+    return (gfxTestBenchmarkMode() ? iteration_count : (iteration_count + 99) / 100);
+}
+
+inline double gfxTestSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline int gfxTestMain(int argc, char **argv)
+{
+    char const *filter = nullptr;
+    for(int i = 1; i < argc; ++i)
+        if(!strcmp(argv[i], "--bench"))
+            gfxTestBenchmarkMode() = true;
+        else
+            filter = argv[i];
+    uint32_t run_count = 0;
+    for(GfxTestCase const &test_case : gfxTestCases())
+    {
+        if(filter != nullptr && strncmp(filter, test_case.name, strlen(filter)) != 0)
+            continue;   // filtered out
+        uint32_t const failure_count = gfxTestFailureCount();
+        printf("[ RUN  ] %s\n", test_case.name);
+        test_case.function();
+        printf("[ %s ] %s\n", failure_count == gfxTestFailureCount() ? " OK " : "FAIL", test_case.name);
+        ++run_count;
+    }
+    if(run_count == 0)
+    {
+        printf("No test case matching `%s'\n", filter != nullptr ? filter : "");
+        return EXIT_FAILURE;
+    }
+    return (gfxTestFailureCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+#endif //! GFX_INCLUDE_GFX_TEST_H
@@ -0,0 +1,313 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gfx.h"
+#include "gfx_test.h"
+
+//!
+//! Async compute.
+//!
+
+GFX_TEST(AsyncComputeOwnership)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    GfxTexture src = gfxCreateTexture2D(gfx, 64, 64, DXGI_FORMAT_R8G8B8A8_UNORM);
+    GfxTexture dst = gfxCreateTexture2D(gfx, 64, 64, DXGI_FORMAT_R8G8B8A8_UNORM);
+    GFX_CHECK(gfxCommandCopyTexture(gfx, dst, src) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandClearTexture(gfx, src) == kGfxResult_NoError);  // leaves `src' in a graphics-only state
+    GFX_CHECK(gfxCommandSetQueue(gfx, kGfxQueue_Compute) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandCopyTexture(gfx, dst, src) == kGfxResult_InvalidOperation); // not released by the graphics queue yet
+    GfxSyncPoint const graphics_sync_point = gfxSignal(gfx, kGfxQueue_Graphics);    // releases `src' as it is now known to the compute queue
+    GFX_CHECK(graphics_sync_point && graphics_sync_point.getQueue() == kGfxQueue_Graphics);
+    GFX_CHECK(gfxCommandGetQueue(gfx) == kGfxQueue_Compute);    // signaling preserves the queue being recorded
+    GFX_CHECK(gfxWait(gfx, kGfxQueue_Compute, graphics_sync_point) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandCopyTexture(gfx, dst, src) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandClearTexture(gfx, dst) == kGfxResult_InvalidOperation); // graphics-only, rejected even with validation compiled out
+    GfxSyncPoint const compute_sync_point = gfxSignal(gfx, kGfxQueue_Compute);
+    GFX_CHECK(compute_sync_point && compute_sync_point.getQueue() == kGfxQueue_Compute);
+    GFX_CHECK(gfxCommandSetQueue(gfx, kGfxQueue_Graphics) == kGfxResult_NoError);
+    GFX_CHECK(gfxWait(gfx, kGfxQueue_Graphics, compute_sync_point) == kGfxResult_NoError);
+    GFX_CHECK(gfxWait(gfx, kGfxQueue_Graphics, GfxSyncPoint()) == kGfxResult_InvalidParameter);
+    GFX_CHECK(gfxCommandClearTexture(gfx, src) == kGfxResult_NoError);  // the graphics queue can use it again
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    gfxDestroyTexture(gfx, src);
+    gfxDestroyTexture(gfx, dst);
+    GFX_CHECK(gfxSignal(gfx, kGfxQueue_Graphics));  // stale compute queue entries are dropped
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    gfxDestroyContext(gfx);
+}
+
+GFX_TEST(AsyncComputeRaytracingOwnership)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    GfxAccelerationStructure acceleration_structure = gfxCreateAccelerationStructure(gfx);
+    if(!acceleration_structure) { gfxDestroyContext(gfx); return; }    // no raytracing support
+    float const vertices[] = { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+    uint32_t const indices[] = { 0, 1, 2 };
+    GfxBuffer vertex_buffer = gfxCreateBuffer<float>(gfx, 9, vertices);
+    GfxBuffer index_buffer = gfxCreateBuffer<uint32_t>(gfx, 3, indices);
+    GfxProgramDesc program_desc = {};
+    program_desc.vs = "float4 main(in uint idx : SV_VertexID) : SV_POSITION { return float4(float(idx & 1), float(idx >> 1), 0.0f, 1.0f); }";
+    program_desc.ps = "float4 main() : SV_Target { return 1.0f; }";
+    GfxProgram program = gfxCreateProgram(gfx, program_desc, "TriangleProgram");
+    GfxKernel kernel = gfxCreateGraphicsKernel(gfx, program);
+    GFX_CHECK(gfxCommandBindKernel(gfx, kernel) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandBindIndexBuffer(gfx, index_buffer) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandDrawIndexed(gfx, 3) == kGfxResult_NoError);    // leaves `index_buffer' in a graphics-only state
+    GfxRaytracingPrimitive raytracing_primitive = gfxCreateRaytracingPrimitive(gfx, acceleration_structure);
+    GFX_CHECK(gfxCommandSetQueue(gfx, kGfxQueue_Compute) == kGfxResult_NoError);
+    GFX_CHECK(gfxRaytracingPrimitiveBuild(gfx, raytracing_primitive, index_buffer, vertex_buffer, 3 * sizeof(float)) == kGfxResult_InvalidOperation);
+    GfxSyncPoint const graphics_sync_point = gfxSignal(gfx, kGfxQueue_Graphics);    // releases `index_buffer'
+    GFX_CHECK(gfxWait(gfx, kGfxQueue_Compute, graphics_sync_point) == kGfxResult_NoError);
+    GFX_CHECK(gfxRaytracingPrimitiveBuild(gfx, raytracing_primitive, index_buffer, vertex_buffer, 3 * sizeof(float)) == kGfxResult_NoError);
+    GFX_CHECK(gfxAccelerationStructureUpdate(gfx, acceleration_structure) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandSetQueue(gfx, kGfxQueue_Graphics) == kGfxResult_NoError);
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    gfxDestroyRaytracingPrimitive(gfx, raytracing_primitive);
+    gfxDestroyAccelerationStructure(gfx, acceleration_structure);
+    gfxDestroyKernel(gfx, kernel);
+    gfxDestroyProgram(gfx, program);
+    gfxDestroyBuffer(gfx, index_buffer);
+    gfxDestroyBuffer(gfx, vertex_buffer);
+    gfxDestroyContext(gfx);
+}
+
+//!
+//! Bundles.
+//!
+
+static GfxKernel CreateTriangleKernel(GfxContext gfx, GfxProgram &program)
+{
+    GfxProgramDesc program_desc = {};
+    program_desc.vs = "float4 main(in uint idx : SV_VertexID) : SV_POSITION { return float4(float(idx & 1), float(idx >> 1), 0.0f, 1.0f); }";
+    program_desc.ps = "float4 main() : SV_Target { return 1.0f; }";
+    program = gfxCreateProgram(gfx, program_desc, "TriangleProgram");
+    return gfxCreateGraphicsKernel(gfx, program);
+}
+
+GFX_TEST(BundleRecordValidation)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    GfxProgram program;
+    GfxKernel kernel = CreateTriangleKernel(gfx, program);
+    GfxProgramDesc compute_program_desc = {};
+    compute_program_desc.cs = "[numthreads(1, 1, 1)] void main() {}";
+    GfxProgram compute_program = gfxCreateProgram(gfx, compute_program_desc, "ComputeProgram");
+    GfxKernel compute_kernel = gfxCreateComputeKernel(gfx, compute_program);
+    uint32_t const indices[] = { 0, 1, 2 };
+    GfxBuffer index_buffer = gfxCreateBuffer<uint32_t>(gfx, 3, indices);
+    GfxBundle bundle = gfxBeginBundle(gfx);
+    GFX_CHECK(gfxCommandDraw(gfx, 3) == kGfxResult_InvalidOperation);   // no kernel bound yet
+    GFX_CHECK(gfxCommandBindKernel(gfx, compute_kernel) == kGfxResult_InvalidOperation);
+    GFX_CHECK(gfxCommandBindKernel(gfx, kernel) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandDrawIndexed(gfx, 3) == kGfxResult_InvalidOperation);    // no index buffer bound yet
+    GFX_CHECK(gfxCommandBindIndexBuffer(gfx, index_buffer) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandDrawIndexed(gfx, 3) == kGfxResult_NoError);
+    GFX_CHECK(gfxEndBundle(gfx, bundle) == kGfxResult_NoError);
+    GFX_CHECK(gfxCommandExecuteBundle(gfx, bundle) == kGfxResult_NoError);
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    gfxDestroyBuffer(gfx, index_buffer);
+    GFX_CHECK(gfxCommandExecuteBundle(gfx, bundle) == kGfxResult_InvalidOperation); // references a destroyed buffer
+    gfxDestroyBundle(gfx, bundle);
+    gfxDestroyKernel(gfx, compute_kernel);
+    gfxDestroyProgram(gfx, compute_program);
+    gfxDestroyKernel(gfx, kernel);
+    gfxDestroyProgram(gfx, program);
+    gfxDestroyContext(gfx);
+}
+
+GFX_TEST(BundleReplayBenchmark)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    GfxProgram program;
+    GfxKernel kernel = CreateTriangleKernel(gfx, program);
+    uint32_t const draw_count = 1000;
+    uint32_t const frame_count = gfxTestIterations(1000);
+    GfxBundle bundle = gfxBeginBundle(gfx);
+    gfxCommandBindKernel(gfx, kernel);
+    for(uint32_t i = 0; i < draw_count; ++i)
+        gfxCommandDraw(gfx, 3, 1, 0, i);
+    GFX_CHECK(gfxEndBundle(gfx, bundle) == kGfxResult_NoError);
+    double live_seconds = 0.0, replay_seconds = 0.0;
+    for(uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        double const live_start = gfxTestSeconds();
+        gfxCommandBindKernel(gfx, kernel);
+        for(uint32_t i = 0; i < draw_count; ++i)
+            gfxCommandDraw(gfx, 3, 1, 0, i);
+        double const replay_start = gfxTestSeconds();
+        GFX_CHECK(gfxCommandExecuteBundle(gfx, bundle) == kGfxResult_NoError);
+        double const replay_end = gfxTestSeconds();
+        live_seconds += replay_start - live_start;
+        replay_seconds += replay_end - replay_start;
+        gfxFrame(gfx, false);
+    }
+    printf("%u draws: live %.3f us/draw, bundle replay %.3f us/draw (%u frames)\n", draw_count,
+        1e6 * live_seconds / ((double)draw_count * frame_count), 1e6 * replay_seconds / ((double)draw_count * frame_count), frame_count);
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    gfxDestroyBundle(gfx, bundle);
+    gfxDestroyKernel(gfx, kernel);
+    gfxDestroyProgram(gfx, program);
+    gfxDestroyContext(gfx);
+}
+
+//!
+//! Validation.
+//!
+
+GFX_TEST(EncodeOverheadBenchmark)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    GfxProgram program;
+    GfxKernel kernel = CreateTriangleKernel(gfx, program);
+    GfxBuffer dst = gfxCreateBuffer(gfx, 256);
+    GfxBuffer src = gfxCreateBuffer(gfx, 256);
+    uint32_t const call_count = 1000;
+    uint32_t const frame_count = gfxTestIterations(1000);
+    double draw_seconds = 0.0, copy_seconds = 0.0;
+    for(uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        double const draw_start = gfxTestSeconds();
+        for(uint32_t i = 0; i < call_count; ++i)
+        {
+            gfxCommandBindKernel(gfx, kernel);
+            gfxCommandDraw(gfx, 3);
+        }
+        double const copy_start = gfxTestSeconds();
+        for(uint32_t i = 0; i < call_count; ++i)
+            gfxCommandCopyBuffer(gfx, dst, src);
+        double const copy_end = gfxTestSeconds();
+        draw_seconds += copy_start - draw_start;
+        copy_seconds += copy_end - copy_start;
+        gfxFrame(gfx, false);
+    }
+    printf("validation %s: bind+draw %.3f us/call, copy %.3f us/call (%u frames)\n", GFX_ENABLE_VALIDATION ? "on" : "off",
+        1e6 * draw_seconds / ((double)call_count * frame_count), 1e6 * copy_seconds / ((double)call_count * frame_count), frame_count);
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    gfxDestroyBuffer(gfx, src);
+    gfxDestroyBuffer(gfx, dst);
+    gfxDestroyKernel(gfx, kernel);
+    gfxDestroyProgram(gfx, program);
+    gfxDestroyContext(gfx);
+}
+
+//!
+//! Memory budget.
+//!
+
+struct BudgetCounter
+{
+    uint32_t over_count = 0;
+    uint32_t under_count = 0;
+    bool remove_self = false;
+};
+
+static void BudgetCallback(GfxContext gfx, GfxMemoryBudget const &, bool is_over_threshold, void *user_data)
+{
+    BudgetCounter &budget_counter = *(BudgetCounter *)user_data;
+    ++(is_over_threshold ? budget_counter.over_count : budget_counter.under_count);
+    if(budget_counter.remove_self)
+        gfxRemoveMemoryBudgetCallback(gfx, BudgetCallback, user_data);
+}
+
+static uint64_t GetDefaultHeapBytes(GfxContext gfx)
+{
+    uint64_t default_heap_bytes = 0;
+    GfxMemoryStatistics const memory_statistics = gfxGetMemoryStatistics(gfx);
+    for(uint32_t i = 0; i < kGfxMemoryResource_Count; ++i)
+        default_heap_bytes += memory_statistics.allocation_bytes[kGfxMemoryHeap_Default][i];
+    return default_heap_bytes;
+}
+
+GFX_TEST(SimulatedMemoryBudget)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    uint64_t const default_heap_bytes = GetDefaultHeapBytes(gfx);
+    GFX_CHECK(default_heap_bytes > 0); // the headless back buffers are tracked
+    GFX_CHECK(gfxSetSimulatedMemoryBudget(gfx, default_heap_bytes + (16 << 20)) == kGfxResult_NoError);
+    GFX_CHECK(gfxGetMemoryBudget(gfx).budget_bytes == default_heap_bytes + (16 << 20));
+    BudgetCounter first, second;
+    first.remove_self = true;   // must not cause `second' to be skipped
+    GFX_CHECK(gfxAddMemoryBudgetCallback(gfx, 1.0f, BudgetCallback, &first) == kGfxResult_NoError);
+    GFX_CHECK(gfxAddMemoryBudgetCallback(gfx, 1.0f, BudgetCallback, &second) == kGfxResult_NoError);
+    gfxFrame(gfx, false);
+    GFX_CHECK(first.over_count == 0 && second.over_count == 0);
+    GfxBuffer buffer = gfxCreateBuffer(gfx, 32 << 20);
+    GFX_CHECK(GetDefaultHeapBytes(gfx) >= default_heap_bytes + (32 << 20));
+    gfxFrame(gfx, false);
+    GFX_CHECK(first.over_count == 1 && second.over_count == 1);
+    gfxDestroyBuffer(gfx, buffer);
+    for(uint32_t i = 0; i <= kGfxConstant_BackBufferCount; ++i)
+        gfxFrame(gfx, false);   // let the garbage collector release the buffer
+    GFX_CHECK(GetDefaultHeapBytes(gfx) == default_heap_bytes);
+    GFX_CHECK(first.under_count == 0 && second.under_count == 1);
+    GFX_CHECK(gfxRemoveMemoryBudgetCallback(gfx, BudgetCallback, &first) == kGfxResult_InvalidParameter);
+    GFX_CHECK(gfxRemoveMemoryBudgetCallback(gfx, BudgetCallback, &second) == kGfxResult_NoError);
+    gfxDestroyContext(gfx);
+}
+
+//!
+//! Descriptor heap.
+//!
+
+// Grows an unbounded texture array from 1 to 262144 descriptors, dispatching after each step, and
+// returns how many times the kernel had to re-populate its descriptors into a replaced heap.
+static uint32_t GrowDescriptorHeap(GfxCreateContextFlags flags)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, flags);
+    GfxProgramDesc program_desc = {};
+    program_desc.cs = "RWBuffer<uint> Output; Texture2D Textures[]; uint TextureCount; [numthreads(1, 1, 1)] void main() { uint w, h; Textures[TextureCount - 1].GetDimensions(w, h); Output[0] = w; }";
+    GfxProgram program = gfxCreateProgram(gfx, program_desc, "DescriptorProgram");
+    GfxKernel kernel = gfxCreateComputeKernel(gfx, program);
+    GfxBuffer output = gfxCreateBuffer<uint32_t>(gfx, 1);
+    GfxTexture texture = gfxCreateTexture2D(gfx, 4, 4, DXGI_FORMAT_R8G8B8A8_UNORM);
+    gfxProgramSetParameter(gfx, program, "Output", output);
+    gfxCommandBindKernel(gfx, kernel);
+    for(uint32_t texture_count = 1; texture_count <= 262144; texture_count *= 8)
+    {
+        std::vector<GfxTexture> const textures(texture_count, texture); // each size change re-allocates the descriptor range
+        gfxProgramSetParameter(gfx, program, "Textures", textures.data(), texture_count);
+        gfxProgramSetParameter(gfx, program, "TextureCount", texture_count);
+        GFX_CHECK(gfxCommandDispatch(gfx, 1, 1, 1) == kGfxResult_NoError);
+        gfxFrame(gfx, false);
+    }
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    uint32_t const repopulation_count = gfxGetDescriptorRepopulationCount(gfx);
+    gfxDestroyTexture(gfx, texture);
+    gfxDestroyBuffer(gfx, output);
+    gfxDestroyKernel(gfx, kernel);
+    gfxDestroyProgram(gfx, program);
+    gfxDestroyContext(gfx);
+    return repopulation_count;
+}
+
+GFX_TEST(DescriptorHeapGrowth)
+{
+    GFX_CHECK(GrowDescriptorHeap(0) == 0);  // fits in the reserved heap
+    GFX_CHECK(GrowDescriptorHeap(kGfxCreateContextFlag_DisableDescriptorHeapReservation) > 0);
+}
+
+int main(int argc, char **argv)
+{
+    return gfxTestMain(argc, argv);
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+MIT License
+
+Copyright (c) 2024 Guillaume Boissé
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+****************************************************************************/
+#include "gpu_scene.h"
+#include "gfx_test.h"
+
+//!
+//! GPU scene.
+//!
+
+GFX_TEST(TransformUploadBenchmark)
+{
+    GfxContext gfx = gfxCreateContext(64, 64, 0);
+    GfxScene scene = gfxCreateScene();
+    GfxRef<GfxMesh> mesh = gfxSceneCreateMesh(scene);
+    mesh->vertices.resize(3);
+    mesh->indices = { 0, 1, 2 };
+    uint32_t const instance_count = 100000;
+    std::vector<GfxRef<GfxInstance>> instances(instance_count);
+    for(uint32_t i = 0; i < instance_count; ++i)
+    {
+        instances[i] = gfxSceneCreateInstance(scene);
+        instances[i]->mesh = mesh;
+    }
+    GpuScene gpu_scene = UploadSceneToGpuMemory(gfx, scene);
+    uint32_t const moved_count = instance_count / 100;  // 1% of the instances move each frame
+    uint32_t const frame_count = gfxTestIterations(1000);
+    gpu_scene.upload_timings = {};
+    for(uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        for(uint32_t i = 0; i < moved_count; ++i)
+        {
+            GfxRef<GfxInstance> const &instance = instances[(frame * moved_count + i) % instance_count];
+            instance->transform[3][0] = (float)frame;
+            gfxSceneMarkInstanceModified(scene, instance);
+        }
+        UpdateGpuScene(gfx, scene, gpu_scene);
+        GFX_CHECK(gfxSceneGetModifiedInstanceCount(scene) == 0);
+        gfxFrame(gfx, false);
+    }
+    GpuSceneTimings const &timings = gpu_scene.upload_timings;
+    printf("%u instances, %u moved per frame: gather %.3f ms/frame, packing %.3f ms/frame (%u frames)\n", instance_count, moved_count,
+        timings.transform_ms / frame_count, timings.transform_packing_ms / frame_count, frame_count);
+    // A static scene has nothing to gather
+    gpu_scene.upload_timings = {};
+    for(uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        UpdateGpuScene(gfx, scene, gpu_scene);
+        gfxFrame(gfx, false);
+    }
+    printf("%u static instances: gather %.3f ms/frame (%u frames)\n", instance_count, gpu_scene.upload_timings.transform_ms / frame_count, frame_count);
+    GFX_CHECK(gfxFinish(gfx) == kGfxResult_NoError);
+    ReleaseGpuScene(gfx, gpu_scene);
+    gfxDestroyScene(scene);
+    gfxDestroyContext(gfx);
+}